@@ -0,0 +1,116 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the build time spent in constant folding.
+
+Times FoldConstant and the whole relay.build on ResNet and on a BERT-like
+encoder, with their parameters bound as constants so that the weight
+preprocessing (batch norm folding, weight transposes and reshapes, casts and
+scaling) is done by the compiler.
+see README.md for the usage of this script.
+"""
+import argparse
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import testing
+
+
+def bind_params(func, params):
+    """Replace the parameters of func with constants"""
+    binds = {}
+    for arg in func.params:
+        if arg.name_hint in params:
+            binds[arg] = relay.const(params[arg.name_hint])
+    return relay.bind(func, binds)
+
+
+def get_resnet(num_layers, batch_size):
+    mod, params = testing.resnet.get_workload(num_layers=num_layers, batch_size=batch_size)
+    mod = relay.transform.SimplifyInference()(mod)
+    func = bind_params(mod["main"], {k: v.asnumpy() for k, v in params.items()})
+    return relay.Module.from_expr(func)
+
+
+def get_bert(num_layers, seq_len, hidden, heads, dtype):
+    """A BERT-like encoder. Weights are stored as [in, out] in float32,
+    and are transposed, reshaped per head, scaled and cast at build time."""
+    head_dim = hidden // heads
+    x = relay.var("x", shape=(seq_len, hidden), dtype=dtype)
+
+    def weight(shape):
+        data = np.random.uniform(-0.1, 0.1, size=shape).astype("float32")
+        return relay.cast(relay.const(data), dtype)
+
+    def dense(data, in_units, units, scale=None):
+        w = relay.transpose(weight((in_units, units)))
+        b = weight((units,))
+        if scale is not None:
+            w = relay.multiply(w, relay.const(scale, dtype))
+            b = relay.multiply(b, relay.const(scale, dtype))
+        return relay.nn.bias_add(relay.nn.dense(data, w), b)
+
+    def heads_of(data, axes):
+        return relay.transpose(relay.reshape(data, (seq_len, heads, head_dim)), axes)
+
+    y = x
+    for _ in range(num_layers):
+        q = heads_of(dense(y, hidden, hidden, scale=1.0 / np.sqrt(head_dim)), (1, 0, 2))
+        k = heads_of(dense(y, hidden, hidden), (1, 0, 2))
+        v = heads_of(dense(y, hidden, hidden), (1, 2, 0))
+        att = relay.nn.softmax(relay.nn.batch_matmul(q, k))
+        ctx = relay.nn.batch_matmul(att, v)
+        ctx = relay.reshape(relay.transpose(ctx, (1, 0, 2)), (seq_len, hidden))
+        y = relay.add(y, dense(ctx, hidden, hidden))
+        h = relay.nn.relu(dense(y, hidden, 4 * hidden))
+        y = relay.add(y, dense(h, 4 * hidden, hidden))
+    return relay.Module.from_expr(relay.Function([x], y))
+
+
+def measure(name, mod, target):
+    start = time.time()
+    with relay.build_config(opt_level=3):
+        relay.transform.FoldConstant()(mod)
+    fold_time = time.time() - start
+    start = time.time()
+    with relay.build_config(opt_level=3):
+        relay.build(mod, target=target)
+    build_time = time.time() - start
+    print("%-20s %-20s %-20s" % (name, "%.2f s" % fold_time, "%.2f s" % build_time))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--batch-size", type=int, default=1)
+    parser.add_argument("--bert-layers", type=int, default=12)
+    parser.add_argument("--seq-len", type=int, default=128)
+    args = parser.parse_args()
+
+    workloads = [
+        ("resnet-18", lambda: get_resnet(18, args.batch_size)),
+        ("resnet-50", lambda: get_resnet(50, args.batch_size)),
+        ("bert-base", lambda: get_bert(args.bert_layers, args.seq_len, 768, 12, "float32")),
+    ]
+
+    print("--------------------------------------------------------------------------")
+    print("%-20s %-20s %-20s" % ("Network", "FoldConstant", "relay.build"))
+    print("--------------------------------------------------------------------------")
+    for name, get_mod in workloads:
+        measure(name, get_mod(), args.target)
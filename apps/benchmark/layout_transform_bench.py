@@ -0,0 +1,75 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the layout transforms left in CNNs with blocked layouts.
+
+Builds DenseNet and Inception-v3 for x86, where AlterOpLayout converts the
+convolutions to NCHW[x]c, with and without EliminateLayoutTransforms, and
+reports the layout transforms left in the graph and the latency.
+see README.md for the usage of this script.
+"""
+import argparse
+import json
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import testing
+from tvm.contrib import graph_runtime
+
+
+def count_layout_transforms(graph):
+    nodes = json.loads(graph)["nodes"]
+    return sum(1 for node in nodes
+               if node["op"] == "tvm_op" and "layout_transform" in node["attrs"]["func_name"])
+
+
+def measure(mod, params, input_shape, target, required_pass, repeat):
+    with relay.build_config(opt_level=3, required_pass=required_pass):
+        graph, lib, params = relay.build(mod, target=target, params=params)
+    ctx = tvm.cpu(0)
+    module = graph_runtime.create(graph, lib, ctx)
+    module.set_input(**params)
+    module.set_input("data", np.random.uniform(size=input_shape).astype("float32"))
+    ftimer = module.module.time_evaluator("run", ctx, number=10, repeat=repeat)
+    return count_layout_transforms(graph), np.mean(np.array(ftimer().results)) * 1000
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm -mcpu=skylake-avx512")
+    parser.add_argument("--batch-size", type=int, default=1)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    networks = [
+        ("densenet-121", lambda: testing.densenet.get_workload(batch_size=args.batch_size),
+         (args.batch_size, 3, 224, 224)),
+        ("inception_v3", lambda: testing.inception_v3.get_workload(batch_size=args.batch_size),
+         (args.batch_size, 3, 299, 299)),
+    ]
+
+    print("-" * 76)
+    print("%-16s %-30s %-30s" % ("Network", "AlterOpLayout", "+EliminateLayoutTransforms"))
+    print("-" * 76)
+    for name, get_workload, shape in networks:
+        mod, params = get_workload()
+        base = measure(mod, params, shape, args.target, None, args.repeat)
+        opt = measure(mod, params, shape, args.target, ["EliminateLayoutTransforms"],
+                      args.repeat)
+        print("%-16s %-30s %-30s" % (name, "%d transforms, %.2f ms" % base,
+                                     "%d transforms, %.2f ms" % opt))
@@ -0,0 +1,95 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of block sparse (BSR) dense layers against dense ones on x86.
+
+The weights are pruned block-wise to several sparsities and converted with
+relay.transform.DenseToSparse, on the dense layers of BERT-base and of a
+recommendation MLP.
+see README.md for the usage of this script.
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.contrib import graph_runtime
+
+
+def prune(weight, block_size, sparsity):
+    """Zero the blocks of weight with the smallest norms"""
+    rows, cols = weight.shape
+    bs_r, bs_c = block_size
+    blocks = weight.reshape(rows // bs_r, bs_r, cols // bs_c, bs_c)
+    norms = np.abs(blocks).sum(axis=(1, 3))
+    mask = norms > np.percentile(norms, sparsity * 100)
+    return (blocks * mask[:, None, :, None]).reshape(rows, cols)
+
+
+def measure(func, target, data, repeat):
+    with relay.build_config(opt_level=3):
+        graph, lib, params = relay.build(relay.Module.from_expr(func), target=target)
+    ctx = tvm.cpu(0)
+    module = graph_runtime.create(graph, lib, ctx)
+    module.set_input(**params)
+    module.set_input("data", data)
+    ftimer = module.module.time_evaluator("run", ctx, number=10, repeat=repeat)
+    return np.mean(np.array(ftimer().results)) * 1000
+
+
+def benchmark(name, m, k, n, block_size, sparsities, target, repeat):
+    data = np.random.uniform(size=(m, k)).astype("float32")
+    weight = np.random.uniform(-1, 1, size=(n, k)).astype("float32")
+    x = relay.var("data", shape=(m, k))
+
+    dense = relay.Function([x], relay.nn.dense(x, relay.const(weight)))
+    dense_time = measure(dense, target, data, repeat)
+    for sparsity in sparsities:
+        pruned = prune(weight, block_size, sparsity)
+        func = relay.Function([x], relay.nn.dense(x, relay.const(pruned)))
+        mod = relay.transform.DenseToSparse(block_size, sparsity - 0.01)(
+            relay.Module.from_expr(func))
+        sparse_time = measure(mod["main"], target, data, repeat)
+        print("%-28s %-10s %-10s %-14s %-14s %-8s" % (
+            name, str(block_size), "%.2f" % sparsity, "%.3f ms" % dense_time,
+            "%.3f ms" % sparse_time, "%.2fx" % (dense_time / sparse_time)))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm -mcpu=skylake-avx512")
+    parser.add_argument("--seq-len", type=int, default=128)
+    parser.add_argument("--batch-size", type=int, default=32)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    workloads = [
+        ("bert qkv/out %dx768x768" % args.seq_len, args.seq_len, 768, 768),
+        ("bert ffn1 %dx768x3072" % args.seq_len, args.seq_len, 768, 3072),
+        ("bert ffn2 %dx3072x768" % args.seq_len, args.seq_len, 3072, 768),
+        ("mlp %dx512x1024" % args.batch_size, args.batch_size, 512, 1024),
+        ("mlp %dx1024x256" % args.batch_size, args.batch_size, 1024, 256),
+    ]
+    sparsities = [0.6, 0.7, 0.8, 0.9, 0.95]
+
+    print("-" * 90)
+    print("%-28s %-10s %-10s %-14s %-14s %-8s" % (
+        "Layer", "Block", "Sparsity", "Dense", "BSR", "Speedup"))
+    print("-" * 90)
+    for block_size in [(1, 16), (16, 1), (8, 8)]:
+        for name, m, k, n in workloads:
+            benchmark(name, m, k, n, block_size, sparsities, args.target, args.repeat)
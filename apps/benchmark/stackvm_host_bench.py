@@ -0,0 +1,97 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of host functions interpreted by StackVM.
+
+Compares the plain stack interpreter with the fused program of StackVM on
+MakeAPI-generated host functions: the argument unpacking and checking in front
+of a kernel launch, and a small elementwise loop.
+see README.md for the usage of this script.
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+
+
+@tvm.register_func("bench.stackvm_kernel_launch")
+def kernel_launch(*args):
+    """Stands for the launch of a device kernel"""
+
+
+def get_launch_glue(num_args):
+    """Unpack num_args buffers and hand their data to a packed function"""
+    n = tvm.var('n')
+    buffers = [tvm.decl_buffer((n, 4), 'float32', name='A%d' % i) for i in range(num_args)]
+    stmt = tvm.make.Evaluate(tvm.call_packed(
+        "bench.stackvm_kernel_launch", *([b.data for b in buffers] + [n])))
+    fapi = tvm.ir_pass.MakeAPI(stmt, "launch", buffers, 0, True)
+    fapi = tvm.ir_pass.LowerTVMBuiltin(fapi)
+    fapi = tvm.ir_pass.LowerIntrin(fapi, "stackvm")
+    func = tvm.codegen.build_module(fapi, "stackvm")
+    args = [tvm.nd.array(np.zeros((16, 4), dtype='float32')) for _ in range(num_args)]
+    return func, args
+
+
+def get_elementwise(length):
+    """C = A + B, computed by the host function itself"""
+    n = tvm.var('n')
+    A = tvm.placeholder((n,), name='A', dtype='int32')
+    B = tvm.placeholder((n,), name='B', dtype='int32')
+    C = tvm.compute(A.shape, lambda i: A[i] + B[i], name='C')
+    s = tvm.create_schedule(C.op)
+    func = tvm.build(s, [A, B, C], "stackvm")
+    args = [tvm.nd.array(np.ones(length, dtype='int32')) for _ in range(3)]
+    return func, args
+
+
+def benchmark(name, func, func_args, fused):
+    tvm.get_global_func("module._StackVMSetFusedDispatch")(fused)
+    ctx = tvm.cpu(0)
+    ftimer = func.time_evaluator(func.entry_name, ctx, number=args.number, repeat=args.repeat)
+    # multiply 1e6 for converting to microsecond
+    prof_res = np.array(ftimer(*func_args).results) * 1e6
+    print("%-20s %-12s %-19s (%s)" % (
+        name, "fused" if fused else "interpreter",
+        "%.2f us" % np.mean(prof_res), "%.2f us" % np.std(prof_res)))
+    return np.mean(prof_res)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--number", type=int, default=1000)
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--length", type=int, default=256,
+                        help="The length of the vectors of the elementwise loop")
+    args = parser.parse_args()
+
+    workloads = [
+        ("launch_glue_3", get_launch_glue(3)),
+        ("launch_glue_8", get_launch_glue(8)),
+        ("elementwise_%d" % args.length, get_elementwise(args.length)),
+    ]
+
+    print("--------------------------------------------------------------------------")
+    print("%-20s %-12s %-20s" % ("Workload", "Dispatch", "Mean Time (std dev)"))
+    print("--------------------------------------------------------------------------")
+    try:
+        for name, (func, func_args) in workloads:
+            base = benchmark(name, func, func_args, False)
+            fused = benchmark(name, func, func_args, True)
+            print("%-20s %-12s %.2fx" % (name, "speedup", base / fused))
+    finally:
+        tvm.get_global_func("module._StackVMSetFusedDispatch")(True)
@@ -0,0 +1,128 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of conv2d chain fusion on x86 CPU.
+
+Compares the default build (opt_level=3) with chain fusion (opt_level=4), on
+MobileNet and on a stack of MobileNetV2-style inverted residual blocks.
+see README.md for the usage of this script.
+"""
+import argparse
+import json
+
+import numpy as np
+
+import tvm
+import tvm.contrib.graph_runtime as runtime
+from tvm import relay
+from tvm.relay import testing
+
+
+def inverted_residual(data, in_channels, expand, out_channels, name):
+    """Pointwise expansion, depthwise 3x3 and pointwise projection"""
+    hidden = in_channels * expand
+    body = relay.nn.conv2d(data, relay.var(name + "_expand_weight"),
+                           channels=hidden, kernel_size=(1, 1))
+    body = relay.nn.relu(body)
+    body = relay.nn.conv2d(body, relay.var(name + "_dw_weight"),
+                           channels=hidden, groups=hidden,
+                           kernel_size=(3, 3), padding=(1, 1))
+    body = relay.nn.relu(body)
+    body = relay.nn.conv2d(body, relay.var(name + "_project_weight"),
+                           channels=out_channels, kernel_size=(1, 1))
+    if in_channels == out_channels:
+        body = relay.add(body, data)
+    return body
+
+
+def get_inverted_residual_net(batch_size, num_blocks=4):
+    data_shape = (batch_size, 32, 56, 56)
+    data = relay.var("data", shape=data_shape)
+    body = data
+    for i in range(num_blocks):
+        body = inverted_residual(body, 32, 6, 32, "block%d" % i)
+    net = relay.Function(relay.analysis.free_vars(body), body)
+    mod, params = testing.create_workload(net)
+    return mod, params, data_shape
+
+
+def get_network(name, batch_size):
+    if name == 'mobilenet':
+        mod, params = testing.mobilenet.get_workload(batch_size=batch_size)
+        return mod, params, (batch_size, 3, 224, 224)
+    if name == 'inverted_residual':
+        return get_inverted_residual_net(batch_size)
+    raise ValueError("Unsupported network: " + name)
+
+
+def intermediate_bytes(graph):
+    """Bytes of the tensors passed between fused functions"""
+    graph = json.loads(graph)
+    shapes = graph["attrs"]["shape"][1]
+    dtypes = graph["attrs"]["dltype"][1]
+    total = 0
+    for nid, node in enumerate(graph["nodes"]):
+        if node["op"] != "tvm_op":
+            continue
+        eid = graph["node_row_ptr"][nid]
+        total += int(np.prod(shapes[eid])) * np.dtype(dtypes[eid]).itemsize
+    return total
+
+
+def benchmark(network, target, opt_level):
+    mod, params, input_shape = get_network(network, batch_size=1)
+    # chain fusion works on NCHW, keep the layout untouched in both builds
+    with relay.build_config(opt_level=opt_level, disabled_pass={"AlterOpLayout"}):
+        graph, lib, params = relay.build(mod, target=target, params=params)
+
+    ctx = tvm.cpu(0)
+    module = runtime.create(graph, lib, ctx)
+    data_tvm = tvm.nd.array((np.random.uniform(size=input_shape)).astype(dtype))
+    module.set_input('data', data_tvm)
+    module.set_input(**params)
+
+    ftimer = module.module.time_evaluator("run", ctx, number=1, repeat=args.repeat)
+    prof_res = np.array(ftimer().results) * 1000  # multiply 1000 for converting to millisecond
+    print("%-20s %-10s %-19s (%s) %10.2f MB" % (
+        network, "O%d" % opt_level, "%.2f ms" % np.mean(prof_res),
+        "%.2f ms" % np.std(prof_res), intermediate_bytes(graph) / 1e6))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--network", type=str, choices=['mobilenet', 'inverted_residual'],
+                        help='The name of neural network')
+    parser.add_argument("--target", type=str, default='llvm',
+                        help="The tvm compilation target, e.g. 'llvm -mcpu=skylake-avx512'")
+    parser.add_argument("--repeat", type=int, default=100)
+    args = parser.parse_args()
+
+    dtype = 'float32'
+
+    if args.network is None:
+        networks = ['mobilenet', 'inverted_residual']
+    else:
+        networks = [args.network]
+
+    target = tvm.target.create(args.target)
+
+    print("--------------------------------------------------------------------------")
+    print("%-20s %-10s %-20s %s" % ("Network Name", "Opt Level",
+                                    "Mean Inference Time (std dev)", "Intermediates"))
+    print("--------------------------------------------------------------------------")
+    for network in networks:
+        for opt_level in [3, 4]:
+            benchmark(network, target, opt_level)
@@ -0,0 +1,165 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of int8 inference against fp32 on x86.
+
+ResNet, MobileNet and the grouped convolutions of ResNeXt are quantized with
+relay.quantize, the encoder layers of a BERT-like model are written with
+qnn.dense, int8 batch_matmul and qnn.requantize. Int8 convolutions, grouped
+convolutions, dense layers and batch_matmuls use the AVX512 uint8 x int8
+dot-product instructions, so use a skylake-avx512 or cascadelake target.
+see README.md for the usage of this script.
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import testing
+from tvm.relay.testing import layers
+from tvm.contrib import graph_runtime
+
+
+def measure(mod, params, input_shape, input_dtype, target, repeat):
+    with relay.build_config(opt_level=3):
+        graph, lib, params = relay.build(mod, target=target, params=params)
+    ctx = tvm.cpu(0)
+    module = graph_runtime.create(graph, lib, ctx)
+    module.set_input(**params)
+    if input_dtype == "uint8":
+        data = np.random.randint(0, 255, size=input_shape).astype(input_dtype)
+    else:
+        data = np.random.uniform(size=input_shape).astype(input_dtype)
+    module.set_input("data", data)
+    ftimer = module.module.time_evaluator("run", ctx, number=10, repeat=repeat)
+    return np.mean(np.array(ftimer().results)) * 1000
+
+
+def get_cnn(name, batch_size):
+    """Get a CNN in fp32 and quantized to int8"""
+    if name.startswith("resnet"):
+        n_layer = int(name.split("-")[1])
+        mod, params = testing.resnet.get_workload(num_layers=n_layer, batch_size=batch_size)
+    else:
+        mod, params = testing.mobilenet.get_workload(batch_size=batch_size)
+    with relay.quantize.qconfig(calibrate_mode="global_scale", global_scale=8.0):
+        qmod = relay.quantize.quantize(mod, params)
+    shape = (batch_size, 3, 224, 224)
+    return (mod, params, shape, "float32"), (qmod, {}, shape, "float32")
+
+
+def get_resnext(batch_size):
+    """The 3x3 grouped convolutions of ResNeXt-50 (32x4d) and the 1x1 convolutions
+    around them, in fp32 and quantized to int8"""
+    shape = (batch_size, 64, 56, 56)
+    y = relay.var("data", shape=shape)
+    for stage, width in enumerate([128, 256, 512, 1024]):
+        strides = (1, 1) if stage == 0 else (2, 2)
+        y = layers.conv2d(y, channels=width, kernel_size=(1, 1), name="s%d_conv1" % stage)
+        y = relay.nn.relu(y)
+        y = layers.conv2d(y, channels=width, kernel_size=(3, 3), strides=strides,
+                          padding=(1, 1), groups=32, name="s%d_conv2" % stage)
+        y = relay.nn.relu(y)
+        y = layers.conv2d(y, channels=2 * width, kernel_size=(1, 1), name="s%d_conv3" % stage)
+        y = relay.nn.relu(y)
+    mod, params = testing.create_workload(relay.Function(relay.analysis.free_vars(y), y))
+    with relay.quantize.qconfig(calibrate_mode="global_scale", global_scale=8.0,
+                                skip_conv_layers=[]):
+        qmod = relay.quantize.quantize(mod, params)
+    return (mod, params, shape, "float32"), (qmod, {}, shape, "float32")
+
+
+def get_bert(num_layers, seq_len, hidden, quantized, num_heads=12):
+    """The dense layers and the attention batch_matmuls of a BERT-like encoder,
+    with requantized int8 activations"""
+    shape = (seq_len, hidden)
+    x = relay.var("data", shape=shape, dtype="uint8" if quantized else "float32")
+    params = {}
+
+    def dense(data, in_units, units, name):
+        if not quantized:
+            params[name] = tvm.nd.array(
+                np.random.uniform(-0.1, 0.1, size=(units, in_units)).astype("float32"))
+            return relay.nn.dense(data, relay.var(name, shape=(units, in_units)))
+        params[name] = tvm.nd.array(
+            np.random.randint(-127, 127, size=(units, in_units)).astype("int8"))
+        weight = relay.var(name, shape=(units, in_units), dtype="int8")
+        out = relay.qnn.op.dense(data, weight, input_zero_point=128, kernel_zero_point=0,
+                                 input_scale=0.05, kernel_scale=0.001, units=units)
+        return relay.qnn.op.requantize(out, input_scale=0.05 * 0.001, input_zero_point=0,
+                                       output_scale=0.05, output_zero_point=128,
+                                       out_dtype="uint8")
+
+    def batch_matmul(a, b):
+        if not quantized:
+            return relay.nn.batch_matmul(a, b)
+        # the zero points are left out, they do not change the cost of the kernel.
+        out = relay.nn.batch_matmul(a, b, out_dtype="int32")
+        return relay.qnn.op.requantize(out, input_scale=0.05 * 0.05, input_zero_point=0,
+                                       output_scale=0.05, output_zero_point=128,
+                                       out_dtype="uint8")
+
+    head_dim = hidden // num_heads
+    def split_heads(data, axes):
+        return relay.transpose(relay.reshape(data, (seq_len, num_heads, head_dim)), axes)
+
+    y = x
+    for i in range(num_layers):
+        q = dense(y, hidden, hidden, "l%d_q" % i)
+        k = dense(y, hidden, hidden, "l%d_k" % i)
+        v = dense(y, hidden, hidden, "l%d_v" % i)
+        # the attention without its softmax, one batch per head
+        scores = batch_matmul(split_heads(q, (1, 0, 2)), split_heads(k, (1, 0, 2)))
+        context = batch_matmul(scores, split_heads(v, (1, 2, 0)))
+        y = relay.reshape(relay.transpose(context, (1, 0, 2)), (seq_len, hidden))
+        y = dense(y, hidden, hidden, "l%d_out" % i)
+        h = dense(y, hidden, 4 * hidden, "l%d_ffn1" % i)
+        if not quantized:
+            h = relay.nn.relu(h)
+        y = dense(h, 4 * hidden, hidden, "l%d_ffn2" % i)
+    func = relay.Function(relay.analysis.free_vars(y), y)
+    return relay.Module.from_expr(func), params, shape, "uint8" if quantized else "float32"
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm -mcpu=cascadelake")
+    parser.add_argument("--batch-size", type=int, default=1)
+    parser.add_argument("--bert-layers", type=int, default=12)
+    parser.add_argument("--seq-len", type=int, default=128)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    print("-" * 60)
+    print("%-20s %-14s %-14s %-8s" % ("Network", "fp32", "int8", "Speedup"))
+    print("-" * 60)
+    for network in ["resnet-18", "resnet-50", "mobilenet", "resnext-50 groups"]:
+        if network.startswith("resnext"):
+            fp32, int8 = get_resnext(args.batch_size)
+        else:
+            fp32, int8 = get_cnn(network, args.batch_size)
+        fp32_time = measure(*fp32, target=args.target, repeat=args.repeat)
+        int8_time = measure(*int8, target=args.target, repeat=args.repeat)
+        print("%-20s %-14s %-14s %-8s" % (network, "%.2f ms" % fp32_time,
+                                          "%.2f ms" % int8_time,
+                                          "%.2fx" % (fp32_time / int8_time)))
+    fp32_time = measure(*get_bert(args.bert_layers, args.seq_len, 768, False),
+                        target=args.target, repeat=args.repeat)
+    int8_time = measure(*get_bert(args.bert_layers, args.seq_len, 768, True),
+                        target=args.target, repeat=args.repeat)
+    print("%-20s %-14s %-14s %-8s" % ("bert-base encoder", "%.2f ms" % fp32_time,
+                                      "%.2f ms" % int8_time, "%.2fx" % (fp32_time / int8_time)))
@@ -19,6 +19,7 @@
 import argparse
 import os
 from tvm import relay
+from tvm.contrib import graph_aot
 import tvm
 import logging
 
@@ -51,6 +52,9 @@ def main():
         f_graph_json.write(graph)
     with open(os.path.join(build_dir, 'params.bin'), 'wb') as f_params:
         f_params.write(relay.save_param_dict(params))
+    # The same graph compiled ahead of time, for bundle_aot.so.
+    with open(os.path.join(build_dir, 'model_aot.cc'), 'w') as f_aot:
+        f_aot.write(graph_aot.codegen(graph, params))
 
 
 if __name__ == '__main__':
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <dlpack/dlpack.h>
+#include <string.h>
+
+// Generated by tvm.contrib.graph_aot into model_aot.cc.
+extern "C" {
+int tvm_aot_init();
+int tvm_aot_run();
+int tvm_aot_get_input_index(const char *name);
+DLTensor *tvm_aot_input(int index);
+DLTensor *tvm_aot_output(int index);
+}
+
+#define TVM_BUNDLE_FUNCTION __attribute__((visibility("default")))
+
+static size_t GetDataSize(const DLTensor *tensor) {
+  size_t size = 1;
+  for (int i = 0; i < tensor->ndim; ++i) {
+    size *= static_cast<size_t>(tensor->shape[i]);
+  }
+  return size * ((tensor->dtype.bits * tensor->dtype.lanes + 7) / 8);
+}
+
+// The graph lives in static storage, so there is a single instance.
+static int bundle_instance;
+
+extern "C" {
+
+TVM_BUNDLE_FUNCTION void *tvm_runtime_create() {
+  if (tvm_aot_init() != 0) {
+    return nullptr;
+  }
+  return &bundle_instance;
+}
+
+TVM_BUNDLE_FUNCTION void tvm_runtime_destroy(void *handle) {}
+
+TVM_BUNDLE_FUNCTION void tvm_runtime_set_input(void *handle, const char *name,
+                                               void *tensor) {
+  // Like GraphRuntime, ignore unknown names; parameters are not settable.
+  int index = tvm_aot_get_input_index(name);
+  if (index < 0) {
+    return;
+  }
+  DLTensor *src = reinterpret_cast<DLTensor *>(tensor);
+  DLTensor *dst = tvm_aot_input(index);
+  memcpy(dst->data, static_cast<char *>(src->data) + src->byte_offset,
+         GetDataSize(dst));
+}
+
+TVM_BUNDLE_FUNCTION void tvm_runtime_run(void *handle) { tvm_aot_run(); }
+
+TVM_BUNDLE_FUNCTION void tvm_runtime_get_output(void *handle, int index,
+                                                void *tensor) {
+  DLTensor *dst = reinterpret_cast<DLTensor *>(tensor);
+  const DLTensor *src = tvm_aot_output(index);
+  memcpy(static_cast<char *>(dst->data) + dst->byte_offset, src->data,
+         GetDataSize(src));
+}
+}
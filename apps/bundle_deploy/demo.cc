@@ -19,6 +19,7 @@
 
 #include "tvm/runtime/c_runtime_api.h"
 #include <assert.h>
+#include <chrono>
 #include <dlfcn.h> //dlopen
 #include <dlpack/dlpack.h>
 #include <iostream>
@@ -38,7 +39,9 @@ int main(int argc, char **argv) {
   auto *bundle = dlopen(argv[1], RTLD_LAZY | RTLD_LOCAL);
   assert(bundle);
 
+  auto t0 = std::chrono::high_resolution_clock::now();
   auto *handle = getFunc<void *()>(bundle, "tvm_runtime_create")();
+  auto t1 = std::chrono::high_resolution_clock::now();
 
   std::vector<float> input_storage(1 * 3 * 224 * 224);
   std::mt19937 gen(0);
@@ -61,7 +64,9 @@ int main(int argc, char **argv) {
   auto *ftvm_runtime_run =
       (auto (*)(void *)->void)dlsym(bundle, "tvm_runtime_run");
   assert(!dlerror());
+  auto t2 = std::chrono::high_resolution_clock::now();
   ftvm_runtime_run(handle);
+  auto t3 = std::chrono::high_resolution_clock::now();
 
   std::vector<float> output_storage(1000);
   std::vector<int64_t> output_shape = {1, 1000};
@@ -79,6 +84,11 @@ int main(int argc, char **argv) {
   for (auto i = 0; i < output_storage.size(); ++i) {
     std::cerr << "output[" << i << "]: " << output_storage[i] << std::endl;
   }
+  std::cerr << "create: "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << "ms, run: "
+            << std::chrono::duration<double, std::milli>(t3 - t2).count()
+            << "ms" << std::endl;
   getFunc<void(void *)>(bundle, "tvm_runtime_destroy")(handle);
   dlclose(bundle);
   return 0;
@@ -235,6 +235,14 @@ class BuildConfigNode : public Node {
   /*! \brief Whether to disable assert stmt generation. */
   bool disable_assert = false;
 
+  /*!
+   * \brief Extent factors used to specialize kernels with dynamic (Any) dimensions.
+   *  For each factor, the compile engine generates a variant that assumes every
+   *  dynamic dimension is a multiple of the factor, guarded by a runtime check
+   *  and falling back to the generic kernel. Empty means no specialization.
+   */
+  Array<Integer> dynamic_shape_buckets;
+
   void VisitAttrs(AttrVisitor* v) {
     v->Visit("data_alignment", &data_alignment);
     v->Visit("offset_factor", &offset_factor);
@@ -251,6 +259,7 @@ class BuildConfigNode : public Node {
     v->Visit("disable_select_rewriting", &disable_select_rewriting);
     v->Visit("disable_vectorize", &disable_vectorize);
     v->Visit("disable_assert", &disable_assert);
+    v->Visit("dynamic_shape_buckets", &dynamic_shape_buckets);
   }
 
   static constexpr const char* _type_key = "BuildConfig";
@@ -300,6 +309,23 @@ class BuildConfig : public ::tvm::NodeRef {
   TVM_DLL void ExitWithScope();
 };
 
+/*!
+* \brief Build a Stmt given a schedule, args and binds. This function runs the IR passes.
+* \param sch The schedule to build.
+* \param args The arguments for the schedule.
+* \param binds Buffer assignments.
+* \param loop_partition True if the LoopPartition pass should be included.
+* \param out_arg_list Returns the arguments for the Stmt.
+* \param config The build configuration.
+* \return The built Stmt.
+*/
+TVM_DLL Stmt BuildStmt(Schedule sch,
+                       const Array<Tensor>& args,
+                       const std::unordered_map<Tensor, Buffer>& binds,
+                       bool loop_partition,
+                       Array<NodeRef> *out_arg_list,
+                       const BuildConfig& config);
+
 /*!
 * \brief Build a LoweredFunc given a schedule, args and binds
 * \param sch The schedule to lower.
@@ -614,6 +614,11 @@ constexpr const char* kParams = "__params__";
 constexpr const char* kExternalSymbol = "ExternalSymbol";
 /*! \brief Mark if the function should be avoided being optimized. */
 constexpr const char* kSkipOptimization = "SkipOptimization";
+/*!
+ * \brief Mark that the function is called with an output planned in place over
+ *  an input, so that its arguments may alias.
+ */
+constexpr const char* kInplace = "Inplace";
 }  // namespace attr
 
 }  // namespace relay
@@ -99,6 +99,18 @@ class PassContextNode : public RelayNode {
   /*! \brief The list of disabled passes. */
   tvm::Array<tvm::Expr> disabled_pass;
 
+  /*!
+   * \brief The number of threads used to run a function pass over the
+   *  functions of a module. 1 runs serially, 0 uses all hardware threads.
+   */
+  int num_threads{1};
+
+  /*!
+   * \brief The bound in bytes of the activation memory of the graphs built
+   *  for the graph runtime, 0 for no bound. See Rematerialize.
+   */
+  int64_t memory_budget{0};
+
   PassContextNode() = default;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
@@ -106,6 +118,8 @@ class PassContextNode : public RelayNode {
     v->Visit("fallback_device", &fallback_device);
     v->Visit("required_pass", &required_pass);
     v->Visit("disabled_pass", &disabled_pass);
+    v->Visit("num_threads", &num_threads);
+    v->Visit("memory_budget", &memory_budget);
   }
 
   static constexpr const char* _type_key = "relay.PassContext";
@@ -488,11 +502,28 @@ TVM_DLL Pass CombineParallelConv2D(uint64_t min_num_branches = 3);
  * number of branches of this dense operator is not less than
  * `min_num_branch`.
  *
+ * If to_batch is false, the dense ops are instead combined into a single
+ * dense on the concatenation of their weights, which also combines dense
+ * ops with different numbers of units.
+ *
  * \param min_num_branches The minimun number of branches.
+ * \param to_batch Whether to combine into a batch_matmul or a dense.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass CombineParallelDense(uint64_t min_num_branches = 3, bool to_batch = true);
+
+/*!
+ * \brief Convert dense ops with a sparse constant weight into sparse_dense
+ * ops with the weight in block sparse row (BSR) format.
+ *
+ * \param bs_r The number of rows of a block.
+ * \param bs_c The number of columns of a block.
+ * \param sparsity_threshold The minimum fraction of zero blocks of a converted weight.
  *
  * \return The pass.
  */
-TVM_DLL Pass CombineParallelDense(uint64_t min_num_branches = 3);
+TVM_DLL Pass DenseToSparse(int bs_r, int bs_c, double sparsity_threshold);
 
 /*!
  * \brief Backward fold axis scaling into weights of conv/dense operators.
@@ -532,6 +563,32 @@ TVM_DLL Pass CanonicalizeOps();
  */
 TVM_DLL Pass AlterOpLayout();
 
+/*!
+ * \brief Run the regions of connected elementwise operators in the layout
+ * of the layout transforms around them which leaves the fewest transforms,
+ * and fold the chains of layout transforms.
+ *
+ * AlterOpLayout transforms the inputs of operators which cannot infer a
+ * layout back to their original layout, this pass removes the transforms
+ * this leaves between blocked operators. The pass is at opt_level 4, so the
+ * build only runs it when it is required.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass EliminateLayoutTransforms();
+
+/*!
+ * \brief Recompute the outputs of cheap operators (elementwise, broadcast and
+ * injective such as pad or cast) for their later users instead of keeping
+ * them alive, until the estimated peak activation memory of the graph is
+ * within the budget.
+ *
+ * \param memory_budget The bound of the activation memory in bytes.
+ *
+ * \return The pass.
+ */
+TVM_DLL Pass Rematerialize(int64_t memory_budget);
+
 /*!
  * \brief Given a dest layout, this pass transforms the expr such that most of the ops input data
  * layout is changed to the dest layout. In ideal situation, there are only 2 layout transforms, one
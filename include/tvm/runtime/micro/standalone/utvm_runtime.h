@@ -39,6 +39,28 @@ TVM_MICRO_RUNTIME_API_API void* UTVMRuntimeDSOModuleCreate(const char* so, size_
 
 TVM_MICRO_RUNTIME_API_API void UTVMRuntimeDSOModuleDestroy(void* module);
 
+// Ahead-of-time runtime. `UTVMRuntimeAOTCompile` runs on the host and returns
+// the size of the descriptor, which is written to `out` if `out_len` is large
+// enough. On the device, the descriptor (aligned to 64 bytes) is instantiated in
+// a caller-provided arena of `UTVMRuntimeAOTArenaSize` bytes without heap
+// allocation; the runtime needs no destruction beyond releasing the arena.
+
+TVM_MICRO_RUNTIME_API_API size_t UTVMRuntimeAOTCompile(const char* json, size_t json_len,
+                                                       const char* params, size_t params_len,
+                                                       void* out, size_t out_len);
+
+TVM_MICRO_RUNTIME_API_API size_t UTVMRuntimeAOTArenaSize(const void* descriptor);
+
+TVM_MICRO_RUNTIME_API_API void* UTVMRuntimeAOTCreate(const void* descriptor, void* arena,
+                                                     size_t arena_size, void* module);
+
+TVM_MICRO_RUNTIME_API_API void UTVMRuntimeAOTSetInput(void* handle, int index, void* tensor);
+
+// Returns 0 on success, otherwise the code of the first failing operator.
+TVM_MICRO_RUNTIME_API_API int UTVMRuntimeAOTRun(void* handle);
+
+TVM_MICRO_RUNTIME_API_API void UTVMRuntimeAOTGetOutput(void* handle, int index, void* tensor);
+
 #undef TVM_MICRO_RUNTIME_API_API
 
 #endif  // TVM_RUNTIME_MICRO_STANDALONE_UTVM_RUNTIME_H_
@@ -236,6 +236,8 @@ constexpr const char* tvm_global_barrier_state = "__tvm_global_barrier_state";
 constexpr const char* tvm_prepare_global_barrier = "__tvm_prepare_global_barrier";
 /*! \brief Placeholder for the module's entry function. */
 constexpr const char* tvm_module_main = "__tvm_main__";
+/*! \brief Global variable to store the target features of multi-versioned functions. */
+constexpr const char* tvm_func_variants = "__tvm_func_variants";
 }  // namespace symbol
 
 // implementations of inline functions.
@@ -19,12 +19,16 @@
 from __future__ import absolute_import as _abs
 from enum import IntEnum
 
+import hashlib
 import logging
+import os
+import numpy as np
 import tvm
 
 from tvm.contrib import graph_runtime
 from tvm._ffi.runtime_ctypes import TVMContext
 from tvm import autotvm
+from tvm.autotvm.task import dispatcher
 from . import graph_attr, graph_util
 from .. import graph as _graph
 from .. import symbol as sym
@@ -34,6 +38,7 @@ from .. import subgraph as _subgraph
 OPT_PASS_LEVEL = {
     "SimplifyInference": 0,
     "PrecomputePrune": 2,
+    "DedupParams": 2,
     "OpFusion": 1,
     "FoldScaleAxis": 3,
     "AlterOpLayout": 3,
@@ -62,6 +67,7 @@ class BuildConfig(object):
         "ext_accel": None,
         "fallback_device": None,
         "op_name_device": None,
+        "compile_cache_dir": None,
     }
     def __init__(self, **kwargs):
         self._old_scope = None
@@ -130,6 +136,11 @@ def build_config(**kwargs):
     op_name_device : dict of str to str or tvm.TVMContext.
         A dictionary contains operator name to device context mapping.
 
+    compile_cache_dir : str
+        Directory of a persistent cache of the lowered fused functions.
+        Fused blocks with the same structure, input shapes and target are
+        lowered once and reused by later builds, also across processes.
+
     Returns
     -------
     config: BuildConfig
@@ -156,6 +167,85 @@ def _lower(sch, inputs, func_name, graph):
         f, (tvm.container.Array, tuple, list)) else [f]
 
 
+_BUILD_ID = []
+
+
+def _build_id():
+    """Digest of the libraries and the operator sources of this build.
+
+    tvm.__version__ does not change across dev trees, so compiled code cached
+    by another build is told apart by the code that produced it. Computed
+    once per process.
+    """
+    if not _BUILD_ID:
+        import topi
+        from .. import top
+        from .._base import _LIB as _NNVM_LIB
+        digest = hashlib.sha1()
+        for path in (tvm._ffi.base._LIB._name, _NNVM_LIB._name):
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 20), b""):
+                    digest.update(chunk)
+        for pkg in (topi, top):
+            pkg_dir = os.path.dirname(os.path.abspath(pkg.__file__))
+            for root, dirs, files in os.walk(pkg_dir):
+                dirs.sort()
+                for name in sorted(files):
+                    if name.endswith(".py"):
+                        path = os.path.join(root, name)
+                        digest.update(os.path.relpath(path, pkg_dir).encode())
+                        with open(path, "rb") as f:
+                            digest.update(f.read())
+        _BUILD_ID.append(digest.hexdigest())
+    return _BUILD_ID[0]
+
+
+def _compile_cache_salt():
+    """Digest of the lowering context that is not part of the graph.
+
+    Returns None when the context cannot be described, e.g. with custom
+    lowering passes, in which case the persistent cache is not used.
+    """
+    # pylint: disable=protected-access
+    cfg = tvm.build_module.current_build_config()
+    if cfg.add_lower_pass:
+        return None
+    ctx_desc = []
+    for key in sorted(tvm.build_module.BuildConfig._node_defaults):
+        ctx_desc.append("%s=%s" % (key, getattr(cfg, key)))
+    # the schedule templates pick their config from the dispatch context.
+    ctx = autotvm.DispatchContext.current
+    while ctx is not None:
+        if isinstance(ctx, dispatcher.ApplyHistoryBest):
+            for best in (ctx.best_by_targetkey, ctx.best_by_model):
+                for key in sorted(best, key=str):
+                    ctx_desc.append("%s:%s" % (key, best[key][0].config))
+            for key in sorted(ctx._best_user_defined, key=str):
+                ctx_desc.append("%s:%s" % (key, ctx._best_user_defined[key]))
+        elif isinstance(ctx, dispatcher.ApplyConfig):
+            ctx_desc.append(str(ctx._config))
+        elif not isinstance(ctx, autotvm.FallbackContext):
+            return None
+        ctx = ctx._old_ctx
+    return "%s;%s;%s" % (tvm.__version__, _build_id(),
+                         hashlib.sha1("\n".join(ctx_desc).encode()).hexdigest())
+
+
+def _graph_compile(graph, cache_dir):
+    """Apply GraphCompile, with the persistent cache in cache_dir if set"""
+    salt = _compile_cache_salt() if cache_dir else None
+    if salt is None:
+        return graph.apply("GraphCompile")
+    if not os.path.isdir(cache_dir):
+        os.makedirs(cache_dir)
+    set_cache = tvm.get_global_func("nnvm.compiler.SetPersistentCache")
+    set_cache(os.path.abspath(cache_dir), salt)
+    try:
+        return graph.apply("GraphCompile")
+    finally:
+        set_cache("", "")
+
+
 @tvm.register_func("nnvm.compiler.build_target")
 def _build(funcs, target, target_host):
     if target_host == "":
@@ -346,6 +436,10 @@ def build(graph, target=None, shape=None, dtype="float32",
         if params and cfg.pass_enabled("PrecomputePrune"):
             graph, params = precompute_prune(graph, params)
             shape, dtype = _update_shape_dtype(shape, dtype, params)
+        # Share the storage of identical params
+        param_alias = {}
+        if params and cfg.pass_enabled("DedupParams"):
+            params, param_alias = dedup_params(params)
         graph = _annotate_graph(graph, device_target,
                                 AnnotationType.COPY_INSERTION)
 
@@ -360,9 +454,11 @@ def build(graph, target=None, shape=None, dtype="float32",
         else:
             graph._set_json_attr("opt_level", 0, "int")
         graph = graph.apply("InferShape").apply("InferType")
+        if param_alias:
+            graph._set_json_attr("param_alias", sum(param_alias.items(), ()), "list_str")
         graph = graph.apply("GraphFindFusibleGroups")
         graph = graph.apply("GraphFuse")
-        graph = graph.apply("GraphCompile")
+        graph = _graph_compile(graph, cfg.compile_cache_dir)
         libmod = graph_attr._move_out_module(graph, "module")
         # Write variable initial values into params
         if init_var:
@@ -527,6 +623,42 @@ def precompute_prune(graph, params):
     return graph, dict(zip(out_names, out_arrs))
 
 
+def dedup_params(params):
+    """Find the identical parameters of a graph.
+
+    Parameters with the same dtype, shape and content are aliased to the
+    first of them in name order. The duplicates are dropped from the params,
+    and GraphCompile plans the graph inputs of an alias into the storage of
+    the kept parameter, so each unique tensor is stored and loaded once.
+
+    Parameters
+    ----------
+    params : dict of str -> tvm.NDArray
+        The parameter dictionary of the graph
+
+    Returns
+    -------
+    new_params : dict of str-> tvm.NDArray
+        The parameters without duplicates.
+
+    alias : dict of str -> str
+        The kept parameter of each dropped one.
+    """
+    unique = {}
+    alias = {}
+    new_params = {}
+    for name in sorted(params):
+        data = params[name].asnumpy()
+        digest = hashlib.sha1(data.tobytes())
+        digest.update(str((data.dtype, data.shape)).encode())
+        kept = unique.setdefault(digest.hexdigest(), (name, data))
+        if kept[0] != name and np.array_equal(kept[1], data):
+            alias[name] = kept[0]
+        else:
+            new_params[name] = params[name]
+    return new_params, alias
+
+
 def initialize_variables(ishape, idtype):
     """ Initialize variables stored in _all_var_init dictionary.
 
@@ -22,13 +22,23 @@
  * \brief The compile engine.
  */
 #include <dmlc/common.h>
+#include <dmlc/json.h>
 #include <tvm/ir.h>
+#include <tvm/lowered_func.h>
+#include <tvm/node/serialization.h>
 #include <tvm/operation.h>
 #include <nnvm/graph.h>
 #include <nnvm/node.h>
 #include <nnvm/pass_functions.h>
 #include <nnvm/compiler/op_attr_types.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
 #include <mutex>
+#include <sstream>
+#include <thread>
 #include <tuple>
 #include <vector>
 #include <limits>
@@ -96,6 +106,69 @@ DataType GetTVMType(int type_flag) {
   }
 }
 
+/*!
+ * \brief Canonical text of a lowering request, used as the key of the
+ *  persistent cache.
+ *
+ *  Node names are left out, so identical fused blocks of different models
+ *  share the key. Everything else that changes the lowered code is included.
+ */
+std::string PersistentCacheKey(const Graph& graph,
+                               const Array<tvm::Tensor>& inputs,
+                               const std::string& target,
+                               int master_idx) {
+  std::ostringstream os;
+  const IndexedGraph& idx = graph.indexed_graph();
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) {
+      os << "var;";
+      continue;
+    }
+    os << inode.source->op()->name << '(';
+    std::map<std::string, std::string> dict(
+        inode.source->attrs.dict.begin(), inode.source->attrs.dict.end());
+    for (const auto& kv : dict) {
+      os << kv.first << '=' << kv.second << ',';
+    }
+    os << ")[";
+    for (const IndexedGraph::NodeEntry& e : inode.inputs) {
+      os << e.node_id << ':' << e.index << ',';
+    }
+    for (uint32_t dep : inode.control_deps) {
+      os << '^' << dep << ',';
+    }
+    os << "];";
+  }
+  os << "out[";
+  for (const IndexedGraph::NodeEntry& e : idx.outputs()) {
+    os << e.node_id << ':' << e.index << ',';
+  }
+  os << "];in[";
+  for (const tvm::Tensor& t : inputs) {
+    os << t->dtype << '(';
+    for (Expr v : t->shape) {
+      os << v << ',';
+    }
+    os << "),";
+  }
+  os << "];target=" << target << ";master=" << master_idx;
+  return os.str();
+}
+
+// 128 bit FNV-1a digest in hex, stable across platforms and runs.
+std::string PersistentCacheDigest(const std::string& key) {
+  uint64_t h[2] = {14695981039346656037ULL, 0x6c62272e07bb0142ULL};
+  for (unsigned char c : key) {
+    h[0] = (h[0] ^ c) * 1099511628211ULL;
+    h[1] = (h[1] ^ c) * 0x100000001b3ULL + 0x9e3779b97f4a7c15ULL;
+  }
+  std::ostringstream os;
+  os << std::hex << std::setfill('0')
+     << std::setw(16) << h[0] << std::setw(16) << h[1];
+  return os.str();
+}
+
 // internal compile engine
 class CompileEngine {
  public:
@@ -115,7 +188,23 @@ class CompileEngine {
       ++(it->second->use_count);
       return it->second->graph_func;
     }
-    GraphFunc f = DoLower(key->graph, key->inputs, key->target, master_idx);
+    GraphFunc f;
+    std::string disk_key, disk_path;
+    if (!cache_dir_.empty()) {
+      disk_key = PersistentCacheKey(key->graph, key->inputs, key->target,
+                                    master_idx) + ";salt=" + cache_salt_;
+      disk_path = cache_dir_ + "/" + PersistentCacheDigest(disk_key) + ".json";
+      f = LoadPersistent(disk_path, disk_key);
+    }
+    if (f.defined()) {
+      ++disk_hits_;
+    } else {
+      f = DoLower(key->graph, key->inputs, key->target, master_idx);
+      if (!disk_path.empty()) {
+        ++disk_misses_;
+        if (IsPersistable(f)) SavePersistent(disk_path, disk_key, f);
+      }
+    }
     auto n = tvm::make_node<GraphCacheEntryNode>();
     n->graph_func = f;
     n->use_count = 1;
@@ -157,6 +246,25 @@ class CompileEngine {
     std::lock_guard<std::mutex> lock(mutex_);
     cache_.clear();
   }
+  // Set the directory of the persistent cache, an empty dir disables it.
+  // The salt is appended to every key, and describes the lowering context
+  // which is not visible from the graph (tvm version, build config, tuned
+  // schedules).
+  void SetPersistentCache(const std::string& dir, const std::string& salt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_dir_ = dir;
+    cache_salt_ = salt;
+  }
+  // Number of persistent cache hits and misses since the last reset.
+  Array<Integer> PersistentCacheStats(bool reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Array<Integer> ret = {Integer(static_cast<int>(disk_hits_)),
+                          Integer(static_cast<int>(disk_misses_))};
+    if (reset) {
+      disk_hits_ = disk_misses_ = 0;
+    }
+    return ret;
+  }
 
   // get schedule and its args
   std::tuple<Schedule, Array<tvm::Tensor>, Graph>
@@ -293,6 +401,7 @@ class CompileEngine {
     auto gf = tvm::make_node<GraphFuncNode>();
     gf->target = target;
     gf->func_name = GetUniqeName(readable_name);
+    readable_names_[gf->func_name] = readable_name;
     gf->inputs = inputs;
     gf->outputs = outputs;
     static const PackedFunc& flower = GetPackedFunc("nnvm.compiler.lower");
@@ -301,6 +410,65 @@ class CompileEngine {
   }
 
  private:
+  // Whether a function can go through the persistent cache. A loaded function
+  // may have to be renamed, which is only safe for a single host function:
+  // device kernels and the packed calls to them are named after it as well.
+  static bool IsPersistable(const GraphFunc& f) {
+    return f->funcs.size() == 1 &&
+        f->funcs[0]->name == f->func_name &&
+        f->funcs[0]->func_type != kDeviceFunc;
+  }
+  // Load a function from the persistent cache, returns an undefined function
+  // on a miss. The function is renamed if its name is taken in this process.
+  GraphFunc LoadPersistent(const std::string& path, const std::string& key) {
+    std::ifstream fs(path, std::ios::in);
+    if (!fs) return GraphFunc();
+    std::map<std::string, std::string> entry;
+    GraphFunc stored;
+    try {
+      dmlc::JSONReader reader(&fs);
+      reader.Read(&entry);
+      if (entry["key"] != key) return GraphFunc();
+      stored = Downcast<GraphFunc>(tvm::LoadJSON(entry["func"]));
+    } catch (const dmlc::Error& e) {
+      LOG(WARNING) << "Ignore corrupted compile cache entry " << path << ": " << e.what();
+      return GraphFunc();
+    }
+    if (!IsPersistable(stored)) return GraphFunc();
+    std::string name = GetUniqeName(entry["name"]);
+    if (name == stored->func_name) return stored;
+    auto gf = tvm::make_node<GraphFuncNode>(*stored.operator->());
+    gf->func_name = name;
+    auto n = tvm::make_node<LoweredFuncNode>(*stored->funcs[0].operator->());
+    n->name = name;
+    gf->funcs = Array<LoweredFunc>({LoweredFunc(n)});
+    return GraphFunc(gf);
+  }
+  // Write a function to the persistent cache. The entry is renamed into
+  // place, so concurrent builds never observe a partial file.
+  void SavePersistent(const std::string& path, const std::string& key,
+                      const GraphFunc& f) {
+    std::map<std::string, std::string> entry;
+    entry["key"] = key;
+    entry["name"] = readable_names_[f->func_name];
+    entry["func"] = tvm::SaveJSON(f);
+    std::ostringstream tmp_path;
+    tmp_path << path << ".tmp"
+             << std::hash<std::thread::id>()(std::this_thread::get_id());
+    {
+      std::ofstream fs(tmp_path.str(), std::ios::out);
+      if (!fs) {
+        LOG(WARNING) << "Cannot write compile cache entry " << tmp_path.str();
+        return;
+      }
+      dmlc::JSONWriter writer(&fs);
+      writer.Write(entry);
+    }
+    if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+      LOG(WARNING) << "Cannot write compile cache entry " << path;
+      std::remove(tmp_path.str().c_str());
+    }
+  }
   // Get unique name
   std::string GetUniqeName(std::string name) {
     while (true) {
@@ -322,9 +490,18 @@ class CompileEngine {
   std::mutex mutex_;
   // the name map
   std::unordered_map<std::string, int> name_map_;
+  // the readable name each unique name was derived from
+  std::unordered_map<std::string, std::string> readable_names_;
   // the compiler cache
   std::unordered_map<GraphKey, GraphCacheEntry,
                      GraphKeyHash, GraphKeyEqual> cache_;
+  // directory of the persistent cache, empty if disabled
+  std::string cache_dir_;
+  // key suffix of the persistent cache
+  std::string cache_salt_;
+  // persistent cache statistics
+  size_t disk_hits_{0};
+  size_t disk_misses_{0};
 };
 
 GraphFunc GraphLower(Graph graph,
@@ -357,6 +534,16 @@ TVM_REGISTER_GLOBAL("nnvm.compiler.SetCacheItem")
     CompileEngine::Global()->Set(args[0], args[1]);
   });
 
+TVM_REGISTER_GLOBAL("nnvm.compiler.SetPersistentCache")
+.set_body([](tvm::runtime::TVMArgs args, tvm::runtime::TVMRetValue *rv) {
+    CompileEngine::Global()->SetPersistentCache(args[0], args[1]);
+  });
+
+TVM_REGISTER_GLOBAL("nnvm.compiler.PersistentCacheStats")
+.set_body([](tvm::runtime::TVMArgs args, tvm::runtime::TVMRetValue *rv) {
+    *rv = CompileEngine::Global()->PersistentCacheStats(args[0]);
+  });
+
 TVM_REGISTER_GLOBAL("nnvm.compiler.GraphKeyGetGraph")
 .set_body([](tvm::runtime::TVMArgs args, tvm::runtime::TVMRetValue *rv) {
     *rv = args[0].operator GraphKey()->graph;
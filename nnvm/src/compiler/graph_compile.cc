@@ -35,6 +35,12 @@
 #include <tvm/lowered_func.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "compile_engine.h"
 #include "graph_fuse.h"
 #include "graph_runtime.h"
@@ -47,12 +53,14 @@ using namespace tvm;
 
 // Decorate the result of PlanMemory
 // This function does two things:
-// - Give separate memory to each variable.
+// - Give separate memory to each variable, except that the variables
+//   of aliased params share the memory of the param they alias.
 // - Tie the memory of output/lhs in assign node properly
 //   so the execution of assign can have side effect.
 nnvm::Graph DecorateMemoryPlan(
     nnvm::Graph g,
-    const std::vector<int>& assign_flag) {
+    const std::vector<int>& assign_flag,
+    const std::unordered_map<std::string, std::string>& param_alias) {
   const IndexedGraph& idx = g.indexed_graph();
   StorageVector storage_vec = g.MoveCopyAttr<StorageVector>("storage_id");
   g.attrs.erase("storage_allocated_bytes");
@@ -67,8 +75,40 @@ nnvm::Graph DecorateMemoryPlan(
   for (size_t i = 0; i < storage_vec.size(); ++i) {
     max_id = std::max(storage_vec[i] + 1, max_id);
   }
+  const DeviceVector* device_vec = nullptr;
+  if (g.HasAttr("device_index")) {
+    device_vec = &g.GetAttr<DeviceVector>("device_index");
+  }
+  // Variables mutated by assign keep a memory of their own.
+  std::unordered_set<uint32_t> assigned;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    if (assign_flag[nid] != 0) assigned.insert(idx[nid].inputs[0].node_id);
+  }
+  std::unordered_set<std::string> alias_targets;
+  for (const auto& kv : param_alias) {
+    alias_targets.insert(kv.second);
+  }
+  std::unordered_map<std::string, int> param_storage;
   for (uint32_t nid : idx.input_nodes()) {
-    storage_vec[idx.entry_id(nid, 0)] = max_id++;
+    uint32_t eid = idx.entry_id(nid, 0);
+    const std::string& name = idx[nid].source->attrs.name;
+    auto it = param_alias.find(name);
+    if (assigned.count(nid) ||
+        (it == param_alias.end() && !alias_targets.count(name))) {
+      storage_vec[eid] = max_id++;
+      continue;
+    }
+    // Aliases can only share memory on the same device.
+    std::ostringstream key;
+    key << (it != param_alias.end() ? it->second : name);
+    if (device_vec != nullptr) key << '@' << (*device_vec)[eid];
+    auto sit = param_storage.find(key.str());
+    if (sit != param_storage.end()) {
+      storage_vec[eid] = sit->second;
+    } else {
+      storage_vec[eid] = max_id++;
+      param_storage[key.str()] = storage_vec[eid];
+    }
   }
   // Tie up the assign node storage properly.
   for (uint32_t nid = 0 ; nid < idx.num_nodes(); ++nid) {
@@ -113,6 +153,15 @@ nnvm::Graph GraphCompile(const nnvm::Graph& g) {
   if (g.HasAttr("target_host")) {
     target_host = g.GetAttr<std::string>("target_host");
   }
+  // Params aliased by DedupParams, as a flat list of (alias, param) pairs.
+  std::unordered_map<std::string, std::string> param_alias;
+  if (g.HasAttr("param_alias")) {
+    const auto& alias = g.GetAttr<std::vector<std::string> >("param_alias");
+    CHECK_EQ(alias.size() % 2, 0U);
+    for (size_t i = 0; i < alias.size(); i += 2) {
+      param_alias[alias[i]] = alias[i + 1];
+    }
+  }
   // Specially handle assign.
   const nnvm::Op* assign_op = nnvm::Op::Get("_assign");
 
@@ -333,7 +382,7 @@ nnvm::Graph GraphCompile(const nnvm::Graph& g) {
 
   ret.attrs["module"] = std::make_shared<any>(std::move(module));
   ret = nnvm::ApplyPass(ret, "PlanMemory");
-  ret = DecorateMemoryPlan(ret, assign_flag);
+  ret = DecorateMemoryPlan(ret, assign_flag, param_alias);
   return ret;
 }
 
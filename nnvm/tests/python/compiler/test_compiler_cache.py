@@ -16,7 +16,7 @@
 # under the License.
 import numpy as np
 import tvm
-from tvm.contrib import graph_runtime
+from tvm.contrib import graph_runtime, util
 import nnvm.symbol as sym
 import nnvm.compiler
 import nnvm.compiler.build_module as build_module
@@ -59,5 +59,52 @@ def test_compile_cache():
     engine.clear_cache()
     engine[gkey] = gf
 
+
+def test_persistent_cache():
+    shape = (10, 1)
+    dtype = "float32"
+    shape_dict = {"data": shape, "bias": shape}
+    stats = tvm.get_global_func("nnvm.compiler.PersistentCacheStats")
+
+    def block(data, bias, name):
+        return sym.exp(sym.elemwise_add(data, bias, name=name + "_add"), name=name + "_exp")
+
+    def build(net, cache_dir):
+        nnvm.compiler.engine.clear_cache()
+        stats(True)
+        # without fusion every operator is a cached function of its own
+        with nnvm.compiler.build_config(opt_level=0, compile_cache_dir=cache_dir):
+            graph, lib, _ = nnvm.compiler.build(net, "llvm", shape_dict)
+        return graph, lib, [x.value for x in stats(True)]
+
+    data = sym.Variable("data")
+    bias = sym.Variable("bias")
+    cache_dir = util.tempdir().relpath("compile_cache")
+    _, _, (hits, misses) = build(block(data, bias, "a"), cache_dir)
+    assert hits == 0 and misses > 0
+    # a variant with differently named copies of the same block
+    net = block(block(data, bias, "b"), bias, "c")
+    graph, lib, (hits, misses) = build(net, cache_dir)
+    assert hits > 0 and misses == 0
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    na = np.random.uniform(size=shape).astype(dtype)
+    nb = np.random.uniform(size=shape).astype(dtype)
+    m.run(data=na, bias=nb)
+    out = m.get_output(0, tvm.nd.empty(shape, dtype))
+    tvm.testing.assert_allclose(out.asnumpy(), np.exp(np.exp(na + nb) + nb), rtol=1e-5)
+    # the cache is not used without a directory
+    _, _, (hits, misses) = build(net, None)
+    assert hits == 0 and misses == 0
+    # nor is code cached by another build of the libraries or the operators
+    build_id = nnvm.compiler.build_module._build_id()
+    nnvm.compiler.build_module._BUILD_ID[:] = ["another build"]
+    try:
+        _, _, (hits, misses) = build(net, cache_dir)
+    finally:
+        nnvm.compiler.build_module._BUILD_ID[:] = [build_id]
+    assert hits == 0 and misses > 0
+
+
 if __name__ == "__main__":
     test_compile_cache()
+    test_persistent_cache()
@@ -0,0 +1,63 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+import tvm
+from tvm import relay
+from tvm.contrib import graph_runtime
+import nnvm.symbol as sym
+import nnvm.compiler
+
+
+def test_dedup_params():
+    shape = (4, 8)
+    dtype = "float32"
+    x = sym.Variable("x")
+    net = x
+    for name in ["w0", "w1", "w2", "w3"]:
+        net = sym.elemwise_add(net, sym.Variable(name))
+    shared = np.random.uniform(size=shape).astype(dtype)
+    other = np.random.uniform(size=shape).astype(dtype)
+    params = {"w0": shared, "w1": other, "w2": shared.copy(), "w3": shared.copy()}
+    params = {k: tvm.nd.array(v) for k, v in params.items()}
+    full_params = dict(params)
+    graph, lib, new_params = nnvm.compiler.build(net, "llvm", {"x": shape}, params=params)
+    assert sorted(new_params.keys()) == ["w0", "w1"]
+    # the aliases are planned into the storage of w0
+    index = graph.index
+    storage = graph.json_attr("storage_id")
+    sid = {name: storage[index.entry_id(name)] for name in index.input_names}
+    assert sid["w0"] == sid["w2"] == sid["w3"]
+    assert sid["w0"] != sid["w1"] and sid["w0"] != sid["x"]
+
+    data = np.random.uniform(size=shape).astype(dtype)
+    expected = data + 3 * shared + other
+    # params saved with or without the duplicates load the same
+    for blob in [relay.save_param_dict(new_params),
+                 relay.save_param_dict(full_params)]:
+        m = graph_runtime.create(graph, lib, tvm.cpu(0))
+        m.load_params(bytearray(blob))
+        m.run(x=data)
+        out = m.get_output(0, tvm.nd.empty(shape, dtype))
+        tvm.testing.assert_allclose(out.asnumpy(), expected, rtol=1e-5)
+
+    with nnvm.compiler.build_config(opt_level=1):
+        _, _, new_params = nnvm.compiler.build(net, "llvm", {"x": shape}, params=full_params)
+    assert len(new_params) == 4
+
+
+if __name__ == "__main__":
+    test_dedup_params()
@@ -19,9 +19,16 @@
 Database of MeasureInput/MeasureResult pair.
 This can be used for replaying measurement.
 """
+import json
+import math
 import os
+import struct
 
-from .record import encode, decode, measure_str_key
+import numpy as np
+
+from .record import encode, decode, measure_str_key, load_from_file
+from .task.dispatcher import DispatchContext
+from .task.space import ReferenceConfigEntity
 
 
 class Database(object):
@@ -194,3 +201,313 @@ class DummyDatabase(RedisDatabase):
 
     def flush(self):
         self.db = {}
+
+
+class IndexedDatabase(Database):
+    """
+    A tuning log database stored in a binary file with a persistent index.
+
+    Records are appended to the file as length prefixed rows of the json log
+    format. The index file next to it maps every (target key, workload) to the
+    offset of its best record, so opening the database and looking up the best
+    config do not parse the records. The offsets of all the records of a config,
+    used by `load`, are only collected on the first call. Workloads without a
+    record can be matched to the nearest tuned workload of the same operator,
+    see `nearest`.
+
+    Parameters
+    ----------
+    path: str
+        The filename of the records. The index is stored in path + ".idx".
+    """
+    MAGIC = b"TVMTUNE\x02"
+    INDEX_VERSION = 2
+    _LEN = struct.Struct("<I")
+
+    def __init__(self, path):
+        self.path = path
+        self._file = open(path, "a+b")
+        self._file.seek(0, os.SEEK_END)
+        if self._file.tell() == 0:
+            self._file.write(IndexedDatabase.MAGIC)
+            self._file.flush()
+        else:
+            self._file.seek(0)
+            if self._file.read(len(IndexedDatabase.MAGIC)) != IndexedDatabase.MAGIC:
+                raise RuntimeError("%s is not a tuning database" % path)
+        # (target key, workload) -> (offset, mean cost) of the best record
+        self._best = {}
+        # measure_str_key -> offsets of all the records of a config, None until used
+        self._records = None
+        self._groups = None
+        if not self._load_index():
+            self._rebuild_index()
+
+    def _index_path(self):
+        return self.path + ".idx"
+
+    def _size(self):
+        self._file.seek(0, os.SEEK_END)
+        return self._file.tell()
+
+    def _load_index(self):
+        """Load the index file, fails if it does not cover the records"""
+        if not os.path.isfile(self._index_path()):
+            return False
+        with open(self._index_path(), "r") as fin:
+            try:
+                index = json.load(fin)
+            except ValueError:
+                return False
+        if not isinstance(index, dict) or \
+                index.get("version") != IndexedDatabase.INDEX_VERSION or \
+                index.get("size") != self._size():
+            return False
+        self._best = {(str(tgt_key), _to_tuple(wkl)): (offset, cost)
+                      for tgt_key, wkl, offset, cost in index["best"]}
+        return True
+
+    def _rebuild_index(self):
+        """Scan all the records, used when the index is missing or stale"""
+        self._best, self._records, self._groups = {}, None, None
+        size = self._size()
+        offset = len(IndexedDatabase.MAGIC)
+        while offset < size:
+            inp, res, next_offset = self._read(offset)
+            if next_offset is None:
+                # drop a record truncated by an interrupted write
+                self._file.truncate(offset)
+                break
+            self._add_to_index(inp, res, offset, False)
+            offset = next_offset
+        self.commit()
+
+    def _read(self, offset):
+        """Read the record at offset, returns (inp, res, offset of the next record)"""
+        self._file.seek(offset)
+        header = self._file.read(IndexedDatabase._LEN.size)
+        if len(header) < IndexedDatabase._LEN.size:
+            return None, None, None
+        length = IndexedDatabase._LEN.unpack(header)[0]
+        payload = self._file.read(length)
+        if len(payload) < length:
+            return None, None, None
+        inp, res = decode(payload.decode("utf-8"))
+        return inp, res, offset + IndexedDatabase._LEN.size + length
+
+    @staticmethod
+    def _target_keys(tgt):
+        keys = list(tgt.keys)
+        if tgt.model != "unknown":
+            keys.insert(0, tgt.model)
+        return keys
+
+    def _add_to_index(self, inp, res, offset, extend):
+        if self._records is not None:
+            str_key = measure_str_key(inp)
+            if extend:
+                self._records.setdefault(str_key, []).append(offset)
+            else:
+                self._records[str_key] = [offset]
+        if res.error_no != 0:
+            return
+        cost = float(np.mean(res.costs))
+        for k in self._target_keys(inp.target):
+            key = (k, inp.task.workload)
+            if key not in self._best or self._best[key][1] > cost:
+                self._best[key] = (offset, cost)
+                self._groups = None
+
+    def _scan_records(self):
+        """Collect the offsets of the records of every config"""
+        self._records = {}
+        size = self._size()
+        offset = len(IndexedDatabase.MAGIC)
+        while offset < size:
+            inp, _, next_offset = self._read(offset)
+            if next_offset is None:
+                break
+            self._records.setdefault(measure_str_key(inp), []).append(offset)
+            offset = next_offset
+
+    def load(self, inp, get_all=False):
+        if self._records is None:
+            self._scan_records()
+        offsets = self._records.get(measure_str_key(inp), None)
+        if offsets is None:
+            return None
+        results = [self._read(x)[1] for x in offsets]
+        if get_all:
+            return results
+        return max(results, key=lambda result: result.timestamp)
+
+    def save(self, inp, res, extend=False):
+        payload = encode(inp, res).encode("utf-8")
+        offset = self._size()
+        self._file.write(IndexedDatabase._LEN.pack(len(payload)) + payload)
+        self._add_to_index(inp, res, offset, extend)
+
+    def import_log(self, records):
+        """Add records to the database
+
+        Parameters
+        ----------
+        records : str or iterator of (MeasureInput, MeasureResult)
+            The filename of a json log file, or the records
+        """
+        if isinstance(records, str):
+            records = load_from_file(records)
+        for inp, res in records:
+            self.save(inp, res)
+        self.commit()
+
+    def query_best(self, target, workload):
+        """Get the best record of a workload in constant time
+
+        Parameters
+        ----------
+        target: Target
+            The target
+        workload: Workload
+            The workload
+
+        Returns
+        -------
+        rec: (MeasureInput, MeasureResult) or None
+        """
+        for k in self._target_keys(target):
+            if (k, workload) in self._best:
+                inp, res, _ = self._read(self._best[(k, workload)][0])
+                return inp, res
+        return None
+
+    def nearest(self, target, workload, k=1):
+        """Get the best records of the tuned workloads nearest to workload.
+
+        Two workloads are comparable if they only differ in their integer
+        fields, such as shapes, strides and paddings. The distance is the sum
+        of the differences of the integers in a log scale which keeps their
+        sign, so an exact match has distance 0 and is returned first.
+
+        Parameters
+        ----------
+        target: Target
+            The target
+        workload: Workload
+            The workload
+        k: int
+            The maximum number of records
+
+        Returns
+        -------
+        recs: List of (MeasureInput, MeasureResult)
+            The best record of each of the k nearest workloads
+        """
+        if self._groups is None:
+            self._groups = {}
+            for (tgt_key, wkl), (offset, _) in self._best.items():
+                sig, values = _workload_signature(wkl)
+                self._groups.setdefault((tgt_key, sig), []).append((values, offset))
+
+        sig, values = _workload_signature(workload)
+        for tgt_key in self._target_keys(target):
+            candidates = self._groups.get((tgt_key, sig), [])
+            if not candidates:
+                continue
+            dist = [sum(abs(_log_scale(a) - _log_scale(b))
+                        for a, b in zip(values, other)) for other, _ in candidates]
+            order = np.argsort(dist, kind="mergesort")[:k]
+            return [self._read(candidates[i][1])[:2] for i in order]
+        return []
+
+    def commit(self):
+        """Write the index file of the records saved so far"""
+        self._file.flush()
+        tmp = self._index_path() + ".tmp"
+        best = [(tgt_key, wkl, offset, cost)
+                for (tgt_key, wkl), (offset, cost) in self._best.items()]
+        with open(tmp, "w") as fout:
+            json.dump({"version": IndexedDatabase.INDEX_VERSION, "size": self._size(),
+                       "best": best}, fout)
+        os.rename(tmp, self._index_path())
+
+    def close(self):
+        """Commit the index and close the database"""
+        if not self._file.closed:
+            self.commit()
+            self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, ptype, value, trace):
+        self.close()
+
+
+def _to_tuple(x):
+    """Convert the lists of a json value to tuples, as in the workloads"""
+    if isinstance(x, list):
+        return tuple(_to_tuple(a) for a in x)
+    return x
+
+
+def _log_scale(x):
+    """log(1 + |x|) with the sign of x"""
+    return math.copysign(math.log1p(abs(x)), x)
+
+
+def _workload_signature(workload):
+    """Split a workload into its non-integer structure and its integer fields"""
+    values = []
+
+    def _sig(x):
+        if isinstance(x, (tuple, list)):
+            return tuple(_sig(a) for a in x)
+        if isinstance(x, (int, np.integer)) and not isinstance(x, bool):
+            values.append(int(x))
+            return "#"
+        return x
+
+    return _sig(workload), values
+
+
+class ApplyDatabaseBest(DispatchContext):
+    """
+    Apply the best configs of an IndexedDatabase.
+
+    Parameters
+    ----------
+    db: IndexedDatabase
+        The database
+    nearest: bool
+        Whether a workload without record uses a config mimicking the best
+        config of its nearest tuned workload, instead of the fallback config.
+    """
+    def __init__(self, db, nearest=True):
+        super(ApplyDatabaseBest, self).__init__()
+        self.db = db
+        self.nearest = nearest
+        self._cache = {}
+
+    def _query_inside(self, target, workload):
+        if target is None:
+            raise RuntimeError("Need a target context to find the history best. "
+                               "Hint: If your target is llvm, use `with tvm.target.create('llvm'):`"
+                               " above the dispatcher call. So does other target. ")
+        key = (str(target), workload)
+        if key in self._cache:
+            return self._cache[key]
+
+        cfg = None
+        rec = self.db.query_best(target, workload)
+        if rec is not None:
+            cfg = rec[0].config
+        elif self.nearest:
+            recs = self.db.nearest(target, workload)
+            if recs:
+                cfg = ReferenceConfigEntity(recs[0][0].config)
+        self._cache[key] = cfg
+        return cfg
+
+    def update(self, target, workload, cfg):
+        self._cache[(str(target), workload)] = cfg
@@ -290,10 +290,13 @@ e.g. python -m tvm.autotvm.record --mode pick --i collect.log
 
 * Split a log file into separate files, each of which contains only a single wkl
 e.g. python -m tvm.autotvm.record --mode split --i collect.log
+
+* Convert a log file to an indexed database
+e.g. python -m tvm.autotvm.record --mode index --i collect.log --o collect.db
 """
 if __name__ == '__main__':
     parser = argparse.ArgumentParser()
-    parser.add_argument("--mode", choices=['read', 'pick', 'split'], default='read')
+    parser.add_argument("--mode", choices=['read', 'pick', 'split', 'index'], default='read')
     parser.add_argument("--i", type=str, help="input file")
     parser.add_argument("--o", type=str, default=None, help='output file')
     parser.add_argument("--begin", type=int, default=0)
@@ -327,3 +330,7 @@ if __name__ == '__main__':
                         print(func.imported_modules[0].get_source())
     elif args.mode == 'split':
         split_workload(args.i)
+    elif args.mode == 'index':
+        from .database import IndexedDatabase
+        with IndexedDatabase(args.o or args.i + ".db") as db:
+            db.import_log(args.i)
@@ -28,6 +28,8 @@ from .code_hash import attach_code_hash, attach_code_hash_to_arg
 from .dispatcher import dispatcher, DispatchContext, ApplyConfig, ApplyHistoryBest, \
     FallbackContext, clear_fallback_cache, ApplyGraphBest
 
+from .auto_schedule import auto_schedule, create_auto_task, tuned_auto_schedule
 from .topi_integration import register_topi_compute, register_topi_schedule, \
     TaskExtractEnv
-from .relay_integration import extract_from_program, extract_from_multiple_program
+from .relay_integration import extract_from_program, extract_from_multiple_program, \
+    extract_auto_tasks
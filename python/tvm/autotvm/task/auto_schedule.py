@@ -0,0 +1,329 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=invalid-name
+"""Template-free schedule search for CPU.
+
+Instead of a hand-written template, the tuning space is derived from the
+compute DAG: injective stages are inlined into their consumers, every
+reduction gets a multi-level tiling of its spatial and reduce axes and is
+fused into its injective epilogue (or a write cache), and the remaining
+injective outputs are flattened, parallelized and vectorized. The decisions
+are ordinary knobs of a ConfigSpace, so the usual tuners, measurers and
+dispatch contexts apply to the generated space.
+
+The CPU schedules of fused injective and reduction ops opt in through
+tuned_auto_schedule: they keep their hand-written schedule unless a tuned
+record of the DAG is applied. Such DAGs are extracted from a relay program
+as tuning tasks by extract_auto_tasks.
+"""
+import hashlib
+
+from ... import tensor, target as _target
+from ..util import get_const_int, get_func_name
+from .dispatcher import DispatchContext, ApplyConfig, ApplyGraphBest, FallbackContext
+from .task import TASK_TABLE, register, create
+from .topi_integration import TaskExtractEnv
+
+# the DAGs of the fused ops traced from relay programs, by their workload hash
+_DAG_TABLE = {}
+
+
+def _post_order(outs):
+    """Get the compute ops in post order and the consumers of every op"""
+    ops, consumers, visited = [], {}, set()
+
+    def _visit(op):
+        if op in visited:
+            return
+        visited.add(op)
+        for t in op.input_tensors:
+            consumers.setdefault(t.op, []).append(op)
+            _visit(t.op)
+        if isinstance(op, tensor.ComputeOp):
+            ops.append(op)
+
+    for t in outs:
+        _visit(t.op)
+    return ops, consumers
+
+
+def _workload(ops):
+    """The workload of a DAG is a hash of its op bodies, shapes and dtypes"""
+    md5 = hashlib.md5()
+    for op in ops:
+        md5.update(str(op.body).encode("utf-8"))
+        for t in list(op.input_tensors) + [op.output(i) for i in range(op.num_outputs)]:
+            md5.update(str((t.op.name, [get_const_int(x) for x in t.shape],
+                            t.dtype)).encode("utf-8"))
+    return ("auto_schedule", md5.hexdigest())
+
+
+def _extents(axes):
+    return [get_const_int(ax.dom.extent) for ax in axes]
+
+
+def _tile_spatial(cfg, s, stage, axes, idx):
+    """Split every spatial axis in three levels with the knobs of anchor idx"""
+    tiles = [cfg["tile_%d_s%d" % (idx, i)].apply(s, stage, ax) for i, ax in enumerate(axes)]
+    return [[t[level] for t in tiles] for level in range(3)]
+
+
+def _schedule_root_injective(cfg, s, op, idx):
+    """Flatten an injective stage, parallelize the outer and vectorize the inner part"""
+    stage = s[op]
+    if not stage.op.axis:
+        return
+    fused = stage.fuse(*stage.op.axis) if len(stage.op.axis) > 1 else stage.op.axis[0]
+    total = 1
+    for extent in _extents(stage.op.axis):
+        total *= extent
+    cfg.define_split("tile_%d" % idx, cfg.axis(total), num_outputs=2,
+                     filter=lambda x: x.size[-1] <= 64)
+    if cfg.is_fallback:
+        cfg.fallback_split("tile_%d" % idx, [-1, 16])
+    outer, inner = cfg["tile_%d" % idx].apply(s, op, fused)
+    stage.parallel(outer)
+    stage.vectorize(inner)
+
+
+def _schedule_reduction(cfg, s, op, consumer, idx):
+    """Tile a reduction, and compute it inside the tiles of consumer if given"""
+    spatial, reduce_axes = list(s[op].op.axis), list(s[op].op.reduce_axis)
+    for i, ax in enumerate(spatial):
+        cfg.define_split("tile_%d_s%d" % (idx, i), ax, num_outputs=3,
+                         filter=lambda x: x.size[-1] <= 64)
+    for i, ax in enumerate(reduce_axes):
+        cfg.define_split("tile_%d_r%d" % (idx, i), ax, num_outputs=2)
+    cfg.define_knob("auto_unroll_%d" % idx, [0, 16, 64, 512])
+    if cfg.is_fallback:
+        for i in range(len(spatial)):
+            cfg.fallback_split("tile_%d_s%d" % (idx, i),
+                               [-1, -1, 16] if i == len(spatial) - 1 else [-1, 4, 1])
+        for i in range(len(reduce_axes)):
+            cfg.fallback_split("tile_%d_r%d" % (idx, i), [-1, 4])
+        cfg["auto_unroll_%d" % idx] = cfg.space_map["auto_unroll_%d" % idx][2]
+
+    reduce_tiles = [cfg["tile_%d_r%d" % (idx, i)].apply(s, op, ax)
+                    for i, ax in enumerate(reduce_axes)]
+    r0 = [t[0] for t in reduce_tiles]
+    r1 = [t[1] for t in reduce_tiles]
+
+    if not spatial:
+        # a full reduction to a scalar has nothing to parallelize or vectorize
+        s[op].reorder(*(r0 + r1))
+        s[op].pragma(r0[0], "auto_unroll_max_step", cfg["auto_unroll_%d" % idx].val)
+        s[op].pragma(r0[0], "unroll_explicit", True)
+        return
+    if consumer is None:
+        s0, s1, s2 = _tile_spatial(cfg, s, op, spatial, idx)
+        s[op].reorder(*(s0 + s1 + r0 + r1 + s2))
+        outer = s[op].fuse(*s0) if len(s0) > 1 else s0[0]
+        inner = s2[-1]
+        root = s[op]
+    else:
+        root = s[consumer]
+        s0, s1, s2 = _tile_spatial(cfg, s, consumer, list(root.op.axis), idx)
+        root.reorder(*(s0 + s1 + s2))
+        outer = root.fuse(*s0) if len(s0) > 1 else s0[0]
+        root.vectorize(s2[-1])
+        s[op].compute_at(root, s1[-1])
+        inner_spatial = list(s[op].op.axis)
+        s[op].reorder(*(r0 + r1 + inner_spatial))
+        inner = inner_spatial[-1]
+    root.parallel(outer)
+    s[op].vectorize(inner)
+    root.pragma(outer, "auto_unroll_max_step", cfg["auto_unroll_%d" % idx].val)
+    root.pragma(outer, "unroll_explicit", True)
+
+
+def auto_schedule(outs):
+    """Create a tunable CPU schedule for outs without a template.
+
+    The config of the schedule is queried from the current dispatch context
+    with a workload hashed from the compute DAG, so the function can be used
+    as the schedule of a tuning task as well as the schedule of an op under
+    ApplyHistoryBest.
+
+    Parameters
+    ----------
+    outs: Array of Tensor
+        The output tensors of the computation.
+
+    Returns
+    -------
+    s: Schedule
+        The schedule.
+    """
+    outs = [outs] if isinstance(outs, tensor.Tensor) else list(outs)
+    ops, consumers = _post_order(outs)
+    cfg = DispatchContext.current.query(_target.current_target(allow_none=True), _workload(ops))
+    return _apply(cfg, outs, ops, consumers)
+
+
+def _apply(cfg, outs, ops, consumers):
+    """Schedule the DAG of outs with the knobs of cfg"""
+    s = tensor.create_schedule([x.op for x in outs])
+    out_ops = set(x.op for x in outs)
+
+    def _is_injective(op):
+        return op.num_outputs == 1 and not op.reduce_axis
+
+    # inline the injective stages which only feed other compute stages
+    inlined = set()
+    for op in ops:
+        users = consumers.get(op, [])
+        if op not in out_ops and _is_injective(op) and \
+                all(isinstance(u, tensor.ComputeOp) for u in users):
+            s[op].compute_inline()
+            inlined.add(op)
+
+    def _users(op):
+        """The consumers of op once the inlined stages are removed"""
+        ret = []
+        for u in consumers.get(op, []):
+            for v in (_users(u) if u in inlined else [u]):
+                if v not in ret:
+                    ret.append(v)
+        return ret
+
+    attached = set()
+    for idx, op in enumerate(ops):
+        if not op.reduce_axis or op.num_outputs != 1:
+            continue
+        users = _users(op)
+        consumer = None
+        # a full reduction to a 0-d tensor is scheduled on its own
+        if op.axis and op in out_ops:
+            cfg.define_knob("cache_write_%d" % idx, [0, 1])
+            if cfg["cache_write_%d" % idx].val:
+                cached = s.cache_write(op.output(0), "global")
+                attached.add(op)
+                consumer, op = op, cached.op
+        elif op.axis and len(users) == 1 and users[0] in out_ops and \
+                _is_injective(users[0]) and users[0] not in attached and \
+                _extents(users[0].axis) == _extents(op.axis):
+            consumer = users[0]
+            attached.add(consumer)
+        _schedule_reduction(cfg, s, op, consumer, idx)
+
+    # the injective stages left at root
+    for idx, op in enumerate(ops):
+        if op in attached or op in inlined or op.reduce_axis or op.num_outputs != 1:
+            continue
+        if op in out_ops or not all(isinstance(u, tensor.ComputeOp)
+                                    for u in consumers.get(op, [])):
+            _schedule_root_injective(cfg, s, op, idx)
+    return s
+
+
+def tuned_auto_schedule(outs):
+    """Schedule outs with auto_schedule if a tuned config of the DAG is applied.
+
+    This is the opt-in hook of the CPU schedules of fused ops. Only the
+    contexts applying tuning records are queried, so a DAG without record
+    keeps the schedule of the caller. While tasks are traced by
+    extract_auto_tasks, the DAG is collected as a tuning task instead.
+
+    Parameters
+    ----------
+    outs: Array of Tensor
+        The output tensors of the computation.
+
+    Returns
+    -------
+    s: Schedule or None
+        The schedule, or None if the caller should use its own schedule.
+    """
+    outs = [outs] if isinstance(outs, tensor.Tensor) else list(outs)
+    ops, consumers = _post_order(outs)
+    if not ops:
+        return None
+    workload = _workload(ops)
+
+    env = TaskExtractEnv.current
+    if env is not None and env.trace_auto_schedule:
+        _DAG_TABLE[workload[1]] = outs
+        key = ("auto_schedule.relay", (workload[1],))
+        if env.allow_duplicate or key not in env.task_collection:
+            env.task_collection.append(key)
+        return None
+
+    target = _target.current_target(allow_none=True)
+    if target is None:
+        return None
+    # pylint: disable=protected-access
+    ctx = DispatchContext.current
+    while not isinstance(ctx, FallbackContext):
+        # ApplyConfig holds the config of the template being measured and
+        # ApplyGraphBest hands out its configs in order, so neither is asked
+        if not isinstance(ctx, (ApplyConfig, ApplyGraphBest)):
+            cfg = ctx._query_inside(target, workload)
+            if cfg is not None and not cfg.is_fallback:
+                return _apply(cfg, outs, ops, consumers)
+        ctx = ctx._old_ctx
+    return None
+
+
+@register("auto_schedule.relay")
+def _relay_task(key):
+    """The task function of a DAG traced from a relay program"""
+    outs = _DAG_TABLE[key]
+    inputs, visited = [], set()
+
+    def _visit(op):
+        if op in visited:
+            return
+        visited.add(op)
+        for t in op.input_tensors:
+            _visit(t.op)
+        if isinstance(op, tensor.PlaceholderOp):
+            inputs.append(op.output(0))
+
+    for t in outs:
+        _visit(t.op)
+    return auto_schedule(outs), inputs + outs
+
+
+def create_auto_task(compute_func, args, target, target_host=None):
+    """Create a tuning task whose schedule is searched by auto_schedule
+
+    Parameters
+    ----------
+    compute_func: callable
+        The function declaring the computation. It takes args and returns the
+        list of input and output tensors, the outputs are the tensors which are
+        not placeholders.
+    args : List
+        Positional arguments of compute_func
+    target : Target
+        The compilation target
+    target_host: Target, optional
+        The compilation target for host side
+
+    Returns
+    -------
+    tsk: Task
+        a task object
+    """
+    func_name = "auto_schedule." + get_func_name(compute_func)
+    if func_name not in TASK_TABLE:
+        def _task_func(*task_args):
+            arg_bufs = compute_func(*task_args)
+            outs = [t for t in arg_bufs if not isinstance(t.op, tensor.PlaceholderOp)]
+            return auto_schedule(outs), arg_bufs
+        register(func_name, func=_task_func)
+    return create(func_name, args, target, target_host)
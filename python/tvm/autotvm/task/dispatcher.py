@@ -37,7 +37,7 @@ from decorator import decorate
 
 from tvm import target as _target
 
-from .space import FallbackConfigEntity
+from .space import FallbackConfigEntity, ReferenceConfigEntity
 
 logger = logging.getLogger('autotvm')
 
@@ -210,6 +210,11 @@ def dispatcher(fworkload):
         tgt = _target.current_target()
         workload = func(*args, **kwargs)
         cfg = DispatchContext.current.query(tgt, workload)
+        if isinstance(cfg, ReferenceConfigEntity) and cfg.template_key not in dispatch_dict:
+            # the reference was tuned with a template this dispatcher does not have,
+            # keep the fallback in the context so the schedule gets the same config
+            cfg = FallbackConfigEntity()
+            DispatchContext.current.update(tgt, workload, cfg)
         if cfg.is_fallback and not cfg.template_key:
             # first try 'direct' template
             if 'direct' in dispatch_dict:
@@ -179,3 +179,52 @@ def extract_from_multiple_program(funcs, params, ops, target, target_host=None,
             logger.warning("Invalid shape during AutoTVM task creation")
 
     return tasks
+
+
+def extract_auto_tasks(func, params, target, target_host=None):
+    """ Extract the fused ops scheduled by auto_schedule from a relay program.
+
+    The program is built with tracing as in extract_from_program, and every
+    fused op whose CPU schedule opts in to tuned_auto_schedule (the injective
+    and reduction ops) becomes a task searched by auto_schedule. Once tuned,
+    the records are picked up by the same schedules under ApplyHistoryBest.
+
+    Parameters
+    ----------
+    func: relay.expr.Function
+        The func to tune
+    params: dict of str to numpy array
+        The associated parameters of the program
+    target: tvm.target.Target
+        The compilation target
+    target_host: tvm.target.Target
+        The host compilation target
+
+    Returns
+    -------
+    task: Array of autotvm.task.Task
+        collected tasks
+    """
+    from tvm import relay
+
+    env = TaskExtractEnv.get()
+    env.reset([], trace_auto_schedule=True)
+    with env:
+        # disable logger temporarily
+        old_state = logger.disabled
+        logger.disabled = True
+
+        relay.backend.compile_engine.get().clear()
+        # wrap build call in thread to avoid multiprocessing problems
+        mod = relay.Module.from_expr(func)
+        build_thread = threading.Thread(target=_lower,
+                                        args=(mod, target, params))
+        build_thread.start()
+        build_thread.join()
+        # the functions lowered while tracing must not be reused once tuned
+        relay.backend.compile_engine.get().clear()
+
+        logger.disabled = old_state
+
+    return [create(task_name, args, target=target, target_host=target_host)
+            for task_name, args in env.get_tasks()]
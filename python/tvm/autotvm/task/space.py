@@ -1061,3 +1061,50 @@ class FallbackConfigEntity(ConfigSpace):
 
     def __repr__(self):
         return "%s,%s,%s" % (str(self._entity_map)[12:-1], self.template_key, self.code_hash)
+
+
+class ReferenceConfigEntity(FallbackConfigEntity):
+    """A fallback config which mimics the knobs of a reference config,
+    typically the tuned config of a similar workload.
+
+    Knobs are copied while the template defines them: a split keeps the
+    inner sizes of the reference split as far as the new extent allows,
+    other knobs are copied if the reference value is in the new space.
+    It is not marked as fallback, so templates do not overwrite the copied
+    knobs with their default values, and it keeps the template key of the
+    reference so a dispatcher picks the same template.
+
+    Parameters
+    ----------
+    ref_config: ConfigEntity
+        The reference config
+    """
+    def __init__(self, ref_config):
+        super(ReferenceConfigEntity, self).__init__()
+        self.ref_config = ref_config
+        self.is_fallback = False
+        self.template_key = ref_config.template_key
+        self.code_hash = ref_config.code_hash
+
+    def _add_new_transform(self, space_class, name, axes, policy, **kwargs):
+        ret = super(ReferenceConfigEntity, self)._add_new_transform(
+            space_class, name, axes, policy, **kwargs)
+        ref = self.ref_config._entity_map.get(name, None)
+        space = self.space_map.get(name, None)
+        if ref is None or space is None:
+            return ret
+
+        if isinstance(space, SplitSpace):
+            if isinstance(ref, SplitEntity) and len(ref.size) == space.num_output:
+                old = self._entity_map[name]
+                self._entity_map[name] = SplitEntity(list(old.size))
+                try:
+                    self.fallback_split(name, [-1] + list(ref.size[1:]))
+                except RuntimeError:
+                    self._entity_map[name] = old
+        else:
+            for entity in space.entities:
+                if repr(entity) == repr(ref):
+                    self._entity_map[name] = entity
+                    break
+        return ret
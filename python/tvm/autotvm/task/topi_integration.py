@@ -134,6 +134,7 @@ class TaskExtractEnv:
         self._register_topi_task()
         self.task_collection = []
         self.wanted_topi_funcs = list(self.topi_to_task.keys())
+        self.trace_auto_schedule = False
         self.modified_funcs = []
 
     def __enter__(self):
@@ -165,6 +166,7 @@ class TaskExtractEnv:
         # revert modification
         for func in self.modified_funcs:
             self.func_to_reflection[func](func)
+        self.trace_auto_schedule = False
 
     def _register_topi_task(self):
         """register tuning wrapper for topi function"""
@@ -296,16 +298,20 @@ class TaskExtractEnv:
             s = topi.generic.schedule_conv2d_NCHWc([C])
             return s, [A, W, C]
 
-    def reset(self, wanted_topi_funcs):
+    def reset(self, wanted_topi_funcs, trace_auto_schedule=False):
         """Reset task collections
 
         Parameters
         ----------
         wanted_topi_funcs: List of function
             The topi function to be extracted
+        trace_auto_schedule: bool
+            Whether the DAGs of the fused ops opting in to auto_schedule are
+            extracted as well
         """
         self.task_collection = []
         self.wanted_topi_funcs = wanted_topi_funcs
+        self.trace_auto_schedule = trace_auto_schedule
 
     def get_tasks(self):
         """Get collected tasks
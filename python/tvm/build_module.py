@@ -145,7 +145,8 @@ class BuildConfig(NodeBase):
         "instrument_bound_checkers": False,
         "disable_select_rewriting": False,
         "disable_vectorize": False,
-        "disable_assert": False
+        "disable_assert": False,
+        "dynamic_shape_buckets": []
     }
     _dump_ir = DumpIR()
 
@@ -251,6 +252,12 @@ def build_config(**kwargs):
 
     dump_pass_ir: dump ir of each pass into file idx_passname_ir.cc, default=False
 
+    dynamic_shape_buckets: list of int, default=[]
+        Extent factors used when relay lowers kernels with dynamic (Any) dimensions.
+        For each factor, a variant that assumes all dynamic dimensions are multiples
+        of the factor is generated, e.g. the vector width. The variants are
+        dispatched at runtime on the actual shape, with the generic kernel as fallback.
+
     Returns
     -------
     config: BuildConfig
@@ -0,0 +1,300 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Ahead-of-time code generation for graphs produced by relay.build.
+
+Instead of interpreting the graph JSON with a graph runtime, the graph is
+turned into C++ source whose run function calls the fused kernels directly,
+with every tensor at a constant offset into one static workspace and the
+parameters placed in read-only data. The source is compiled together with the
+kernel library, e.g. in apps/bundle_deploy.
+"""
+import json
+
+from .._ffi.base import string_types
+from .._ffi.runtime_ctypes import TVMType
+
+# Alignment of tensor data in the workspace and in read-only data.
+_ALIGN = 64
+
+# Context functions called through pointers by kernels built without
+# --system-lib; they are bound at init time when present, as
+# InitContextFunctions in src/runtime/library_module.cc does.
+_CONTEXT_FUNCS = ["TVMFuncCall", "TVMAPISetLastError", "TVMBackendGetFuncFromEnv",
+                  "TVMBackendAllocWorkspace", "TVMBackendFreeWorkspace",
+                  "TVMBackendParallelLaunch", "TVMBackendParallelBarrier"]
+
+
+def _align(value):
+    return (value + _ALIGN - 1) // _ALIGN * _ALIGN
+
+
+def _byte_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in bytearray(data[i:i + 16])) + ",")
+    return "\n".join(lines)
+
+
+def codegen(graph_json, params=None, prefix="tvm_aot"):
+    """Generate C++ source that runs a graph ahead of time.
+
+    The source defines the following functions with C linkage:
+
+    - ``int <prefix>_init()`` binds the runtime context of the kernels and copies
+      the parameters that share storage into the workspace. Call it once.
+    - ``int <prefix>_run()`` runs the graph; returns non-zero on kernel failure.
+    - ``int <prefix>_get_input_index(const char* name)``, -1 if not found or if
+      the input is bound to a parameter, which cannot be overwritten.
+    - ``DLTensor* <prefix>_input(int index)`` and ``DLTensor* <prefix>_output(int index)``
+      give the tensors of the graph inputs that are not parameters and of the
+      outputs, to be filled and read in place.
+
+    Parameters
+    ----------
+    graph_json : str or graph class
+        The graph produced by relay.build.
+
+    params : dict of str to NDArray
+        The parameters produced by relay.build.
+
+    prefix : str
+        The prefix of the generated symbols.
+
+    Returns
+    -------
+    source : str
+        The C++ source.
+    """
+    if not isinstance(graph_json, string_types):
+        try:
+            graph_json = graph_json._tvm_graph_json()
+        except AttributeError:
+            raise ValueError("Type %s is not supported" % type(graph_json))
+    graph = json.loads(graph_json)
+    params = params or {}
+    nodes = graph["nodes"]
+    row_ptr = graph["node_row_ptr"]
+    attrs = graph["attrs"]
+    storage_id = attrs["storage_id"][1]
+    shapes = attrs["shape"][1]
+    dltypes = [TVMType(t) for t in attrs["dltype"][1]]
+    num_entries = row_ptr[-1]
+
+    def entry_id(nid, index):
+        return row_ptr[nid] + index
+
+    # Size of each node entry and of each storage pool entry.
+    entry_bytes = []
+    sid_bytes = {}
+    sid_users = {}
+    for eid in range(num_entries):
+        size = 1
+        for dim in shapes[eid]:
+            size *= dim
+        dtype = dltypes[eid]
+        nbytes = (dtype.bits * dtype.lanes + 7) // 8 * size
+        entry_bytes.append(nbytes)
+        sid = storage_id[eid]
+        sid_bytes[sid] = max(sid_bytes.get(sid, 0), nbytes)
+        sid_users[sid] = sid_users.get(sid, 0) + 1
+
+    # Parameters with storage of their own are used in place from read-only
+    # data; the others are copied into the workspace by init.
+    input_eid = {nodes[nid]["name"]: entry_id(nid, 0) for nid in graph["arg_nodes"]}
+    param_data = {}
+    for name, value in params.items():
+        if name not in input_eid:
+            raise ValueError("Found param for non-existent input: %s" % name)
+        eid = input_eid[name]
+        data = value.asnumpy().tobytes()
+        if len(data) != entry_bytes[eid]:
+            raise ValueError("Param %s has %d bytes, expected %d" %
+                             (name, len(data), entry_bytes[eid]))
+        param_data[eid] = data
+    const_sids = set(storage_id[eid] for eid in param_data
+                     if sid_users[storage_id[eid]] == 1)
+
+    sid_offset = {}
+    workspace_size = 0
+    for sid in sorted(sid_bytes):
+        if sid in const_sids:
+            continue
+        sid_offset[sid] = workspace_size
+        workspace_size = _align(workspace_size + sid_bytes[sid])
+
+    # Tensors, one per node entry and flattening.
+    tensors = []
+    tensor_index = {}
+
+    def get_tensor(eid, flatten):
+        key = (eid, flatten)
+        if key not in tensor_index:
+            shape = list(shapes[eid])
+            if flatten:
+                size = 1
+                for dim in shape:
+                    size *= dim
+                shape = [size]
+            sid = storage_id[eid]
+            if sid in const_sids:
+                data = "%s_param_%d" % (prefix, eid)
+            else:
+                data = "%s_workspace + %d" % (prefix, sid_offset[sid])
+            tensor_index[key] = len(tensors)
+            tensors.append((data, shape, dltypes[eid]))
+        return tensor_index[key]
+
+    funcs = []
+    calls = []
+    args = []
+    for nid, node in enumerate(nodes):
+        if node["op"] == "null":
+            continue
+        if node["op"] != "tvm_op":
+            raise ValueError("Unsupported op type %s" % node["op"])
+        node_attrs = node["attrs"]
+        func_name = node_attrs["func_name"]
+        if func_name == "__nop":
+            continue
+        flatten = int(node_attrs.get("flatten_data", "0")) != 0
+        arg_eids = [entry_id(e[0], e[1]) for e in node["inputs"]]
+        arg_eids += [entry_id(nid, i) for i in range(int(node_attrs["num_outputs"]))]
+        if func_name == "__copy":
+            src, dst = arg_eids
+            calls.append("  memcpy(%s_tensors[%d].data, %s_tensors[%d].data, %d);" % (
+                prefix, get_tensor(dst, False), prefix, get_tensor(src, False),
+                entry_bytes[src]))
+            continue
+        if func_name not in funcs:
+            funcs.append(func_name)
+        arg_begin = len(args)
+        args += [get_tensor(eid, flatten) for eid in arg_eids]
+        calls.append("  if ((ret = %s(&%s_args[%d], &%s_tcodes[%d], %d)) != 0) return ret;" % (
+            func_name, prefix, arg_begin, prefix, arg_begin, len(arg_eids)))
+    input_nids = [nid for nid in graph["arg_nodes"] if entry_id(nid, 0) not in param_data]
+    inputs = [get_tensor(entry_id(nid, 0), False) for nid in input_nids]
+    outputs = [get_tensor(entry_id(e[0], e[1]), False) for e in graph["heads"]]
+    input_names = [nodes[nid]["name"] for nid in input_nids]
+    copied_params = [eid for eid in sorted(param_data) if storage_id[eid] not in const_sids]
+
+    code = []
+    code.append("// Generated by tvm.contrib.graph_aot, do not edit.")
+    code.append("#include <stdint.h>")
+    code.append("#include <string.h>")
+    code.append("#include <string>")
+    code.append("#include <dlpack/dlpack.h>")
+    code.append("#include <tvm/runtime/c_backend_api.h>")
+    code.append("#include <tvm/runtime/c_runtime_api.h>")
+    code.append("#include <tvm/runtime/module.h>")
+    code.append("#include <tvm/runtime/packed_func.h>")
+    code.append("")
+    code.append('extern "C" {')
+    for func_name in funcs:
+        code.append("int %s(void* args, void* type_codes, int num_args);" % func_name)
+    for name in _CONTEXT_FUNCS:
+        code.append("extern void* __%s __attribute__((weak));" % name)
+    code.append("extern void* __tvm_module_ctx __attribute__((weak));")
+    code.append("}")
+    code.append("")
+    code.append("namespace {")
+    code.append("")
+    code.append("// laid out as TVMValue, initialized through its handle member")
+    code.append("union %s_value {" % prefix)
+    code.append("  void* v_handle;")
+    code.append("  int64_t v_int64;")
+    code.append("  double v_float64;")
+    code.append("};")
+    code.append("")
+    code.append("// module context of the kernels; the functions called with tvm_call_packed")
+    code.append("// are looked up in the global registry")
+    code.append("class %s_module final : public tvm::runtime::ModuleNode {" % prefix)
+    code.append(" public:")
+    code.append('  const char* type_key() const final { return "%s"; }' % prefix)
+    code.append("  tvm::runtime::PackedFunc GetFunction(")
+    code.append("      const std::string& name,")
+    code.append("      const tvm::runtime::ObjectPtr<tvm::runtime::Object>& sptr_to_self) final {")
+    code.append("    return tvm::runtime::PackedFunc();")
+    code.append("  }")
+    code.append("};")
+    code.append("")
+    code.append("alignas(%d) uint8_t %s_workspace[%d];" % (_ALIGN, prefix, max(workspace_size, 1)))
+    for eid in sorted(param_data):
+        code.append("alignas(%d) const uint8_t %s_param_%d[%d] = {" % (
+            _ALIGN, prefix, eid, len(param_data[eid])))
+        code.append(_byte_array(param_data[eid]))
+        code.append("};")
+    code.append("")
+    for i, (_, shape, _) in enumerate(tensors):
+        code.append("int64_t %s_shape_%d[] = {%s};" % (
+            prefix, i, ", ".join(str(dim) for dim in shape) or "0"))
+    code.append("")
+    code.append("DLTensor %s_tensors[] = {" % prefix)
+    for i, (data, shape, dtype) in enumerate(tensors):
+        code.append("  {const_cast<uint8_t*>(%s), {kDLCPU, 0}, %d, {%d, %d, %d}, %s_shape_%d, "
+                    "nullptr, 0}," % (data, len(shape), dtype.type_code, dtype.bits,
+                                      dtype.lanes, prefix, i))
+    code.append("};")
+    code.append("")
+    if args:
+        code.append("%s_value %s_args[] = {" % (prefix, prefix))
+        code.append("\n".join("  {&%s_tensors[%d]}," % (prefix, t) for t in args))
+        code.append("};")
+        code.append("int %s_tcodes[] = {%s};" % (
+            prefix, ", ".join(["kArrayHandle"] * len(args))))
+    code.append("const char* %s_input_names[] = {%s};" % (
+        prefix, ", ".join('"%s"' % name for name in input_names)))
+    code.append("const int %s_inputs[] = {%s};" % (prefix, ", ".join(str(t) for t in inputs)))
+    code.append("const int %s_outputs[] = {%s};" % (prefix, ", ".join(str(t) for t in outputs)))
+    code.append("")
+    code.append("}  // namespace")
+    code.append("")
+    code.append('extern "C" {')
+    code.append("")
+    code.append("int %s_init() {" % prefix)
+    for name in _CONTEXT_FUNCS:
+        code.append("  if (&__%s) __%s = reinterpret_cast<void*>(%s);" % (name, name, name))
+    code.append("  static tvm::runtime::Module module(")
+    code.append("      tvm::runtime::make_object<%s_module>());" % prefix)
+    code.append("  if (&__tvm_module_ctx) __tvm_module_ctx = module.operator->();")
+    for eid in copied_params:
+        code.append("  memcpy(%s_tensors[%d].data, %s_param_%d, %d);" % (
+            prefix, get_tensor(eid, False), prefix, eid, entry_bytes[eid]))
+    code.append("  return 0;")
+    code.append("}")
+    code.append("")
+    code.append("int %s_run() {" % prefix)
+    code.append("  int ret;")
+    code.append("  (void)ret;")
+    code += calls
+    code.append("  return 0;")
+    code.append("}")
+    code.append("")
+    code.append("int %s_get_input_index(const char* name) {" % prefix)
+    code.append("  for (int i = 0; i < %d; ++i) {" % len(input_names))
+    code.append("    if (strcmp(%s_input_names[i], name) == 0) return i;" % prefix)
+    code.append("  }")
+    code.append("  return -1;")
+    code.append("}")
+    code.append("")
+    code.append("DLTensor* %s_input(int index) { return &%s_tensors[%s_inputs[index]]; }" % (
+        prefix, prefix, prefix))
+    code.append("")
+    code.append("DLTensor* %s_output(int index) { return &%s_tensors[%s_outputs[index]]; }" % (
+        prefix, prefix, prefix))
+    code.append("")
+    code.append("}")
+    return "\n".join(code) + "\n"
@@ -131,6 +131,8 @@ class GraphModule(object):
         self._get_num_outputs = module["get_num_outputs"]
         self._load_params = module["load_params"]
         self._share_params = module["share_params"]
+        # arrays used by asynchronous copies, kept alive until sync
+        self._pending = []
 
     def set_input(self, key=None, value=None, **params):
         """Set inputs to the module via kwargs
@@ -156,6 +158,20 @@ class GraphModule(object):
             for k in keys:
                 self._get_input(k).copyfrom(params[k])
 
+    def set_input_async(self, key, value):
+        """Set an input without waiting for the copy
+
+        Parameters
+        ----------
+        key : int or str
+           The input key
+
+        value : NDArray
+           The input value, which must be left unchanged until sync().
+        """
+        self._pending.append(value)
+        self.module["set_input_async"](key, value)
+
     def run(self, **input_dict):
         """Run forward execution of the graph
 
@@ -212,6 +228,36 @@ class GraphModule(object):
 
         return self._get_output(index)
 
+    def get_output_async(self, index, out):
+        """Copy index-th output to out without waiting for the copy
+
+        Parameters
+        ----------
+        index : int
+            The output index
+
+        out : NDArray
+            The output array container, which can be read after sync().
+        """
+        self._pending.append(out)
+        self.module["get_output_async"](index, out)
+        return out
+
+    def enable_streams(self):
+        """Execute the graph on streams
+
+        Each context gets a compute stream and a copy stream, which only wait
+        for each other where the graph needs it, so that copies overlap with
+        the kernels. With set_input_async and get_output_async the copies
+        also overlap with the host.
+        """
+        self.module["enable_streams"]()
+
+    def sync(self):
+        """Wait for the work queued on the streams"""
+        self.module["sync"]()
+        self._pending = []
+
     def debug_get_output(self, node, out):
         """Run graph up to node and get the output to out
 
@@ -18,7 +18,7 @@
 from .._ffi.function import get_global_func
 from ..rpc import base as rpc_base
 
-def create(tflite_model_bytes, ctx):
+def create(tflite_model_bytes, ctx, num_interpreters=1):
     """Create a runtime executor module given a tflite model and context.
     Parameters
     ----------
@@ -27,6 +27,9 @@ def create(tflite_model_bytes, ctx):
     ctx : TVMContext
         The context to deploy the module. It can be local or remote when there
         is only one TVMContext.
+    num_interpreters : int
+        The number of interpreters sharing the model, each can run a request
+        concurrently with the others.
     Returns
     -------
     tflite_runtime : TFLiteModule
@@ -35,9 +38,9 @@ def create(tflite_model_bytes, ctx):
     device_type = ctx.device_type
     if device_type >= rpc_base.RPC_SESS_MASK:
         fcreate = ctx._rpc_sess.get_function("tvm.tflite_runtime.create")
-        return TFLiteModule(fcreate(bytearray(tflite_model_bytes), ctx))
+        return TFLiteModule(fcreate(bytearray(tflite_model_bytes), ctx, num_interpreters))
     fcreate = get_global_func("tvm.tflite_runtime.create")
-    return TFLiteModule(fcreate(bytearray(tflite_model_bytes), ctx))
+    return TFLiteModule(fcreate(bytearray(tflite_model_bytes), ctx, num_interpreters))
 
 
 class TFLiteModule(object):
@@ -47,6 +50,10 @@ class TFLiteModule(object):
     you can also directly call set_input, run, and get_output
     of underlying module functions
 
+    The module holds one or more interpreters, selected by ``slot``.
+    Each interpreter has its own inputs and outputs, and ``invoke_async``
+    queues a request on it so that several requests run concurrently.
+
     Parameters
     ----------
     module : Module
@@ -64,8 +71,18 @@ class TFLiteModule(object):
         self._invoke = module["invoke"]
         self._get_output = module["get_output"]
         self._allocate_tensors = module["allocate_tensors"]
-
-    def set_input(self, index, value):
+        self._set_input_zero_copy = module["set_input_zero_copy"]
+        self._get_output_view = module["get_output_view"]
+        self._invoke_async = module["invoke_async"]
+        self._wait = module["wait"]
+        self._num_interpreters = module["num_interpreters"]
+
+    @property
+    def num_interpreters(self):
+        """The number of interpreters sharing the model"""
+        return self._num_interpreters()
+
+    def set_input(self, index, value, slot=0):
         """Set inputs to the module via kwargs
 
         Parameters
@@ -76,20 +93,64 @@ class TFLiteModule(object):
         value : the input value.
            The input key
 
-        params : dict of str to NDArray
-           Additonal arguments
+        slot : int
+           The interpreter
+        """
+        self._set_input(index, value, slot)
+
+    def set_input_zero_copy(self, index, value, slot=0):
+        """Bind an input to a caller-owned array without copying
+
+        The interpreter reads the array directly, so later updates of the
+        array are seen by the next invocation.
+
+        Parameters
+        ----------
+        index : int
+           The input index
+
+        value : NDArray
+           A CPU array of the input shape and data type
+
+        slot : int
+           The interpreter
         """
-        self._set_input(index, value)
+        self._set_input_zero_copy(index, value, slot)
 
-    def invoke(self):
+    def invoke(self, slot=0):
         """Invoke forward execution of the model
 
         Parameters
         ----------
-        input_dict: dict of str to NDArray
-            List of input values to be feed to
+        slot : int
+           The interpreter
+        """
+        self._invoke(slot)
+
+    def invoke_async(self, slot):
+        """Queue forward execution of the model and return immediately
+
+        The invocations of a slot run in order. Use wait, or get_output,
+        before reading the outputs of the slot.
+
+        Parameters
+        ----------
+        slot : int
+           The interpreter
+        """
+        self._invoke_async(slot)
+
+    def wait(self, slot=None):
+        """Wait for the queued invocations to finish
+
+        Parameters
+        ----------
+        slot : int, optional
+           The interpreter, all interpreters when not given
         """
-        self._invoke()
+        slots = range(self.num_interpreters) if slot is None else [slot]
+        for i in slots:
+            self._wait(i)
 
     def allocate_tensors(self):
         """Allocate space for all tensors.
@@ -97,12 +158,31 @@ class TFLiteModule(object):
         self._allocate_tensors()
 
 
-    def get_output(self, index):
+    def get_output(self, index, slot=0):
         """Get index-th output to out
 
         Parameters
         ----------
         index : int
             The output index
+
+        slot : int
+           The interpreter
+        """
+        return self._get_output(index, slot)
+
+    def get_output_view(self, index, slot=0):
+        """Get index-th output without copying
+
+        The view shares memory with the interpreter and is overwritten
+        by the next invocation of the slot.
+
+        Parameters
+        ----------
+        index : int
+            The output index
+
+        slot : int
+           The interpreter
         """
-        return self._get_output(index)
+        return self._get_output_view(index, slot)
@@ -110,6 +110,9 @@ class Session:
             server_port)
         self._enter = self.module["enter"]
         self._exit = self.module["exit"]
+        self._begin_batch = self.module["begin_batch"]
+        self._end_batch = self.module["end_batch"]
+        self._get_batch_time = self.module["get_batch_time"]
 
     def _check_system(self):
         """Check if the user's system is supported by MicroTVM.
@@ -123,6 +126,26 @@ class Session:
         if sys.maxsize <= 2**32:
             raise RuntimeError("MicroTVM is currently only supported on 64-bit host platforms")
 
+    def begin_batch(self):
+        """Start batching micro function calls.
+
+        Calls made until `end_batch` are queued on the host and run on the device
+        in a single execution, which is triggered early when device memory is
+        copied or freed (e.g., by `get_output` of a graph runtime).
+        """
+        self._begin_batch()
+
+    def end_batch(self):
+        """Run the remaining queued calls and stop batching.
+
+        Return
+        ------
+        times : List[float]
+            elapsed device time of each call made since `begin_batch`, in order
+        """
+        num_tasks = self._end_batch()
+        return [self._get_batch_time(i) for i in range(num_tasks)]
+
     def __enter__(self):
         self._enter()
         return self
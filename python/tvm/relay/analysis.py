@@ -344,6 +344,28 @@ def get_total_mac_number(expr):
     return _analysis.GetTotalMacNumber(expr)
 
 
+def rematerialization_tradeoff(expr, memory_budget):
+    """
+    Estimate the trade-off of the Rematerialize pass on a function.
+
+    Parameters
+    ----------
+    expr : tvm.relay.Function
+        The input function, with its types inferred.
+
+    memory_budget : int
+        The bound of the activation memory in bytes.
+
+    Returns
+    -------
+    result : Tuple[int, int, int]
+        The extra operations of the recomputations, one per output element,
+        and the estimated peak activation bytes before and after them.
+    """
+    flops, peak_before, peak_after = _analysis.RematerializationTradeoff(expr, memory_budget)
+    return flops.value, peak_before.value, peak_after.value
+
+
 def unmatched_cases(match, mod=None):
     """
     Finds cases that the match expression does not catch, if any.
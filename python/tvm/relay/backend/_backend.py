@@ -23,7 +23,7 @@ from ..._ffi.function import _init_api, register_func
 
 
 @register_func("relay.backend.lower")
-def lower(sch, inputs, func_name, source_func):
+def lower(sch, inputs, func_name, source_func, binds=None):
     """Backend function for lowering.
 
     Parameters
@@ -40,6 +40,10 @@ def lower(sch, inputs, func_name, source_func):
     source-func : tvm.relay.Function
         The source function to be lowered.
 
+    binds : Map[tvm.Tensor, tvm.Buffer], optional
+        The buffers of the inputs, used by the shape buckets to share the
+        buffers between the specialized bodies.
+
     Returns
     -------
     lowered_funcs : List[tvm.LoweredFunc]
@@ -48,7 +52,9 @@ def lower(sch, inputs, func_name, source_func):
     import traceback
     # pylint: disable=broad-except
     try:
-        f = _build.lower(sch, inputs, name=func_name)
+        if binds is not None:
+            binds = {k: v for k, v in binds.items()}
+        f = _build.lower(sch, inputs, name=func_name, binds=binds)
         # logging.debug("lower function %s", func_name)
         # logging.debug("%s", _build.lower(sch, inputs, simple_mode=True))
     except Exception:
@@ -54,6 +54,11 @@ class DenseAttrs(Attrs):
     """Attributes for nn.dense"""
 
 
+@register_relay_attr_node
+class BatchMatmulAttrs(Attrs):
+    """Attributes for nn.batch_matmul"""
+
+
 @register_relay_attr_node
 class FIFOBufferAttrs(Attrs):
     """Attributes for nn.fifo_buffer"""
@@ -17,7 +17,6 @@
 """Find scales for quantization on the dataset."""
 from __future__ import absolute_import
 import logging
-import multiprocessing as mp
 import numpy as np
 import tvm
 
@@ -30,7 +29,6 @@ from .. import analysis as _analysis
 from .. import transform as _transform
 from .. import build_module as _build_module
 from ...contrib import graph_runtime
-from .kl_divergence import _find_scale_by_kl
 
 
 def collect_stats(mod, dataset):
@@ -81,13 +79,59 @@ def collect_stats(mod, dataset):
     return outputs
 
 
-def _kl_scale(stats):
-    with mp.Pool() as pool:
-        logging.info("finding threshold with kl for calibration...")
-        scales = list(pool.map(_find_scale_by_kl, stats))
+def collect_histograms(mod, dataset, num_bins=8001):
+    """Given an annotated graph, run its profile graph on the calibration dataset and
+    accumulate running histograms of the profiled tensors in native code.
+
+    Unlike collect_stats, only a histogram of fixed size is kept for every tensor.
+
+    Parameters
+    ----------
+    mod: Module
+        The simulation graph after annotation.
+
+    dataset: Iterable[dict of str to array]
+        The calibration dataset.
+
+    num_bins: int
+        The number of histogram bins, must be odd.
+
+    Returns
+    -------
+    ret: tvm.module.Module
+        The statistics, with functions min_max() and find_scales(mode, param).
+    """
+    logging.info("collecting statistics for calibration...")
+    func = mod['main']
+    func = _quantize.CreateStatsCollector(func)
+
+    if tvm.target.current_target():
+        target = tvm.target.current_target()
+        ctx = tvm.context(target.target_name)
+    else:
+        target = 'llvm'
+        ctx = tvm.context(target)
+
+    with _transform.build_config(opt_level=3):
+        graph, lib, params = _build_module.build(func, target=target)
+    runtime = graph_runtime.create(graph, lib, ctx)
+    runtime.set_input(**params)
+
+    stats = _quantize.CreateCalibrationStats(runtime.get_num_outputs(), num_bins)
+    update = stats["update"]
+    for batch in dataset:
+        runtime.set_input(**batch)
+        runtime.run()
+        update(runtime.module)
+    return stats
+
+
+def _native_scale(stats, mode, param):
+    logging.info("finding threshold with %s for calibration...", mode)
+    scales = stats["find_scales"](mode, param).asnumpy()
 
     def func(sq_call):  # pylint: disable=unused-argument
-        scale = scales[func.scale_idx]
+        scale = float(scales[func.scale_idx])
         func.scale_idx += 1
         return scale
     func.scale_idx = 0
@@ -173,8 +217,11 @@ def calibrate(dataset=None):
         cfg = quantize.current_qconfig()
 
         if cfg.calibrate_mode == 'kl_divergence':
-            stats = collect_stats(mod, dataset)
-            input_scale_func = _kl_scale(stats)
+            stats = collect_histograms(mod, dataset)
+            input_scale_func = _native_scale(stats, 'kl_divergence', 255)
+        elif cfg.calibrate_mode == 'percentile':
+            stats = collect_histograms(mod, dataset)
+            input_scale_func = _native_scale(stats, 'percentile', cfg.calibrate_percentile)
         elif cfg.calibrate_mode == 'global_scale':
             input_scale_func = _global_scale
         else:
@@ -76,6 +76,7 @@ class QConfig(NodeBase):
         "dtype_activation": "int32",
         "calibrate_mode": "global_scale",
         "global_scale": 8.0,
+        "calibrate_percentile": 0.9999,
         "weight_scale": "power2",
         "skip_conv_layers": [0],
         "do_simulation": False,
@@ -142,13 +143,17 @@ def qconfig(**kwargs):
         Number of bit for every kind of annotate field.
 
     calibrate_mode: str
-        The calibration mode. 'global_scale' or 'kl_divergence'.
+        The calibration mode. 'global_scale', 'kl_divergence' or 'percentile'.
         global_scale: use global scale
         kl_divergence: find scales by kl divergence on the dataset.
+        percentile: find scales covering calibrate_percentile of the values on the dataset.
 
     global_scale: float
         The global scale for calibration.
 
+    calibrate_percentile: float
+        The fraction of the values covered by the scale in percentile mode.
+
     weight_scale: str
         The way to calculate scales for weights (annotated with QAnnotateKind.WEIGHT).
         power2: Find the maximum of the absolute value of the tensor, and then round up to power
@@ -73,12 +73,22 @@ class PassContext(RelayNode):
 
     disabled_pass : Optional[Union[List[str], Set[str], Tuple[str]]]
         The list of passes that are disabled.
+
+    num_threads : Optional[int]
+        The number of threads used to run a function pass over the functions
+        of a module. 1 runs them serially and 0 uses all hardware threads.
+
+    memory_budget : Optional[int]
+        The bound in bytes of the activation memory of the graphs built for
+        the graph runtime, 0 for no bound.
     """
     def __init__(self,
                  opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
-                 disabled_pass=None):
+                 disabled_pass=None,
+                 num_threads=1,
+                 memory_budget=0):
         if isinstance(fallback_device, str):
             fallback_device = _nd.context(fallback_device).device_type
         elif isinstance(fallback_device, TVMContext):
@@ -99,7 +109,7 @@ class PassContext(RelayNode):
 
         self.__init_handle_by_constructor__(_transform.PassContext, opt_level,
                                             fallback_device, required,
-                                            disabled)
+                                            disabled, num_threads, memory_budget)
 
     def __enter__(self):
         _transform.EnterPassContext(self)
@@ -117,7 +127,9 @@ class PassContext(RelayNode):
 def build_config(opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
-                 disabled_pass=None):
+                 disabled_pass=None,
+                 num_threads=1,
+                 memory_budget=0):
     """Configure the build behavior by setting config variables.
 
     Parameters
@@ -134,6 +146,7 @@ def build_config(opt_level=2,
                 "FoldConstant": 2,
                 "FoldScaleAxis": 3,
                 "AlterOpLayout": 3,
+                "EliminateLayoutTransforms": 4,
                 "CanonicalizeOps": 3,
                 "CanonicalizeCast": 3,
                 "EliminateCommonSubexpr": 3,
@@ -151,13 +164,23 @@ def build_config(opt_level=2,
     disabled_pass: set of str, optional
         Optimization passes to be disabled during optimization.
 
+    num_threads: int, optional
+        The number of threads used to run function passes over the functions
+        of a module, 0 uses all hardware threads. Function passes implemented
+        in Python are serialized by the interpreter lock.
+
+    memory_budget: int, optional
+        The bound in bytes of the activation memory of the graphs built for
+        the graph runtime. Cheap operators are recomputed to stay within it,
+        see Rematerialize. 0 for no bound.
+
     Returns
     -------
     pass_context: PassContext
         The pass context for optimizations.
     """
     return PassContext(opt_level, fallback_device, required_pass,
-                       disabled_pass)
+                       disabled_pass, num_threads, memory_budget)
 
 
 @register_relay_node
@@ -417,7 +440,7 @@ def CombineParallelConv2D(min_num_branches=3):
     return _transform.CombineParallelConv2D(min_num_branches)
 
 
-def CombineParallelDense(min_num_branches=3):
+def CombineParallelDense(min_num_branches=3, to_batch=True):
     """Combine multiple dense operators into one. For example:
 
                 data
@@ -432,18 +455,53 @@ def CombineParallelDense(min_num_branches=3):
               |
         batch_matmul+elemwise/bcast (2,2,2)
 
+    or, with to_batch=False, which also combines dense operators with
+    different numbers of units:
+
+             data
+              |
+        dense+elemwise/bcast (2,4)
+          /              \
+     strided_slice (2,2)  strided_slice (2,2)
+
     Parameters
     ----------
     min_num_branches : int
         The minimum number of required parallel branches for performing this
         optimization.
 
+    to_batch : bool
+        Whether to combine the dense operators into a batch_matmul, or into a
+        dense on the concatenation of their weights.
+
     Returns
     -------
     ret: tvm.relay.Pass
         The registered pass that combines parallel dense operators.
     """
-    return _transform.CombineParallelDense(min_num_branches)
+    return _transform.CombineParallelDense(min_num_branches, to_batch)
+
+
+def DenseToSparse(block_size=(1, 16), sparsity_threshold=0.75):
+    """Convert dense ops whose weight is a sparse constant into sparse_dense
+    ops with the weight in block sparse row (BSR) format. The weights have to
+    be bound as constants, e.g. with `relay.build_module.bind_params_by_name`.
+
+    Parameters
+    ----------
+    block_size : tuple of int
+        The (rows, columns) of a block. A weight whose shape is not divisible
+        by the block size is kept dense.
+
+    sparsity_threshold : float
+        The minimum fraction of zero blocks of a converted weight.
+
+    Returns
+    -------
+    ret: tvm.relay.Pass
+        The registered pass that converts sparse dense ops.
+    """
+    return _transform.DenseToSparse(block_size[0], block_size[1], sparsity_threshold)
 
 
 def AlterOpLayout():
@@ -460,6 +518,42 @@ def AlterOpLayout():
     return _transform.AlterOpLayout()
 
 
+def EliminateLayoutTransforms():
+    """Run the regions of connected elementwise operators in the layout of the
+    layout transforms around them which leaves the fewest transforms, and fold
+    the chains of layout transforms.
+    AlterOpLayout transforms the inputs of operators which cannot infer a
+    layout back to their original layout, this pass removes the transforms
+    this leaves between blocked operators.
+    relay.build only runs it with opt_level=4 or in required_pass.
+
+    Returns
+    -------
+    ret : tvm.relay.Pass
+        The registered pass that eliminates layout transforms.
+    """
+    return _transform.EliminateLayoutTransforms()
+
+
+def Rematerialize(memory_budget):
+    """Recompute the outputs of cheap operators (elementwise, broadcast and
+    injective such as pad or cast) for their later users instead of keeping
+    them alive, until the estimated peak activation memory is within the
+    budget. relay.build runs it when the build config has a memory_budget.
+
+    Parameters
+    ----------
+    memory_budget : int
+        The bound of the activation memory in bytes.
+
+    Returns
+    -------
+    ret : tvm.relay.Pass
+        The registered pass that recomputes cheap operators.
+    """
+    return _transform.Rematerialize(memory_budget)
+
+
 def ConvertLayout(desired_layout):
     """ Given a dest layout, this pass transforms the expr such that most of the ops input data
     layout is changed to the dest layout. In ideal situation, there are only 2 layout transforms,
@@ -43,6 +43,15 @@ The list of options include:
    such as whether SIMD operations are enabled or not. The
    default set of attributes is set by the current CPU.
 
+- **-mattr-variants=a1,+a2;+a3,...**
+
+   Additionally compile every function for each ';' separated
+   attribute list and pack the variants into the same module.
+   The runtime checks the host CPU once at load time and binds
+   the last variant whose attributes are all supported, falling
+   back to the baseline code generated for -mcpu/-mattr. Only the
+   x86 features the runtime can detect with cpuid are accepted.
+
 - **-system-lib**
 
    Build TVM system library module. System lib is a global module that contains
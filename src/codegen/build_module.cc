@@ -678,7 +678,8 @@ TVM_STATIC_IR_FUNCTOR(IRPrinter, vtable)
   p->stream << "instrument_bound_checkers=" << op->instrument_bound_checkers << ", ";
   p->stream << "disable_select_rewriting=" << op->disable_select_rewriting;
   p->stream << "disable_vectorize=" << op->disable_vectorize;
-  p->stream << "disable_assert=" << op->disable_assert;
+  p->stream << "disable_assert=" << op->disable_assert << ", ";
+  p->stream << "dynamic_shape_buckets=" << op->dynamic_shape_buckets;
   p->stream << ")";
 });
 
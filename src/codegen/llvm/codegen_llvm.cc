@@ -101,6 +101,30 @@ void CodeGenLLVM::AddFunction(const LoweredFunc& f) {
   this->AddFunctionInternal(f, false);
 }
 
+void CodeGenLLVM::AddFunctionVariant(const LoweredFunc& f,
+                                     const std::string& suffix,
+                                     const std::string& mattr) {
+  auto n = make_object<LoweredFuncNode>(*f.operator->());
+  n->name = f->name + suffix;
+  std::unordered_set<const llvm::Function*> existing;
+  for (const llvm::Function& fn : *module_) {
+    existing.insert(&fn);
+  }
+  this->AddFunction(LoweredFunc(n));
+  // The backend picks the subtarget per function from these attributes,
+  // so the variant gets its own instruction selection and cost model.
+  // The parallel lambdas and compute scopes emitted for the variant hold
+  // its loops, so every function defined here gets the attributes.
+  std::string features = target_machine_->getTargetFeatureString().str();
+  if (features.length() != 0) features += ",";
+  features += mattr;
+  for (llvm::Function& fn : *module_) {
+    if (fn.isDeclaration() || existing.count(&fn)) continue;
+    fn.addFnAttr("target-cpu", target_machine_->getTargetCPU());
+    fn.addFnAttr("target-features", features);
+  }
+}
+
 void CodeGenLLVM::InitFuncState() {
   var_map_.clear();
   alias_var_set_.clear();
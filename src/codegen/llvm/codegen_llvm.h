@@ -75,6 +75,16 @@ class CodeGenLLVM :
    * \param f The function to be added.
    */
   virtual void AddFunction(const LoweredFunc& f);
+  /*!
+   * \brief Compile and add a specialized copy of f that is code generated
+   *  with extra target features, the copy is named f->name + suffix.
+   * \param f The function to be added.
+   * \param suffix The suffix appended to the function name.
+   * \param mattr The target features of the variant, e.g. "+avx2,+fma".
+   */
+  void AddFunctionVariant(const LoweredFunc& f,
+                          const std::string& suffix,
+                          const std::string& mattr);
   /*!
    * \brief Add main function as the entry name
    * \param entry_func_name The name of entry function to be added.
@@ -27,6 +27,7 @@
 #include <mutex>
 #include <memory>
 #include "llvm_common.h"
+#include "../../runtime/library_module.h"
 
 namespace tvm {
 namespace codegen {
@@ -108,7 +109,8 @@ void ParseLLVMTargetOptions(const std::string& target_str,
       } else {
         LOG(FATAL) << "invalid -mfloat-abi option " << value;
       }
-    } else if (key == "-device" || key == "-libs" || key == "-model") {
+    } else if (key == "-device" || key == "-libs" || key == "-model" ||
+               key == "-mattr-variants") {
       // pass
     } else {
       LOG(FATAL) << "unknown option " << key;
@@ -169,6 +171,32 @@ GetLLVMTargetMachine(const std::string& target_str,
   return std::unique_ptr<llvm::TargetMachine>(tm);
 }
 
+std::vector<std::string> GetLLVMTargetVariants(const std::string& target_str) {
+  std::vector<std::string> variants;
+  std::string key;
+  std::istringstream is(target_str);
+  while (is >> key) {
+    const std::string prefix = "-mattr-variants=";
+    if (key.compare(0, prefix.length(), prefix) != 0) continue;
+    std::istringstream vs(key.substr(prefix.length()));
+    std::string mattr;
+    while (std::getline(vs, mattr, ';')) {
+      if (mattr.length() == 0) continue;
+      // the loaded module can only select variants with features it can probe.
+      std::istringstream fs(mattr);
+      std::string feature;
+      while (std::getline(fs, feature, ',')) {
+        if (feature.length() < 2 || feature[0] != '+') continue;
+        CHECK(runtime::IsKnownCPUFeature(feature.substr(1)))
+            << "Function variants cannot be built with " << feature
+            << ", the runtime does not detect it on the host";
+      }
+      variants.push_back(mattr);
+    }
+  }
+  return variants;
+}
+
 }  // namespace codegen
 }  // namespace tvm
 #endif  // TVM_LLVM_VERSION
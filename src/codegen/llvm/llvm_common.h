@@ -63,6 +63,7 @@
 #include <llvm/Support/Alignment.h>
 #endif
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/Casting.h>
@@ -78,6 +79,7 @@
 #include <utility>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace tvm {
 namespace codegen {
@@ -111,6 +113,19 @@ void ParseLLVMTargetOptions(const std::string& target_str,
 std::unique_ptr<llvm::TargetMachine>
 GetLLVMTargetMachine(const std::string& target_str, bool allow_null = false);
 
+/*!
+ * \brief Get the feature variants requested by -mattr-variants.
+ *
+ *  The option takes a ';' separated list of attribute strings,
+ *  e.g. "-mattr-variants=+avx2,+fma;+avx512f,+avx512bw".
+ *  Each entry is compiled in addition to the baseline target,
+ *  later entries are preferred by the runtime dispatcher.
+ *
+ * \param target_str Target string, in format "llvm -target=xxx -mcpu=xxx"
+ * \return The attribute string of each variant, empty if not multi-versioned.
+ */
+std::vector<std::string> GetLLVMTargetVariants(const std::string& target_str);
+
 }  // namespace codegen
 }  // namespace tvm
 #endif  // TVM_LLVM_VERSION
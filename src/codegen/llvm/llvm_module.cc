@@ -25,6 +25,9 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/codegen.h>
 #include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "llvm_common.h"
 #include "codegen_llvm.h"
 #include "../../runtime/file_util.h"
@@ -66,8 +69,14 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     const std::string& fname = (name == runtime::symbol::tvm_module_main ?
                                 entry_func_ : name);
 
-    BackendPackedCFunc faddr =
-        reinterpret_cast<BackendPackedCFunc>(GetFunctionAddr(fname));
+    BackendPackedCFunc faddr = nullptr;
+    if (variant_suffix_.length() != 0) {
+      faddr = reinterpret_cast<BackendPackedCFunc>(
+          GetFunctionAddr(fname + variant_suffix_));
+    }
+    if (faddr == nullptr) {
+      faddr = reinterpret_cast<BackendPackedCFunc>(GetFunctionAddr(fname));
+    }
     if (faddr == nullptr) return PackedFunc();
     return WrapPackedFunc(faddr, sptr_to_self);
   }
@@ -196,8 +205,17 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     for (LoweredFunc f :  funcs) {
       cg->AddFunction(f);
     }
+    std::vector<std::string> variants = GetLLVMTargetVariants(target);
+    for (size_t i = 0; i < variants.size(); ++i) {
+      for (LoweredFunc f : funcs) {
+        cg->AddFunctionVariant(f, runtime::FunctionVariantSuffix(i), variants[i]);
+      }
+    }
     cg->AddMainFunction(funcs[0]->name);
     module_ = cg->Finish();
+    if (variants.size() != 0) {
+      AddVariantTable(variants);
+    }
 
     module_->addModuleFlag(llvm::Module::Warning, "tvm_target", llvm::MDString::get(*ctx_, target));
     module_->addModuleFlag(llvm::Module::Override, "Debug Info Version",
@@ -288,6 +306,28 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     runtime::InitContextFunctions([this](const char *name) {
         return reinterpret_cast<void*>(GetGlobalAddr(name));
       });
+    // select the function variants once for the host cpu.
+    if (const char* variants = reinterpret_cast<const char*>(
+            GetGlobalAddr(runtime::symbol::tvm_func_variants))) {
+      variant_suffix_ = runtime::SelectFunctionVariant(variants, runtime::HostCPUHasFeature);
+    }
+  }
+  // Record the features of each function variant in the module.
+  void AddVariantTable(const std::vector<std::string>& variants) {
+    std::ostringstream os;
+    for (size_t i = 0; i < variants.size(); ++i) {
+      if (i != 0) os << ';';
+      os << variants[i];
+    }
+    llvm::Constant* init = llvm::ConstantDataArray::getString(*ctx_, os.str());
+    llvm::GlobalVariable *global = new llvm::GlobalVariable(
+        *module_, init->getType(), true, llvm::GlobalValue::WeakAnyLinkage, init,
+        runtime::symbol::tvm_func_variants);
+#if TVM_LLVM_VERSION >= 100
+    global->setAlignment(llvm::Align(1));
+#else
+    global->setAlignment(1);
+#endif
   }
   // Get global address from execution engine.
   uint64_t GetGlobalAddr(const std::string& name) {
@@ -311,6 +351,8 @@ class LLVMModuleNode final : public runtime::ModuleNode {
   std::string target_;
   // Name of entry function.
   std::string entry_func_;
+  // Symbol suffix of the function variant selected for the host.
+  std::string variant_suffix_;
   // JIT lock
   std::mutex mutex_;
   // execution engine
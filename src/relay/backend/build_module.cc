@@ -332,18 +332,30 @@ class RelayBuildModule : public runtime::ModuleNode {
     });
     pass_seqs.push_back(transform::EliminateCommonSubexpr(fskip));
     pass_seqs.push_back(transform::CombineParallelConv2D(3));
-    pass_seqs.push_back(transform::CombineParallelDense(3));
+    // On CPUs a single dense on the concatenated weights makes better use of
+    // the caches and the threads than a batch_matmul on the stacked input.
+    bool dense_to_batch = !(targets.size() == 1 &&
+                            (*targets.begin()).second->device_type == kDLCPU);
+    pass_seqs.push_back(transform::CombineParallelDense(3, dense_to_batch));
     pass_seqs.push_back(transform::FoldConstant());
     pass_seqs.push_back(transform::FoldScaleAxis());
     pass_seqs.push_back(transform::CanonicalizeCast());
     pass_seqs.push_back(transform::CanonicalizeOps());
 
     // Alter layout transformation is only applied to homogeneous execution yet.
+    // EliminateLayoutTransforms is at opt_level 4, enable it with required_pass.
     if (targets.size() == 1) {
       pass_seqs.push_back(transform::AlterOpLayout());
+      pass_seqs.push_back(transform::EliminateLayoutTransforms());
     }
     pass_seqs.push_back(transform::FoldConstant());
 
+    // Recompute cheap operators to fit the activation memory in the budget.
+    int64_t memory_budget = PassContext::Current()->memory_budget;
+    if (memory_budget > 0) {
+      pass_seqs.push_back(transform::Rematerialize(memory_budget));
+    }
+
     // Create a sequential pass and perform optimizations.
     transform::Pass seq = transform::Sequential(pass_seqs);
     if (targets.size() == 1) {
@@ -362,7 +374,13 @@ class RelayBuildModule : public runtime::ModuleNode {
     }
 
     // Fuse the operations if it is needed.
-    relay_module = transform::FuseOps()(relay_module);
+    if (targets.size() == 1) {
+      const auto& it = targets.begin();
+      With<Target> tctx((*it).second);
+      relay_module = transform::FuseOps()(relay_module);
+    } else {
+      relay_module = transform::FuseOps()(relay_module);
+    }
     relay_module = transform::InferType()(relay_module);
     CHECK(relay_module.defined());
 
@@ -24,6 +24,10 @@
 #include "compile_engine.h"
 
 #include <tvm/schedule.h>
+#include <tvm/build_module.h>
+#include <tvm/ir_pass.h>
+#include <tvm/ir_mutator.h>
+#include <tvm/ir_visitor.h>
 #include <tvm/packed_func_ext.h>
 #include <tvm/operation.h>
 #include <tvm/runtime/registry.h>
@@ -34,12 +38,14 @@
 #include <tvm/relay/op.h>
 #include <tvm/relay/op_attr_types.h>
 #include <topi/tags.h>
+#include <algorithm>
 #include <utility>
 #include <limits>
 #include <mutex>
 #include <functional>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "../ir/type_functor.h"
 
 namespace tvm {
@@ -50,13 +56,6 @@ TVM_REGISTER_NODE_TYPE(CCacheKeyNode);
 TVM_REGISTER_NODE_TYPE(CCacheValueNode);
 TVM_REGISTER_OBJECT_TYPE(CompileEngineNode);
 
-CCacheKey CCacheKeyNode::make(Function source_func, Target target) {
-  auto n = make_node<CCacheKeyNode>();
-  n->source_func = std::move(source_func);
-  n->target = std::move(target);
-  return CCacheKey(n);
-}
-
 struct IsDynamicVisitor : public TypeVisitor {
   bool is_dyn{false};
   void VisitType_(const TensorTypeNode* tt) {
@@ -79,7 +78,17 @@ bool IsDynamic(const Type& ty) {
 TVM_REGISTER_API("relay._make.IsDynamic")
 .set_body_typed(IsDynamic);
 
-Array<IndexExpr> GetShape(const Array<IndexExpr>& shape) {
+CCacheKey CCacheKeyNode::make(Function source_func, Target target) {
+  auto n = make_node<CCacheKeyNode>();
+  if (source_func->checked_type_.defined() && IsDynamic(source_func->checked_type())) {
+    n->dynamic_shape_buckets = BuildConfig::Current()->dynamic_shape_buckets;
+  }
+  n->source_func = std::move(source_func);
+  n->target = std::move(target);
+  return CCacheKey(n);
+}
+
+Array<IndexExpr> GetShape(const Array<IndexExpr>& shape, int any_dim_factor = 1) {
   // for now, we always use int32 shape when possible
   // even if the result of shape inference becomes int64.
   Array<IndexExpr> res;
@@ -90,7 +99,13 @@ Array<IndexExpr> GetShape(const Array<IndexExpr>& shape) {
       CHECK_GE(pval[0], std::numeric_limits<int32_t>::min());
       res.push_back(ir::IntImm::make(DataType::Int(32), *pval));
     } else if (val->IsInstance<ir::Any>()) {
-      res.push_back(val.as<ir::Any>()->ToVar());
+      tvm::Var var = val.as<ir::Any>()->ToVar();
+      if (any_dim_factor == 1) {
+        res.push_back(var);
+      } else {
+        // specialize the dimension to be a multiple of the factor.
+        res.push_back(ir::Mul::make(var, make_const(var.dtype(), any_dim_factor)));
+      }
     } else {
       res.push_back(val);
     }
@@ -103,8 +118,15 @@ Array<IndexExpr> GetShape(const Array<IndexExpr>& shape) {
 class ScheduleGetter :
       public ExprFunctor<Array<Tensor>(const Expr&)> {
  public:
-  explicit ScheduleGetter(Target target)
-      : target_(target), device_copy_op_(Op::Get("device_copy")) {}
+  /*!
+   * \brief Constructor
+   * \param target The target to create schedule for.
+   * \param any_dim_factor When not 1, dynamic dimensions are assumed to be
+   *        multiples of this factor in the created compute.
+   */
+  explicit ScheduleGetter(Target target, int any_dim_factor = 1)
+      : target_(target), any_dim_factor_(any_dim_factor),
+        device_copy_op_(Op::Get("device_copy")) {}
 
   std::pair<Schedule, CachedFunc> Create(const Function& prim_func) {
     static auto fschedule =
@@ -115,7 +137,7 @@ class ScheduleGetter :
       Array<tvm::Tensor> inputs;
       if (const auto* ttype = param->checked_type().as<TensorTypeNode>()) {
         tvm::Tensor tensor = tvm::placeholder(
-            GetShape(ttype->shape), ttype->dtype);
+            GetShape(ttype->shape, any_dim_factor_), ttype->dtype);
         cache_node->inputs.push_back(tensor);
         inputs.push_back(tensor);
       } else {
@@ -126,7 +148,7 @@ class ScheduleGetter :
           // TODO(@icemelon): Allow recursive tuple
           CHECK(ttype != nullptr);
           tvm::Tensor tensor = tvm::placeholder(
-              GetShape(ttype->shape), ttype->dtype);
+              GetShape(ttype->shape, any_dim_factor_), ttype->dtype);
           cache_node->inputs.push_back(tensor);
           inputs.push_back(tensor);
         }
@@ -236,12 +258,13 @@ class ScheduleGetter :
     // TODO(@icemelon): Support recursive tuple
     Type call_node_type = call_node->checked_type();
     if (const auto* tt = call_node->checked_type().as<TensorTypeNode>()) {
-      call_node_type = TensorTypeNode::make(GetShape(tt->shape), tt->dtype);
+      call_node_type = TensorTypeNode::make(GetShape(tt->shape, any_dim_factor_), tt->dtype);
     } else if (const auto* tuple_t = call_node->checked_type().as<TupleTypeNode>()) {
       std::vector<Type> new_fields;
       for (auto field : tuple_t->fields) {
         if (const auto* tt = field.as<TensorTypeNode>()) {
-          new_fields.push_back(TensorTypeNode::make(GetShape(tt->shape), tt->dtype));
+          new_fields.push_back(
+              TensorTypeNode::make(GetShape(tt->shape, any_dim_factor_), tt->dtype));
         } else {
           new_fields.push_back(field);
         }
@@ -265,7 +288,10 @@ class ScheduleGetter :
 
     int op_pattern = fpattern[op];
     if (op_pattern >= kCommReduce) {
-      CHECK(!master_op_.defined() || master_op_pattern_ < kCommReduce)
+      // Chains of out-fusable ops (e.g. conv2d -> conv2d) are created by FuseOps
+      // at fuse_opt_level 4, the last op of the chain becomes the master.
+      CHECK(!master_op_.defined() || master_op_pattern_ < kCommReduce ||
+            (op_pattern == kOutEWiseFusable && master_op_pattern_ == kOutEWiseFusable))
           << "Two complicated op in a primitive function "
           << " master=" << master_op_ << " current=" << op;
     }
@@ -326,6 +352,7 @@ class ScheduleGetter :
 
  private:
   tvm::Target target_;
+  int any_dim_factor_;
   Op master_op_;
   Attrs master_attrs_;
   int master_op_pattern_{0};
@@ -728,17 +755,188 @@ class CompileEngineImpl : public CompileEngineNode {
       all_args.push_back(arg);
     }
     // lower the function
-    if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
-      cache_node->funcs = (*f)(
-          spair.first, all_args, cache_node->func_name, key->source_func);
+    if (key->dynamic_shape_buckets.size() != 0) {
+      cache_node->funcs = LowerShapeBuckets(
+          key, spair.first, all_args, cache_node->func_name);
     } else {
-      tvm::BuildConfig bcfg = BuildConfig::Create();
-      std::unordered_map<Tensor, Buffer> binds;
-      cache_node->funcs = tvm::lower(spair.first, all_args, cache_node->func_name, binds, bcfg);
+      cache_node->funcs = LowerFunc(
+          spair.first, Array<NodeRef>(all_args.begin(), all_args.end()),
+          cache_node->func_name, key->source_func, {});
     }
     value->cached_func = CachedFunc(cache_node);
     return value;
   }
+  /*!
+   * \brief Lower a schedule, through the relay.backend.lower hook if it is registered.
+   * \param sch The schedule.
+   * \param args The arguments of the function.
+   * \param func_name The name of the lowered function.
+   * \param source_func The relay function being lowered.
+   * \param binds The buffers of the arguments, new buffers are created if empty.
+   * \return The lowered functions.
+   */
+  Array<LoweredFunc> LowerFunc(Schedule sch,
+                               const Array<NodeRef>& args,
+                               const std::string& func_name,
+                               const Function& source_func,
+                               const std::unordered_map<Tensor, Buffer>& binds) {
+    // The arguments of a function planned in place may alias, so they are not
+    // marked noalias. Otherwise e.g. CUDA could read an input through the
+    // non-coherent cache while the same buffer is written as the output.
+    BuildConfig bcfg = BuildConfig::Current();
+    if (FunctionGetAttr(source_func, attr::kInplace).defined()) {
+      auto n = make_node<BuildConfigNode>(*bcfg.operator->());
+      n->restricted_func = false;
+      bcfg = BuildConfig(n);
+    }
+    With<BuildConfig> build_config_scope(bcfg);
+    if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
+      if (binds.empty()) {
+        return (*f)(sch, args, func_name, source_func);
+      }
+      Map<Tensor, Buffer> bind_map;
+      for (const auto& kv : binds) {
+        bind_map.Set(kv.first, kv.second);
+      }
+      return (*f)(sch, args, func_name, source_func, bind_map);
+    }
+    // same as tvm::lower, except that the scalar arguments of the shape
+    // buckets are appended to the argument list.
+    Array<Tensor> tensors;
+    Array<NodeRef> scalars;
+    for (const NodeRef& arg : args) {
+      if (arg.as<tvm::TensorNode>()) {
+        tensors.push_back(Downcast<Tensor>(arg));
+      } else {
+        scalars.push_back(arg);
+      }
+    }
+    Array<NodeRef> arg_list;
+    Stmt stmt = tvm::BuildStmt(sch, tensors, binds, true, &arg_list, bcfg);
+    for (const NodeRef& arg : scalars) {
+      arg_list.push_back(arg);
+    }
+    return Array<LoweredFunc>({
+        ir::MakeAPI(stmt, func_name, arg_list, 0, bcfg->restricted_func)});
+  }
+  /*!
+   * \brief Get the body of the compute scope of a lowered function,
+   *  i.e. the function without its argument unpacking.
+   */
+  static Stmt ComputeScopeBody(const LoweredFunc& f) {
+    Stmt body;
+    ir::PostOrderVisit(f->body, [&body](const NodeRef& n) {
+      const auto* op = n.as<ir::AttrStmt>();
+      if (op != nullptr && op->attr_key == ir::attr::compute_scope) {
+        body = op->body;
+      }
+    });
+    return body;
+  }
+  /*! \brief Replace the body of the compute scope of a lowered function. */
+  class ComputeScopeReplacer : public ir::IRMutator {
+   public:
+    explicit ComputeScopeReplacer(Stmt body) : body_(body) {}
+
+    Stmt Mutate_(const ir::AttrStmt* op, const Stmt& s) final {
+      if (op->attr_key == ir::attr::compute_scope) {
+        return ir::AttrStmt::make(op->node, op->attr_key, op->value, body_);
+      }
+      return IRMutator::Mutate_(op, s);
+    }
+
+   private:
+    Stmt body_;
+  };
+  /*!
+   * \brief Lower a function with dynamic dimensions into shape buckets.
+   *
+   *  For each bucket factor, the function is scheduled again with every
+   *  dynamic dimension expressed as factor * k, so that LoopPartition and
+   *  VectorizeLoop can split off clean bodies. All the bodies are lowered
+   *  through LowerFunc with the same argument buffers, the specialized ones
+   *  are put under the argument unpacking of the generic function and are
+   *  selected by checking the actual extents, the generic body serves as
+   *  the fallback.
+   *
+   * \param key The cache key of the function.
+   * \param sch The schedule of the generic function.
+   * \param all_args The inputs and outputs of the generic function.
+   * \param func_name The name of the lowered function.
+   * \return The lowered functions.
+   */
+  Array<LoweredFunc> LowerShapeBuckets(const CCacheKey& key,
+                                       Schedule sch,
+                                       const Array<Tensor>& all_args,
+                                       const std::string& func_name) {
+    std::unordered_map<Tensor, Buffer> binds;
+    Array<NodeRef> args;
+    for (Tensor arg : all_args) {
+      binds[arg] = decl_buffer(arg->shape, arg->dtype, arg->op->name);
+      args.push_back(arg);
+    }
+    Array<LoweredFunc> funcs = LowerFunc(sch, args, func_name, key->source_func, binds);
+    if (funcs.size() != 1) return funcs;
+    Stmt body = ComputeScopeBody(funcs[0]);
+    CHECK(body.defined());
+    // Try the larger factors first.
+    std::vector<int> factors;
+    for (Integer factor : key->dynamic_shape_buckets) {
+      CHECK_GT(factor->value, 1) << "Shape bucket factor must be greater than 1";
+      factors.push_back(static_cast<int>(factor->value));
+    }
+    std::sort(factors.begin(), factors.end());
+    for (int factor : factors) {
+      auto spair = ScheduleGetter(key->target, factor).Create(key->source_func);
+      Array<Tensor> spec_tensors = spair.second->inputs;
+      for (Tensor arg : spair.second->outputs) {
+        spec_tensors.push_back(arg);
+      }
+      CHECK_EQ(spec_tensors.size(), all_args.size());
+      // Bind the specialized tensors to the generic buffers and
+      // recover each k from the actual extent.
+      std::unordered_map<Tensor, Buffer> spec_binds;
+      Array<NodeRef> spec_args;
+      std::vector<std::pair<tvm::Var, tvm::Expr> > lets;
+      std::unordered_set<const Variable*> bound;
+      tvm::Expr cond = make_const(DataType::Bool(), true);
+      for (size_t i = 0; i < spec_tensors.size(); ++i) {
+        Buffer buf = binds.at(all_args[i]);
+        spec_binds[spec_tensors[i]] = buf;
+        spec_args.push_back(spec_tensors[i]);
+        CHECK_EQ(spec_tensors[i]->shape.size(), buf->shape.size());
+        for (size_t j = 0; j < buf->shape.size(); ++j) {
+          const auto* mul = spec_tensors[i]->shape[j].as<ir::Mul>();
+          if (mul == nullptr || !mul->a.as<Variable>()) continue;
+          tvm::Var k = Downcast<tvm::Var>(mul->a);
+          if (bound.count(k.get())) continue;
+          bound.insert(k.get());
+          tvm::Expr extent = buf->shape[j];
+          cond = cond && (indexmod(extent, mul->b) == make_zero(extent.dtype()));
+          lets.emplace_back(k, indexdiv(extent, mul->b));
+        }
+      }
+      // Only dimensions that are structurally tied to the inputs can be specialized.
+      if (lets.empty()) continue;
+      // The k are passed as arguments so that the specialized function is closed,
+      // only its compute scope is kept and they are bound by lets there.
+      for (const auto& let : lets) {
+        spec_args.push_back(let.first);
+      }
+      Array<LoweredFunc> spec_funcs = LowerFunc(
+          spair.first, spec_args, func_name, key->source_func, spec_binds);
+      if (spec_funcs.size() != 1) continue;
+      Stmt spec_body = ComputeScopeBody(spec_funcs[0]);
+      CHECK(spec_body.defined());
+      for (auto it = lets.rbegin(); it != lets.rend(); ++it) {
+        spec_body = ir::LetStmt::make(it->first, it->second, spec_body);
+      }
+      body = ir::IfThenElse::make(ir::Simplify(cond), spec_body, body);
+    }
+    auto n = make_node<LoweredFuncNode>(*funcs[0].operator->());
+    n->body = ComputeScopeReplacer(body).Mutate(funcs[0]->body);
+    return Array<LoweredFunc>({LoweredFunc(n)});
+  }
   // implement lowered shape func
   CCacheValue LowerShapeFuncInternal(const CCacheKey& key) {
     std::lock_guard<std::mutex> lock(mutex_);
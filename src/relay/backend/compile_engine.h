@@ -83,10 +83,16 @@ class CCacheKeyNode : public Node {
   Function source_func;
   /*! \brief The hardware target.*/
   Target target;
+  /*!
+   * \brief The shape bucket factors the function is lowered with,
+   *  empty unless the function has dynamic dimensions.
+   */
+  Array<Integer> dynamic_shape_buckets;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
     v->Visit("source_func", &source_func);
     v->Visit("target", &target);
+    v->Visit("dynamic_shape_buckets", &dynamic_shape_buckets);
   }
   /*! \return The hash value of CCacheKey. */
   inline size_t Hash() const;
@@ -98,6 +104,8 @@ class CCacheKeyNode : public Node {
   inline bool Equal(const CCacheKeyNode* other) const;
   /*!
    * \brief create a cache key.
+   *  The shape buckets of the current build config are recorded
+   *  when source_func has dynamic dimensions.
    * \param source_func The source function.
    * \param target The target device.
    * \return the created key.
@@ -230,6 +238,9 @@ inline size_t CCacheKeyNode::Hash() const {
   hash_ = StructuralHash()(this->source_func);
   hash_ = dmlc::HashCombine(
       hash_, std::hash<std::string>()(target->str()));
+  for (const Integer& factor : dynamic_shape_buckets) {
+    hash_ = dmlc::HashCombine(hash_, std::hash<int64_t>()(factor->value));
+  }
   if (hash_ == 0) hash_ = 1;
   return hash_;
 }
@@ -237,6 +248,12 @@ inline size_t CCacheKeyNode::Hash() const {
 inline bool CCacheKeyNode::Equal(
     const CCacheKeyNode* other) const {
   if (Hash() != other->Hash()) return false;
+  if (dynamic_shape_buckets.size() != other->dynamic_shape_buckets.size()) return false;
+  for (size_t i = 0; i < dynamic_shape_buckets.size(); ++i) {
+    if (dynamic_shape_buckets[i]->value != other->dynamic_shape_buckets[i]->value) {
+      return false;
+    }
+  }
   return this->target->str() == other->target->str() &&
       AlphaEqual(this->source_func, other->source_func);
 }
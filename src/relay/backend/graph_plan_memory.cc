@@ -25,6 +25,9 @@
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/analysis.h>
+#include <tvm/relay/op_attr_types.h>
+#include <algorithm>
+#include <unordered_set>
 #include "../../common/arena.h"
 
 namespace tvm {
@@ -203,6 +206,9 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   // Run storage allocation for a function.
   Map<Expr, Array<IntegerArray> > Plan(const Function& func) {
     prototype_ = StorageAllocaInit(&arena_).GetInitTokenMap(func);
+    for (StorageToken* tok : prototype_.at(func->body.operator->())) {
+      output_prototypes_.insert(tok);
+    }
     this->Run(func);
 
     // The value of smap contains two integer arrays where the first array
@@ -265,8 +271,14 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
         args.push_back(tok);
       }
     }
-    // create token for the call node.
-    CreateToken(op, true);
+    // create token for the call node, reusing the storage of an input
+    // which dies at this call if the call can overwrite it.
+    if (StorageToken* tok = FindInplaceToken(op, args)) {
+      tok->ref_counter += prototype_.at(op)[0]->ref_counter;
+      token_map_[op] = {tok};
+    } else {
+      CreateToken(op, true);
+    }
     // check if there is orphaned output that can be released immediately.
     for (StorageToken* tok : token_map_.at(op)) {
       CheckForRelease(tok);
@@ -276,6 +288,73 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       CheckForRelease(tok);
     }
   }
+  /*!
+   * \brief Whether each element of the output of the call only depends on the
+   *  elements at the same index of the inputs of the same shape.
+   *
+   *  This is the case of the calls to elementwise and broadcast operators and of
+   *  the fused functions made of them, which can write their output over such
+   *  an input.
+   * \param call The call.
+   */
+  static bool IsInplaceSafe(const CallNode* call) {
+    static auto fpattern = Op::GetAttr<TOpPattern>("TOpPattern");
+    auto is_safe_op = [](const CallNode* n) {
+      const auto* op_node = n->op.as<OpNode>();
+      if (op_node == nullptr) return false;
+      Op op = GetRef<Op>(op_node);
+      return fpattern.count(op) && fpattern[op] <= kBroadcast;
+    };
+    if (call->op.as<OpNode>()) {
+      return is_safe_op(call);
+    }
+    const auto* func = call->op.as<FunctionNode>();
+    if (func == nullptr) return false;
+    bool safe = true;
+    PostOrderVisit(func->body, [&](const Expr& e) {
+      if (const auto* n = e.as<CallNode>()) {
+        safe = safe && is_safe_op(n);
+      } else if (!e.as<VarNode>() && !e.as<ConstantNode>() && !e.as<OpNode>()) {
+        safe = false;
+      }
+    });
+    return safe;
+  }
+  /*!
+   * \brief Find an input whose storage the output of the call can be written to.
+   * \param op The call.
+   * \param args The tokens of the inputs of the call.
+   * \return The token of the input, nullptr if there is none.
+   */
+  StorageToken* FindInplaceToken(const CallNode* op, const std::vector<StorageToken*>& args) {
+    const auto& prototypes = prototype_.at(op);
+    if (prototypes.size() != 1 || !IsInplaceSafe(op)) return nullptr;
+    const TensorTypeNode* ttype = prototypes[0]->ttype;
+    AttrsEqual equal;
+    for (Expr arg : op->args) {
+      const auto* arg_ttype = arg->checked_type().as<TensorTypeNode>();
+      const auto& toks = token_map_.at(arg.operator->());
+      if (arg_ttype == nullptr || toks.size() != 1 ||
+          arg_ttype->dtype.bits() * arg_ttype->dtype.lanes() !=
+          ttype->dtype.bits() * ttype->dtype.lanes() ||
+          !equal(arg_ttype->shape, ttype->shape)) {
+        continue;
+      }
+      // the outputs of the function must survive until its end.
+      const auto& arg_prototypes = prototype_.at(arg.operator->());
+      if (arg_prototypes.size() != 1 || output_prototypes_.count(arg_prototypes[0])) {
+        continue;
+      }
+      StorageToken* tok = toks[0];
+      // params and constants are never released, the other inputs can be
+      // overwritten if all their remaining references are from this call.
+      if (tok->device_type == prototypes[0]->device_type &&
+          tok->ref_counter == std::count(args.begin(), args.end(), tok)) {
+        return tok;
+      }
+    }
+    return nullptr;
+  }
   /*!
    * \brief ceil(size/word_size) to get number of words.
    * \param size The original size.
@@ -383,6 +462,8 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   std::vector<StorageToken*> data_;
   /*! \brief internal prototype token map */
   std::unordered_map<const ExprNode*, std::vector<StorageToken*> > prototype_;
+  /*! \brief prototype tokens of the outputs of the function */
+  std::unordered_set<const StorageToken*> output_prototypes_;
 };
 
 Map<Expr, Array<IntegerArray> > GraphPlanMemory(const Function& func) {
@@ -31,6 +31,7 @@
 
 #include <list>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "utils.h"
@@ -402,6 +403,24 @@ class GraphRuntimeCodegen
     return AddNode(node, GetRef<Expr>(op));
   }
 
+  /*!
+   * \brief Whether an output of the call shares its storage with an input.
+   * \param op The call.
+   */
+  bool IsPlannedInplace(const CallNode* op) {
+    std::unordered_set<int64_t> storage_ids;
+    for (const auto& sid : storage_device_map_[GetRef<Expr>(op)][0]) {
+      storage_ids.insert(sid->value);
+    }
+    for (const Expr& arg : op->args) {
+      if (!storage_device_map_.count(arg)) continue;
+      for (const auto& sid : storage_device_map_[arg][0]) {
+        if (storage_ids.count(sid->value)) return true;
+      }
+    }
+    return false;
+  }
+
   std::vector<GraphNodeRef> VisitExpr_(const CallNode* op) override {
     Expr expr = GetRef<Expr>(op);
     Function func;
@@ -454,6 +473,10 @@ class GraphRuntimeCodegen
       }
       target = targets_[call_dev_type];
     }
+    // The kernel of a call planned in place is lowered for aliasing arguments.
+    if (IsPlannedInplace(op)) {
+      func = FunctionSetAttr(func, attr::kInplace, tvm::Integer(1));
+    }
     CCacheKey key = (*pf0)(func, target);
     CachedFunc lowered_func = (*pf1)(compile_engine_, key);
     if (!lowered_funcs_.count(target->str())) {
@@ -859,6 +859,8 @@ RELAY_REGISTER_OP("nn.layer_norm")
 .add_type_rel("LayerNorm", LayerNormRel);
 
 // relay.nn.batch_matmul
+TVM_REGISTER_NODE_TYPE(BatchMatmulAttrs);
+
 bool BatchMatmulRel(const Array<Type>& types,
                     int num_inputs,
                     const Attrs& attrs,
@@ -880,17 +882,26 @@ bool BatchMatmulRel(const Array<Type>& types,
   Array<tvm::Expr> oshape = x->shape;
   oshape.Set(2, y->shape[1]);
 
+  // batch_matmul built by the parallel dense combiner has no attrs.
+  const BatchMatmulAttrs* param = attrs.as<BatchMatmulAttrs>();
+  DataType out_dtype = x->dtype;
+  if (param != nullptr && param->out_dtype.bits() != 0) {
+    out_dtype = param->out_dtype;
+  }
   // assign output type
-  reporter->Assign(types[2], TensorTypeNode::make(oshape, x->dtype));
+  reporter->Assign(types[2], TensorTypeNode::make(oshape, out_dtype));
   return true;
 }
 
 
 // Positional relay function to create batch_matmul operator used by frontend FFI.
 Expr MakeBatchMatmul(Expr x,
-                     Expr y) {
+                     Expr y,
+                     DataType out_dtype) {
+  auto attrs = make_node<BatchMatmulAttrs>();
+  attrs->out_dtype = out_dtype;
   static const Op& op = Op::Get("nn.batch_matmul");
-  return CallNode::make(op, {x, y}, Attrs(), {});
+  return CallNode::make(op, {x, y}, Attrs(attrs), {});
 }
 
 
@@ -911,6 +922,7 @@ are data in batch.
 - **out**: `(b, m, n)`.
 
 )code" TVM_ADD_FILELINE)
+.set_attrs_type<BatchMatmulAttrs>()
 .set_num_inputs(2)
 .add_argument("x", "3D Tensor", "First input.")
 .add_argument("y", "3D Tensor", "Second input.")
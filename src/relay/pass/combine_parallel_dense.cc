@@ -27,6 +27,11 @@
  * The inputs of the new batch_matmul is the stack of the original inputs. 
  * Elemwise and broadcast ops following dense are also combined if possible.
  *
+ * Alternatively, dense ops that share the same input node and the same
+ * reduction dimension, but may have different numbers of units, can be
+ * replaced with a single dense whose weight is the concatenation of the
+ * original weights, followed by slices of its output.
+ *
  * This prevents launching multiple kernels in networks with multiple
  * dense branches, such as BERT.
  */
@@ -68,17 +73,200 @@ class ParallelDenseCombiner : public ParallelOpBatchCombiner {
   }
 };
 
-/*! \brief Combine parallel dense if number of branches >= min_num_branches */
-Expr CombineParallelDense(const Expr& expr, uint64_t min_num_branches) {
-  return ParallelDenseCombiner(min_num_branches).Combine(expr);
+/*
+ * Combines dense ops into a single dense by concatenating their weights
+ * along the units axis:
+ *
+ *                data
+ *          /              \
+ *     dense (m,n)         dense (m,k)
+ *         |                 |
+ *    elemwise/bcast (m,n)  elemwise/bcast (m,k)
+ *
+ * Would become:
+ *
+ *             data
+ *              |
+ *        dense+elemwise/bcast (m,n+k)
+ *          /       \
+ *   slice (m,n)   slice (m,k)
+ */
+class ParallelDenseToDenseCombiner : public ParallelOpCombiner {
+ public:
+  explicit ParallelDenseToDenseCombiner(uint64_t min_num_branches)
+    : ParallelOpCombiner("nn.dense", min_num_branches) {
+  }
+
+ protected:
+  bool IsSupportedOp(const CallNode* n) {
+    const auto* weight = n->args[1]->type_as<TensorTypeNode>();
+    return weight->shape.size() == 2 && weight->shape[0].as<IntImm>();
+  }
+
+  bool CanOpsBeCombined(const CallNode* a, const CallNode* b) {
+    AttrsEqual eq;
+    const auto* attrs_a = a->attrs.as<DenseAttrs>();
+    const auto* attrs_b = b->attrs.as<DenseAttrs>();
+    CHECK(attrs_a);
+    CHECK(attrs_b);
+    const auto* weight_a = a->args[1]->type_as<TensorTypeNode>();
+    const auto* weight_b = b->args[1]->type_as<TensorTypeNode>();
+
+    return eq(attrs_a->out_dtype, attrs_b->out_dtype) &&
+           eq(weight_a->dtype, weight_b->dtype) &&
+           eq(weight_a->shape[1], weight_b->shape[1]);
+  }
+
+  Call MakeCombinedOp(const Group& branches) {
+    const Op& dense = Op::Get("nn.dense");
+    Expr data = branches[0][0]->args[0];
+    Array<Expr> weights;
+    int64_t units = 0;
+    bool has_units = true;
+    for (const auto& branch : branches) {
+      weights.push_back(branch[0]->args[1]);
+      units += GetUnits(branch[0]);
+      has_units = has_units && branch[0]->attrs.as<DenseAttrs>()->units.defined();
+    }
+
+    const auto* attrs = branches[0][0]->attrs.as<DenseAttrs>();
+    CHECK(attrs);
+    const auto new_attrs = make_node<DenseAttrs>();
+    new_attrs->out_dtype = attrs->out_dtype;
+    if (has_units) {
+      new_attrs->units = MakeConstScalar(DataType::Int(32), units);
+    }
+    return CallNode::make(dense, {data, MakeConcatenate(TupleNode::make(weights), 0)},
+                          Attrs{new_attrs}, {});
+  }
+
+  bool IsArgCompatible(const CallNode* a, const CallNode* b, size_t index) {
+    AttrsEqual eq;
+    auto ta = a->args[index]->type_as<TensorTypeNode>();
+    auto tb = b->args[index]->type_as<TensorTypeNode>();
+    auto toutput_a = a->type_as<TensorTypeNode>();
+    auto toutput_b = b->type_as<TensorTypeNode>();
+    size_t ndim = toutput_a->shape.size();
+
+    if (!eq(ta->dtype, tb->dtype) || ta->shape.size() != tb->shape.size() ||
+        ta->shape.size() > ndim || toutput_b->shape.size() != ndim)
+      return false;
+
+    // a single unit could be broadcast to the units of the argument
+    if (is_const_int(toutput_a->shape[ndim - 1], 1) || is_const_int(toutput_b->shape[ndim - 1], 1))
+      return false;
+
+    if (const auto* bias_add = a->attrs.as<BiasAddAttrs>()) {
+      // the bias follows the units axis only if it is the last axis
+      return bias_add->axis == -1 || bias_add->axis == static_cast<int>(ndim) - 1;
+    }
+
+    // a scalar is broadcast to all the units, keep it if it is the same in all branches
+    if (ta->shape.size() == 0) {
+      return AlphaEqual(a->args[index], b->args[index]);
+    }
+
+    // the units axis of the argument either follows the units of the output,
+    // or is broadcast and repeated to them when the branches are combined
+    size_t last = ta->shape.size() - 1;
+    const auto& units_a = ta->shape[last];
+    const auto& units_b = tb->shape[last];
+    if (!(eq(units_a, toutput_a->shape[ndim - 1]) || is_const_int(units_a, 1)) ||
+        !(eq(units_b, toutput_b->shape[ndim - 1]) || is_const_int(units_b, 1)))
+      return false;
+
+    for (size_t i = 0; i < last; i++) {
+      if (!eq(ta->shape[i], tb->shape[i]))
+        return false;
+    }
+    return true;
+  }
+
+  Call MakeCombinedCallFromFollowingOps(const Expr& data,
+                                        const Group& branches,
+                                        size_t depth,
+                                        size_t parent_index) {
+    Array<Expr> new_args;
+    const CallNode* call = branches[0][depth];
+
+    for (size_t i = 0; i < call->args.size(); i++) {
+      if (i == parent_index) {
+        new_args.push_back(data);
+        continue;
+      }
+
+      size_t arg_ndim = call->args[i]->type_as<TensorTypeNode>()->shape.size();
+      if (arg_ndim == 0) {
+        new_args.push_back(call->args[i]);
+        continue;
+      }
+
+      Array<Expr> tuple;
+      for (const auto& branch : branches) {
+        Expr arg = branch[depth]->args[i];
+        const auto* targ = arg->type_as<TensorTypeNode>();
+        int64_t units = GetUnits(branch[0]);
+        if (is_const_int(targ->shape[arg_ndim - 1], 1) && units != 1) {
+          arg = MakeRepeat(arg, static_cast<int>(units), arg_ndim - 1);
+        }
+        tuple.push_back(arg);
+      }
+
+      auto concat = MakeConcatenate(TupleNode::make(tuple), arg_ndim - 1);
+      new_args.push_back(std::move(concat));
+    }
+
+    return CallNode::make(call->op, new_args, call->attrs, {});
+  }
+
+  void UpdateGroupOutput(const Expr& data,
+                         const Group& branches,
+                         size_t depth,
+                         ExprSubstMap* subst_map) {
+    size_t ndim = branches[0][depth]->type_as<TensorTypeNode>()->shape.size();
+    int64_t index = 0;
+    for (const auto& branch : branches) {
+      Array<Integer> begin;
+      Array<Integer> end;
+      for (size_t i = 0; i + 1 < ndim; i++) {
+        begin.push_back(0);
+        end.push_back(NullValue<Integer>());
+      }
+      begin.push_back(index);
+      index += GetUnits(branch[0]);
+      end.push_back(index);
+      auto slice = MakeStridedSlice(data, std::move(begin), std::move(end), Array<Integer>{});
+      subst_map->insert({GetRef<Expr>(branch[depth]), slice});
+    }
+  }
+
+ private:
+  static int64_t GetUnits(const CallNode* dense) {
+    const auto* weight = dense->args[1]->type_as<TensorTypeNode>();
+    const auto* units = weight->shape[0].as<IntImm>();
+    CHECK(units);
+    return units->value;
+  }
+};
+
+/*!
+ * \brief Combine parallel dense if number of branches >= min_num_branches,
+ * into a batch_matmul if to_batch is true and into a dense otherwise.
+ */
+Expr CombineParallelDense(const Expr& expr, uint64_t min_num_branches, bool to_batch) {
+  if (to_batch) {
+    return ParallelDenseCombiner(min_num_branches).Combine(expr);
+  } else {
+    return ParallelDenseToDenseCombiner(min_num_branches).Combine(expr);
+  }
 }
 
 namespace transform {
 
-Pass CombineParallelDense(uint64_t min_num_branches) {
+Pass CombineParallelDense(uint64_t min_num_branches, bool to_batch) {
   runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func =
     [=](Function f, Module m, PassContext pc) {
-      return Downcast<Function>(CombineParallelDense(f, min_num_branches));
+      return Downcast<Function>(CombineParallelDense(f, min_num_branches, to_batch));
   };
   return CreateFunctionPass(pass_func, 4, "CombineParallelDense",
                             {ir::StringImm::make("InferType")});
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dense_to_sparse.cc
+ * \brief Convert dense operators with sparse constant weights into
+ *  block sparse (BSR) sparse_dense operators.
+ */
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/attrs/nn.h>
+#include <tvm/relay/transform.h>
+#include <tvm/relay/op.h>
+#include <cstring>
+#include <vector>
+#include "pattern_util.h"
+
+namespace tvm {
+namespace relay {
+
+Expr MakeSparseDense(Expr data, Expr weight_data, Expr weight_indices, Expr weight_indptr);
+
+// Rewrites nn.dense(x, w) into nn.sparse_dense(x, bsr(w)) when w is a
+// constant float32 matrix in which at least `sparsity_threshold` of the
+// (bs_r, bs_c) blocks are zero.
+//
+// The conversion is done at compile time, so the block shape is known to
+// the sparse_dense schedule.
+class DenseToSparseMutator : public ExprMutator {
+ public:
+  DenseToSparseMutator(int bs_r, int bs_c, double sparsity_threshold)
+      : bs_r_(bs_r), bs_c_(bs_c), sparsity_threshold_(sparsity_threshold) {
+    CHECK_GT(bs_r_, 0);
+    CHECK_GT(bs_c_, 0);
+  }
+
+  Expr VisitExpr_(const CallNode* n) final {
+    Expr new_e = ExprMutator::VisitExpr_(n);
+    if (n->op != dense_op_) return new_e;
+    const auto* call = new_e.as<CallNode>();
+    const auto* data_type = n->args[0]->checked_type().as<TensorTypeNode>();
+    const auto* weight = call->args[1].as<ConstantNode>();
+    const auto* param = call->attrs.as<DenseAttrs>();
+    CHECK(data_type != nullptr && param != nullptr);
+    // sparse_dense only takes 2-D data and outputs its dtype.
+    if (weight == nullptr || data_type->shape.size() != 2 ||
+        data_type->dtype != DataType::Float(32) ||
+        (param->out_dtype.bits() != 0 && param->out_dtype != data_type->dtype)) {
+      return new_e;
+    }
+    Expr bsr_data, bsr_indices, bsr_indptr;
+    if (!ToBSR(weight->data, &bsr_data, &bsr_indices, &bsr_indptr)) {
+      return new_e;
+    }
+    return MakeSparseDense(call->args[0], bsr_data, bsr_indices, bsr_indptr);
+  }
+
+ private:
+  bool ToBSR(const runtime::NDArray& weight, Expr* data, Expr* indices, Expr* indptr) {
+    const DLTensor* w = weight.operator->();
+    if (w->ndim != 2 || w->ctx.device_type != kDLCPU ||
+        DataType(w->dtype) != DataType::Float(32)) {
+      return false;
+    }
+    int64_t rows = w->shape[0], cols = w->shape[1];
+    if (rows % bs_r_ != 0 || cols % bs_c_ != 0) return false;
+    int64_t block_rows = rows / bs_r_, block_cols = cols / bs_c_;
+    const float* src = static_cast<const float*>(w->data);
+    auto block_nonzero = [&](int64_t br, int64_t bc) {
+      for (int64_t i = br * bs_r_; i < (br + 1) * bs_r_; ++i) {
+        for (int64_t j = bc * bs_c_; j < (bc + 1) * bs_c_; ++j) {
+          if (src[i * cols + j] != 0.0f) return true;
+        }
+      }
+      return false;
+    };
+    std::vector<int32_t> block_indptr(1, 0), block_indices;
+    for (int64_t br = 0; br < block_rows; ++br) {
+      for (int64_t bc = 0; bc < block_cols; ++bc) {
+        if (block_nonzero(br, bc)) {
+          block_indices.push_back(static_cast<int32_t>(bc));
+        }
+      }
+      block_indptr.push_back(static_cast<int32_t>(block_indices.size()));
+    }
+    int64_t num_blocks = static_cast<int64_t>(block_indices.size());
+    double sparsity = 1.0 - static_cast<double>(num_blocks) / (block_rows * block_cols);
+    if (num_blocks == 0 || sparsity < sparsity_threshold_) return false;
+
+    DLContext cpu{kDLCPU, 0};
+    auto bsr_data = runtime::NDArray::Empty({num_blocks, bs_r_, bs_c_}, w->dtype, cpu);
+    float* dst = static_cast<float*>(bsr_data->data);
+    for (int64_t br = 0; br < block_rows; ++br) {
+      for (int32_t k = block_indptr[br]; k < block_indptr[br + 1]; ++k) {
+        for (int64_t i = 0; i < bs_r_; ++i) {
+          std::memcpy(dst, src + (br * bs_r_ + i) * cols + block_indices[k] * bs_c_,
+                      bs_c_ * sizeof(float));
+          dst += bs_c_;
+        }
+      }
+    }
+    auto to_array = [&](const std::vector<int32_t>& v) {
+      auto arr = runtime::NDArray::Empty({static_cast<int64_t>(v.size())},
+                                         DataType::Int(32), cpu);
+      std::memcpy(arr->data, v.data(), v.size() * sizeof(int32_t));
+      return arr;
+    };
+    *data = ConstantNode::make(bsr_data);
+    *indices = ConstantNode::make(to_array(block_indices));
+    *indptr = ConstantNode::make(to_array(block_indptr));
+    return true;
+  }
+
+  const Op& dense_op_ = Op::Get("nn.dense");
+  int64_t bs_r_;
+  int64_t bs_c_;
+  double sparsity_threshold_;
+};
+
+Expr DenseToSparse(const Expr& e, int bs_r, int bs_c, double sparsity_threshold) {
+  return DenseToSparseMutator(bs_r, bs_c, sparsity_threshold).Mutate(e);
+}
+
+namespace transform {
+
+Pass DenseToSparse(int bs_r, int bs_c, double sparsity_threshold) {
+  runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func =
+    [=](Function f, Module m, PassContext pc) {
+      return Downcast<Function>(DenseToSparse(f, bs_r, bs_c, sparsity_threshold));
+  };
+  return CreateFunctionPass(pass_func, 0, "DenseToSparse",
+                            {ir::StringImm::make("InferType")});
+}
+
+TVM_REGISTER_API("relay._transform.DenseToSparse")
+.set_body_typed(DenseToSparse);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
@@ -0,0 +1,398 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file eliminate_layout_transforms.cc
+ * \brief Choose the layouts of the regions of elementwise operators between
+ *  layout transforms so that the fewest transforms are left.
+ */
+#include <tvm/data_layout.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/transform.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "infer_layout_util.h"
+#include "pattern_util.h"
+
+namespace tvm {
+namespace relay {
+namespace eliminate_layout_transforms {
+
+// AlterOpLayout picks the layouts operator by operator. The operators which
+// cannot infer a layout from their inputs, and the function outputs, get their
+// inputs transformed back to the original layout, so a region of elementwise
+// operators between two blocked convolutions can end up in NCHW, with an
+// NCHW16c -> NCHW transform at each of its inputs and the reverse at each of
+// its outputs.
+//
+// Elementwise operators whose tensor arguments all have the shape of their
+// output compute the same thing in any layout. This pass groups the connected
+// operators of that kind into regions and looks at the transforms around each
+// region as a whole. It runs the region in the layout of its boundary which
+// moves the fewest bytes through layout transforms, and folds the chains of
+// transforms this leaves, e.g. A -> B -> A into nothing.
+
+const LayoutTransformAttrs* GetLayoutTransform(const Node* node) {
+  static const Op& op = Op::Get("layout_transform");
+  if (node != nullptr && node->IsInstance<CallNode>()) {
+    const auto* call = static_cast<const CallNode*>(node);
+    if (!call->op.same_as(op)) return nullptr;
+    return call->attrs.as<LayoutTransformAttrs>();
+  }
+  return nullptr;
+}
+
+const LayoutTransformAttrs* GetLayoutTransform(const Expr& e) {
+  return GetLayoutTransform(e.get());
+}
+
+int64_t TensorBytes(const Type& type) {
+  const auto* ttype = type.as<TensorTypeNode>();
+  CHECK(ttype != nullptr);
+  int64_t size = (ttype->dtype.bits() * ttype->dtype.lanes() + 7) / 8;
+  for (const auto& dim : ttype->shape) {
+    const auto* value = dim.as<IntImm>();
+    // a dynamic dimension counts as 1, all tensors of a region have its shape
+    if (value != nullptr) {
+      size *= value->value;
+    }
+  }
+  return size;
+}
+
+bool IsScalarTensor(const Expr& e) {
+  const auto* ttype = e->checked_type().as<TensorTypeNode>();
+  return ttype != nullptr && ttype->shape.size() == 0;
+}
+
+// Whether the call computes the same in any layout of its tensors.
+bool IsLayoutAgnostic(const CallNode* call) {
+  static auto fpattern = Op::GetAttr<TOpPattern>("TOpPattern");
+  static auto finfer_layout = Op::GetAttr<FInferCorrectLayout>("FInferCorrectLayout");
+  const auto* op_node = call->op.as<OpNode>();
+  if (op_node == nullptr) return false;
+  Op op = GetRef<Op>(op_node);
+  if (!fpattern.count(op) || fpattern[op] > kBroadcast || !finfer_layout.count(op)) {
+    return false;
+  }
+  const auto* out_type = call->checked_type().as<TensorTypeNode>();
+  if (out_type == nullptr || out_type->shape.size() == 0) return false;
+  AttrsEqual equal;
+  for (const auto& arg : call->args) {
+    const auto* arg_type = arg->checked_type().as<TensorTypeNode>();
+    if (arg_type == nullptr) return false;
+    if (arg_type->shape.size() != 0 && !equal(arg_type->shape, out_type->shape)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsConvertible(const std::string& src, const std::string& dst) {
+  return src == dst || BijectiveLayoutNode::make(Layout(src), Layout(dst)).defined();
+}
+
+/*! \brief A connected set of layout agnostic calls. */
+struct Region {
+  /*! \brief The calls of the region. */
+  std::vector<const CallNode*> nodes;
+  /*! \brief The layout the region is computed in. */
+  std::string layout;
+  /*! \brief The layout the region will be computed in. */
+  std::string chosen;
+};
+
+class RegionFinder {
+ public:
+  /*!
+   * \brief Find the regions of a function body whose layout has to change.
+   * \return false if the body has expressions the pass does not handle.
+   */
+  bool Find(const Expr& body) {
+    bool supported = true;
+    PostOrderVisit(body, [&](const Expr& e) {
+      if (const auto* call = e.as<CallNode>()) {
+        for (const auto& arg : call->args) {
+          users_[arg.get()].push_back(e.get());
+        }
+        if (IsLayoutAgnostic(call)) {
+          parent_[call] = call;
+          order_.push_back(call);
+        }
+      } else if (const auto* tuple = e.as<TupleNode>()) {
+        for (const auto& field : tuple->fields) {
+          users_[field.get()].push_back(e.get());
+        }
+      } else if (const auto* get = e.as<TupleGetItemNode>()) {
+        users_[get->tuple.get()].push_back(e.get());
+      } else if (!e.as<VarNode>() && !e.as<ConstantNode>() && !e.as<OpNode>() &&
+                 !e.as<GlobalVarNode>()) {
+        supported = false;
+      }
+    });
+    if (!supported) return false;
+    // the function output keeps its layout
+    users_[body.get()].push_back(nullptr);
+
+    for (const CallNode* call : order_) {
+      for (const auto& arg : call->args) {
+        const auto* arg_call = arg.as<CallNode>();
+        if (arg_call != nullptr && parent_.count(arg_call) && !IsScalarTensor(arg)) {
+          parent_[FindRoot(arg_call)] = FindRoot(call);
+        }
+      }
+    }
+    std::unordered_map<const CallNode*, size_t> region_index;
+    for (const CallNode* call : order_) {
+      const CallNode* root = FindRoot(call);
+      if (!region_index.count(root)) {
+        region_index[root] = regions_.size();
+        regions_.emplace_back();
+      }
+      regions_[region_index[root]].nodes.push_back(call);
+    }
+    for (auto& region : regions_) {
+      if (ChooseLayout(&region)) {
+        for (const CallNode* call : region.nodes) {
+          region_of_[call] = &region;
+        }
+      }
+    }
+    return true;
+  }
+
+  /*! \brief The regions whose layout changes, by their calls. */
+  std::unordered_map<const CallNode*, const Region*> region_of_;
+
+ private:
+  const CallNode* FindRoot(const CallNode* call) {
+    while (parent_[call] != call) {
+      parent_[call] = parent_[parent_[call]];
+      call = parent_[call];
+    }
+    return call;
+  }
+
+  bool InRegion(const Node* node, const Region& region) {
+    if (node == nullptr || !node->IsInstance<CallNode>()) return false;
+    const auto* call = static_cast<const CallNode*>(node);
+    return parent_.count(call) && FindRoot(call) == FindRoot(region.nodes[0]);
+  }
+
+  // Sets region->layout and region->chosen, returns whether they differ.
+  bool ChooseLayout(Region* region) {
+    // The boundary of the region: its inputs and, for the region outputs, the
+    // layouts their users need. An empty layout stands for the region layout.
+    std::vector<std::tuple<std::string, int64_t> > inputs;
+    std::vector<std::tuple<std::string, int64_t> > outputs;
+    std::string layout;
+    auto set_layout = [&layout](const std::string& l) {
+      if (layout.empty()) layout = l;
+      return layout == l;
+    };
+
+    std::unordered_set<const Node*> visited_inputs;
+    for (const CallNode* call : region->nodes) {
+      for (const auto& arg : call->args) {
+        if (IsScalarTensor(arg) || InRegion(arg.get(), *region) ||
+            !visited_inputs.insert(arg.get()).second) {
+          continue;
+        }
+        int64_t bytes = TensorBytes(arg->checked_type());
+        if (const auto* attrs = GetLayoutTransform(arg)) {
+          if (!set_layout(attrs->dst_layout)) return false;
+          inputs.emplace_back(attrs->src_layout, bytes);
+        } else {
+          inputs.emplace_back("", bytes);
+        }
+      }
+      std::unordered_set<std::string> needed;
+      for (const Node* user : users_[call]) {
+        if (user != nullptr && InRegion(user, *region)) continue;
+        std::string need;
+        if (const auto* attrs = GetLayoutTransform(user)) {
+          if (!set_layout(attrs->src_layout)) return false;
+          need = attrs->dst_layout;
+        }
+        if (needed.insert(need).second) {
+          outputs.emplace_back(need, TensorBytes(call->checked_type()));
+        }
+      }
+    }
+    Layout region_layout(layout);
+    if (layout.empty() || !region_layout.defined()) return false;
+
+    auto cost = [&](const std::string& l) {
+      int64_t total = 0;
+      for (const auto& input : inputs) {
+        const std::string& src = std::get<0>(input).empty() ? layout : std::get<0>(input);
+        if (src != l) {
+          if (!IsConvertible(src, l)) return int64_t(-1);
+          total += std::get<1>(input);
+        }
+      }
+      for (const auto& output : outputs) {
+        const std::string& dst = std::get<0>(output).empty() ? layout : std::get<0>(output);
+        if (dst != l) {
+          if (!IsConvertible(l, dst)) return int64_t(-1);
+          total += std::get<1>(output);
+        }
+      }
+      return total;
+    };
+
+    std::string best = layout;
+    int64_t best_cost = cost(layout);
+    auto try_layout = [&](const std::string& l) {
+      if (l.empty() || !Layout(l).defined()) return;
+      int64_t c = cost(l);
+      if (c >= 0 && (best_cost < 0 || c < best_cost)) {
+        best = l;
+        best_cost = c;
+      }
+    };
+    for (const auto& input : inputs) try_layout(std::get<0>(input));
+    for (const auto& output : outputs) try_layout(std::get<0>(output));
+
+    region->layout = layout;
+    region->chosen = best;
+    return best != layout;
+  }
+
+  std::unordered_map<const Node*, std::vector<const Node*> > users_;
+  std::unordered_map<const CallNode*, const CallNode*> parent_;
+  std::vector<const CallNode*> order_;
+  std::vector<Region> regions_;
+};
+
+class LayoutTransformEliminator : public ExprMutator {
+ public:
+  explicit LayoutTransformEliminator(const RegionFinder& finder)
+      : region_of_(finder.region_of_) {}
+
+  Expr VisitExpr_(const CallNode* call) final {
+    auto it = region_of_.find(call);
+    if (it != region_of_.end()) {
+      // a user outside of the region sees the region in its old layout
+      return Transform(InChosenLayout(call), it->second->chosen, it->second->layout);
+    }
+    if (const auto* attrs = GetLayoutTransform(GetRef<Call>(call))) {
+      const auto* producer = call->args[0].as<CallNode>();
+      auto pit = producer != nullptr ? region_of_.find(producer) : region_of_.end();
+      if (pit != region_of_.end() && attrs->src_layout == pit->second->layout) {
+        return Transform(InChosenLayout(producer), pit->second->chosen, attrs->dst_layout);
+      }
+      return Transform(VisitExpr(call->args[0]), attrs->src_layout, attrs->dst_layout);
+    }
+    return ExprMutator::VisitExpr_(call);
+  }
+
+ private:
+  // The region call computed in the chosen layout of its region.
+  Expr InChosenLayout(const CallNode* call) {
+    auto it = chosen_memo_.find(call);
+    if (it != chosen_memo_.end()) return it->second;
+    const Region* region = region_of_.at(call);
+    Array<Expr> args;
+    for (const auto& arg : call->args) {
+      const auto* arg_call = arg.as<CallNode>();
+      if (IsScalarTensor(arg)) {
+        args.push_back(VisitExpr(arg));
+      } else if (arg_call != nullptr && region_of_.count(arg_call) &&
+                 region_of_.at(arg_call) == region) {
+        args.push_back(InChosenLayout(arg_call));
+      } else if (const auto* attrs = GetLayoutTransform(arg)) {
+        args.push_back(Transform(VisitExpr(arg_call->args[0]), attrs->src_layout, region->chosen));
+      } else {
+        args.push_back(Transform(VisitExpr(arg), region->layout, region->chosen));
+      }
+    }
+    Expr new_call = CallNode::make(call->op, args, call->attrs, call->type_args);
+    chosen_memo_[call] = new_call;
+    return new_call;
+  }
+
+  // Transform the layout of an expression, folding it into the transform
+  // which produced the expression if there is one.
+  Expr Transform(Expr expr, std::string src, const std::string& dst) {
+    if (const auto* attrs = GetLayoutTransform(expr)) {
+      if (attrs->dst_layout == src && IsConvertible(attrs->src_layout, dst)) {
+        src = attrs->src_layout;
+        expr = expr.as<CallNode>()->args[0];
+      }
+    }
+    if (src == dst) return expr;
+    auto key = std::make_tuple(expr.get(), src, dst);
+    auto it = transform_memo_.find(key);
+    if (it != transform_memo_.end()) return it->second;
+    Expr transform = MakeLayoutTransform(expr, src, dst);
+    transform_memo_[key] = transform;
+    return transform;
+  }
+
+  struct KeyHash {
+    size_t operator()(const std::tuple<const Node*, std::string, std::string>& k) const {
+      return dmlc::HashCombine(dmlc::HashCombine(std::hash<const Node*>()(std::get<0>(k)),
+                                                 std::get<1>(k)), std::get<2>(k));
+    }
+  };
+
+  const std::unordered_map<const CallNode*, const Region*>& region_of_;
+  std::unordered_map<const CallNode*, Expr> chosen_memo_;
+  std::unordered_map<std::tuple<const Node*, std::string, std::string>, Expr, KeyHash>
+      transform_memo_;
+};
+
+Expr EliminateLayoutTransforms(const Function& func) {
+  RegionFinder finder;
+  if (!finder.Find(func->body)) {
+    return func;
+  }
+  Expr body = LayoutTransformEliminator(finder).Mutate(func->body);
+  return FunctionNode::make(func->params, body, func->ret_type, func->type_params, func->attrs);
+}
+
+}  // namespace eliminate_layout_transforms
+
+namespace transform {
+
+Pass EliminateLayoutTransforms() {
+  runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func =
+      [=](Function f, Module m, PassContext pc) {
+        return Downcast<Function>(
+            relay::eliminate_layout_transforms::EliminateLayoutTransforms(f));
+      };
+  return CreateFunctionPass(pass_func, 4, "EliminateLayoutTransforms",
+                            {ir::StringImm::make("InferType")});
+}
+
+TVM_REGISTER_API("relay._transform.EliminateLayoutTransforms")
+.set_body_typed(EliminateLayoutTransforms);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
@@ -27,6 +27,10 @@
 #include <tvm/relay/interpreter.h>
 #include <tvm/relay/attrs/transform.h>
 #include <tvm/relay/transform.h>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
 #include "./pattern_util.h"
 
 namespace tvm {
@@ -73,8 +77,262 @@ bool ConstantCheck(const Expr& e) {
 TVM_REGISTER_API("relay._analysis.check_constant")
 .set_body_typed(ConstantCheck);
 
+namespace {
+
+// Largest tensor computed by the native fast path, in elements.
+// Larger tensors are compiled, where the generated code pays off.
+constexpr int64_t kNativeMaxElements = 1 << 20;
+
+// Whether the native fast path computes on dtype. float16 is stored as
+// uint16, so it is left to the compiler like bool.
+bool IsNativeType(const DataType& dtype) {
+  if (dtype.lanes() != 1) return false;
+  if (dtype.is_float()) return dtype.bits() == 32 || dtype.bits() == 64;
+  if (dtype.is_int() || dtype.is_uint()) return dtype.bits() >= 8;
+  return false;
+}
+
+int64_t NumElements(const std::vector<int64_t>& shape) {
+  int64_t size = 1;
+  for (int64_t dim : shape) size *= dim;
+  return size;
+}
+
+// Get a constant shape from a tensor type, false if it is not static.
+bool GetStaticShape(const Type& type, std::vector<int64_t>* shape, DataType* dtype) {
+  const auto* tt = type.as<TensorTypeNode>();
+  if (tt == nullptr) return false;
+  for (const auto& dim : tt->shape) {
+    const auto* imm = dim.as<ir::IntImm>();
+    if (imm == nullptr) return false;
+    shape->push_back(imm->value);
+  }
+  *dtype = tt->dtype;
+  return true;
+}
+
+// Row-major strides of shape, with zero strides on the broadcast dimensions
+// when the shape is aligned to the right of out_ndim dimensions.
+std::vector<int64_t> BroadcastStrides(const std::vector<int64_t>& shape, size_t out_ndim) {
+  std::vector<int64_t> strides(out_ndim, 0);
+  int64_t stride = 1;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    size_t dim = shape.size() - 1 - i;
+    if (shape[dim] != 1) {
+      strides[out_ndim - 1 - i] = stride;
+    }
+    stride *= shape[dim];
+  }
+  return strides;
+}
+
+// Reshape-like ops only change the shape, the result is a view of the input.
+runtime::NDArray FoldView(runtime::NDArray data, const Type& out_type) {
+  std::vector<int64_t> shape;
+  DataType dtype;
+  if (!GetStaticShape(out_type, &shape, &dtype)) return runtime::NDArray();
+  if (DataType(data->dtype) != dtype || NumElements(shape) != NumElements(data.Shape())) {
+    return runtime::NDArray();
+  }
+  return data.CreateView(shape, dtype);
+}
+
+runtime::NDArray FoldTranspose(const runtime::NDArray& data, const TransposeAttrs* param) {
+  std::vector<int64_t> ishape = data.Shape();
+  int ndim = static_cast<int>(ishape.size());
+  std::vector<int> axes;
+  if (!param->axes.defined() || param->axes.size() == 0) {
+    for (int i = ndim - 1; i >= 0; --i) axes.push_back(i);
+  } else {
+    if (static_cast<int>(param->axes.size()) != ndim) return runtime::NDArray();
+    for (const Integer& axis : param->axes) {
+      int64_t a = axis->value;
+      axes.push_back(static_cast<int>(a < 0 ? a + ndim : a));
+    }
+  }
+  std::vector<int64_t> oshape(ndim);
+  std::vector<int64_t> istrides(ndim);
+  int64_t stride = 1;
+  for (int i = ndim - 1; i >= 0; --i) {
+    istrides[i] = stride;
+    stride *= ishape[i];
+  }
+  // strides of the input along each output dimension
+  std::vector<int64_t> strides(ndim);
+  for (int i = 0; i < ndim; ++i) {
+    oshape[i] = ishape[axes[i]];
+    strides[i] = istrides[axes[i]];
+  }
+  runtime::NDArray ret = runtime::NDArray::Empty(oshape, data->dtype, data->ctx);
+  size_t elem_bytes = (data->dtype.bits * data->dtype.lanes + 7) / 8;
+  const char* src = static_cast<const char*>(data->data);
+  char* dst = static_cast<char*>(ret->data);
+  std::vector<int64_t> index(ndim, 0);
+  int64_t offset = 0;
+  int64_t size = NumElements(oshape);
+  for (int64_t i = 0; i < size; ++i) {
+    std::copy(src + offset * elem_bytes, src + (offset + 1) * elem_bytes, dst + i * elem_bytes);
+    // advance the output index, and the input offset with it
+    for (int d = ndim - 1; d >= 0; --d) {
+      offset += strides[d];
+      if (++index[d] < oshape[d]) break;
+      offset -= strides[d] * oshape[d];
+      index[d] = 0;
+    }
+  }
+  return ret;
+}
+
+runtime::NDArray FoldCast(const runtime::NDArray& data, const CastAttrs* param) {
+  DataType src_type(data->dtype);
+  DataType dst_type = param->dtype;
+  if (!IsNativeType(src_type) || !IsNativeType(dst_type)) return runtime::NDArray();
+  runtime::NDArray ret = runtime::NDArray::Empty(data.Shape(), dst_type, data->ctx);
+  int64_t size = NumElements(data.Shape());
+  TVM_DTYPE_DISPATCH(src_type, SrcType, {
+    TVM_DTYPE_DISPATCH(dst_type, DstType, {
+      const SrcType* src = static_cast<const SrcType*>(data->data);
+      DstType* dst = static_cast<DstType*>(ret->data);
+      for (int64_t i = 0; i < size; ++i) {
+        dst[i] = static_cast<DstType>(src[i]);
+      }
+    });
+  });
+  return ret;
+}
+
+// The type in which add, subtract and multiply of DType are computed. Integers
+// use the unsigned promoted type, so that overflow wraps around like in the
+// compiled kernels instead of being undefined.
+template<typename DType, bool = std::is_integral<DType>::value>
+struct WrapType {
+  using type = DType;
+};
+
+template<typename DType>
+struct WrapType<DType, true> {
+  using type = typename std::make_unsigned<decltype(DType() + DType())>::type;
+};
+
+template<typename DType, typename F>
+void BroadcastBinary(const runtime::NDArray& lhs, const runtime::NDArray& rhs,
+                     runtime::NDArray* out, F f) {
+  std::vector<int64_t> oshape = (*out).Shape();
+  size_t ndim = oshape.size();
+  std::vector<int64_t> lstrides = BroadcastStrides(lhs.Shape(), ndim);
+  std::vector<int64_t> rstrides = BroadcastStrides(rhs.Shape(), ndim);
+  const DType* a = static_cast<const DType*>(lhs->data);
+  const DType* b = static_cast<const DType*>(rhs->data);
+  DType* c = static_cast<DType*>((*out)->data);
+  std::vector<int64_t> index(ndim, 0);
+  int64_t loffset = 0, roffset = 0;
+  int64_t size = NumElements(oshape);
+  for (int64_t i = 0; i < size; ++i) {
+    c[i] = f(a[loffset], b[roffset]);
+    for (int d = static_cast<int>(ndim) - 1; d >= 0; --d) {
+      loffset += lstrides[d];
+      roffset += rstrides[d];
+      if (++index[d] < oshape[d]) break;
+      loffset -= lstrides[d] * oshape[d];
+      roffset -= rstrides[d] * oshape[d];
+      index[d] = 0;
+    }
+  }
+}
+
+runtime::NDArray FoldBinary(const std::string& op_name,
+                            const runtime::NDArray& lhs,
+                            const runtime::NDArray& rhs) {
+  DataType dtype(lhs->dtype);
+  if (DataType(rhs->dtype) != dtype || !IsNativeType(dtype)) {
+    return runtime::NDArray();
+  }
+  // integer division rounds differently across ops, leave it to the compiler.
+  if (op_name == "divide" && !dtype.is_float()) return runtime::NDArray();
+  // numpy-style broadcast of the shapes
+  std::vector<int64_t> lshape = lhs.Shape(), rshape = rhs.Shape();
+  size_t ndim = std::max(lshape.size(), rshape.size());
+  std::vector<int64_t> oshape(ndim);
+  for (size_t i = 0; i < ndim; ++i) {
+    int64_t l = i < lshape.size() ? lshape[lshape.size() - 1 - i] : 1;
+    int64_t r = i < rshape.size() ? rshape[rshape.size() - 1 - i] : 1;
+    if (l != r && l != 1 && r != 1) return runtime::NDArray();
+    oshape[ndim - 1 - i] = std::max(l, r);
+  }
+  int64_t size = NumElements(oshape);
+  if (size == 0 || size > kNativeMaxElements) return runtime::NDArray();
+  runtime::NDArray ret = runtime::NDArray::Empty(oshape, dtype, lhs->ctx);
+  TVM_DTYPE_DISPATCH(dtype, DType, {
+    using WType = typename WrapType<DType>::type;
+    if (op_name == "add") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) {
+          return static_cast<DType>(static_cast<WType>(a) + static_cast<WType>(b));
+        });
+    } else if (op_name == "subtract") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) {
+          return static_cast<DType>(static_cast<WType>(a) - static_cast<WType>(b));
+        });
+    } else if (op_name == "multiply") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) {
+          return static_cast<DType>(static_cast<WType>(a) * static_cast<WType>(b));
+        });
+    } else if (op_name == "divide") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) { return a / b; });
+    } else if (op_name == "maximum") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) { return a > b ? a : b; });
+    } else if (op_name == "minimum") {
+      BroadcastBinary<DType>(lhs, rhs, &ret, [](DType a, DType b) { return a < b ? a : b; });
+    }
+  });
+  return ret;
+}
+
+/*!
+ * \brief Evaluate a call of a cheap op on constants directly, without going
+ *  through the compile engine.
+ * \param call The call.
+ * \param args The values of the arguments.
+ * \param out_type The checked type of the call, may be undefined.
+ * \return The result, undefined if the call is not handled.
+ */
+runtime::NDArray NativeEvaluate(const CallNode* call,
+                                const std::vector<runtime::NDArray>& args,
+                                const Type& out_type) {
+  static const std::unordered_set<std::string> view_ops{
+    "reshape", "reshape_like", "squeeze", "expand_dims", "contrib_reverse_reshape"};
+  static const std::unordered_set<std::string> binary_ops{
+    "add", "subtract", "multiply", "divide", "maximum", "minimum"};
+  const OpNode* op = call->op.as<OpNode>();
+  if (op == nullptr || args.empty()) return runtime::NDArray();
+  for (const runtime::NDArray& arg : args) {
+    if (arg->ctx.device_type != kDLCPU || arg->dtype.lanes != 1) return runtime::NDArray();
+  }
+  int64_t size = NumElements(args[0].Shape());
+  if (size == 0) return runtime::NDArray();
+  if (view_ops.count(op->name)) {
+    return FoldView(args[0], out_type);
+  }
+  if (size > kNativeMaxElements) return runtime::NDArray();
+  if (op->name == "transpose" && args.size() == 1) {
+    return FoldTranspose(args[0], call->attrs.as<TransposeAttrs>());
+  } else if (op->name == "cast" && args.size() == 1) {
+    return FoldCast(args[0], call->attrs.as<CastAttrs>());
+  } else if (binary_ops.count(op->name) && args.size() == 2) {
+    return FoldBinary(op->name, args[0], args[1]);
+  }
+  return runtime::NDArray();
+}
+
+}  // namespace
+
 // TODO(tvm-team) consider combine dead-code with constant folder.
 // or make a more powerful partial evaluator.
+//
+// Cheap ops on constants are evaluated natively while mutating. The other
+// foldable calls are only marked as pending, and all the maximal pending
+// subexpressions are evaluated together at the end, so that the interpreter
+// runs a single function instead of one per call. FuseOps(0) still lowers
+// each call to a kernel of its own, but shared subexpressions are evaluated once.
 class ConstantFolder : public ExprMutator {
  public:
   explicit ConstantFolder(FInterpreter executor, Module module)
@@ -87,9 +345,33 @@ class ConstantFolder : public ExprMutator {
         alloc_storage_op_(Op::Get("memory.alloc_storage")),
         cast_op_(Op::Get("cast")) {}
 
+  /*!
+   * \brief Fold all the constant subexpressions of expr.
+   * \param expr The expression.
+   * \return The folded expression.
+   */
+  Expr Fold(const Expr& expr) {
+    Expr res = this->Mutate(expr);
+    if (pending_.empty()) return res;
+    Array<Expr> roots = PendingRoots(res);
+    if (roots.empty()) return res;
+    std::unordered_map<Expr, Expr, NodeHash, NodeEqual> values;
+    if (roots.size() == 1) {
+      values[roots[0]] = ConstEvaluate(roots[0]);
+    } else {
+      Expr tuple = ConstEvaluate(TupleNode::make(roots));
+      const auto* fields = tuple.as<TupleNode>();
+      CHECK(fields != nullptr && fields->fields.size() == roots.size());
+      for (size_t i = 0; i < roots.size(); ++i) {
+        values[roots[i]] = fields->fields[i];
+      }
+    }
+    return PendingReplacer(values).Mutate(res);
+  }
+
   Expr VisitExpr_(const LetNode* op) final {
     Expr value = this->Mutate(op->value);
-    if (value.as<ConstantNode>()) {
+    if (value.as<ConstantNode>() || pending_.count(value)) {
       memo_[op->var] = value;
       return this->Mutate(op->body);
     } else {
@@ -111,6 +393,7 @@ class ConstantFolder : public ExprMutator {
     std::unordered_set<std::string> skip_list{"zeros_like", "ones_like", "full_like", "full"};
 
     auto origin_args = call->args;
+    Type origin_type = call->checked_type_;
     Expr res = ExprMutator::VisitExpr_(call);
     call = res.as<CallNode>();
     // We don't constant fold function with zero arguments.
@@ -139,12 +422,12 @@ class ConstantFolder : public ExprMutator {
 
     bool all_const_args = true;
     for (Expr arg : call->args) {
-      if (!checker_.Check(arg)) {
+      if (!IsFoldable(arg)) {
         all_const_args = false;
       }
     }
     if (all_const_args) {
-      return ConstEvaluate(res);
+      return FoldCall(res, origin_type);
     } else {
       return res;
     }
@@ -156,6 +439,9 @@ class ConstantFolder : public ExprMutator {
     if (const auto* tuple = op->tuple.as<TupleNode>()) {
       return tuple->fields[op->index];
     } else {
+      if (pending_.count(op->tuple)) {
+        pending_.insert(res);
+      }
       return res;
     }
   }
@@ -175,6 +461,89 @@ class ConstantFolder : public ExprMutator {
   const Op& alloc_tensor_op_;
   const Op& alloc_storage_op_;
   const Op& cast_op_;
+  // Foldable calls which are not evaluated yet.
+  std::unordered_set<Expr, NodeHash, NodeEqual> pending_;
+
+  // Collect the maximal pending subexpressions.
+  class PendingCollector : public ExprVisitor {
+   public:
+    explicit PendingCollector(
+        const std::unordered_set<Expr, NodeHash, NodeEqual>& pending)
+        : pending_(pending) {}
+
+    void VisitExpr(const Expr& expr) final {
+      if (pending_.count(expr)) {
+        if (visited_.insert(expr).second) {
+          roots.push_back(expr);
+        }
+        return;
+      }
+      ExprVisitor::VisitExpr(expr);
+    }
+
+    Array<Expr> roots;
+
+   private:
+    const std::unordered_set<Expr, NodeHash, NodeEqual>& pending_;
+    std::unordered_set<Expr, NodeHash, NodeEqual> visited_;
+  };
+
+  // Replace the pending subexpressions by their values.
+  class PendingReplacer : public ExprMutator {
+   public:
+    explicit PendingReplacer(
+        const std::unordered_map<Expr, Expr, NodeHash, NodeEqual>& values)
+        : values_(values) {}
+
+    Expr VisitExpr(const Expr& expr) final {
+      auto it = values_.find(expr);
+      if (it != values_.end()) {
+        return it->second;
+      }
+      return ExprMutator::VisitExpr(expr);
+    }
+
+   private:
+    const std::unordered_map<Expr, Expr, NodeHash, NodeEqual>& values_;
+  };
+
+  Array<Expr> PendingRoots(const Expr& expr) {
+    PendingCollector collector(pending_);
+    collector.VisitExpr(expr);
+    return collector.roots;
+  }
+
+  // Whether expr is a constant, or will be one after evaluation.
+  bool IsFoldable(const Expr& expr) {
+    if (pending_.count(expr)) return true;
+    if (const auto* tuple = expr.as<TupleNode>()) {
+      for (const Expr& field : tuple->fields) {
+        if (!IsFoldable(field)) return false;
+      }
+      return true;
+    }
+    return checker_.Check(expr);
+  }
+
+  // Fold a call whose arguments are all foldable. Cheap ops on constant
+  // arguments are evaluated right away, the others are deferred.
+  Expr FoldCall(const Expr& expr, const Type& out_type) {
+    const auto* call = expr.as<CallNode>();
+    std::vector<runtime::NDArray> args;
+    for (const Expr& arg : call->args) {
+      const auto* constant = arg.as<ConstantNode>();
+      if (constant == nullptr) break;
+      args.push_back(constant->data);
+    }
+    if (args.size() == call->args.size()) {
+      runtime::NDArray value = NativeEvaluate(call, args, out_type);
+      if (value.defined()) {
+        return ValueToExpr(TensorValueNode::make(value));
+      }
+    }
+    pending_.insert(expr);
+    return expr;
+  }
 
   // Convert value to expression.
   Expr ValueToExpr(Value value) {
@@ -197,7 +566,10 @@ class ConstantFolder : public ExprMutator {
   }
   // Constant evaluate a expression.
   Expr ConstEvaluate(Expr expr) {
+    // Batched expressions share subexpressions, which the interpreter
+    // only accepts in A-normal form.
     std::vector<transform::Pass> passes = {transform::FuseOps(0),
+                                           transform::ToANormalForm(),
                                            transform::InferType()};
     Function func;
     if (expr.as<FunctionNode>()) {
@@ -269,7 +641,7 @@ class ConstantFolder : public ExprMutator {
     auto cast_attrs = make_node<CastAttrs>();
     cast_attrs->dtype = param->dtype;
     Expr ret = CallNode::make(cast_op_, { shape }, Attrs(cast_attrs), {});
-    return ConstEvaluate(ret);
+    return FoldCall(ret, Type());
   }
 };
 
@@ -284,7 +656,7 @@ Expr FoldConstant(const Expr& expr, const Module& mod) {
   With<BuildConfig> fresh_build_ctx(BuildConfig::Create());
 
   return ConstantFolder(CreateInterpreter(
-      mod, ctx, target), mod).Mutate(expr);
+      mod, ctx, target), mod).Fold(expr);
 }
 
 namespace transform {
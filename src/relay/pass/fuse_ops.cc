@@ -24,6 +24,7 @@
  * \brief This is a backend-aware optimization pass.
  *   Fuse necessary ops into a single one.
  */
+#include <tvm/build_module.h>
 #include <tvm/expr_operator.h>
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/expr_functor.h>
@@ -72,6 +73,12 @@ namespace relay {
       will still run correctly.
   - CommitFuse: mark all the nodes between source and post-dominator as the same group.
   - We use an Union-Find data structure to manage the groups.
+
+  With fuse_opt_level >= 4, an additional chain fusion step merges a conv2d group
+  into the group of the conv2d that directly and exclusively consumes its output
+  (e.g. depthwise followed by pointwise convolution in MobileNet blocks). The backend
+  schedule then computes the producer tile by tile inside the consumer, so the
+  intermediate feature map only lives in a small scratch buffer.
 */
 using common::LinkNode;
 using common::LinkedList;
@@ -684,6 +691,56 @@ class GraphPartitioner {
     }
   }
 
+  // Check whether the node is a NCHW conv2d that can participate in chain fusion.
+  static bool IsChainableConv2D(const tvm::Node* ref, bool allow_depthwise) {
+    static const Op& conv2d_op = Op::Get("nn.conv2d");
+    if (ref == nullptr || !ref->IsInstance<CallNode>()) return false;
+    const CallNode* call = static_cast<const CallNode*>(ref);
+    if (call->op != conv2d_op) return false;
+    const auto* param = call->attrs.as<Conv2DAttrs>();
+    CHECK(param != nullptr);
+    if (param->data_layout != "NCHW" || param->kernel_layout != "OIHW") return false;
+    if (param->groups == 1) return true;
+    if (!allow_depthwise) return false;
+    const auto* wtype = call->args[1]->checked_type().as<TensorTypeNode>();
+    if (wtype == nullptr) return false;
+    const int64_t* in_per_group = as_const_int(wtype->shape[1]);
+    return in_per_group != nullptr && *in_per_group == 1;
+  }
+
+  // Fuse a conv2d group into the conv2d group that consumes its output.
+  // The schedule computes a single producer inside the consumer, so a group
+  // which already absorbed a producer is not chained any further.
+  void RunChainFuse(const IndexedForwardGraph& graph) {
+    std::unordered_set<const Group*> chained;
+    for (size_t nid = 0; nid < groups_.size(); ++nid) {
+      auto* graph_node = graph.post_dfs_order[nid];
+      Group* group_node = groups_[nid]->FindRoot();
+      // Only the output of a complete conv2d group can be chained.
+      if (group_node->root_ref != graph_node->ref) continue;
+      if (group_node->pattern != kOutEWiseFusable) continue;
+      if (!IsChainableConv2D(group_node->master_ref, true)) continue;
+      if (chained.count(group_node)) continue;
+      // The intermediate must only feed the data input of the consumer.
+      if (graph_node->extern_ref) continue;
+      auto* link = graph_node->outputs.head;
+      if (link == nullptr || link->next != nullptr) continue;
+      IndexedForwardGraph::Node* consumer = link->value.node;
+      Group* consumer_group = groups_[consumer->index]->FindRoot();
+      if (consumer_group == group_node) continue;
+      if (consumer_group->pattern != kOutEWiseFusable ||
+          consumer_group->master_ref != consumer->ref) continue;
+      if (!IsChainableConv2D(consumer->ref, false)) continue;
+      const CallNode* call = static_cast<const CallNode*>(consumer->ref);
+      if (call->args[0].get() != graph_node->ref) continue;
+      if (group_node->num_nodes + consumer_group->num_nodes > kMaxFusedOps) continue;
+      // The consumer stays the master of the chain.
+      group_node->parent = consumer_group;
+      consumer_group->num_nodes += group_node->num_nodes;
+      chained.insert(consumer_group);
+    }
+  }
+
   // execute the fusion algorithm.
   void RunFuse(const IndexedForwardGraph& graph,
                const DominatorTree& post_dom_tree,
@@ -800,6 +857,11 @@ GraphPartitioner::Partition(const IndexedForwardGraph& graph) {
   for (int phase = 0; phase < 3; ++phase) {
     this->RunFuse(graph, post_dom_tree, phase);
   }
+  // Chain fusion relies on the tiled conv2d schedules of the CPU backend.
+  Target target = Target::Current(true);
+  if (opt_level_ >= 4 && target.defined() && target->device_type == kDLCPU) {
+    this->RunChainFuse(graph);
+  }
   return std::move(groups_);
 }
 
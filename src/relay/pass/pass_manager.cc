@@ -22,13 +22,23 @@
  * \brief Relay pass manager implementation.
  */
 #include <dmlc/thread_local.h>
+#include <tvm/build_module.h>
+#include <tvm/relay/analysis.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/transform.h>
 #include <tvm/runtime/device_api.h>
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
 #include <stack>
+#include <thread>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "pass_util.h"
 
 namespace tvm {
 namespace relay {
@@ -191,6 +201,24 @@ class FunctionPassNode : public PassNode {
    * \return Return true if the function will be skipped, otherwise false.
    */
   bool SkipFunction(const Function& func) const;
+
+  /*
+   * \brief Check if two function signatures are the same, undefined ones included.
+   */
+  static bool SameType(const Type& lhs, const Type& rhs);
+
+  /*
+   * \brief Run the pass function over the given functions with multiple threads.
+   *
+   * \param mod The module that the pass is applied on.
+   * \param pass_ctx The context that the pass executes on.
+   * \param num_threads The number of threads to be used.
+   * \param updates The functions to be transformed, updated in place.
+   */
+  void RunParallel(const Module& mod,
+                   const PassContext& pass_ctx,
+                   int num_threads,
+                   std::vector<std::pair<GlobalVar, Function> >* updates) const;
 };
 
 RELAY_DEFINE_NODE_REF(FunctionPass, FunctionPassNode, Pass);
@@ -317,18 +345,114 @@ Module FunctionPassNode::operator()(const Module& mod,
   Module updated_mod = ModuleNode::make(mod->functions, mod->type_definitions, mod->Imports());
   std::vector<std::pair<GlobalVar, Function> > updates;
   for (const auto& it : updated_mod->functions) {
-    auto updated_func = SkipFunction(it.second)
-                            ? it.second
-                            : pass_func(it.second, updated_mod, pass_ctx);
-    updates.push_back({it.first, updated_func});
+    updates.push_back({it.first, it.second});
   }
 
+  int num_threads = pass_ctx->num_threads;
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, static_cast<int>(updates.size()));
+  if (num_threads > 1) {
+    RunParallel(updated_mod, pass_ctx, num_threads, &updates);
+  } else {
+    for (auto& pair : updates) {
+      if (SkipFunction(pair.second)) continue;
+      pair.second = pass_func(pair.second, updated_mod, pass_ctx);
+    }
+  }
+
+  // Only the functions changed by the pass are type checked again, the others
+  // keep their definition (and checked types) from the input module.
+  std::unordered_set<const GlobalVarNode*> retyped;
   for (const auto& pair : updates) {
+    const Function& func = updated_mod->functions[pair.first];
+    if (pair.second.same_as(func) && IsTypeChecked(func)) continue;
+    Type old_type = func->checked_type_;
     updated_mod->Add(pair.first, pair.second, true);
+    if (!SameType(old_type, updated_mod->Lookup(pair.first)->checked_type_)) {
+      retyped.insert(pair.first.operator->());
+    }
+  }
+  // The callers of the functions whose signature changed are type checked
+  // again as well, which may in turn change their own signature.
+  for (size_t round = 0; !retyped.empty() && round <= updates.size(); ++round) {
+    std::unordered_set<const GlobalVarNode*> next;
+    for (const auto& pair : updates) {
+      Function func = updated_mod->Lookup(pair.first);
+      bool calls_retyped = false;
+      PostOrderVisit(func, [&](const Expr& e) {
+        if (retyped.count(e.as<GlobalVarNode>())) calls_retyped = true;
+      });
+      if (!calls_retyped) continue;
+      Type old_type = func->checked_type_;
+      updated_mod->Add(pair.first, func, true);
+      if (!SameType(old_type, updated_mod->Lookup(pair.first)->checked_type_)) {
+        next.insert(pair.first.operator->());
+      }
+    }
+    retyped = std::move(next);
   }
   return updated_mod;
 }
 
+bool FunctionPassNode::SameType(const Type& lhs, const Type& rhs) {
+  if (!lhs.defined() || !rhs.defined()) return lhs.defined() == rhs.defined();
+  return AlphaEqual(lhs, rhs);
+}
+
+void FunctionPassNode::RunParallel(
+    const Module& mod,
+    const PassContext& pass_ctx,
+    int num_threads,
+    std::vector<std::pair<GlobalVar, Function> >* updates) const {
+  // Every worker gets its own shallow copy of the module, so that passes which
+  // temporarily add functions to it (e.g. to type check a function) do not race
+  // on the shared module. The copies are created here as creating a module
+  // registers the constructors of its type definitions.
+  std::vector<Module> worker_mods;
+  for (int i = 0; i < num_threads; ++i) {
+    worker_mods.push_back(
+        ModuleNode::make(mod->functions, mod->type_definitions, mod->Imports()));
+  }
+  // The pass context, the build config and the target are thread local,
+  // re-enter them in the workers.
+  Target target = Target::Current(true);
+  BuildConfig build_config = BuildConfig::Current();
+  std::atomic<size_t> next{0};
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto worker = [&](int tid) {
+    With<PassContext> ctx_scope(pass_ctx);
+    With<BuildConfig> build_config_scope(build_config);
+    std::unique_ptr<With<Target> > target_scope;
+    if (target.defined()) {
+      target_scope.reset(new With<Target>(target));
+    }
+    try {
+      for (size_t i = next++; i < updates->size(); i = next++) {
+        auto& pair = (*updates)[i];
+        if (SkipFunction(pair.second)) continue;
+        pair.second = pass_func(pair.second, worker_mods[tid], pass_ctx);
+      }
+    } catch (...) {
+      errors[tid] = std::current_exception();
+      // stop the other workers early.
+      next = updates->size();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int tid = 1; tid < num_threads; ++tid) {
+    threads.emplace_back(worker, tid);
+  }
+  worker(0);
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (const auto& err : errors) {
+    if (err) std::rethrow_exception(err);
+  }
+}
+
 bool FunctionPassNode::SkipFunction(const Function& func) const {
   NodeRef skip_opt = FunctionGetAttr(func, attr::kSkipOptimization);
   const ir::IntImm* pval = skip_opt.as<ir::IntImm>();
@@ -533,6 +657,12 @@ TVM_REGISTER_API("relay._transform.PassContext")
   pctx->fallback_device = fallback_device;
   pctx->required_pass = std::move(required);
   pctx->disabled_pass = std::move(disabled);
+  if (args.size() > 4) {
+    pctx->num_threads = args[4];
+  }
+  if (args.size() > 5) {
+    pctx->memory_budget = args[5];
+  }
   *ret = pctx;
 });
 
@@ -555,7 +685,9 @@ TVM_STATIC_IR_FUNCTOR(IRPrinter, vtable)
   for (const auto& it : node->disabled_pass) {
     p->stream << it << " ";
   }
-  p->stream << "]";
+  p->stream << "]\n";
+  p->stream << "\tnum_threads: " << node->num_threads << "\n";
+  p->stream << "\tmemory_budget: " << node->memory_budget;
 });
 
 class PassContext::Internal {
@@ -49,6 +49,25 @@ GetExprRefCount(const Expr& body);
  */
 bool IsAllPositiveConstant(const Expr& expr);
 
+/*!
+ * \brief Check if every sub-expression of expr carries a resolved checked type,
+ *  i.e. whether type inference on expr would be a no-op.
+ * \param expr The expression to be checked.
+ * \return Whether expr is fully type checked.
+ */
+bool IsTypeChecked(const Expr& expr);
+
+/*!
+ * \brief Check if the calls of global functions in expr still match the
+ *  checked types of the callees in mod, i.e. whether no callee changed its
+ *  signature since expr was type checked. Global functions which are
+ *  polymorphic or used as values are never considered as matching.
+ * \param expr The expression to be checked.
+ * \param mod The module defining the callees.
+ * \return Whether the calls of expr match their callees.
+ */
+bool CalleeTypesMatch(const Expr& expr, const Module& mod);
+
 /*!
  * \brief Substitute var with subst.
  * \param type The type to be substituted.
@@ -22,10 +22,25 @@
  * \file calibrate.cc
  *
  * \brief Create profile graph and calibrate on dataset
+ *
+ *  The profiled tensors are reduced batch by batch into running histograms,
+ *  from which the scales are found by KL-divergence or percentile.
  */
 #include <tvm/relay/analysis.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/op.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/threading_backend.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
 #include "./quantize.h"
 
 namespace tvm {
@@ -95,6 +110,330 @@ Expr CreateStatsCollector(const Expr& expr) {
 TVM_REGISTER_API("relay._quantize.CreateStatsCollector")
 .set_body_typed(CreateStatsCollector);
 
+/*!
+ * \brief Run f(i) for i in [0, n) on the available cores.
+ *  The first error raised by f is rethrown on the caller once all the
+ *  workers are joined.
+ */
+template<typename FLambda>
+void ParallelFor(size_t n, FLambda f) {
+  size_t num_threads = std::min<size_t>(
+      n, static_cast<size_t>(std::max(runtime::threading::MaxConcurrency(), 1)));
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < n; ++i) f(i);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto worker = [&](size_t tid) {
+    try {
+      for (size_t i = next++; i < n; i = next++) f(i);
+    } catch (...) {
+      errors[tid] = std::current_exception();
+      // stop the other workers early.
+      next = n;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto& t : threads) t.join();
+  for (const auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+/*!
+ * \brief Histogram of a tensor over the symmetric range [-threshold, threshold],
+ *  which grows with the data seen so far.
+ */
+struct RunningHistogram {
+  double min_val{std::numeric_limits<double>::infinity()};
+  double max_val{-std::numeric_limits<double>::infinity()};
+  double threshold{0};
+  std::vector<double> counts;
+
+  void Update(const float* data, int64_t size, int num_bins) {
+    if (size == 0) return;
+    float lo = data[0], hi = data[0];
+    for (int64_t i = 1; i < size; ++i) {
+      lo = std::min(lo, data[i]);
+      hi = std::max(hi, data[i]);
+    }
+    min_val = std::min(min_val, static_cast<double>(lo));
+    max_val = std::max(max_val, static_cast<double>(hi));
+    double th = std::max(std::fabs(min_val), std::fabs(max_val));
+    // same convention as numpy.histogram for an empty range.
+    if (th == 0) th = 0.5;
+    if (counts.empty()) {
+      counts.assign(num_bins, 0.0);
+      threshold = th;
+    } else if (th > threshold) {
+      Rebin(th);
+    }
+    double scale = num_bins / (2 * threshold);
+    for (int64_t i = 0; i < size; ++i) {
+      int idx = static_cast<int>((data[i] + threshold) * scale);
+      counts[std::min(std::max(idx, 0), num_bins - 1)] += 1;
+    }
+  }
+
+  // Spread the counts over the bins of the larger range, proportionally to the overlap.
+  void Rebin(double new_threshold) {
+    const int num_bins = static_cast<int>(counts.size());
+    const double old_width = 2 * threshold / num_bins;
+    const double new_width = 2 * new_threshold / num_bins;
+    std::vector<double> new_counts(num_bins, 0.0);
+    for (int k = 0; k < num_bins; ++k) {
+      if (counts[k] == 0) continue;
+      double lo = (k * old_width - threshold + new_threshold) / new_width;
+      double hi = lo + old_width / new_width;
+      for (int j = static_cast<int>(lo); j < num_bins && j < hi; ++j) {
+        double overlap = std::min<double>(hi, j + 1) - std::max<double>(lo, j);
+        new_counts[j] += counts[k] * overlap / (hi - lo);
+      }
+    }
+    counts = std::move(new_counts);
+    threshold = new_threshold;
+  }
+
+  double Edge(int k) const {
+    return -threshold + k * 2 * threshold / counts.size();
+  }
+};
+
+// Replace the zeros of a distribution by eps, taking the amount off the non-zero values.
+static bool SmoothDistribution(std::vector<double>* p, double eps = 0.0001) {
+  size_t n_zeros = std::count(p->begin(), p->end(), 0.0);
+  size_t n_nonzeros = p->size() - n_zeros;
+  if (n_nonzeros == 0) return false;
+  double eps1 = eps * n_zeros / n_nonzeros;
+  for (double& v : *p) {
+    v += (v == 0) ? eps : -eps1;
+    if (v <= 0) return false;
+  }
+  return true;
+}
+
+// The KL-divergence of the normalized distributions, as scipy.stats.entropy.
+static double Entropy(const std::vector<double>& p, const std::vector<double>& q) {
+  double sum_p = 0, sum_q = 0;
+  for (size_t i = 0; i < p.size(); ++i) {
+    sum_p += p[i];
+    sum_q += q[i];
+  }
+  double ret = 0;
+  for (size_t i = 0; i < p.size(); ++i) {
+    double pi = p[i] / sum_p, qi = q[i] / sum_q;
+    ret += pi * std::log(pi / qi);
+  }
+  return ret;
+}
+
+/*!
+ * \brief Find the threshold minimizing the KL-divergence between the histogram
+ *  and its quantized version, same as relay.quantize.kl_divergence.
+ */
+double FindThresholdByKL(const RunningHistogram& hist, int num_quantized_bins) {
+  const std::vector<double>& counts = hist.counts;
+  const int num_bins = static_cast<int>(counts.size());
+  const int zero_bin_idx = num_bins / 2;
+  const int num_half_quantized_bins = num_quantized_bins / 2;
+  CHECK_GE(num_bins, num_quantized_bins);
+
+  double min_divergence = std::numeric_limits<double>::infinity();
+  double opt_threshold = hist.threshold;
+  std::vector<double> quantized_bins(num_quantized_bins);
+  for (int i = num_half_quantized_bins; i <= zero_bin_idx; ++i) {
+    int start = zero_bin_idx - i;
+    int stop = std::min(zero_bin_idx + i + 1, num_bins);
+    int size = stop - start;
+    // reference distribution p, with the outliers in the boundary bins.
+    std::vector<double> p(counts.begin() + start, counts.begin() + stop);
+    p.front() += std::accumulate(counts.begin(), counts.begin() + start, 0.0);
+    p.back() += std::accumulate(counts.begin() + stop, counts.end(), 0.0);
+    // merge the sliced histogram into num_quantized_bins bins.
+    int num_merged_bins = size / num_quantized_bins;
+    for (int j = 0; j < num_quantized_bins; ++j) {
+      int bin_start = j * num_merged_bins;
+      int bin_stop = (j == num_quantized_bins - 1) ? size : bin_start + num_merged_bins;
+      quantized_bins[j] = std::accumulate(counts.begin() + start + bin_start,
+                                          counts.begin() + start + bin_stop, 0.0);
+    }
+    // expand the quantized bins back into candidate distribution q.
+    std::vector<double> q(size, 0.0);
+    for (int j = 0; j < num_quantized_bins; ++j) {
+      int bin_start = j * num_merged_bins;
+      int bin_stop = (j == num_quantized_bins - 1) ? size : bin_start + num_merged_bins;
+      int norm = 0;
+      for (int k = bin_start; k < bin_stop; ++k) norm += (p[k] != 0);
+      if (norm == 0) continue;
+      for (int k = bin_start; k < bin_stop; ++k) {
+        q[k] = p[k] != 0 ? quantized_bins[j] / norm : 0;
+      }
+    }
+    if (!SmoothDistribution(&p) || !SmoothDistribution(&q)) continue;
+    double divergence = Entropy(p, q);
+    if (divergence < min_divergence) {
+      min_divergence = divergence;
+      opt_threshold = hist.Edge(stop);
+    }
+  }
+  return opt_threshold;
+}
+
+/*!
+ * \brief Find the smallest threshold covering the given fraction of the values.
+ */
+double FindThresholdByPercentile(const RunningHistogram& hist, double percentile) {
+  const std::vector<double>& counts = hist.counts;
+  const int num_bins = static_cast<int>(counts.size());
+  const int zero_bin_idx = num_bins / 2;
+  double total = std::accumulate(counts.begin(), counts.end(), 0.0);
+  double covered = counts[zero_bin_idx];
+  for (int i = 0; i < zero_bin_idx; ++i) {
+    if (covered >= percentile * total) return hist.Edge(zero_bin_idx + i + 1);
+    covered += counts[zero_bin_idx - i - 1];
+    if (zero_bin_idx + i + 1 < num_bins) covered += counts[zero_bin_idx + i + 1];
+  }
+  return hist.threshold;
+}
+
+/*!
+ * \brief Runtime module accumulating the statistics of the outputs of the profile
+ *  graph over the calibration dataset.
+ *
+ *  Each batch only updates a fixed size histogram per output, so the memory use does
+ *  not grow with the dataset, and the outputs are processed in parallel.
+ */
+class CalibrationStats : public runtime::ModuleNode {
+ public:
+  CalibrationStats(int num_outputs, int num_bins)
+      : num_bins_(num_bins), hists_(num_outputs) {
+    CHECK_EQ(num_bins % 2, 1) << "The number of histogram bins must be odd";
+  }
+
+  const char* type_key() const final {
+    return "CalibrationStats";
+  }
+
+  runtime::PackedFunc GetFunction(
+      const std::string& name,
+      const runtime::ObjectPtr<runtime::Object>& sptr_to_self) final {
+    if (name == "update") {
+      return runtime::PackedFunc([sptr_to_self, this](runtime::TVMArgs args,
+                                                      runtime::TVMRetValue* rv) {
+        if (args.num_args == 1 && args[0].type_code() == kModuleHandle) {
+          this->UpdateFromRuntime(args[0]);
+        } else {
+          std::vector<runtime::NDArray> outputs;
+          for (int i = 0; i < args.num_args; ++i) {
+            outputs.push_back(args[i]);
+          }
+          this->Update(outputs);
+        }
+      });
+    } else if (name == "min_max") {
+      return runtime::PackedFunc([sptr_to_self, this](runtime::TVMArgs args,
+                                                      runtime::TVMRetValue* rv) {
+        *rv = this->MinMax();
+      });
+    } else if (name == "find_scales") {
+      return runtime::PackedFunc([sptr_to_self, this](runtime::TVMArgs args,
+                                                      runtime::TVMRetValue* rv) {
+        std::string mode = args[0];
+        double param = args[1];
+        *rv = this->FindScales(mode, param);
+      });
+    }
+    return runtime::PackedFunc();
+  }
+
+  /*! \brief Update the statistics with the outputs of a graph runtime after a run. */
+  void UpdateFromRuntime(runtime::Module rt) {
+    runtime::PackedFunc get_output = rt.GetFunction("get_output");
+    CHECK(get_output != nullptr) << "Expect a graph runtime module";
+    std::vector<runtime::NDArray> outputs;
+    for (size_t i = 0; i < hists_.size(); ++i) {
+      runtime::NDArray out = get_output(static_cast<int>(i));
+      outputs.push_back(out);
+    }
+    Update(outputs);
+  }
+
+  void Update(const std::vector<runtime::NDArray>& outputs) {
+    CHECK_EQ(outputs.size(), hists_.size())
+        << "Expect " << hists_.size() << " outputs of the profile graph";
+    DLContext cpu_ctx{kDLCPU, 0};
+    ParallelFor(outputs.size(), [&](size_t i) {
+      runtime::NDArray arr = outputs[i];
+      const DLTensor* t = arr.operator->();
+      CHECK(t->dtype.code == kDLFloat && t->dtype.bits == 32 && t->dtype.lanes == 1)
+          << "Calibration expects float32 outputs";
+      if (t->ctx.device_type != kDLCPU) {
+        arr = arr.CopyTo(cpu_ctx);
+        t = arr.operator->();
+      }
+      int64_t size = 1;
+      for (int k = 0; k < t->ndim; ++k) size *= t->shape[k];
+      const float* ptr = reinterpret_cast<const float*>(
+          static_cast<const char*>(t->data) + t->byte_offset);
+      hists_[i].Update(ptr, size, num_bins_);
+    });
+  }
+
+  runtime::NDArray MinMax() const {
+    runtime::NDArray ret = runtime::NDArray::Empty({static_cast<int64_t>(hists_.size()), 2},
+                                                   DLDataType{kDLFloat, 32, 1},
+                                                   DLContext{kDLCPU, 0});
+    float* data = static_cast<float*>(ret->data);
+    for (size_t i = 0; i < hists_.size(); ++i) {
+      data[2 * i] = static_cast<float>(hists_[i].min_val);
+      data[2 * i + 1] = static_cast<float>(hists_[i].max_val);
+    }
+    return ret;
+  }
+
+  /*!
+   * \brief Find the scale of every output.
+   * \param mode "kl_divergence" or "percentile".
+   * \param param The number of quantized bins for kl_divergence, the fraction of
+   *  values to cover for percentile.
+   */
+  runtime::NDArray FindScales(const std::string& mode, double param) const {
+    runtime::NDArray ret = runtime::NDArray::Empty({static_cast<int64_t>(hists_.size())},
+                                                   DLDataType{kDLFloat, 32, 1},
+                                                   DLContext{kDLCPU, 0});
+    float* data = static_cast<float*>(ret->data);
+    if (mode == "kl_divergence") {
+      ParallelFor(hists_.size(), [&](size_t i) {
+        CHECK(!hists_[i].counts.empty()) << "No calibration data for output " << i;
+        data[i] = static_cast<float>(FindThresholdByKL(hists_[i], static_cast<int>(param)));
+      });
+    } else if (mode == "percentile") {
+      CHECK(param > 0 && param <= 1) << "percentile must be in (0, 1]";
+      ParallelFor(hists_.size(), [&](size_t i) {
+        CHECK(!hists_[i].counts.empty()) << "No calibration data for output " << i;
+        data[i] = static_cast<float>(FindThresholdByPercentile(hists_[i], param));
+      });
+    } else {
+      LOG(FATAL) << "Unknown calibration mode " << mode;
+    }
+    return ret;
+  }
+
+ private:
+  int num_bins_;
+  std::vector<RunningHistogram> hists_;
+};
+
+TVM_REGISTER_API("relay._quantize.CreateCalibrationStats")
+.set_body_typed<runtime::Module(int, int)>([](int num_outputs, int num_bins) {
+  return runtime::Module(runtime::make_object<CalibrationStats>(num_outputs, num_bins));
+});
+
 }  // namespace quantize
 }  // namespace relay
 }  // namespace tvm
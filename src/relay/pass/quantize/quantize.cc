@@ -125,6 +125,7 @@ TVM_STATIC_IR_FUNCTOR(IRPrinter, vtable)
   p->stream << "nbit_activation=" << op->nbit_activation << ", ";
   p->stream << "calibrate_mode=" << op->calibrate_mode << ", ";
   p->stream << "global_scale=" << op->global_scale << ", ";
+  p->stream << "calibrate_percentile=" << op->calibrate_percentile << ", ";
   p->stream << "weight_scale=" << op->weight_scale << ", ";
   p->stream << "skip_conv_layers==" << op->skip_conv_layers << ", ";
   p->stream << "do_simulation==" << op->do_simulation << ", ";
@@ -72,6 +72,7 @@ class QConfigNode : public Node {
   DataType dtype_activation = DataType::Int(32);
   std::string calibrate_mode = "global_scale";
   double global_scale = 8.0;
+  double calibrate_percentile = 0.9999;
   std::string weight_scale = "power2";
   Array<Expr> skip_conv_layers = Array<Expr>(NodePtr<Node>(nullptr));
   bool do_simulation = false;
@@ -88,6 +89,7 @@ class QConfigNode : public Node {
     v->Visit("dtype_activation", &dtype_activation);
     v->Visit("calibrate_mode", &calibrate_mode);
     v->Visit("global_scale", &global_scale);
+    v->Visit("calibrate_percentile", &calibrate_percentile);
     v->Visit("weight_scale", &weight_scale);
     v->Visit("skip_conv_layers", &skip_conv_layers);
     v->Visit("do_simulation", &do_simulation);
@@ -0,0 +1,417 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rematerialize.cc
+ * \brief Recompute cheap operators instead of keeping their outputs alive
+ *  to bound the activation memory of a graph.
+ */
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/op_attr_types.h>
+#include <tvm/relay/transform.h>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tvm {
+namespace relay {
+namespace rematerialize {
+
+// The graph runtime runs the operators in the post order of the graph and
+// keeps each output alive from the operator computing it to its last user.
+// An output computed early and used again much later stays alive across the
+// peak of the activation memory. When it is computed by a cheap operator
+// (elementwise, broadcast or injective such as pad or cast) from inputs which
+// are alive at the peak anyway, or are smaller, computing it again for its
+// later users frees its storage at the peak.
+//
+// The pass greedily recomputes the output saving the most bytes at the peak
+// until the peak is within the budget. The peak is estimated on the unfused
+// operators, the storage of the params and constants is not counted.
+
+/*! \brief The trade-off of the recomputations. */
+struct Tradeoff {
+  /*! \brief The operations recomputed, one per output element. */
+  int64_t extra_flops{0};
+  /*! \brief The estimated peak bytes before recomputing. */
+  int64_t peak_before{0};
+  /*! \brief The estimated peak bytes after recomputing. */
+  int64_t peak_after{0};
+  /*! \brief The number of recomputed calls. */
+  int64_t num_recomputed{0};
+};
+
+class Rematerializer {
+ public:
+  explicit Rematerializer(int64_t memory_budget) : memory_budget_(memory_budget) {}
+
+  /*! \brief Recompute cheap calls of the function until it fits the budget. */
+  Function Run(const Function& func, Tradeoff* tradeoff) {
+    if (!Build(func->body)) {
+      return func;
+    }
+    int64_t peak_step;
+    int64_t peak = Simulate(&peak_step);
+    tradeoff->peak_before = peak;
+    while (peak > memory_budget_) {
+      int64_t new_peak = RecomputeAtPeak(peak_step, peak, tradeoff);
+      if (new_peak >= peak) break;
+      peak = Simulate(&peak_step);
+    }
+    tradeoff->peak_after = peak;
+    if (tradeoff->num_recomputed == 0) {
+      return func;
+    }
+    std::vector<Expr> memo(nodes_.size());
+    Expr body = Rebuild(output_, &memo);
+    return FunctionNode::make(func->params, body, func->ret_type, func->type_params, func->attrs);
+  }
+
+ private:
+  struct Node {
+    /*! \brief The original expression. */
+    Expr expr;
+    /*! \brief The arguments of a call, the fields of a tuple or the tuple of a get item. */
+    std::vector<int> inputs;
+    /*! \brief The bytes of the output of a call. */
+    int64_t bytes{0};
+    /*! \brief The operations of a call, one per output element. */
+    int64_t flops{0};
+    /*! \brief Whether the call is cheap enough to be recomputed. */
+    bool cheap{false};
+  };
+
+  static int64_t NumElements(const TensorTypeNode* ttype) {
+    int64_t size = 1;
+    for (const auto& dim : ttype->shape) {
+      const int64_t* value = as_const_int(dim);
+      if (value == nullptr) return -1;
+      size *= *value;
+    }
+    return size;
+  }
+
+  // Build the graph of the function body, false if it has unsupported expressions.
+  bool Build(const Expr& body) {
+    static auto fpattern = Op::GetAttr<TOpPattern>("TOpPattern");
+    std::unordered_map<const Object*, int> index;
+    bool supported = true;
+    auto input = [&](const Expr& e) {
+      auto it = index.find(e.get());
+      if (it == index.end()) {
+        supported = false;
+        return -1;
+      }
+      return it->second;
+    };
+    PostOrderVisit(body, [&](const Expr& e) {
+      if (!supported || e.as<OpNode>()) return;
+      Node node;
+      node.expr = e;
+      if (const auto* call = e.as<CallNode>()) {
+        for (const auto& arg : call->args) {
+          node.inputs.push_back(input(arg));
+        }
+        std::vector<const TensorTypeNode*> ttypes;
+        if (const auto* ttype = call->checked_type().as<TensorTypeNode>()) {
+          ttypes.push_back(ttype);
+        } else if (const auto* tuple_type = call->checked_type().as<TupleTypeNode>()) {
+          for (const auto& field : tuple_type->fields) {
+            ttypes.push_back(field.as<TensorTypeNode>());
+          }
+        }
+        bool static_shape = !ttypes.empty();
+        for (const auto* ttype : ttypes) {
+          int64_t size = ttype != nullptr ? NumElements(ttype) : -1;
+          if (size < 0) {
+            static_shape = false;
+            break;
+          }
+          node.bytes += size * ((ttype->dtype.bits() * ttype->dtype.lanes() + 7) / 8);
+          node.flops += size;
+        }
+        if (!static_shape) {
+          node.bytes = 0;
+          node.flops = 0;
+        }
+        const auto* op = call->op.as<OpNode>();
+        node.cheap = static_shape && call->checked_type().as<TensorTypeNode>() &&
+            op != nullptr && fpattern.count(GetRef<Op>(op)) &&
+            fpattern[GetRef<Op>(op)] <= kInjective;
+      } else if (const auto* tuple = e.as<TupleNode>()) {
+        for (const auto& field : tuple->fields) {
+          node.inputs.push_back(input(field));
+        }
+      } else if (const auto* get = e.as<TupleGetItemNode>()) {
+        node.inputs.push_back(input(get->tuple));
+      } else if (!e.as<VarNode>() && !e.as<ConstantNode>()) {
+        supported = false;
+        return;
+      }
+      index[e.get()] = static_cast<int>(nodes_.size());
+      nodes_.push_back(std::move(node));
+    });
+    if (!supported) return false;
+    output_ = index.at(body.get());
+    return true;
+  }
+
+  bool IsCall(int id) const {
+    return nodes_[id].expr.as<CallNode>() != nullptr;
+  }
+
+  // The calls whose storage holds the value of a node.
+  void CollectOwners(int id, std::vector<int>* owners) const {
+    if (IsCall(id)) {
+      owners->push_back(id);
+    } else {
+      for (int input : nodes_[id].inputs) {
+        CollectOwners(input, owners);
+      }
+    }
+  }
+
+  void PostOrder(int id, std::vector<bool>* visited) {
+    if ((*visited)[id]) return;
+    (*visited)[id] = true;
+    for (int input : nodes_[id].inputs) {
+      PostOrder(input, visited);
+    }
+    pos_[id] = static_cast<int64_t>(order_.size());
+    order_.push_back(id);
+  }
+
+  // Compute the execution order and the live ranges of the outputs of the
+  // calls, return the peak of the live bytes and set its step.
+  int64_t Simulate(int64_t* peak_step) {
+    size_t n = nodes_.size();
+    order_.clear();
+    pos_.assign(n, -1);
+    last_use_.assign(n, -1);
+    users_.assign(n, std::vector<int>());
+    std::vector<bool> visited(n, false);
+    PostOrder(output_, &visited);
+
+    int64_t num_steps = static_cast<int64_t>(order_.size());
+    for (int id : order_) {
+      for (int input : nodes_[id].inputs) {
+        users_[input].push_back(id);
+        std::vector<int> owners;
+        CollectOwners(input, &owners);
+        for (int owner : owners) {
+          last_use_[owner] = std::max(last_use_[owner], pos_[id]);
+        }
+      }
+    }
+    std::vector<int> outputs;
+    CollectOwners(output_, &outputs);
+    for (int owner : outputs) {
+      last_use_[owner] = num_steps;
+    }
+
+    std::vector<int64_t> delta(num_steps + 2, 0);
+    for (int id : order_) {
+      if (!IsCall(id)) continue;
+      last_use_[id] = std::max(last_use_[id], pos_[id]);
+      delta[pos_[id]] += nodes_[id].bytes;
+      delta[last_use_[id] + 1] -= nodes_[id].bytes;
+    }
+    int64_t live = 0;
+    int64_t peak = 0;
+    *peak_step = 0;
+    for (int64_t step = 0; step < num_steps; ++step) {
+      live += delta[step];
+      if (live > peak) {
+        peak = live;
+        *peak_step = step;
+      }
+    }
+    return peak;
+  }
+
+  bool IsLiveAt(int id, int64_t step) const {
+    return pos_[id] >= 0 && pos_[id] <= step && step <= last_use_[id];
+  }
+
+  // Try the candidates alive across the peak step in the order of the bytes
+  // they save, keep the first recomputation which lowers the peak.
+  int64_t RecomputeAtPeak(int64_t peak_step, int64_t peak, Tradeoff* tradeoff) {
+    std::vector<std::pair<int64_t, int> > candidates;
+    for (int id : order_) {
+      const Node& node = nodes_[id];
+      if (!node.cheap || pos_[id] >= peak_step || last_use_[id] <= peak_step ||
+          last_use_[id] >= static_cast<int64_t>(order_.size())) {
+        continue;
+      }
+      bool direct_users = true;
+      for (int user : users_[id]) {
+        direct_users = direct_users && IsCall(user) && pos_[user] != peak_step;
+      }
+      if (!direct_users) continue;
+      // the inputs not alive at the peak are kept alive for the recomputation
+      int64_t saved = node.bytes;
+      std::unordered_set<int> counted;
+      for (int input : node.inputs) {
+        std::vector<int> owners;
+        CollectOwners(input, &owners);
+        for (int owner : owners) {
+          if (!IsLiveAt(owner, peak_step) && counted.insert(owner).second) {
+            saved -= nodes_[owner].bytes;
+          }
+        }
+      }
+      if (saved > 0) {
+        candidates.emplace_back(saved, id);
+      }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::pair<int64_t, int>& a, const std::pair<int64_t, int>& b) {
+                       return a.first > b.first;
+                     });
+
+    for (const auto& candidate : candidates) {
+      int id = candidate.second;
+      // the users after the peak use a copy of the call
+      int clone = static_cast<int>(nodes_.size());
+      nodes_.push_back(nodes_[id]);
+      std::vector<int> later_users;
+      for (int user : users_[id]) {
+        if (pos_[user] > peak_step) later_users.push_back(user);
+      }
+      auto replace = [this](const std::vector<int>& users, int from, int to) {
+        for (int user : users) {
+          std::replace(nodes_[user].inputs.begin(), nodes_[user].inputs.end(), from, to);
+        }
+      };
+      replace(later_users, id, clone);
+      // the simulation overwrites the order, keep it for the other candidates
+      std::vector<int> order = order_;
+      std::vector<int64_t> pos = pos_;
+      std::vector<int64_t> last_use = last_use_;
+      std::vector<std::vector<int> > users = users_;
+      int64_t new_step;
+      int64_t new_peak = Simulate(&new_step);
+      if (new_peak < peak) {
+        clones_.insert(clone);
+        tradeoff->extra_flops += nodes_[id].flops;
+        tradeoff->num_recomputed += 1;
+        return new_peak;
+      }
+      replace(later_users, clone, id);
+      nodes_.pop_back();
+      order_.swap(order);
+      pos_.swap(pos);
+      last_use_.swap(last_use);
+      users_.swap(users);
+    }
+    return peak;
+  }
+
+  Expr Rebuild(int id, std::vector<Expr>* memo) {
+    if ((*memo)[id].defined()) return (*memo)[id];
+    const Node& node = nodes_[id];
+    Array<Expr> inputs;
+    bool changed = false;
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+      Expr input = Rebuild(node.inputs[i], memo);
+      changed = changed || !input.same_as(nodes_[node.inputs[i]].expr);
+      inputs.push_back(input);
+    }
+    Expr result = node.expr;
+    // a recomputation is a new call to the same operator
+    bool is_clone = clones_.count(id) != 0;
+    if (const auto* call = node.expr.as<CallNode>()) {
+      if (changed || is_clone) {
+        result = CallNode::make(call->op, inputs, call->attrs, call->type_args);
+      }
+    } else if (node.expr.as<TupleNode>()) {
+      if (changed) result = TupleNode::make(inputs);
+    } else if (const auto* get = node.expr.as<TupleGetItemNode>()) {
+      if (changed) result = TupleGetItemNode::make(inputs[0], get->index);
+    }
+    (*memo)[id] = result;
+    return result;
+  }
+
+  /*! \brief The bound of the activation bytes. */
+  int64_t memory_budget_;
+  /*! \brief The nodes of the graph, recomputations are appended. */
+  std::vector<Node> nodes_;
+  /*! \brief The recomputations. */
+  std::unordered_set<int> clones_;
+  /*! \brief The node of the function body. */
+  int output_{-1};
+  /*! \brief The execution order and the step of each node in it. */
+  std::vector<int> order_;
+  std::vector<int64_t> pos_;
+  /*! \brief The last step the output of each call is used at. */
+  std::vector<int64_t> last_use_;
+  /*! \brief The users of each node. */
+  std::vector<std::vector<int> > users_;
+};
+
+Function Rematerialize(const Function& func, int64_t memory_budget, Tradeoff* tradeoff) {
+  Function result = Rematerializer(memory_budget).Run(func, tradeoff);
+  if (tradeoff->num_recomputed > 0) {
+    LOG(INFO) << "Rematerialize: recomputing " << tradeoff->num_recomputed << " calls costs "
+              << tradeoff->extra_flops << " extra operations, and lowers the estimated peak "
+              << "activation memory from " << tradeoff->peak_before << " to "
+              << tradeoff->peak_after << " bytes";
+  }
+  if (tradeoff->peak_after > memory_budget) {
+    LOG(WARNING) << "Rematerialize: the estimated peak activation memory of "
+                 << tradeoff->peak_after << " bytes exceeds the budget of "
+                 << memory_budget << " bytes";
+  }
+  return result;
+}
+
+TVM_REGISTER_API("relay._analysis.RematerializationTradeoff")
+.set_body_typed<Array<tvm::Expr>(const Function&, int64_t)>([](const Function& func,
+                                                               int64_t memory_budget) {
+  Tradeoff tradeoff;
+  Rematerializer(memory_budget).Run(func, &tradeoff);
+  return Array<tvm::Expr>{make_const(DataType::Int(64), tradeoff.extra_flops),
+                          make_const(DataType::Int(64), tradeoff.peak_before),
+                          make_const(DataType::Int(64), tradeoff.peak_after)};
+});
+
+}  // namespace rematerialize
+
+namespace transform {
+
+Pass Rematerialize(int64_t memory_budget) {
+  runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func =
+      [=](Function f, Module m, PassContext pc) {
+        rematerialize::Tradeoff tradeoff;
+        return rematerialize::Rematerialize(f, memory_budget, &tradeoff);
+      };
+  return CreateFunctionPass(pass_func, 0, "Rematerialize",
+                            {ir::StringImm::make("InferType")});
+}
+
+TVM_REGISTER_API("relay._transform.Rematerialize")
+.set_body_typed(Rematerialize);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
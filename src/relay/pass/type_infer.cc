@@ -834,6 +834,10 @@ namespace transform {
 Pass InferType() {
   runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func =
     [=](Function f, Module m, PassContext pc) {
+      // Functions untouched since the last inference keep their types, so
+      // re-running InferType in a pipeline only checks the modified functions
+      // and the callers of functions whose signature changed.
+      if (IsTypeChecked(f) && CalleeTypesMatch(f, m)) return f;
       return Downcast<Function>(InferType(f, m));
   };
   return CreateFunctionPass(pass_func, 0, "InferType", {});
@@ -361,6 +361,73 @@ bool IsNDArrayAllGreaterEqual(const runtime::NDArray& tensor, T value) {
   return true;
 }
 
+bool IsTypeChecked(const Expr& expr) {
+  bool checked = true;
+  PostOrderVisit(expr, [&checked](const Expr& e) {
+    if (!checked) return;
+    // operators, global vars and constructors are typed through the module.
+    if (e.as<OpNode>() || e.as<GlobalVarNode>() || e.as<ConstructorNode>()) return;
+    if (!e->checked_type_.defined() || e->checked_type_.as<IncompleteTypeNode>()) {
+      checked = false;
+    }
+  });
+  return checked;
+}
+
+class CalleeTypeChecker : private ExprVisitor {
+ public:
+  explicit CalleeTypeChecker(const Module& mod) : mod_(mod) {}
+
+  bool Check(const Expr& expr) {
+    this->VisitExpr(expr);
+    return match_;
+  }
+
+ private:
+  void VisitExpr_(const CallNode* call) final {
+    const auto* gvn = call->op.as<GlobalVarNode>();
+    if (gvn == nullptr) {
+      ExprVisitor::VisitExpr_(call);
+      return;
+    }
+    auto it = mod_->functions.find(GetRef<GlobalVar>(gvn));
+    const FuncTypeNode* ftype = nullptr;
+    if (it != mod_->functions.end() && (*it).second->checked_type_.defined()) {
+      ftype = (*it).second->checked_type_.as<FuncTypeNode>();
+    }
+    // polymorphic callees are instantiated per call, they are not compared.
+    if (ftype == nullptr || ftype->type_params.size() != 0 ||
+        ftype->arg_types.size() != call->args.size() ||
+        !call->checked_type_.defined() ||
+        !AlphaEqual(ftype->ret_type, call->checked_type_)) {
+      match_ = false;
+      return;
+    }
+    for (size_t i = 0; i < call->args.size(); ++i) {
+      const Type& arg_type = call->args[i]->checked_type_;
+      if (!arg_type.defined() || !AlphaEqual(ftype->arg_types[i], arg_type)) {
+        match_ = false;
+        return;
+      }
+    }
+    for (const Expr& arg : call->args) {
+      this->VisitExpr(arg);
+    }
+  }
+
+  void VisitExpr_(const GlobalVarNode* op) final {
+    // a global function used as a value is not checked against its uses.
+    match_ = false;
+  }
+
+  const Module& mod_;
+  bool match_{true};
+};
+
+bool CalleeTypesMatch(const Expr& expr, const Module& mod) {
+  return CalleeTypeChecker(mod).Check(expr);
+}
+
 // Cache the operators that are checked recursively to reduce lookup overhead.
 static const auto& expand_dims_op = Op::Get("expand_dims");
 static const auto& reshape_op = Op::Get("reshape");
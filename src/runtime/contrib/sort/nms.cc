@@ -0,0 +1,311 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file nms.cc
+ * \brief CPU kernels of get_valid_counts and non_max_suppression.
+ *
+ *  The results are the same as the ones of the hybrid script versions in
+ *  topi.vision.nms. Boxes are sorted by score only up to top_k, the IoU of a
+ *  box against the remaining ones is computed in a branch free loop over
+ *  separate coordinate arrays, and suppression runs in parallel over the
+ *  batch and, when boxes of different classes do not suppress each other,
+ *  over the classes.
+ */
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <dlpack/dlpack.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace tvm {
+namespace contrib {
+
+using namespace runtime;
+
+namespace {
+
+struct ParallelForEnv {
+  const std::function<void(int64_t)>* body;
+  int64_t num_items;
+};
+
+int ParallelForTask(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+  auto* env = static_cast<ParallelForEnv*>(cdata);
+  for (int64_t i = task_id; i < env->num_items; i += penv->num_task) {
+    (*env->body)(i);
+  }
+  return 0;
+}
+
+// Run body(i) for i in [0, num_items) on the runtime thread pool.
+void ParallelFor(int64_t num_items, const std::function<void(int64_t)>& body) {
+  if (num_items <= 1) {
+    for (int64_t i = 0; i < num_items; ++i) body(i);
+    return;
+  }
+  ParallelForEnv env{&body, num_items};
+  CHECK_EQ(TVMBackendParallelLaunch(ParallelForTask, &env, 0), 0);
+}
+
+void CheckBoxes(DLTensor* data) {
+  CHECK_EQ(data->ndim, 3) << "boxes must be a 3-D tensor";
+  CHECK(data->dtype.code == kDLFloat && data->dtype.bits == 32 && data->dtype.lanes == 1)
+      << "Currently only supports boxes of type float32.";
+}
+
+inline void FillInvalid(float* row, int64_t elem_length) {
+  std::fill(row, row + elem_length, -1.0f);
+}
+
+// A set of boxes of one batch which may suppress each other,
+// as a range of rows in the score-sorted output.
+struct NMSGroup {
+  int64_t batch;
+  std::vector<int32_t> rows;
+};
+
+// Greedy suppression inside a group, rows are in descending score order.
+void SuppressGroup(const NMSGroup& group, float* out, int32_t* box_indices,
+                   int64_t num_anchors, int64_t elem_length, float iou_threshold,
+                   int coord_start, int score_index, int id_index) {
+  const int64_t n = static_cast<int64_t>(group.rows.size());
+  float* batch_out = out + group.batch * num_anchors * elem_length;
+  std::vector<float> left(n), top(n), right(n), bottom(n), area(n);
+  std::vector<int32_t> alive(n, 1);
+  for (int64_t k = 0; k < n; ++k) {
+    const float* box = batch_out + group.rows[k] * elem_length + coord_start;
+    left[k] = box[0];
+    top[k] = box[1];
+    right[k] = box[2];
+    bottom[k] = box[3];
+    area[k] = (box[2] - box[0]) * (box[3] - box[1]);
+  }
+  const float* l = left.data();
+  const float* t = top.data();
+  const float* r = right.data();
+  const float* b = bottom.data();
+  const float* s = area.data();
+  int32_t* keep = alive.data();
+  for (int64_t j = 0; j < n; ++j) {
+    if (!keep[j]) continue;
+    const float a_l = l[j], a_t = t[j], a_r = r[j], a_b = b[j], a_s = s[j];
+    for (int64_t k = j + 1; k < n; ++k) {
+      float w = std::max(0.0f, std::min(a_r, r[k]) - std::max(a_l, l[k]));
+      float h = std::max(0.0f, std::min(a_b, b[k]) - std::max(a_t, t[k]));
+      float inter = h * w;
+      float u = a_s + s[k] - inter;
+      // iou is 0 when u <= 0, which never reaches a positive threshold.
+      float iou = inter / u;
+      keep[k] &= static_cast<int32_t>(!((u > 0.0f) & (iou >= iou_threshold)));
+    }
+  }
+  int32_t* batch_indices = box_indices + group.batch * num_anchors;
+  for (int64_t k = 0; k < n; ++k) {
+    if (keep[k]) continue;
+    float* row = batch_out + group.rows[k] * elem_length;
+    row[score_index] = -1.0f;
+    if (id_index >= 0) row[id_index] = -1.0f;
+    batch_indices[group.rows[k]] = -1;
+  }
+}
+
+}  // namespace
+
+// Move the boxes with a score above score_threshold (and a valid class
+// when id_index >= 0) to the top of each batch, and count them.
+// Remaining rows are filled with -1.
+TVM_REGISTER_GLOBAL("tvm.contrib.sort.get_valid_counts")
+.set_body([](TVMArgs args, TVMRetValue *ret) {
+  DLTensor* data = args[0];
+  DLTensor* valid_count = args[1];
+  DLTensor* out = args[2];
+  float score_threshold = static_cast<float>(static_cast<double>(args[3]));
+  int id_index = args[4];
+  int score_index = args[5];
+  CheckBoxes(data);
+
+  const int64_t batch_size = data->shape[0];
+  const int64_t num_anchors = data->shape[1];
+  const int64_t elem_length = data->shape[2];
+  const float* data_ptr = static_cast<const float*>(data->data);
+  int32_t* count_ptr = static_cast<int32_t*>(valid_count->data);
+  float* out_ptr = static_cast<float*>(out->data);
+
+  ParallelFor(batch_size, [&](int64_t i) {
+    const float* src = data_ptr + i * num_anchors * elem_length;
+    float* dst = out_ptr + i * num_anchors * elem_length;
+    int64_t count = 0;
+    for (int64_t j = 0; j < num_anchors; ++j) {
+      const float* row = src + j * elem_length;
+      if (row[score_index] > score_threshold && (id_index < 0 || row[id_index] >= 0)) {
+        std::copy(row, row + elem_length, dst + count * elem_length);
+        ++count;
+      }
+    }
+    for (int64_t j = count; j < num_anchors; ++j) {
+      FillInvalid(dst + j * elem_length, elem_length);
+    }
+    count_ptr[i] = static_cast<int32_t>(count);
+  });
+});
+
+// Non-maximum suppression over the valid boxes of each batch.
+// Writes the suppressed boxes and, for every output row, the index of the
+// box in the input data (-1 for invalid rows).
+TVM_REGISTER_GLOBAL("tvm.contrib.sort.nms")
+.set_body([](TVMArgs args, TVMRetValue *ret) {
+  DLTensor* data = args[0];
+  DLTensor* valid_count = args[1];
+  DLTensor* out = args[2];
+  DLTensor* box_indices = args[3];
+  int max_output_size = args[4];
+  float iou_threshold = static_cast<float>(static_cast<double>(args[5]));
+  bool force_suppress = args[6];
+  int top_k = args[7];
+  int coord_start = args[8];
+  int score_index = args[9];
+  int id_index = args[10];
+  bool invalid_to_bottom = args[11];
+  CheckBoxes(data);
+
+  const int64_t batch_size = data->shape[0];
+  const int64_t num_anchors = data->shape[1];
+  const int64_t elem_length = data->shape[2];
+  CHECK_LE(coord_start + 4, elem_length);
+  const float* data_ptr = static_cast<const float*>(data->data);
+  const int32_t* count_ptr = static_cast<const int32_t*>(valid_count->data);
+  float* out_ptr = static_cast<float*>(out->data);
+  int32_t* index_ptr = static_cast<int32_t*>(box_indices->data);
+  auto num_valid = [&](int64_t i) {
+    return std::min<int64_t>(std::max<int32_t>(count_ptr[i], 0), num_anchors);
+  };
+
+  // Sort the valid boxes by score, keeping only the top_k ones.
+  std::vector<std::vector<NMSGroup>> batch_groups(batch_size);
+  ParallelFor(batch_size, [&](int64_t i) {
+    const float* src = data_ptr + i * num_anchors * elem_length;
+    float* dst = out_ptr + i * num_anchors * elem_length;
+    int32_t* indices = index_ptr + i * num_anchors;
+    const int64_t count = num_valid(i);
+    int64_t nkeep = count;
+    if (iou_threshold > 0) {
+      if (top_k > 0 && top_k < nkeep) nkeep = top_k;
+      std::vector<int32_t> order(count);
+      for (int64_t j = 0; j < count; ++j) order[j] = static_cast<int32_t>(j);
+      // ties are broken by position, as the stable argsort of the generic version.
+      auto by_score = [&](int32_t lhs, int32_t rhs) {
+        float a = src[lhs * elem_length + score_index];
+        float b = src[rhs * elem_length + score_index];
+        return a > b || (!(b > a) && lhs < rhs);
+      };
+      std::partial_sort(order.begin(), order.begin() + nkeep, order.end(), by_score);
+      for (int64_t j = 0; j < nkeep; ++j) {
+        const float* row = src + order[j] * elem_length;
+        std::copy(row, row + elem_length, dst + j * elem_length);
+        indices[j] = order[j];
+      }
+    } else {
+      std::copy(src, src + count * elem_length, dst);
+      for (int64_t j = 0; j < count; ++j) indices[j] = static_cast<int32_t>(j);
+    }
+    for (int64_t j = nkeep; j < num_anchors; ++j) {
+      FillInvalid(dst + j * elem_length, elem_length);
+      indices[j] = -1;
+    }
+    if (iou_threshold <= 0) return;
+    // Boxes of different classes only suppress each other with force_suppress.
+    std::vector<int32_t> rows;
+    for (int64_t j = 0; j < nkeep; ++j) {
+      const float* row = dst + j * elem_length;
+      if (row[score_index] > 0 && (id_index < 0 || row[id_index] >= 0)) {
+        rows.push_back(static_cast<int32_t>(j));
+      }
+    }
+    if (rows.empty()) return;
+    std::vector<NMSGroup>& groups = batch_groups[i];
+    if (force_suppress || id_index < 0) {
+      groups.push_back(NMSGroup{i, std::move(rows)});
+      return;
+    }
+    std::stable_sort(rows.begin(), rows.end(), [&](int32_t lhs, int32_t rhs) {
+      return dst[lhs * elem_length + id_index] < dst[rhs * elem_length + id_index];
+    });
+    size_t begin = 0;
+    for (size_t j = 1; j <= rows.size(); ++j) {
+      if (j == rows.size() ||
+          dst[rows[j] * elem_length + id_index] != dst[rows[begin] * elem_length + id_index]) {
+        groups.push_back(NMSGroup{i, std::vector<int32_t>(rows.begin() + begin,
+                                                          rows.begin() + j)});
+        begin = j;
+      }
+    }
+  });
+
+  std::vector<const NMSGroup*> work;
+  for (const auto& groups : batch_groups) {
+    for (const auto& group : groups) work.push_back(&group);
+  }
+  // Larger groups first, for a better balance between the threads.
+  std::stable_sort(work.begin(), work.end(), [](const NMSGroup* lhs, const NMSGroup* rhs) {
+    return lhs->rows.size() > rhs->rows.size();
+  });
+  ParallelFor(static_cast<int64_t>(work.size()), [&](int64_t w) {
+    SuppressGroup(*work[w], out_ptr, index_ptr, num_anchors, elem_length,
+                  iou_threshold, coord_start, score_index, id_index);
+  });
+
+  ParallelFor(batch_size, [&](int64_t i) {
+    float* dst = out_ptr + i * num_anchors * elem_length;
+    int32_t* indices = index_ptr + i * num_anchors;
+    const int64_t count = num_valid(i);
+    // Only return max_output_size valid boxes
+    if (max_output_size > 0) {
+      int64_t num_valid_boxes = 0;
+      for (int64_t j = 0; j < count; ++j) {
+        float* row = dst + j * elem_length;
+        if (row[0] < 0) continue;
+        if (num_valid_boxes == max_output_size) {
+          FillInvalid(row, elem_length);
+          indices[j] = -1;
+        } else {
+          ++num_valid_boxes;
+        }
+      }
+    }
+    if (invalid_to_bottom) {
+      int64_t valid_idx = 0;
+      for (int64_t j = 0; j < num_anchors; ++j) {
+        float* row = dst + j * elem_length;
+        if (row[0] < 0) continue;
+        if (valid_idx != j) {
+          std::copy(row, row + elem_length, dst + valid_idx * elem_length);
+        }
+        ++valid_idx;
+      }
+      for (int64_t j = valid_idx; j < num_anchors; ++j) {
+        FillInvalid(dst + j * elem_length, elem_length);
+      }
+    }
+  });
+});
+
+}  // namespace contrib
+}  // namespace tvm
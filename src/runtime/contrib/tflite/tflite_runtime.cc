@@ -21,7 +21,7 @@
  * \file tflite_runtime.cc
  */
 #include <tvm/runtime/registry.h>
-#include <tvm/dtype.h>
+#include <tvm/runtime/data_type.h>
 #include <tensorflow/lite/interpreter.h>
 #include <tensorflow/lite/kernels/register.h>
 #include <tensorflow/lite/model.h>
@@ -79,9 +79,9 @@ DataType TfLiteDType2TVMDType(TfLiteType dtype) {
     case kTfLiteInt64:
       return DataType::Int(64);
     case kTfLiteInt16:
-      returnDataType::Int(16);
+      return DataType::Int(16);
     case kTfLiteInt8:
-      returnDataType::Int(8);
+      return DataType::Int(8);
     case kTfLiteUInt8:
       return DataType::UInt(8);
     case kTfLiteFloat16:
@@ -93,29 +93,107 @@ DataType TfLiteDType2TVMDType(TfLiteType dtype) {
 }
 
 
+TFLiteRuntime::~TFLiteRuntime() {
+  for (auto& s : slots_) {
+    {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->shutdown = true;
+    }
+    s->cv.notify_all();
+    if (s->worker.joinable()) {
+      s->worker.join();
+    }
+  }
+}
+
 void TFLiteRuntime::Init(const std::string& tflite_model_bytes,
-                         TVMContext ctx) {
-  const char* buffer = tflite_model_bytes.c_str();
-  size_t buffer_size = tflite_model_bytes.size();
-  std::unique_ptr<tflite::FlatBufferModel> model =
-    tflite::FlatBufferModel::BuildFromBuffer(buffer, buffer_size);
+                         TVMContext ctx,
+                         int num_interpreters) {
+  CHECK_GE(num_interpreters, 1);
+  // The model keeps pointers into the buffer, which must outlive all interpreters.
+  model_bytes_ = tflite_model_bytes;
+  model_ = tflite::FlatBufferModel::BuildFromBuffer(model_bytes_.data(), model_bytes_.size());
+  CHECK(model_ != nullptr) << "Fail to load tflite model";
   tflite::ops::builtin::BuiltinOpResolver resolver;
-  tflite::InterpreterBuilder(*model, resolver)(&interpreter_);
+  for (int i = 0; i < num_interpreters; ++i) {
+    std::unique_ptr<Slot> slot(new Slot());
+    tflite::InterpreterBuilder(*model_, resolver)(&slot->interpreter);
+    CHECK(slot->interpreter != nullptr) << "Fail to build tflite interpreter";
+    slots_.emplace_back(std::move(slot));
+  }
   ctx_ = ctx;
 }
 
+TFLiteRuntime::Slot* TFLiteRuntime::GetSlot(int slot) const {
+  CHECK(slot >= 0 && slot < static_cast<int>(slots_.size()))
+      << "Invalid interpreter slot " << slot << ", the runtime has "
+      << slots_.size() << " interpreters";
+  return slots_[slot].get();
+}
+
 void TFLiteRuntime::AllocateTensors() {
-  interpreter_->AllocateTensors();
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    Wait(static_cast<int>(i));
+    CHECK_EQ(slots_[i]->interpreter->AllocateTensors(), kTfLiteOk)
+        << "Fail to allocate tensors";
+  }
 }
 
-void TFLiteRuntime::Invoke() {
-  interpreter_->Invoke();
+void TFLiteRuntime::Invoke(int slot) {
+  Slot* s = GetSlot(slot);
+  Wait(slot);
+  CHECK_EQ(s->interpreter->Invoke(), kTfLiteOk) << "Fail to invoke tflite interpreter";
+}
+
+void TFLiteRuntime::InvokeAsync(int slot) {
+  Slot* s = GetSlot(slot);
+  {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (!s->worker.joinable()) {
+      s->worker = std::thread(&TFLiteRuntime::WorkerLoop, this, s);
+    }
+    ++s->pending;
+  }
+  s->cv.notify_all();
 }
 
-void TFLiteRuntime::SetInput(int index, DLTensor* data_in) {
+void TFLiteRuntime::Wait(int slot) {
+  Slot* s = GetSlot(slot);
+  std::string error;
+  {
+    std::unique_lock<std::mutex> lock(s->mutex);
+    s->cv.wait(lock, [s] { return s->pending == 0; });
+    std::swap(error, s->error);
+  }
+  CHECK(error.empty()) << error;
+}
+
+void TFLiteRuntime::WorkerLoop(Slot* s) {
+  std::unique_lock<std::mutex> lock(s->mutex);
+  while (true) {
+    s->cv.wait(lock, [s] { return s->shutdown || s->pending != 0; });
+    // queued invocations are finished before shutting down.
+    if (s->pending == 0) return;
+    lock.unlock();
+    TfLiteStatus status = s->interpreter->Invoke();
+    lock.lock();
+    if (status != kTfLiteOk && s->error.empty()) {
+      s->error = "Fail to invoke tflite interpreter";
+    }
+    --s->pending;
+    s->cv.notify_all();
+  }
+}
+
+void TFLiteRuntime::SetInput(int index, DLTensor* data_in, int slot) {
+  Slot* s = GetSlot(slot);
+  Wait(slot);
+  CHECK(static_cast<size_t>(index) >= s->bound_inputs.size() ||
+        !s->bound_inputs[index].defined())
+      << "Input " << index << " is bound to a caller-owned array, update the array instead";
   DataType dtype(data_in->dtype);
   TVM_DTYPE_DISPATCH(dtype, DType, {
-      DType* dest = interpreter_->typed_input_tensor<DType>(index);
+      DType* dest = s->interpreter->typed_input_tensor<DType>(index);
       DType* src = static_cast<DType*>(data_in->data);
       CHECK(data_in->strides == NULL);
       int64_t size = 1;
@@ -128,8 +206,42 @@ void TFLiteRuntime::SetInput(int index, DLTensor* data_in) {
     });
 }
 
-NDArray TFLiteRuntime::GetOutput(int index) const {
-  TfLiteTensor* output = interpreter_->output_tensor(index);
+void TFLiteRuntime::SetInputZeroCopy(int index, NDArray data_in, int slot) {
+  Slot* s = GetSlot(slot);
+  Wait(slot);
+  tflite::Interpreter* interpreter = s->interpreter.get();
+  CHECK(index >= 0 && static_cast<size_t>(index) < interpreter->inputs().size())
+      << "Invalid input index " << index;
+  int tensor_index = interpreter->inputs()[index];
+  const TfLiteTensor* tensor = interpreter->tensor(tensor_index);
+  const DLTensor* arr = data_in.operator->();
+  CHECK_EQ(arr->ctx.device_type, kDLCPU)
+      << "Zero copy input requires an array on CPU";
+  CHECK(arr->strides == nullptr) << "Zero copy input requires a compact array";
+  CHECK(DataType(arr->dtype) == TfLiteDType2TVMDType(tensor->type))
+      << "Input " << index << " data type mismatch";
+  std::vector<int> dims(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+  CHECK_EQ(arr->ndim, static_cast<int>(dims.size()))
+      << "Input " << index << " shape mismatch";
+  for (int i = 0; i < arr->ndim; ++i) {
+    CHECK_EQ(arr->shape[i], dims[i]) << "Input " << index << " shape mismatch";
+  }
+  // A read-only buffer of the same type and shape replaces the data pointer
+  // of the tensor and keeps the interpreter invokable.
+  const char* data = static_cast<const char*>(arr->data) + arr->byte_offset;
+  TfLiteStatus status = interpreter->SetTensorParametersReadOnly(
+      tensor_index, tensor->type, tensor->name, dims, tensor->params, data, tensor->bytes);
+  CHECK_EQ(status, kTfLiteOk) << "Fail to bind input " << index;
+  if (s->bound_inputs.size() <= static_cast<size_t>(index)) {
+    s->bound_inputs.resize(index + 1);
+  }
+  s->bound_inputs[index] = data_in;
+}
+
+NDArray TFLiteRuntime::GetOutput(int index, int slot) {
+  Slot* s = GetSlot(slot);
+  Wait(slot);
+  TfLiteTensor* output = s->interpreter->output_tensor(index);
   DataType dtype = TfLiteDType2TVMDType(output->type);
   TfLiteIntArray* dims = output->dims;
   int64_t size = 1;
@@ -141,7 +253,7 @@ NDArray TFLiteRuntime::GetOutput(int index) const {
   NDArray ret = NDArray::Empty(shape, dtype, ctx_);
   TVM_DTYPE_DISPATCH(dtype, DType, {
       DType* dest = static_cast<DType*>(ret->data);
-      DType* src = interpreter_->typed_output_tensor<DType>(index);
+      DType* src = s->interpreter->typed_output_tensor<DType>(index);
       for (int64_t i = 0; i < size; ++i) {
         dest[i] = src[i];
       }
@@ -149,23 +261,85 @@ NDArray TFLiteRuntime::GetOutput(int index) const {
   return ret;
 }
 
+/*! \brief Manager of an output view, keeping the runtime alive */
+struct TFLiteOutputView {
+  std::vector<int64_t> shape;
+  ObjectPtr<Object> runtime;
+  DLManagedTensor tensor;
+
+  static void Deleter(DLManagedTensor* tensor) {
+    delete static_cast<TFLiteOutputView*>(tensor->manager_ctx);
+  }
+};
+
+NDArray TFLiteRuntime::GetOutputView(int index, int slot) {
+  Slot* s = GetSlot(slot);
+  Wait(slot);
+  TfLiteTensor* output = s->interpreter->output_tensor(index);
+  CHECK(output != nullptr && output->data.raw != nullptr)
+      << "Output " << index << " is not allocated";
+  TFLiteOutputView* view = new TFLiteOutputView();
+  for (int i = 0; i < output->dims->size; ++i) {
+    view->shape.push_back(output->dims->data[i]);
+  }
+  view->runtime = GetObjectPtr<Object>(this);
+  DLTensor& dl_tensor = view->tensor.dl_tensor;
+  dl_tensor.data = output->data.raw;
+  // the interpreter memory is on host.
+  dl_tensor.ctx = TVMContext{kDLCPU, 0};
+  dl_tensor.ndim = static_cast<int>(view->shape.size());
+  dl_tensor.dtype = TfLiteDType2TVMDType(output->type);
+  dl_tensor.shape = view->shape.data();
+  dl_tensor.strides = nullptr;
+  dl_tensor.byte_offset = 0;
+  view->tensor.manager_ctx = view;
+  view->tensor.deleter = TFLiteOutputView::Deleter;
+  return NDArray::FromDLPack(&view->tensor);
+}
+
 PackedFunc TFLiteRuntime::GetFunction(
     const std::string& name,
     const ObjectPtr<Object>& sptr_to_self) {
   // Return member functions during query.
+  // The interpreter slot is an optional trailing argument, 0 by default.
   if (name == "set_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         int in_idx = args[0];
         CHECK_GE(in_idx, 0);
-        this->SetInput(in_idx, args[1]);
+        int slot = args.num_args > 2 ? static_cast<int>(args[2]) : 0;
+        this->SetInput(in_idx, args[1], slot);
+      });
+  } else if (name == "set_input_zero_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int slot = args.num_args > 2 ? static_cast<int>(args[2]) : 0;
+        this->SetInputZeroCopy(args[0], args[1], slot);
       });
   } else if (name == "get_output") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-        *rv = this->GetOutput(args[0]);
+        int slot = args.num_args > 1 ? static_cast<int>(args[1]) : 0;
+        *rv = this->GetOutput(args[0], slot);
+      });
+  } else if (name == "get_output_view") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int slot = args.num_args > 1 ? static_cast<int>(args[1]) : 0;
+        *rv = this->GetOutputView(args[0], slot);
       });
   } else if (name == "invoke") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-        this->Invoke();
+        int slot = args.num_args > 0 ? static_cast<int>(args[0]) : 0;
+        this->Invoke(slot);
+      });
+  } else if (name == "invoke_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->InvokeAsync(args[0]);
+      });
+  } else if (name == "wait") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->Wait(args[0]);
+      });
+  } else if (name == "num_interpreters") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->NumInterpreters();
       });
   } else if (name == "allocate_tensors") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
@@ -177,15 +351,17 @@ PackedFunc TFLiteRuntime::GetFunction(
 }
 
 Module TFLiteRuntimeCreate(const std::string& tflite_model_bytes,
-                           TVMContext ctx) {
+                           TVMContext ctx,
+                           int num_interpreters) {
   auto exec = make_object<TFLiteRuntime>();
-  exec->Init(tflite_model_bytes, ctx);
+  exec->Init(tflite_model_bytes, ctx, num_interpreters);
   return Module(exec);
 }
 
 TVM_REGISTER_GLOBAL("tvm.tflite_runtime.create")
   .set_body([](TVMArgs args, TVMRetValue* rv) {
-    *rv = TFLiteRuntimeCreate(args[0], args[1]);
+    int num_interpreters = args.num_args > 2 ? static_cast<int>(args[2]) : 1;
+    *rv = TFLiteRuntimeCreate(args[0], args[1], num_interpreters);
   });
 }  // namespace runtime
 }  // namespace tvm
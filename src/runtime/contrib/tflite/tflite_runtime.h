@@ -29,9 +29,12 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <memory>
+#include <thread>
 
 namespace tvm {
 namespace runtime {
@@ -42,9 +45,15 @@ namespace runtime {
  *
  *  This runtime can be acccesibly in various language via
  *  TVM runtime PackedFunc API.
+ *
+ *  The runtime holds one or more interpreters built from the same model
+ *  buffer. Each interpreter is a slot with its own inputs and outputs,
+ *  and can be invoked asynchronously, so that several requests run
+ *  concurrently in the same process.
  */
 class TFLiteRuntime : public ModuleNode {
  public:
+  ~TFLiteRuntime();
   /*!
    * \brief Get member function to front-end
    * \param name The name of the function.
@@ -68,23 +77,46 @@ class TFLiteRuntime : public ModuleNode {
   /*!
    * \brief Invoke the internal tflite interpreter and run the whole model in 
    * dependency order.
+   * \param slot The interpreter to run.
+   */
+  void Invoke(int slot = 0);
+  /*!
+   * \brief Queue an invocation of the interpreter and return immediately.
+   *  Invocations of a slot run in order on a worker thread of the slot.
+   * \param slot The interpreter to run.
+   */
+  void InvokeAsync(int slot);
+  /*!
+   * \brief Wait for the queued invocations of a slot to finish.
+   * \param slot The interpreter to wait for.
    */
-  void Invoke();
+  void Wait(int slot);
 
   /*!
    * \brief Initialize the tflite runtime with tflite model and context.
    * \param tflite_model_bytes The tflite model.
    * \param ctx The context where the tflite model will be executed on.
+   * \param num_interpreters The number of interpreters sharing the model.
    */
   void Init(const std::string& tflite_model_bytes,
-            TVMContext ctx);
+            TVMContext ctx,
+            int num_interpreters = 1);
 
   /*!
    * \brief set index-th input to the model.
    * \param index The input index.
    * \param data_in The input data.
+   * \param slot The interpreter.
+   */
+  void SetInput(int index, DLTensor* data_in, int slot = 0);
+  /*!
+   * \brief Bind index-th input of the model to a caller-owned array, without copying.
+   *  The interpreter reads the array directly until another array is bound.
+   * \param index The input index.
+   * \param data_in The input array, a compact CPU array of the input shape and type.
+   * \param slot The interpreter.
    */
-  void SetInput(int index, DLTensor* data_in);
+  void SetInputZeroCopy(int index, NDArray data_in, int slot = 0);
   /*!
    * \brief Return NDArray for given input index.
    * \param index The input index.
@@ -95,13 +127,53 @@ class TFLiteRuntime : public ModuleNode {
   /*!
    * \brief Return NDArray for given output index.
    * \param index The output index.
+   * \param slot The interpreter.
    *
    * \return NDArray corresponding to given output node index.
    */
-  NDArray GetOutput(int index) const;
+  NDArray GetOutput(int index, int slot = 0);
+  /*!
+   * \brief Return a view of the output memory of the interpreter, without copying.
+   *  The view is overwritten by the next invocation of the slot and must not
+   *  be used after tensors are allocated again.
+   * \param index The output index.
+   * \param slot The interpreter.
+   *
+   * \return NDArray sharing memory with the output.
+   */
+  NDArray GetOutputView(int index, int slot = 0);
+  /*!
+   * \return The number of interpreters.
+   */
+  int NumInterpreters() const {
+    return static_cast<int>(slots_.size());
+  }
 
  private:
-  std::unique_ptr<tflite::Interpreter> interpreter_;
+  /*! \brief An interpreter and its asynchronous invoke queue. */
+  struct Slot {
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    /*! \brief Caller-owned arrays bound to the inputs */
+    std::vector<NDArray> bound_inputs;
+    /*! \brief Worker thread running queued invocations */
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    /*! \brief Number of queued invocations that are not finished */
+    int pending{0};
+    bool shutdown{false};
+    /*! \brief Error of the last failed queued invocation */
+    std::string error;
+  };
+  // get the slot, checking the index
+  Slot* GetSlot(int slot) const;
+  // run the queued invocations of a slot
+  void WorkerLoop(Slot* slot);
+
+  // the model bytes, shared by all interpreters
+  std::string model_bytes_;
+  std::unique_ptr<tflite::FlatBufferModel> model_;
+  std::vector<std::unique_ptr<Slot>> slots_;
   TVMContext ctx_;
 };
 
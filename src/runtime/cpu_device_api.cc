@@ -83,9 +83,22 @@ class CPUDeviceAPI final : public DeviceAPI {
            size);
   }
 
+  // Work on the CPU is done when it returns, the streams are trivial.
+  TVMStreamHandle CreateStream(TVMContext ctx) final {
+    return nullptr;
+  }
+
+  void FreeStream(TVMContext ctx, TVMStreamHandle stream) final {
+  }
+
   void StreamSync(TVMContext ctx, TVMStreamHandle stream) final {
   }
 
+  void SyncStreamFromTo(TVMContext ctx,
+                        TVMStreamHandle event_src,
+                        TVMStreamHandle event_dst) final {
+  }
+
   void* AllocWorkspace(TVMContext ctx, size_t size, TVMType type_hint) final;
   void FreeWorkspace(TVMContext ctx, void* data) final;
 
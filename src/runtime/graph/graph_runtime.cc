@@ -45,16 +45,77 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
   if (align < kAllocAlignment) return kAllocAlignment;
   return align;
 }
+// Advance strm past one NDArray without allocating it.
+inline void SkipNDArray(dmlc::Stream* strm) {
+  uint64_t header, reserved;
+  DLContext ctx;
+  int ndim;
+  DLDataType dtype;
+  CHECK(strm->Read(&header) && strm->Read(&reserved) &&
+        strm->Read(&ctx) && strm->Read(&ndim) && strm->Read(&dtype))
+      << "Invalid DLTensor file format";
+  CHECK(header == kTVMNDArrayMagic) << "Invalid DLTensor file format";
+  std::vector<int64_t> shape(ndim);
+  if (ndim != 0) {
+    CHECK(strm->ReadArray(&shape[0], ndim)) << "Invalid DLTensor file format";
+  }
+  int64_t data_byte_size;
+  CHECK(strm->Read(&data_byte_size)) << "Invalid DLTensor file format";
+  char buf[4096];
+  while (data_byte_size > 0) {
+    size_t n = static_cast<size_t>(
+        std::min<int64_t>(data_byte_size, sizeof(buf)));
+    CHECK_EQ(strm->Read(buf, n), n) << "Invalid DLTensor file format";
+    data_byte_size -= n;
+  }
+}
 }  // namespace details
 
+constexpr int GraphRuntime::kHostStream;
+
+GraphRuntime::~GraphRuntime() {
+  // Errors cannot be raised from a destructor, the return codes are ignored.
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    const TVMContext& ctx = ctxs_[i / 2];
+    TVMSynchronize(ctx.device_type, ctx.device_id, streams_[i]);
+    TVMStreamFree(ctx.device_type, ctx.device_id, streams_[i]);
+  }
+}
 /*!
  * \brief Run all the operations one by one.
  */
 void GraphRuntime::Run() {
-  // setup the array and requirements.
+  if (streams_.empty()) {
+    // setup the array and requirements.
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (op_execs_[i]) op_execs_[i]();
+    }
+    return;
+  }
+  // Start after the copies and the runs queued before.
+  if (multi_device_) {
+    this->Sync();
+  } else {
+    for (size_t i = 0; i < ctxs_.size(); ++i) {
+      this->WaitStream(2 * i + 1, 2 * i);
+      this->WaitStream(2 * i, 2 * i + 1);
+    }
+  }
+  for (size_t i = 0; i < ctxs_.size(); ++i) {
+    TVM_CCALL(TVMSetStream(ctxs_[i].device_type, ctxs_[i].device_id, streams_[2 * i]));
+  }
   for (size_t i = 0; i < op_execs_.size(); ++i) {
+    for (const StreamWait& wait : node_waits_[i]) {
+      this->WaitStream(wait.src, wait.dst);
+    }
     if (op_execs_[i]) op_execs_[i]();
   }
+  for (const StreamWait& wait : run_end_waits_) {
+    this->WaitStream(wait.src, wait.dst);
+  }
+  for (size_t i = 0; i < ctxs_.size(); ++i) {
+    TVM_CCALL(TVMSetStream(ctxs_[i].device_type, ctxs_[i].device_id, nullptr));
+  }
 }
 /*!
  * \brief Initialize the graph executor with graph and context.
@@ -105,7 +166,31 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
 void GraphRuntime::SetInput(int index, DLTensor* data_in) {
   CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
-  data_entry_[eid].CopyFrom(data_in);
+  if (streams_.empty()) {
+    data_entry_[eid].CopyFrom(data_in);
+  } else {
+    this->SetInputAsync(index, data_in);
+    this->Sync();
+  }
+}
+/*!
+ * \brief set index-th input to the graph, without waiting for the copy.
+ * \param index The input index.
+ * \param data_in The input data.
+ */
+void GraphRuntime::SetInputAsync(int index, DLTensor* data_in) {
+  CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  uint32_t eid = this->entry_id(input_nodes_[index], 0);
+  if (streams_.empty()) {
+    data_entry_[eid].CopyFrom(data_in);
+    return;
+  }
+  DLTensor* entry = const_cast<DLTensor*>(data_entry_[eid].operator->());
+  int stream = this->CopyAsync(data_in, entry);
+  // The nodes on the host read host storage without waiting.
+  if (stream != kHostStream && entry->ctx.device_type == kDLCPU) {
+    this->WaitStream(stream, kHostStream);
+  }
 }
 /*!
  * \brief Get the number of inputs
@@ -175,6 +260,7 @@ int GraphRuntime::NumOutputs() const {
  */
 NDArray GraphRuntime::GetInput(int index) const {
   CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  this->Sync();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   return data_entry_[eid];
 }
@@ -186,6 +272,7 @@ NDArray GraphRuntime::GetInput(int index) const {
  */
 NDArray GraphRuntime::GetOutput(int index) const {
   CHECK_LT(static_cast<size_t>(index), outputs_.size());
+  this->Sync();
   uint32_t eid = this->entry_id(outputs_[index]);
   return data_entry_[eid];
 }
@@ -195,6 +282,15 @@ NDArray GraphRuntime::GetOutput(int index) const {
  * \param data_out the output data.
  */
 void GraphRuntime::CopyOutputTo(int index, DLTensor* data_out) {
+  this->CopyOutputToAsync(index, data_out);
+  this->Sync();
+}
+/*!
+ * \brief Copy index-th output to data_out, without waiting for the copy.
+ * \param index The output index.
+ * \param data_out the output data.
+ */
+void GraphRuntime::CopyOutputToAsync(int index, DLTensor* data_out) {
   CHECK_LT(static_cast<size_t>(index), outputs_.size());
   uint32_t eid = this->entry_id(outputs_[index]);
 
@@ -205,7 +301,20 @@ void GraphRuntime::CopyOutputTo(int index, DLTensor* data_out) {
     CHECK_EQ(data->shape[j], data_out->shape[j]);
   }
 
-  data_entry_[eid].CopyTo(data_out);
+  if (streams_.empty()) {
+    data_entry_[eid].CopyTo(data_out);
+  } else {
+    this->CopyAsync(data.operator->(), data_out);
+  }
+}
+/*!
+ * \brief Wait for all the work queued on the streams.
+ */
+void GraphRuntime::Sync() const {
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    const TVMContext& ctx = ctxs_[i / 2];
+    TVM_CCALL(TVMSynchronize(ctx.device_type, ctx.device_id, streams_[i]));
+  }
 }
 
 /*!
@@ -218,6 +327,7 @@ void GraphRuntime::LoadParams(const std::string& param_blob) {
 }
 
 void GraphRuntime::LoadParams(dmlc::Stream* strm) {
+  this->Sync();
   uint64_t header, reserved;
   CHECK(strm->Read(&header))
       << "Invalid parameters file format";
@@ -233,9 +343,15 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
   size_t size = static_cast<size_t>(sz);
   CHECK(size == weight_names_.size())
       << "Invalid parameters file format";
+  // Aliased params share their storage, only the first of them is loaded.
+  std::vector<bool> loaded(input_nodes_.size(), false);
   for (size_t i = 0; i < size; ++i) {
     int in_idx = GetInputIndex(weight_names_[i]);
     CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << weight_names_[i];
+    if (loaded[in_idx]) {
+      details::SkipNDArray(strm);
+      continue;
+    }
     uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
     CHECK_LT(eid, data_entry_.size());
 
@@ -243,6 +359,10 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
     NDArray temp;
     temp.Load(strm);
     data_entry_[eid].CopyFrom(temp);
+    loaded[in_idx] = true;
+    for (uint32_t alias : input_aliases_[in_idx]) {
+      loaded[alias] = true;
+    }
   }
 }
 
@@ -260,16 +380,25 @@ void GraphRuntime::ShareParams(const GraphRuntime& other, dmlc::Stream* strm) {
   strm->Read(&sz);
   size_t size = static_cast<size_t>(sz);
   CHECK(size == names.size()) << "Invalid parameters file format";
+  std::vector<bool> shared(input_nodes_.size(), false);
   for (size_t i = 0; i < size; ++i) {
     int in_idx = GetInputIndex(names[i]);
     CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << names[i];
-    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
-    CHECK_LT(eid, data_entry_.size());
-    CHECK_EQ(data_entry_[eid].use_count(), 1);
-    data_entry_[eid] = other.GetInput(GetInputIndex(names[i]));
-    CHECK_GT(data_entry_[eid].use_count(), 1);
-    const DLTensor* tmp = data_entry_[eid].operator->();
-    data_alignment_[eid] = details::GetDataAlignment(*tmp);
+    if (shared[in_idx]) continue;
+    NDArray param = other.GetInput(in_idx);
+    // Aliased params keep sharing one storage.
+    std::vector<uint32_t> inputs = input_aliases_[in_idx];
+    inputs.push_back(static_cast<uint32_t>(in_idx));
+    for (uint32_t input : inputs) {
+      uint32_t eid = this->entry_id(input_nodes_[input], 0);
+      CHECK_LT(eid, data_entry_.size());
+      CHECK_EQ(data_entry_[eid].use_count(), 1);
+      data_entry_[eid] = param;
+      CHECK_GT(data_entry_[eid].use_count(), 1);
+      const DLTensor* tmp = data_entry_[eid].operator->();
+      data_alignment_[eid] = details::GetDataAlignment(*tmp);
+      shared[input] = true;
+    }
   }
   this->SetupOpExecs();
 }
@@ -341,10 +470,26 @@ void GraphRuntime::SetupStorage() {
     const DLTensor* tmp = data_entry_[i].operator->();
     data_alignment_[i] = details::GetDataAlignment(*tmp);
   }
+
+  // Inputs planned into the same storage, e.g. deduplicated params.
+  std::unordered_map<int, std::vector<uint32_t>> storage_inputs;
+  for (size_t i = 0; i < input_nodes_.size(); ++i) {
+    int storage_id = attrs_.storage_id[entry_id(input_nodes_[i], 0)];
+    storage_inputs[storage_id].push_back(static_cast<uint32_t>(i));
+  }
+  input_aliases_.assign(input_nodes_.size(), {});
+  for (const auto& kv : storage_inputs) {
+    for (uint32_t i : kv.second) {
+      for (uint32_t j : kv.second) {
+        if (i != j) input_aliases_[i].push_back(j);
+      }
+    }
+  }
 }
 
 void GraphRuntime::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
+  op_args_.resize(this->GetNumOfNodes());
   input_dltensors_.resize(num_node_entries());
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
@@ -370,6 +515,7 @@ void GraphRuntime::SetupOpExecs() {
       std::shared_ptr<OpArgs> op_args = nullptr;
       std::tie(op_execs_[nid], op_args) =
           CreateTVMOp(inode.param, args, inode.inputs.size());
+      op_args_[nid] = op_args;
 
       for (size_t i = 0; i < inode.inputs.size(); i++) {
         uint32_t eid = this->entry_id(inode.inputs[i]);
@@ -392,6 +538,176 @@ void GraphRuntime::SetupOpExecs() {
       LOG(FATAL) << "Unknown op type " << inode.op_type << " in graph runtime";
     }
   }
+  if (!streams_.empty()) {
+    this->SetupStreams();
+  }
+}
+
+void GraphRuntime::EnableStreams() {
+  if (!streams_.empty()) return;
+  std::vector<TVMStreamHandle> streams;
+  int num_devices = 0;
+  for (const TVMContext& ctx : ctxs_) {
+    if (ctx.device_type != kDLCPU) ++num_devices;
+    // The compute stream and the copy stream.
+    for (int k = 0; k < 2; ++k) {
+      TVMStreamHandle stream;
+      TVM_CCALL(TVMStreamCreate(ctx.device_type, ctx.device_id, &stream));
+      streams.push_back(stream);
+    }
+  }
+  streams_ = streams;
+  multi_device_ = num_devices > 1;
+  this->SetupStreams();
+}
+
+void GraphRuntime::SetupStreams() {
+  const int num_streams = static_cast<int>(streams_.size());
+  node_stream_.assign(this->GetNumOfNodes(), kHostStream);
+  node_waits_.assign(this->GetNumOfNodes(), std::vector<StreamWait>());
+  run_end_waits_.clear();
+  // Number of nodes queued on each stream so far.
+  std::vector<uint64_t> queued(num_streams, 0);
+  // seen[x][y]: the number of nodes of stream y that stream x, or the host
+  // for x == num_streams, is known to run after.
+  std::vector<std::vector<uint64_t> > seen(
+      num_streams + 1, std::vector<uint64_t>(num_streams, 0));
+  // The last write and the reads since then of each storage, as the stream
+  // and its number of queued nodes after the access.
+  typedef std::pair<int, uint64_t> Access;
+  std::vector<Access> writer(storage_pool_.size(), Access(kHostStream, 0));
+  std::vector<std::vector<Access> > readers(storage_pool_.size());
+
+  // Order dst after an access, recording the wait needed in waits.
+  auto wait_for = [&](const Access& access, int dst, std::vector<StreamWait>* waits) {
+    int src = access.first;
+    // Work of the host is done by the time anything is queued after it.
+    if (src == kHostStream || src == dst) return;
+    // Streams of different devices are ordered through the host: stream to
+    // stream waits only hold within one context, e.g. not from cuda:0 to cuda:1.
+    if (dst != kHostStream &&
+        (ctxs_[src / 2].device_type != ctxs_[dst / 2].device_type ||
+         ctxs_[src / 2].device_id != ctxs_[dst / 2].device_id)) {
+      dst = kHostStream;
+    }
+    int row = dst == kHostStream ? num_streams : dst;
+    if (seen[row][src] >= access.second) return;
+    waits->push_back(StreamWait{src, dst});
+    // Once the host waited, everything queued later runs after src.
+    int begin = dst == kHostStream ? 0 : row;
+    int end = dst == kHostStream ? num_streams + 1 : row + 1;
+    for (int r = begin; r < end; ++r) {
+      seen[r][src] = std::max(seen[r][src], queued[src]);
+      for (int y = 0; y < num_streams; ++y) {
+        seen[r][y] = std::max(seen[r][y], seen[src][y]);
+      }
+    }
+  };
+
+  for (uint32_t nid = 0; nid < this->GetNumOfNodes(); ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null" || inode.param.func_name == "__nop") continue;
+    std::vector<uint32_t> reads, writes;
+    for (const auto& e : inode.inputs) {
+      reads.push_back(attrs_.storage_id[this->entry_id(e)]);
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      writes.push_back(attrs_.storage_id[this->entry_id(nid, index)]);
+    }
+    // Kernels go to the compute stream of their context, copies to the copy
+    // stream of the device side. Other nodes run on the host.
+    int stream = kHostStream;
+    if (inode.op_type == "tvm_op") {
+      const DLTensor* out = data_entry_[this->entry_id(nid, 0)].operator->();
+      if (inode.param.func_name == "__copy") {
+        const DLTensor* in = data_entry_[this->entry_id(inode.inputs[0])].operator->();
+        int ctx_index = ContextIndex(in->ctx.device_type != kDLCPU ? in->ctx : out->ctx);
+        CHECK_GE(ctx_index, 0);
+        stream = 2 * ctx_index + 1;
+      } else {
+        int ctx_index = ContextIndex(out->ctx);
+        CHECK_GE(ctx_index, 0);
+        stream = 2 * ctx_index;
+      }
+    }
+    std::vector<StreamWait>* waits = &node_waits_[nid];
+    for (uint32_t sid : reads) {
+      wait_for(writer[sid], stream, waits);
+    }
+    for (uint32_t sid : writes) {
+      wait_for(writer[sid], stream, waits);
+      for (const Access& access : readers[sid]) {
+        wait_for(access, stream, waits);
+      }
+    }
+    node_stream_[nid] = stream;
+    uint64_t epoch = stream == kHostStream ? 0 : ++queued[stream];
+    if (stream != kHostStream) {
+      for (uint32_t sid : reads) {
+        auto it = std::find_if(readers[sid].begin(), readers[sid].end(),
+                               [stream](const Access& a) { return a.first == stream; });
+        if (it == readers[sid].end()) {
+          readers[sid].push_back(Access(stream, epoch));
+        } else {
+          it->second = epoch;
+        }
+      }
+    }
+    for (uint32_t sid : writes) {
+      writer[sid] = Access(stream, epoch);
+      readers[sid].clear();
+    }
+    if (op_args_[nid] != nullptr && stream != kHostStream) {
+      op_args_[nid]->stream = streams_[stream];
+    }
+  }
+  // The host may use its storage once the run returns.
+  for (size_t sid = 0; sid < storage_pool_.size(); ++sid) {
+    if (storage_pool_[sid]->ctx.device_type != kDLCPU) continue;
+    wait_for(writer[sid], kHostStream, &run_end_waits_);
+    for (const Access& access : readers[sid]) {
+      wait_for(access, kHostStream, &run_end_waits_);
+    }
+  }
+}
+
+int GraphRuntime::ContextIndex(const TVMContext& ctx) const {
+  for (size_t i = 0; i < ctxs_.size(); ++i) {
+    if (ctxs_[i].device_type == ctx.device_type && ctxs_[i].device_id == ctx.device_id) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+int GraphRuntime::CopyAsync(const DLTensor* from, DLTensor* to) {
+  int ctx_index = ContextIndex(from->ctx.device_type != kDLCPU ? from->ctx : to->ctx);
+  if (ctx_index < 0) {
+    // A device the graph does not use, copy without its streams.
+    this->Sync();
+    TVM_CCALL(TVMArrayCopyFromTo(const_cast<DLTensor*>(from), to, nullptr));
+    return kHostStream;
+  }
+  int stream = 2 * ctx_index + 1;
+  // The storage may still be used by the last run.
+  if (multi_device_) {
+    this->Sync();
+  } else {
+    this->WaitStream(2 * ctx_index, stream);
+  }
+  TVM_CCALL(TVMArrayCopyFromTo(const_cast<DLTensor*>(from), to, streams_[stream]));
+  return stream;
+}
+
+void GraphRuntime::WaitStream(int src, int dst) const {
+  const TVMContext& src_ctx = ctxs_[src / 2];
+  if (dst == kHostStream) {
+    TVM_CCALL(TVMSynchronize(src_ctx.device_type, src_ctx.device_id, streams_[src]));
+  } else {
+    const TVMContext& dst_ctx = ctxs_[dst / 2];
+    TVM_CCALL(TVMStreamStreamSynchronize(dst_ctx.device_type, dst_ctx.device_id,
+                                         streams_[src], streams_[dst]));
+  }
 }
 
 std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRuntime::CreateTVMOp(
@@ -426,7 +742,7 @@ std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRu
     auto fexec = [arg_ptr]() {
       DLTensor* from = static_cast<DLTensor*>(arg_ptr->arg_values[0].v_handle);
       DLTensor* to = static_cast<DLTensor*>(arg_ptr->arg_values[1].v_handle);
-      TVM_CCALL(TVMArrayCopyFromTo(from, to, nullptr));
+      TVM_CCALL(TVMArrayCopyFromTo(from, to, arg_ptr->stream));
     };
     return {fexec, arg_ptr};
   }
@@ -470,6 +786,15 @@ PackedFunc GraphRuntime::GetFunction(
         this->SetInputZeroCopy(args[0], args[1]);
       }
     });
+  } else if (name == "set_input_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        if (args[0].type_code() == kStr) {
+          int in_idx = this->GetInputIndex(args[0]);
+          if (in_idx >= 0) this->SetInputAsync(in_idx, args[1]);
+        } else {
+          this->SetInputAsync(args[0], args[1]);
+        }
+      });
   } else if (name == "get_output") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       if (args.num_args == 2) {
@@ -478,6 +803,18 @@ PackedFunc GraphRuntime::GetFunction(
         *rv = this->GetOutput(args[0]);
       }
     });
+  } else if (name == "get_output_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->CopyOutputToAsync(args[0], args[1]);
+      });
+  } else if (name == "enable_streams") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->EnableStreams();
+      });
+  } else if (name == "sync") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->Sync();
+      });
   } else if (name == "get_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         int in_idx = 0;
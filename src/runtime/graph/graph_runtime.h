@@ -76,6 +76,8 @@ class GraphRuntime : public ModuleNode {
     std::vector<TVMValue> arg_values;
     std::vector<int> arg_tcodes;
     std::vector<int64_t> shape_data;
+    // Stream of the copy nodes, when streams are enabled.
+    TVMStreamHandle stream{nullptr};
   };
 
  public:
@@ -94,6 +96,7 @@ class GraphRuntime : public ModuleNode {
   const char* type_key() const final {
     return "GraphRuntime";
   }
+  ~GraphRuntime();
   void Run();
 
   /*!
@@ -192,6 +195,34 @@ class GraphRuntime : public ModuleNode {
    */
   void ShareParams(const GraphRuntime& other, dmlc::Stream* strm);
 
+  /*!
+   * \brief Execute the graph on streams.
+   *
+   *  Each context gets a compute stream, set with TVMSetStream while running,
+   *  and a copy stream for the inputs, the outputs and the copy nodes. The
+   *  streams wait for each other only where a storage is shared, so copies
+   *  overlap with the kernels and with the host.
+   */
+  void EnableStreams();
+  /*!
+   * \brief set index-th input to the graph, without waiting for the copy.
+   *  data_in must be left unchanged until Sync().
+   * \param index The input index.
+   * \param data_in The input data.
+   */
+  void SetInputAsync(int index, DLTensor* data_in);
+  /*!
+   * \brief Copy index-th output to data_out, without waiting for the copy.
+   *  data_out can be used after Sync().
+   * \param index The output index.
+   * \param data_out the output data.
+   */
+  void CopyOutputToAsync(int index, DLTensor* data_out);
+  /*!
+   * \brief Wait for all the work queued on the streams.
+   */
+  void Sync() const;
+
   /*!
    * \brief Get total number of nodes.
    * \return Total number of nodes.
@@ -411,6 +442,17 @@ class GraphRuntime : public ModuleNode {
   void SetupStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*! \brief Plan the stream and the waits of each node. */
+  void SetupStreams();
+  /*! \brief The index of ctx in ctxs_, -1 if it is not used by the graph. */
+  int ContextIndex(const TVMContext& ctx) const;
+  /*!
+   * \brief Queue a copy on the copy stream of the device side.
+   * \return The stream of the copy, kHostStream if the copy is done.
+   */
+  int CopyAsync(const DLTensor* from, DLTensor* to);
+  /*! \brief Make stream dst wait for stream src, or the host if dst is kHostStream. */
+  void WaitStream(int src, int dst) const;
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -441,6 +483,8 @@ class GraphRuntime : public ModuleNode {
   std::vector<uint32_t> input_nodes_;
   /*! \brief Map of input names to input indices. */
   std::unordered_map<std::string, uint32_t> input_map_;
+  /*! \brief The other inputs sharing the storage of each input. */
+  std::vector<std::vector<uint32_t>> input_aliases_;
   /*! \brief Used for quick node input DLTensor* lookup given an input eid. */
   std::vector<std::vector<DLTensor*>> input_dltensors_;
   /*! \brief Used for quick entry indexing. */
@@ -467,6 +511,27 @@ class GraphRuntime : public ModuleNode {
 
   /*! \brief Arg info of TVM ops */
   std::vector<std::shared_ptr<OpArgs> > op_args_;
+
+  // The host, or work that is done when the node returns.
+  static constexpr int kHostStream = -1;
+  // A point where stream dst waits for the work queued on stream src.
+  struct StreamWait {
+    int src;
+    int dst;
+  };
+  /*!
+   * \brief The streams, empty unless enabled. Context i has the compute
+   *  stream 2 * i and the copy stream 2 * i + 1.
+   */
+  std::vector<TVMStreamHandle> streams_;
+  /*! \brief Whether more than one context is a device with real streams. */
+  bool multi_device_{false};
+  /*! \brief Stream of each node. */
+  std::vector<int> node_stream_;
+  /*! \brief Waits before each node. */
+  std::vector<std::vector<StreamWait> > node_waits_;
+  /*! \brief Waits at the end of Run, for host storage used by streams. */
+  std::vector<StreamWait> run_end_waits_;
 };
 
 std::vector<TVMContext> GetAllContext(const TVMArgs& args);
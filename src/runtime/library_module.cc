@@ -27,10 +27,16 @@
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/registry.h>
 #include <string>
+#include <sstream>
 #include <vector>
 #include <cstdint>
+#include <unordered_map>
 #include "library_module.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <cpuid.h>
+#endif
+
 namespace tvm {
 namespace runtime {
 
@@ -39,6 +45,10 @@ class LibraryModuleNode final : public ModuleNode {
  public:
   explicit LibraryModuleNode(ObjectPtr<Library> lib)
       : lib_(lib) {
+    if (const char* variants = reinterpret_cast<const char*>(
+            lib_->GetSymbol(runtime::symbol::tvm_func_variants))) {
+      variant_suffix_ = SelectFunctionVariant(variants, HostCPUHasFeature);
+    }
   }
 
   const char* type_key() const final {
@@ -54,16 +64,28 @@ class LibraryModuleNode final : public ModuleNode {
           lib_->GetSymbol(runtime::symbol::tvm_module_main));
       CHECK(entry_name!= nullptr)
           << "Symbol " << runtime::symbol::tvm_module_main << " is not presented";
-      faddr = reinterpret_cast<BackendPackedCFunc>(lib_->GetSymbol(entry_name));
+      faddr = GetFunctionAddr(entry_name);
     } else {
-      faddr = reinterpret_cast<BackendPackedCFunc>(lib_->GetSymbol(name.c_str()));
+      faddr = GetFunctionAddr(name);
     }
     if (faddr == nullptr) return PackedFunc();
     return WrapPackedFunc(faddr, sptr_to_self);
   }
 
  private:
+  // Get the address of the selected variant, fallback to the baseline function.
+  BackendPackedCFunc GetFunctionAddr(const std::string& name) {
+    if (variant_suffix_.length() != 0) {
+      if (void* faddr = lib_->GetSymbol((name + variant_suffix_).c_str())) {
+        return reinterpret_cast<BackendPackedCFunc>(faddr);
+      }
+    }
+    return reinterpret_cast<BackendPackedCFunc>(lib_->GetSymbol(name.c_str()));
+  }
+
   ObjectPtr<Library> lib_;
+  // The symbol suffix of function variant selected for this host.
+  std::string variant_suffix_;
 };
 
 /*!
@@ -88,6 +110,138 @@ PackedFunc WrapPackedFunc(BackendPackedCFunc faddr,
     });
 }
 
+std::string SelectFunctionVariant(const std::string& variants,
+                                  std::function<bool(const std::string&)> fhas_feature) {
+  std::istringstream is(variants);
+  std::string mattr, suffix;
+  for (size_t index = 0; std::getline(is, mattr, ';'); ++index) {
+    std::istringstream fs(mattr);
+    std::string feature;
+    bool supported = true;
+    while (supported && std::getline(fs, feature, ',')) {
+      // Only enabled features need support from the host.
+      if (feature.length() < 2 || feature[0] != '+') continue;
+      supported = fhas_feature(feature.substr(1));
+    }
+    if (supported) suffix = FunctionVariantSuffix(index);
+  }
+  return suffix;
+}
+
+namespace {
+
+// A target feature, with the LLVM name, and the cpuid bit that reports it.
+struct CPUFeatureBit {
+  const char* name;
+  unsigned leaf;
+  unsigned subleaf;
+  // 0: eax, 1: ebx, 2: ecx, 3: edx
+  int reg;
+  int bit;
+  // The register state the OS must save, 0: none, 1: avx, 2: avx512.
+  int state;
+};
+
+// The x86 features that function variants can be built with.
+const CPUFeatureBit kCPUFeatures[] = {
+  {"cmov", 1, 0, 3, 15, 0},
+  {"mmx", 1, 0, 3, 23, 0},
+  {"fxsr", 1, 0, 3, 24, 0},
+  {"sse", 1, 0, 3, 25, 0},
+  {"sse2", 1, 0, 3, 26, 0},
+  {"sse3", 1, 0, 2, 0, 0},
+  {"pclmul", 1, 0, 2, 1, 0},
+  {"ssse3", 1, 0, 2, 9, 0},
+  {"fma", 1, 0, 2, 12, 1},
+  {"cx16", 1, 0, 2, 13, 0},
+  {"sse4.1", 1, 0, 2, 19, 0},
+  {"sse4.2", 1, 0, 2, 20, 0},
+  {"movbe", 1, 0, 2, 22, 0},
+  {"popcnt", 1, 0, 2, 23, 0},
+  {"aes", 1, 0, 2, 25, 0},
+  {"xsave", 1, 0, 2, 26, 0},
+  {"avx", 1, 0, 2, 28, 1},
+  {"f16c", 1, 0, 2, 29, 1},
+  {"rdrnd", 1, 0, 2, 30, 0},
+  {"fsgsbase", 7, 0, 1, 0, 0},
+  {"bmi", 7, 0, 1, 3, 0},
+  {"avx2", 7, 0, 1, 5, 1},
+  {"bmi2", 7, 0, 1, 8, 0},
+  {"avx512f", 7, 0, 1, 16, 2},
+  {"avx512dq", 7, 0, 1, 17, 2},
+  {"rdseed", 7, 0, 1, 18, 0},
+  {"adx", 7, 0, 1, 19, 0},
+  {"avx512ifma", 7, 0, 1, 21, 2},
+  {"clflushopt", 7, 0, 1, 23, 0},
+  {"clwb", 7, 0, 1, 24, 0},
+  {"avx512pf", 7, 0, 1, 26, 2},
+  {"avx512er", 7, 0, 1, 27, 2},
+  {"avx512cd", 7, 0, 1, 28, 2},
+  {"sha", 7, 0, 1, 29, 0},
+  {"avx512bw", 7, 0, 1, 30, 2},
+  {"avx512vl", 7, 0, 1, 31, 2},
+  {"avx512vbmi", 7, 0, 2, 1, 2},
+  {"avx512vbmi2", 7, 0, 2, 6, 2},
+  {"gfni", 7, 0, 2, 8, 0},
+  {"vaes", 7, 0, 2, 9, 1},
+  {"vpclmulqdq", 7, 0, 2, 10, 1},
+  {"avx512vnni", 7, 0, 2, 11, 2},
+  {"avx512bitalg", 7, 0, 2, 12, 2},
+  {"avx512vpopcntdq", 7, 0, 2, 14, 2},
+  {"avx512bf16", 7, 1, 0, 5, 2},
+  {"xsaveopt", 0xd, 1, 0, 0, 0},
+  {"xsavec", 0xd, 1, 0, 1, 0},
+  {"xsaves", 0xd, 1, 0, 3, 0},
+  {"sahf", 0x80000001, 0, 2, 0, 0},
+  {"lzcnt", 0x80000001, 0, 2, 5, 0},
+  {"sse4a", 0x80000001, 0, 2, 6, 0},
+  {"prfchw", 0x80000001, 0, 2, 8, 0},
+  {"xop", 0x80000001, 0, 2, 11, 1},
+  {"fma4", 0x80000001, 0, 2, 16, 1},
+  {"tbm", 0x80000001, 0, 2, 21, 0},
+};
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+std::unordered_map<std::string, bool> ProbeHostCPUFeatures() {
+  std::unordered_map<std::string, bool> features;
+  unsigned regs[4];
+  // The avx and avx512 registers are only usable if the OS saves them.
+  int saved_state = 0;
+  if (__get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]) && (regs[2] >> 27 & 1)) {
+    unsigned xcr0, xcr0_high;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+    if ((xcr0 & 0x6) == 0x6) saved_state = (xcr0 & 0xe0) == 0xe0 ? 2 : 1;
+  }
+  for (const CPUFeatureBit& f : kCPUFeatures) {
+    bool supported = f.state <= saved_state &&
+        __get_cpuid_max(f.leaf & 0x80000000, nullptr) >= f.leaf &&
+        __get_cpuid_count(f.leaf, f.subleaf, &regs[0], &regs[1], &regs[2], &regs[3]) &&
+        (regs[f.reg] >> f.bit & 1);
+    features[f.name] = supported;
+  }
+  return features;
+}
+#endif
+
+}  // namespace
+
+bool IsKnownCPUFeature(const std::string& feature) {
+  for (const CPUFeatureBit& f : kCPUFeatures) {
+    if (feature == f.name) return true;
+  }
+  return false;
+}
+
+bool HostCPUHasFeature(const std::string& feature) {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  static const std::unordered_map<std::string, bool> host_features = ProbeHostCPUFeatures();
+  auto it = host_features.find(feature);
+  return it != host_features.end() && it->second;
+#else
+  return false;
+#endif
+}
+
 void InitContextFunctions(std::function<void*(const char*)> fgetsymbol) {
   #define TVM_INIT_CONTEXT_FUNC(FuncName)                          \
     if (auto *fp = reinterpret_cast<decltype(&FuncName)*>          \
@@ -28,6 +28,7 @@
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/runtime/c_backend_api.h>
 #include <functional>
+#include <string>
 
 extern "C" {
 // Function signature for generated packed function in shared library
@@ -70,6 +71,45 @@ PackedFunc WrapPackedFunc(BackendPackedCFunc faddr, const ObjectPtr<Object>& mpt
  */
 void InitContextFunctions(std::function<void*(const char*)> fgetsymbol);
 
+/*!
+ * \brief Get the symbol suffix of the index-th variant of a multi-versioned function.
+ * \param index The index of the variant in runtime::symbol::tvm_func_variants.
+ * \return The suffix.
+ */
+inline std::string FunctionVariantSuffix(size_t index) {
+  return "__tvm_variant" + std::to_string(index);
+}
+
+/*!
+ * \brief Select the function variant to bind on the current host.
+ *
+ *  Later variants are preferred, a variant is eligible when every
+ *  feature it enables is reported as supported by fhas_feature.
+ *
+ * \param variants The ';' separated attribute lists of the variants,
+ *        as stored in runtime::symbol::tvm_func_variants.
+ * \param fhas_feature Query whether a feature (e.g. "avx2") is supported.
+ * \return The symbol suffix of the selected variant, empty for the baseline.
+ */
+std::string SelectFunctionVariant(const std::string& variants,
+                                  std::function<bool(const std::string&)> fhas_feature);
+
+/*!
+ * \brief Check whether the host CPU supports the given target feature.
+ *  The CPU is probed once with cpuid, this is used by both the JIT and the
+ *  library modules so that they select the same variant.
+ * \param feature The LLVM feature name, e.g. "avx2".
+ * \return Whether the feature is supported, false for unknown features.
+ */
+bool HostCPUHasFeature(const std::string& feature);
+
+/*!
+ * \brief Check whether HostCPUHasFeature can probe the given feature.
+ * \param feature The LLVM feature name, e.g. "avx512vnni".
+ * \return Whether the feature is known.
+ */
+bool IsKnownCPUFeature(const std::string& feature);
+
 /*!
  * \brief Create a module from a library.
  *
@@ -23,7 +23,10 @@
  *
  * All function calls go through the externally defined `UTVMInit`, which
  * performs device-specific setup, then calls `UTVMMain`.  `UTVMMain` then
- * calls the function in `utvm_task` with the arguments from the task.
+ * calls the function in `utvm_task` with the arguments from the task.  When
+ * the host has patched in a batch of tasks (`utvm_num_tasks > 0`), `UTVMMain`
+ * instead runs every task in `utvm_tasks` back to back, recording the cycle
+ * count of each into `utvm_task_times`.
  *
  * Additionally included in this file are definitions for some of the most
  * common functions used in the C runtime API.
@@ -42,6 +45,13 @@ UTVMTask utvm_task = {
     .num_args = 0,
 };
 
+// Batch of tasks to run in a single execution.  The arrays live in the args
+// section and are patched by the host; `utvm_num_tasks` is cleared after every
+// batch, so single-task calls leave it at zero.
+UTVMTask* utvm_tasks = NULL;        // NOLINT(*)
+uint32_t* utvm_task_times = NULL;   // NOLINT(*)
+uint32_t utvm_num_tasks = 0;
+
 size_t utvm_word_size = 0;  // NOLINT(*)
 
 // These pointers are patched at load time to point to the workspace section.
@@ -56,25 +66,40 @@ int32_t utvm_return_code = 0;        // NOLINT(*)
 
 uint32_t utvm_task_time = 0;
 
-// Gets called by UTVMInit, after device-specific initialization is finished.
-void UTVMMain() {
+// Runs a single task on a fresh workspace and stores its cycle count in `time`.
+static int32_t UTVMRunTask(const UTVMTask* task, uint32_t* time) {
   utvm_workspace_curr = utvm_workspace_start;
   utvm_num_active_allocs = 0;
-  utvm_last_error = NULL;  // NOLINT(*)
-  utvm_return_code = 0;
-  utvm_task_time = 0;
   UTVMTimerReset();
   int32_t err = UTVMTimerStart();
   if (err < 0) {
-    utvm_return_code = err;
-    UTVMDone();
+    return err;
   }
-  utvm_return_code = utvm_task.func(
-          (void*) utvm_task.arg_values,      // NOLINT(*)
-          (void*) utvm_task.arg_type_codes,  // NOLINT(*)
-          utvm_task.num_args);
+  int32_t ret = task->func(
+          (void*) task->arg_values,      // NOLINT(*)
+          (void*) task->arg_type_codes,  // NOLINT(*)
+          task->num_args);
   UTVMTimerStop();
-  utvm_task_time = UTVMTimerRead();
+  *time = UTVMTimerRead();
+  return ret;
+}
+
+// Gets called by UTVMInit, after device-specific initialization is finished.
+void UTVMMain() {
+  utvm_last_error = NULL;  // NOLINT(*)
+  utvm_return_code = 0;
+  utvm_task_time = 0;
+  if (utvm_num_tasks == 0) {
+    utvm_return_code = UTVMRunTask(&utvm_task, &utvm_task_time);
+  } else {
+    // Stop at the first failing task; the times of the tasks after it stay zero.
+    uint32_t i;
+    for (i = 0; i < utvm_num_tasks && utvm_return_code == 0; i++) {
+      utvm_return_code = UTVMRunTask(&utvm_tasks[i], &utvm_task_times[i]);
+      utvm_task_time += utvm_task_times[i];
+    }
+    utvm_num_tasks = 0;
+  }
   UTVMDone();
 }
 
@@ -60,6 +60,8 @@ class MicroDeviceAPI final : public DeviceAPI {
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
     MicroDevSpace* dev_space = static_cast<MicroDevSpace*>(ptr);
+    // Queued tasks may still reference the freed memory.
+    dev_space->session->FlushBatch();
     dev_space->session->FreeInSection(
       SectionKind::kHeap, DevPtr(reinterpret_cast<std::uintptr_t>(dev_space->data)));
     delete dev_space;
@@ -87,6 +89,8 @@ class MicroDeviceAPI final : public DeviceAPI {
       CHECK(ctx_from.device_id == ctx_to.device_id)
         << "can only copy between the same micro device";
       ObjectPtr<MicroSession>& session = from_space->session;
+      // Run any queued tasks first, so the copy observes their effects.
+      session->FlushBatch();
       const std::shared_ptr<LowLevelDevice>& lld = session->low_level_device();
 
       DevPtr from_dev_addr = GetDevLoc(from_space, from_offset);
@@ -100,6 +104,7 @@ class MicroDeviceAPI final : public DeviceAPI {
 
       MicroDevSpace* from_space = static_cast<MicroDevSpace*>(const_cast<void*>(from));
       ObjectPtr<MicroSession>& session = from_space->session;
+      session->FlushBatch();
       const std::shared_ptr<LowLevelDevice>& lld = session->low_level_device();
 
       DevPtr from_dev_addr = GetDevLoc(from_space, from_offset);
@@ -110,6 +115,7 @@ class MicroDeviceAPI final : public DeviceAPI {
 
       MicroDevSpace* to_space = static_cast<MicroDevSpace*>(const_cast<void*>(to));
       ObjectPtr<MicroSession>& session = to_space->session;
+      session->FlushBatch();
       const std::shared_ptr<LowLevelDevice>& lld = session->low_level_device();
 
       void* from_host_ptr = GetHostLoc(from, from_offset);
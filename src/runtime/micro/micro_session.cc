@@ -26,6 +26,7 @@
 #include <memory>
 #include <stack>
 #include <tuple>
+#include <utility>
 #include <vector>
 #include "micro_session.h"
 #include "low_level_device.h"
@@ -214,6 +215,27 @@ double MicroSession::PushToExecQueue(DevPtr func_ptr, const TVMArgs& args) {
     func_ptr += 1;
   }
 
+  if (batching_) {
+    // Queued tasks are encoded back to back into the region after the most
+    // recent allocation in the args section, and written out by `FlushBatch`.
+    // Flush first if this task would not fit in the args section with them.
+    if (batch_encoder_ != nullptr && !BatchFits(args)) {
+      FlushBatch();
+    }
+    if (batch_encoder_ == nullptr) {
+      DevPtr args_addr = GetAllocator(SectionKind::kArgs)->curr_end_addr();
+      batch_encoder_.reset(new TargetDataLayoutEncoder(args_addr, word_size_));
+    }
+    std::tuple<DevPtr, DevPtr> arg_field_addrs = EncoderAppend(batch_encoder_.get(), args);
+    batch_tasks_.push_back(BatchTask {
+      .func = func_ptr,
+      .arg_values = std::get<0>(arg_field_addrs),
+      .arg_type_codes = std::get<1>(arg_field_addrs),
+      .num_args = args.num_args,
+    });
+    return 0.0;
+  }
+
   // Create an allocator stream for the memory region after the most recent
   // allocation in the args section.
   DevPtr args_addr = GetAllocator(SectionKind::kArgs)->curr_end_addr();
@@ -256,14 +278,123 @@ double MicroSession::PushToExecQueue(DevPtr func_ptr, const TVMArgs& args) {
     utvm_init_addr += 1;
   }
 
-  low_level_device()->Execute(utvm_init_addr, utvm_done_addr);
-  // Check if there was an error during execution.  If so, log it.
-  CheckDeviceError();
-  uint32_t task_time = DevSymbolRead<uint32_t>(runtime_symbol_map_, "utvm_task_time");
+  uint32_t task_time = 0;
+  try {
+    low_level_device()->Execute(utvm_init_addr, utvm_done_addr);
+    // Check if there was an error during execution.  If so, log it.
+    CheckDeviceError();
+    task_time = DevSymbolRead<uint32_t>(runtime_symbol_map_, "utvm_task_time");
+  } catch (...) {
+    GetAllocator(SectionKind::kArgs)->Free(stream_dev_addr);
+    throw;
+  }
   GetAllocator(SectionKind::kArgs)->Free(stream_dev_addr);
   return static_cast<double>(task_time);
 }
 
+void MicroSession::BeginBatch() {
+  CHECK(!batching_) << "micro session is already batching tasks";
+  batching_ = true;
+  batch_task_times_.clear();
+}
+
+void MicroSession::FlushBatch() {
+  if (batch_tasks_.empty()) return;
+  std::unique_ptr<TargetDataLayoutEncoder> encoder = std::move(batch_encoder_);
+  std::vector<BatchTask> tasks = std::move(batch_tasks_);
+  batch_tasks_.clear();
+  uint32_t num_tasks = static_cast<uint32_t>(tasks.size());
+
+  // The task array and the slots for the per-task times go after the args, so
+  // the whole batch is flushed with a single write.
+  DevPtr tasks_dev_addr;
+  if (word_size_ == 4) {
+    tasks_dev_addr = EncodeTasks<UTVMTask32>(encoder.get(), tasks);
+  } else {
+    tasks_dev_addr = EncodeTasks<UTVMTask64>(encoder.get(), tasks);
+  }
+  auto times_slot = encoder->Alloc<uint32_t>(num_tasks);
+  std::vector<uint32_t> task_times(num_tasks, 0);
+  times_slot.WriteArray(task_times.data(), num_tasks);
+  DevPtr times_dev_addr = times_slot.start_addr();
+
+  DevPtr stream_dev_addr =
+      GetAllocator(SectionKind::kArgs)->Allocate(encoder->buf_size());
+  low_level_device()->Write(stream_dev_addr,
+                            reinterpret_cast<void*>(encoder->data()),
+                            encoder->buf_size());
+
+  if (word_size_ == 4) {
+    DevSymbolWrite(runtime_symbol_map_, "utvm_tasks", tasks_dev_addr.value().val32);
+    DevSymbolWrite(runtime_symbol_map_, "utvm_task_times", times_dev_addr.value().val32);
+  } else if (word_size_ == 8) {
+    DevSymbolWrite(runtime_symbol_map_, "utvm_tasks", tasks_dev_addr.value().val64);
+    DevSymbolWrite(runtime_symbol_map_, "utvm_task_times", times_dev_addr.value().val64);
+  }
+  DevSymbolWrite(runtime_symbol_map_, "utvm_num_tasks", num_tasks);
+
+  DevPtr utvm_init_addr = runtime_symbol_map_["UTVMInit"];
+  DevPtr utvm_done_addr = runtime_symbol_map_["UTVMDone"];
+  if (thumb_mode_) {
+    utvm_init_addr += 1;
+  }
+
+  try {
+    low_level_device()->Execute(utvm_init_addr, utvm_done_addr);
+    // Check if there was an error during execution.  If so, log it.
+    CheckDeviceError();
+    low_level_device()->Read(times_dev_addr, task_times.data(), num_tasks * sizeof(uint32_t));
+  } catch (...) {
+    GetAllocator(SectionKind::kArgs)->Free(stream_dev_addr);
+    throw;
+  }
+  GetAllocator(SectionKind::kArgs)->Free(stream_dev_addr);
+  for (uint32_t time : task_times) {
+    batch_task_times_.push_back(static_cast<double>(time));
+  }
+}
+
+bool MicroSession::BatchFits(const TVMArgs& args) {
+  // Encode the arguments on the side to measure them. The encoding is word
+  // aligned, so its size only changes by the padding in front of it.
+  TargetDataLayoutEncoder probe(DevPtr(nullptr), word_size_);
+  EncoderAppend(&probe, args);
+  size_t num_tasks = batch_tasks_.size() + 1;
+  size_t task_size = word_size_ == 4 ? sizeof(UTVMTask32) : sizeof(UTVMTask64);
+  // `FlushBatch` appends the task array and the task time slots.
+  size_t batch_size = batch_encoder_->buf_size() + word_size_ + probe.buf_size() +
+                      word_size_ + num_tasks * task_size +
+                      word_size_ + num_tasks * sizeof(uint32_t);
+  std::shared_ptr<MicroSectionAllocator> args_allocator = GetAllocator(SectionKind::kArgs);
+  size_t used = UpperAlignValue(args_allocator->size(), word_size_);
+  return used + batch_size < args_allocator->capacity();
+}
+
+std::vector<double> MicroSession::EndBatch() {
+  CHECK(batching_) << "micro session is not batching tasks";
+  FlushBatch();
+  batching_ = false;
+  std::vector<double> task_times = std::move(batch_task_times_);
+  batch_task_times_.clear();
+  return task_times;
+}
+
+template <typename T>
+DevPtr MicroSession::EncodeTasks(TargetDataLayoutEncoder* encoder,
+                                 const std::vector<BatchTask>& tasks) {
+  auto tasks_slot = encoder->Alloc<T>(tasks.size());
+  for (const BatchTask& task : tasks) {
+    T dev_task = {};
+    dev_task.func = static_cast<decltype(dev_task.func)>(task.func.value().val64);
+    dev_task.arg_values = static_cast<decltype(dev_task.arg_values)>(task.arg_values.value().val64);
+    dev_task.arg_type_codes =
+        static_cast<decltype(dev_task.arg_type_codes)>(task.arg_type_codes.value().val64);
+    dev_task.num_args = task.num_args;
+    tasks_slot.WriteValue(dev_task);
+  }
+  return tasks_slot.start_addr();
+}
+
 BinaryInfo MicroSession::LoadBinary(const std::string& binary_path, bool patch_dylib_pointers) {
   DevMemRegion text_section;
   DevMemRegion rodata_section;
@@ -489,6 +620,23 @@ PackedFunc MicroSession::GetFunction(
     return PackedFunc([sptr_to_self](TVMArgs args, TVMRetValue* rv) {
       MicroSession::ExitWithScope();
     });
+  } else if (name == "begin_batch") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      BeginBatch();
+    });
+  } else if (name == "end_batch") {
+    // Returns the number of tasks run; their times are read with "get_batch_time".
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      last_batch_times_ = EndBatch();
+      *rv = static_cast<int64_t>(last_batch_times_.size());
+    });
+  } else if (name == "get_batch_time") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int64_t index = args[0];
+      CHECK(index >= 0 && index < static_cast<int64_t>(last_batch_times_.size()))
+          << "batch task index " << index << " out of range";
+      *rv = last_batch_times_[index];
+    });
   } else {
     return PackedFunc();
   }
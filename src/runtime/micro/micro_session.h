@@ -139,6 +139,28 @@ class MicroSession : public ModuleNode {
    */
   double PushToExecQueue(DevPtr func, const TVMArgs& args);
 
+  /*!
+   * \brief starts batching task executions
+   *
+   * While batching, `PushToExecQueue` only encodes the task and its arguments
+   * on the host and returns zero.  The queued tasks are written to the device
+   * with a single write and run with a single execution by `FlushBatch`.
+   */
+  void BeginBatch();
+
+  /*!
+   * \brief runs all tasks queued since the last flush
+   * \note called before any device memory is copied or freed while batching, so
+   *  that host accesses observe the effects of the queued tasks
+   */
+  void FlushBatch();
+
+  /*!
+   * \brief flushes the queued tasks and stops batching
+   * \return elapsed time of each task executed since `BeginBatch`, in order
+   */
+  std::vector<double> EndBatch();
+
   /*!
    * \brief loads binary onto device
    * \param binary_path path to binary object file
@@ -216,6 +238,44 @@ class MicroSession : public ModuleNode {
   /*! \brief symbol map for the device runtime */
   SymbolMap runtime_symbol_map_;
 
+  /*! \brief a task queued in batch mode, with device addresses into `batch_encoder_` */
+  struct BatchTask {
+    /*! \brief address of the function to be executed */
+    DevPtr func;
+    /*! \brief device address of the encoded argument values */
+    DevPtr arg_values;
+    /*! \brief device address of the encoded argument type codes */
+    DevPtr arg_type_codes;
+    /*! \brief number of arguments */
+    int32_t num_args;
+  };
+  /*! \brief whether task executions are being batched */
+  bool batching_{false};
+  /*! \brief encoder holding the arguments of the queued tasks */
+  std::unique_ptr<TargetDataLayoutEncoder> batch_encoder_;
+  /*! \brief tasks queued since the last flush */
+  std::vector<BatchTask> batch_tasks_;
+  /*! \brief elapsed times of the tasks flushed since `BeginBatch` */
+  std::vector<double> batch_task_times_;
+  /*! \brief elapsed times returned by the last `EndBatch` called from the frontend */
+  std::vector<double> last_batch_times_;
+
+  /*!
+   * \brief writes the device-side task array to the args section
+   * \param encoder encoder the array is appended to
+   * \param tasks tasks to be encoded
+   * \return device address of the task array
+   */
+  template <typename T>
+  DevPtr EncodeTasks(TargetDataLayoutEncoder* encoder, const std::vector<BatchTask>& tasks);
+
+  /*!
+   * \brief checks whether the queued tasks and a task with `args` fit in the args section
+   * \param args args of the task to be queued
+   * \return whether the batch can be flushed with the task added
+   */
+  bool BatchFits(const TVMArgs& args);
+
   /*!
    * \brief patches a function pointer in this module to an implementation
    * \param func_name name of the function pointer being patched
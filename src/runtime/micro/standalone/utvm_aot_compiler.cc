@@ -0,0 +1,346 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "utvm_graph_runtime.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utvm_aot_runtime.h"
+
+namespace tvm {
+namespace micro {
+namespace {
+
+// Magic numbers of the parameter blob saved by `relay.save_param_dict`.
+constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+constexpr uint64_t kTVMNDArrayMagic = 0xDD5E40F096B4A13F;
+
+size_t AlignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+DLDataType ParseDLType(const std::string& str) {
+  DLDataType t;
+  t.lanes = 1;
+  const char* scan = str.c_str();
+  if (str.compare(0, 5, "float") == 0) {
+    t.code = kDLFloat;
+    scan += 5;
+  } else if (str.compare(0, 4, "uint") == 0) {
+    t.code = kDLUInt;
+    scan += 4;
+  } else if (str.compare(0, 3, "int") == 0) {
+    t.code = kDLInt;
+    scan += 3;
+  } else {
+    assert(false && "unsupported dtype");
+  }
+  char* end;
+  t.bits = static_cast<uint8_t>(std::strtoul(scan, &end, 10));
+  if (*end == 'x') {
+    t.lanes = static_cast<uint16_t>(std::strtoul(end + 1, &end, 10));
+  }
+  return t;
+}
+
+// A parameter of the blob, with its data left in place.
+struct Param {
+  std::string name;
+  size_t data_offset;
+  size_t nbytes;
+};
+
+class BlobReader {
+ public:
+  explicit BlobReader(const std::string& blob) : blob_(blob) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    assert(offset_ + sizeof(T) <= blob_.size());
+    std::memcpy(&value, blob_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  std::string ReadString() {
+    size_t len = static_cast<size_t>(Read<uint64_t>());
+    assert(offset_ + len <= blob_.size());
+    std::string str = blob_.substr(offset_, len);
+    offset_ += len;
+    return str;
+  }
+
+  void Skip(size_t nbytes) {
+    assert(offset_ + nbytes <= blob_.size());
+    offset_ += nbytes;
+  }
+
+  size_t offset() const { return offset_; }
+
+ private:
+  const std::string& blob_;
+  size_t offset_{0};
+};
+
+std::vector<Param> ParseParams(const std::string& blob) {
+  std::vector<Param> params;
+  if (blob.empty()) {
+    return params;
+  }
+  BlobReader reader(blob);
+  uint64_t header = reader.Read<uint64_t>();
+  assert(header == kTVMNDArrayListMagic);
+  reader.Read<uint64_t>();  // reserved
+  params.resize(static_cast<size_t>(reader.Read<uint64_t>()));
+  for (auto& p : params) {
+    p.name = reader.ReadString();
+  }
+  uint64_t num_arrays = reader.Read<uint64_t>();
+  assert(num_arrays == params.size());
+  for (auto& p : params) {
+    uint64_t array_header = reader.Read<uint64_t>();
+    assert(array_header == kTVMNDArrayMagic);
+    reader.Read<uint64_t>();  // reserved
+    reader.Read<DLContext>();
+    int32_t ndim = reader.Read<int32_t>();
+    reader.Read<DLDataType>();
+    reader.Skip(ndim * sizeof(int64_t));
+    p.nbytes = static_cast<size_t>(reader.Read<int64_t>());
+    p.data_offset = reader.offset();
+    reader.Skip(p.nbytes);
+  }
+  (void)header;
+  (void)num_arrays;
+  return params;
+}
+
+}  // namespace
+
+std::string CompileAOTDescriptor(const std::string& graph_json, const std::string& params) {
+  Graph graph;
+  ParseGraph(graph_json, &graph);
+  const GraphAttr& attrs = graph.attrs;
+  auto entry_id = [&graph](uint32_t nid, uint32_t index) {
+    return graph.node_row_ptr[nid] + index;
+  };
+  const size_t num_entries = graph.node_row_ptr.back();
+
+  // Size of each node entry and of each storage pool entry.
+  std::vector<DLDataType> entry_dtype(num_entries);
+  std::vector<size_t> entry_bytes(num_entries);
+  std::vector<size_t> sid_bytes;
+  std::vector<uint32_t> sid_users;
+  for (size_t eid = 0; eid < num_entries; ++eid) {
+    entry_dtype[eid] = ParseDLType(attrs.dltype[eid]);
+    size_t size = 1;
+    for (int64_t sz : attrs.shape[eid]) {
+      size *= static_cast<size_t>(sz);
+    }
+    size_t bits = entry_dtype[eid].bits * entry_dtype[eid].lanes;
+    entry_bytes[eid] = ((bits + 7U) / 8U) * size;
+    assert(attrs.storage_id[eid] >= 0);
+    size_t sid = static_cast<size_t>(attrs.storage_id[eid]);
+    if (sid >= sid_bytes.size()) {
+      sid_bytes.resize(sid + 1, 0);
+      sid_users.resize(sid + 1, 0);
+    }
+    sid_bytes[sid] = std::max(sid_bytes[sid], entry_bytes[eid]);
+    ++sid_users[sid];
+  }
+
+  // Parameters are stored in the descriptor. The ones with storage of their own
+  // are used in place; the others are copied into the pool at startup.
+  std::map<std::string, uint32_t> input_entry;
+  for (size_t i = 0; i < graph.input_nodes.size(); ++i) {
+    uint32_t nid = graph.input_nodes[i];
+    input_entry[graph.nodes[nid].name] = entry_id(nid, 0);
+  }
+  std::vector<Param> param_list = ParseParams(params);
+  std::vector<const Param*> entry_param(num_entries, nullptr);
+  std::vector<bool> sid_const(sid_bytes.size(), false);
+  std::vector<uint64_t> const_offset(num_entries, 0);
+  uint64_t const_size = 0;
+  for (const Param& p : param_list) {
+    auto it = input_entry.find(p.name);
+    assert(it != input_entry.end());
+    uint32_t eid = it->second;
+    assert(entry_bytes[eid] == p.nbytes);
+    entry_param[eid] = &p;
+    const_offset[eid] = const_size;
+    const_size = AlignUp(const_size + p.nbytes, kAOTAlign);
+    size_t sid = static_cast<size_t>(attrs.storage_id[eid]);
+    sid_const[sid] = sid_users[sid] == 1;
+  }
+
+  // One aligned region of the pool per storage id.
+  std::vector<uint64_t> sid_offset(sid_bytes.size(), 0);
+  uint64_t pool_size = 0;
+  for (size_t sid = 0; sid < sid_bytes.size(); ++sid) {
+    if (sid_const[sid]) continue;
+    sid_offset[sid] = pool_size;
+    pool_size = AlignUp(pool_size + sid_bytes[sid], kAOTAlign);
+  }
+
+  // Tensors, one per node entry and flattening. Offsets into the constant data
+  // are relative until the descriptor is laid out.
+  std::vector<AOTTensor> tensors;
+  std::vector<int64_t> shapes;
+  std::map<std::pair<uint32_t, bool>, uint32_t> tensor_index;
+  auto get_tensor = [&](uint32_t eid, bool flatten) {
+    auto key = std::make_pair(eid, flatten);
+    auto it = tensor_index.find(key);
+    if (it != tensor_index.end()) {
+      return it->second;
+    }
+    AOTTensor t;
+    std::memset(&t, 0, sizeof(t));
+    t.nbytes = entry_bytes[eid];
+    t.dtype = entry_dtype[eid];
+    t.shape_index = static_cast<uint32_t>(shapes.size());
+    const auto& shape = attrs.shape[eid];
+    if (flatten) {
+      int64_t size = 1;
+      for (int64_t sz : shape) {
+        size *= sz;
+      }
+      shapes.push_back(size);
+      t.ndim = 1;
+    } else {
+      shapes.insert(shapes.end(), shape.begin(), shape.end());
+      t.ndim = static_cast<int32_t>(shape.size());
+    }
+    size_t sid = static_cast<size_t>(attrs.storage_id[eid]);
+    t.init_offset = kAOTNoInit;
+    if (sid_const[sid]) {
+      t.kind = kAOTConst;
+      t.data_offset = const_offset[eid];
+    } else {
+      t.kind = kAOTPool;
+      t.data_offset = sid_offset[sid];
+      if (entry_param[eid] != nullptr) {
+        t.init_offset = const_offset[eid];
+      }
+    }
+    uint32_t index = static_cast<uint32_t>(tensors.size());
+    tensors.push_back(t);
+    tensor_index[key] = index;
+    return index;
+  };
+
+  std::vector<AOTOp> ops;
+  std::vector<uint32_t> args;
+  std::string strings;
+  for (uint32_t nid = 0; nid < graph.nodes.size(); ++nid) {
+    const auto& inode = graph.nodes[nid];
+    if (inode.op_type == "null") continue;
+    assert(inode.op_type == "tvm_op");
+    if (inode.param.func_name == "__nop") continue;
+    assert(inode.param.func_name != "__copy");
+    bool flatten = inode.param.flatten_data != 0;
+    AOTOp op;
+    std::memset(&op, 0, sizeof(op));
+    op.name_offset = static_cast<uint32_t>(strings.size());
+    strings += inode.param.func_name;
+    strings.push_back('\0');
+    op.arg_begin = static_cast<uint32_t>(args.size());
+    for (const auto& e : inode.inputs) {
+      args.push_back(get_tensor(entry_id(e.node_id, e.index), flatten));
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      args.push_back(get_tensor(entry_id(nid, index), flatten));
+    }
+    op.num_args = static_cast<uint32_t>(args.size()) - op.arg_begin;
+    ops.push_back(op);
+  }
+  std::vector<uint32_t> inputs;
+  for (size_t i = 0; i < graph.input_nodes.size(); ++i) {
+    inputs.push_back(get_tensor(entry_id(graph.input_nodes[i], 0), false));
+  }
+  std::vector<uint32_t> outputs;
+  for (size_t i = 0; i < graph.outputs.size(); ++i) {
+    outputs.push_back(get_tensor(entry_id(graph.outputs[i].node_id, graph.outputs[i].index),
+                                 false));
+  }
+
+  // Lay out the descriptor: header, tables, then the aligned constant data.
+  AOTHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = kAOTMagic;
+  header.num_tensors = static_cast<uint32_t>(tensors.size());
+  header.num_ops = static_cast<uint32_t>(ops.size());
+  header.num_args = static_cast<uint32_t>(args.size());
+  header.num_inputs = static_cast<uint32_t>(inputs.size());
+  header.num_outputs = static_cast<uint32_t>(outputs.size());
+  header.pool_size = pool_size;
+  size_t offset = AlignUp(sizeof(AOTHeader), sizeof(uint64_t));
+  header.tensors_offset = offset;
+  offset += tensors.size() * sizeof(AOTTensor);
+  header.ops_offset = offset;
+  offset += ops.size() * sizeof(AOTOp);
+  header.args_offset = offset;
+  offset += args.size() * sizeof(uint32_t);
+  header.inputs_offset = offset;
+  offset += inputs.size() * sizeof(uint32_t);
+  header.outputs_offset = offset;
+  offset += outputs.size() * sizeof(uint32_t);
+  header.shapes_offset = AlignUp(offset, sizeof(int64_t));
+  offset = header.shapes_offset + shapes.size() * sizeof(int64_t);
+  header.strings_offset = offset;
+  offset += strings.size();
+  const uint64_t const_start = AlignUp(offset, kAOTAlign);
+  header.size = const_start + const_size;
+
+  for (auto& t : tensors) {
+    if (t.kind == kAOTConst) {
+      t.data_offset += const_start;
+    }
+    if (t.init_offset != kAOTNoInit) {
+      t.init_offset += const_start;
+    }
+  }
+
+  std::string descriptor(header.size, '\0');
+  auto write = [&descriptor](uint64_t offset, const void* data, size_t nbytes) {
+    if (nbytes != 0) {
+      std::memcpy(&descriptor[offset], data, nbytes);
+    }
+  };
+  write(0, &header, sizeof(header));
+  write(header.tensors_offset, tensors.data(), tensors.size() * sizeof(AOTTensor));
+  write(header.ops_offset, ops.data(), ops.size() * sizeof(AOTOp));
+  write(header.args_offset, args.data(), args.size() * sizeof(uint32_t));
+  write(header.inputs_offset, inputs.data(), inputs.size() * sizeof(uint32_t));
+  write(header.outputs_offset, outputs.data(), outputs.size() * sizeof(uint32_t));
+  write(header.shapes_offset, shapes.data(), shapes.size() * sizeof(int64_t));
+  write(header.strings_offset, strings.data(), strings.size());
+  for (size_t eid = 0; eid < num_entries; ++eid) {
+    if (const Param* p = entry_param[eid]) {
+      write(const_start + const_offset[eid], params.data() + p->data_offset, p->nbytes);
+    }
+  }
+  return descriptor;
+}
+
+}  // namespace micro
+}  // namespace tvm
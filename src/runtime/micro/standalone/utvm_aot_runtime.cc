@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "utvm_graph_runtime.h"
+#include "utvm_aot_runtime.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace tvm {
+namespace micro {
+namespace {
+
+/*typedef*/ enum {
+  kArrayHandle = 7U,
+} /*TVMTypeCode*/;
+
+size_t AlignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+// Offsets of the runtime state in the (aligned) arena.
+struct ArenaLayout {
+  size_t tensors;
+  size_t arg_values;
+  size_t arg_tcodes;
+  size_t funcs;
+  size_t pool;
+  size_t size;
+};
+
+ArenaLayout GetArenaLayout(const AOTHeader& header) {
+  ArenaLayout layout;
+  size_t offset = AlignUp(sizeof(MicroAOTRuntime), sizeof(uint64_t));
+  layout.tensors = offset;
+  offset = AlignUp(offset + header.num_tensors * sizeof(DLTensor), sizeof(uint64_t));
+  layout.arg_values = offset;
+  offset += header.num_args * sizeof(AOTValue);
+  layout.arg_tcodes = offset;
+  offset = AlignUp(offset + header.num_args * sizeof(int), sizeof(uint64_t));
+  layout.funcs = offset;
+  offset += header.num_ops * sizeof(BackendPackedCFunc);
+  layout.pool = AlignUp(offset, kAOTAlign);
+  layout.size = layout.pool + header.pool_size;
+  return layout;
+}
+
+const AOTHeader* GetHeader(const void* descriptor) {
+  assert(reinterpret_cast<uintptr_t>(descriptor) % kAOTAlign == 0);
+  const auto* header = static_cast<const AOTHeader*>(descriptor);
+  assert(header->magic == kAOTMagic);
+  return header;
+}
+
+}  // namespace
+
+size_t MicroAOTRuntime::ArenaSize(const void* descriptor) {
+  // Leave room to align the start of the arena.
+  return GetArenaLayout(*GetHeader(descriptor)).size + kAOTAlign - 1;
+}
+
+MicroAOTRuntime* MicroAOTRuntime::Create(const void* descriptor, void* arena, size_t arena_size,
+                                         const DSOModule* module) {
+  assert(module);
+  const AOTHeader* header = GetHeader(descriptor);
+  const ArenaLayout layout = GetArenaLayout(*header);
+  uint8_t* start = reinterpret_cast<uint8_t*>(
+      AlignUp(reinterpret_cast<uintptr_t>(arena), kAOTAlign));
+  assert(start + layout.size <= static_cast<uint8_t*>(arena) + arena_size);
+  (void)arena_size;
+
+  MicroAOTRuntime* rt = new (start) MicroAOTRuntime();
+  const uint8_t* base = static_cast<const uint8_t*>(descriptor);
+  rt->descriptor_ = base;
+  rt->header_ = header;
+  rt->tensor_descs_ = reinterpret_cast<const AOTTensor*>(base + header->tensors_offset);
+  rt->ops_ = reinterpret_cast<const AOTOp*>(base + header->ops_offset);
+  rt->inputs_ = reinterpret_cast<const uint32_t*>(base + header->inputs_offset);
+  rt->outputs_ = reinterpret_cast<const uint32_t*>(base + header->outputs_offset);
+  rt->tensors_ = reinterpret_cast<DLTensor*>(start + layout.tensors);
+  rt->arg_values_ = reinterpret_cast<AOTValue*>(start + layout.arg_values);
+  rt->arg_tcodes_ = reinterpret_cast<int*>(start + layout.arg_tcodes);
+  rt->funcs_ = reinterpret_cast<BackendPackedCFunc*>(start + layout.funcs);
+  uint8_t* pool = start + layout.pool;
+
+  const auto* shapes = reinterpret_cast<const int64_t*>(base + header->shapes_offset);
+  for (uint32_t i = 0; i < header->num_tensors; ++i) {
+    const AOTTensor& desc = rt->tensor_descs_[i];
+    DLTensor* t = &rt->tensors_[i];
+    if (desc.kind == kAOTConst) {
+      t->data = const_cast<uint8_t*>(base + desc.data_offset);
+    } else {
+      t->data = pool + desc.data_offset;
+    }
+    t->ctx = DLContext{kDLCPU, 0};
+    t->ndim = desc.ndim;
+    t->dtype = desc.dtype;
+    t->shape = const_cast<int64_t*>(shapes + desc.shape_index);
+    t->strides = nullptr;
+    t->byte_offset = 0;
+    if (desc.init_offset != kAOTNoInit) {
+      std::memcpy(t->data, base + desc.init_offset, desc.nbytes);
+    }
+  }
+
+  const auto* args = reinterpret_cast<const uint32_t*>(base + header->args_offset);
+  for (uint32_t i = 0; i < header->num_args; ++i) {
+    rt->arg_values_[i].v_handle = &rt->tensors_[args[i]];
+    rt->arg_tcodes_[i] = kArrayHandle;
+  }
+
+  const char* strings = reinterpret_cast<const char*>(base + header->strings_offset);
+  for (uint32_t i = 0; i < header->num_ops; ++i) {
+    rt->funcs_[i] = module->GetFunction(strings + rt->ops_[i].name_offset);
+  }
+  return rt;
+}
+
+int MicroAOTRuntime::Run() {
+  for (uint32_t i = 0; i < header_->num_ops; ++i) {
+    const AOTOp& op = ops_[i];
+    int ret = funcs_[i](&arg_values_[op.arg_begin], &arg_tcodes_[op.arg_begin],
+                        static_cast<int>(op.num_args));
+    if (ret != 0) return ret;
+  }
+  return 0;
+}
+
+void MicroAOTRuntime::SetInput(int index, DLTensor* data_in) {
+  assert(static_cast<uint32_t>(index) < header_->num_inputs);
+  uint32_t tid = inputs_[index];
+  // Constant parameters are read-only.
+  assert(tensor_descs_[tid].kind == kAOTPool);
+  std::memcpy(tensors_[tid].data,
+              reinterpret_cast<const uint8_t*>(data_in->data) +
+                  static_cast<size_t>(data_in->byte_offset),
+              tensor_descs_[tid].nbytes);
+}
+
+void MicroAOTRuntime::CopyOutputTo(int index, DLTensor* data_out) {
+  assert(static_cast<uint32_t>(index) < header_->num_outputs);
+  uint32_t tid = outputs_[index];
+  std::memcpy(reinterpret_cast<uint8_t*>(data_out->data) +
+                  static_cast<size_t>(data_out->byte_offset),
+              tensors_[tid].data, tensor_descs_[tid].nbytes);
+}
+
+}  // namespace micro
+}  // namespace tvm
@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef TVM_RUNTIME_MICRO_STANDALONE_UTVM_AOT_RUNTIME_H_
+#define TVM_RUNTIME_MICRO_STANDALONE_UTVM_AOT_RUNTIME_H_
+
+#include <dlpack/dlpack.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "utvm_graph_runtime.h"
+
+namespace tvm {
+namespace micro {
+
+// Ahead-of-time graph runtime.
+//
+// `CompileAOTDescriptor` turns a graph JSON, its storage plan and its
+// parameter blob into a flat binary descriptor on the host. All offsets are
+// precomputed, so `MicroAOTRuntime` lays itself out in a single caller-provided
+// arena without parsing or heap allocation, and `Run` is a loop over function
+// pointers. Parameters whose storage is not shared are used in place from the
+// descriptor, so they can stay in read-only memory.
+
+constexpr uint64_t kAOTMagic = 0x31544F414D565455;  // "UTVMAOT1"
+// Alignment of tensor data in the arena and in the descriptor.
+constexpr uint64_t kAOTAlign = 64;
+// `AOTTensor::init_offset` of tensors without initial contents.
+constexpr uint64_t kAOTNoInit = UINT64_MAX;
+
+// Descriptor header. All offsets are in bytes from the start of the descriptor.
+struct AOTHeader {
+  uint64_t magic;
+  uint32_t num_tensors;
+  uint32_t num_ops;
+  uint32_t num_args;
+  uint32_t num_inputs;
+  uint32_t num_outputs;
+  uint32_t reserved;
+  // bytes of tensor storage in the arena
+  uint64_t pool_size;
+  // AOTTensor[num_tensors]
+  uint64_t tensors_offset;
+  // AOTOp[num_ops]
+  uint64_t ops_offset;
+  // uint32_t[num_args], the tensor of each operator argument
+  uint64_t args_offset;
+  // uint32_t[num_inputs], the tensor of each graph input
+  uint64_t inputs_offset;
+  // uint32_t[num_outputs], the tensor of each graph output
+  uint64_t outputs_offset;
+  // int64_t, the shapes of all tensors
+  uint64_t shapes_offset;
+  // null-terminated function names
+  uint64_t strings_offset;
+  // total size of the descriptor
+  uint64_t size;
+};
+
+enum AOTTensorKind : uint32_t {
+  // the data lives in the tensor pool of the arena
+  kAOTPool = 0,
+  // the data is a constant inside the descriptor
+  kAOTConst = 1,
+};
+
+struct AOTTensor {
+  // offset of the data in the pool or in the descriptor, depending on `kind`
+  uint64_t data_offset;
+  // offset of the initial contents in the descriptor, or kAOTNoInit
+  uint64_t init_offset;
+  uint64_t nbytes;
+  // index of the first dimension in the shape table
+  uint32_t shape_index;
+  int32_t ndim;
+  DLDataType dtype;
+  uint32_t kind;
+};
+
+struct AOTOp {
+  // offset of the function name in the string table
+  uint32_t name_offset;
+  // index of the first argument in the argument table
+  uint32_t arg_begin;
+  uint32_t num_args;
+  uint32_t reserved;
+};
+
+// Packed argument value, laid out as TVMValue.
+union AOTValue {
+  int64_t v_int64;
+  double v_float64;
+  void* v_handle;
+};
+
+// Compile a graph and its parameters into an AOT descriptor.
+std::string CompileAOTDescriptor(const std::string& graph_json, const std::string& params);
+
+// Minimal GraphRuntime running from an AOT descriptor
+class MicroAOTRuntime {
+ public:
+  // Bytes of arena needed to create a runtime for `descriptor`.
+  static size_t ArenaSize(const void* descriptor);
+  // Lay out a runtime in `arena`. The descriptor must stay alive and be aligned
+  // to kAOTAlign bytes; the runtime is released with the arena.
+  static MicroAOTRuntime* Create(const void* descriptor, void* arena, size_t arena_size,
+                                 const DSOModule* module);
+  // Run the graph, returns the non-zero code of the first failing operator.
+  int Run();
+  // Set the input at `index` to a copy of the tensor `data_in`
+  void SetInput(int index, DLTensor* data_in);
+  // Copy the output at `index` into `data_out`
+  void CopyOutputTo(int index, DLTensor* data_out);
+
+ private:
+  MicroAOTRuntime() {}
+
+  const uint8_t* descriptor_{nullptr};
+  const AOTHeader* header_{nullptr};
+  const AOTTensor* tensor_descs_{nullptr};
+  const AOTOp* ops_{nullptr};
+  const uint32_t* inputs_{nullptr};
+  const uint32_t* outputs_{nullptr};
+
+  // Tensor for each descriptor tensor
+  DLTensor* tensors_{nullptr};
+  // Packed arguments of all the operators
+  AOTValue* arg_values_{nullptr};
+  int* arg_tcodes_{nullptr};
+  // Function for each operator
+  BackendPackedCFunc* funcs_{nullptr};
+};
+
+}  // namespace micro
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_MICRO_STANDALONE_UTVM_AOT_RUNTIME_H_
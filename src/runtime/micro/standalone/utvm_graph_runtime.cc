@@ -118,6 +118,18 @@ void ParseArgNodes(const picojson::array& jinput_nodes, DynArray<uint32_t>* inpu
 }
 }  // namespace
 
+void ParseGraph(const std::string& graph_json, Graph* graph) {
+  picojson::value v;
+  picojson::parse(v, graph_json);
+  ParseNodes(v.get<picojson::object>()["nodes"].get<picojson::array>(), &graph->nodes);
+  ParseArgNodes(v.get<picojson::object>()["arg_nodes"].get<picojson::array>(),
+                &graph->input_nodes);
+  ParseArgNodes(v.get<picojson::object>()["node_row_ptr"].get<picojson::array>(),
+                &graph->node_row_ptr);
+  ParseOutputs(v.get<picojson::object>()["heads"].get<picojson::array>(), &graph->outputs);
+  ParseAttrs(v.get<picojson::object>()["attrs"].get<picojson::object>(), &graph->attrs);
+}
+
 NDArray::~NDArray() {}
 
 NDArray NDArray::Empty(const DynArray<int64_t>& shape, DLDataType dtype, DLContext ctx) {
@@ -212,7 +224,11 @@ DSOModule::~DSOModule() {
 }
 
 BackendPackedCFunc DSOModule::GetFunction(const std::string& name) const {
-  auto faddr = reinterpret_cast<BackendPackedCFunc>(GetSymbol(name.c_str()));
+  return GetFunction(name.c_str());
+}
+
+BackendPackedCFunc DSOModule::GetFunction(const char* name) const {
+  auto faddr = reinterpret_cast<BackendPackedCFunc>(GetSymbol(name));
   assert(faddr);
   return faddr;
 }
@@ -227,13 +243,13 @@ void* DSOModule::GetSymbol(const char* name) const {
 MicroGraphRuntime::MicroGraphRuntime(const std::string& graph_json, DSOModule* module) {
   assert(module);
   module_ = module;
-  picojson::value v;
-  picojson::parse(v, graph_json);
-  ParseNodes(v.get<picojson::object>()["nodes"].get<picojson::array>(), &nodes_);
-  ParseArgNodes(v.get<picojson::object>()["arg_nodes"].get<picojson::array>(), &input_nodes_);
-  ParseArgNodes(v.get<picojson::object>()["node_row_ptr"].get<picojson::array>(), &node_row_ptr_);
-  ParseOutputs(v.get<picojson::object>()["heads"].get<picojson::array>(), &outputs_);
-  ParseAttrs(v.get<picojson::object>()["attrs"].get<picojson::object>(), &attrs_);
+  Graph graph;
+  ParseGraph(graph_json, &graph);
+  nodes_ = graph.nodes;
+  input_nodes_ = graph.input_nodes;
+  node_row_ptr_ = graph.node_row_ptr;
+  outputs_ = graph.outputs;
+  attrs_ = graph.attrs;
   SetupStorage();
   SetupOpExecs();
 }
@@ -365,8 +381,10 @@ std::function<void()> CreateTVMOp(const DSOModule& module, const TVMOpParam& par
 
   auto fexec = [arg_ptr, pf]() {
     assert(pf);
-    (pf)(arg_ptr->arg_values.data(), arg_ptr->arg_tcodes.data(),
-         static_cast<int>(arg_ptr->arg_values.size()));
+    int ret = (pf)(arg_ptr->arg_values.data(), arg_ptr->arg_tcodes.data(),
+                   static_cast<int>(arg_ptr->arg_values.size()));
+    assert(ret == 0);
+    (void)ret;
   };
   return fexec;
 }
@@ -44,6 +44,7 @@ class DSOModule {
   explicit DSOModule(const std::string& name);
   ~DSOModule();
   BackendPackedCFunc GetFunction(const std::string& name) const;
+  BackendPackedCFunc GetFunction(const char* name) const;
 
  private:
   void* GetSymbol(const char* name) const;
@@ -90,6 +91,23 @@ struct Node {
   DynArray<NodeEntry> inputs;
 };
 
+// The parsed graph JSON.
+struct Graph {
+  // The graph nodes
+  DynArray<Node> nodes;
+  // The argument nodes
+  DynArray<uint32_t> input_nodes;
+  // Used for quick entry indexing
+  DynArray<uint32_t> node_row_ptr;
+  // Output entries
+  DynArray<NodeEntry> outputs;
+  // Additional graph attributes
+  GraphAttr attrs;
+};
+
+// Parse the JSON of a graph produced by the graph runtime codegen.
+void ParseGraph(const std::string& graph_json, Graph* graph);
+
 // Minimal NDArray abstraction
 class NDArray {
  public:
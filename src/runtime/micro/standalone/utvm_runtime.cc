@@ -17,8 +17,11 @@
  * under the License.
  */
 #include <cassert>
+#include <cstring>
+#include <string>
 
 #include "tvm/runtime/micro/standalone/utvm_runtime.h"
+#include "utvm_aot_runtime.h"
 #include "utvm_graph_runtime.h"
 
 void* UTVMRuntimeCreate(const char* json, size_t json_len, void* module) {
@@ -51,3 +54,36 @@ void* UTVMRuntimeDSOModuleCreate(const char* so, size_t so_len) {
 void UTVMRuntimeDSOModuleDestroy(void* module) {
   delete reinterpret_cast<tvm::micro::DSOModule*>(module);
 }
+
+size_t UTVMRuntimeAOTCompile(const char* json, size_t json_len, const char* params,
+                             size_t params_len, void* out, size_t out_len) {
+  std::string descriptor = tvm::micro::CompileAOTDescriptor(
+      std::string(json, json + json_len), std::string(params, params + params_len));
+  if (out != nullptr && out_len >= descriptor.size()) {
+    std::memcpy(out, descriptor.data(), descriptor.size());
+  }
+  return descriptor.size();
+}
+
+size_t UTVMRuntimeAOTArenaSize(const void* descriptor) {
+  return tvm::micro::MicroAOTRuntime::ArenaSize(descriptor);
+}
+
+void* UTVMRuntimeAOTCreate(const void* descriptor, void* arena, size_t arena_size, void* module) {
+  return tvm::micro::MicroAOTRuntime::Create(
+      descriptor, arena, arena_size, reinterpret_cast<tvm::micro::DSOModule*>(module));
+}
+
+void UTVMRuntimeAOTSetInput(void* handle, int index, void* tensor) {
+  reinterpret_cast<tvm::micro::MicroAOTRuntime*>(handle)->SetInput(
+      index, reinterpret_cast<DLTensor*>(tensor));
+}
+
+int UTVMRuntimeAOTRun(void* handle) {
+  return reinterpret_cast<tvm::micro::MicroAOTRuntime*>(handle)->Run();
+}
+
+void UTVMRuntimeAOTGetOutput(void* handle, int index, void* tensor) {
+  reinterpret_cast<tvm::micro::MicroAOTRuntime*>(handle)->CopyOutputTo(
+      index, reinterpret_cast<DLTensor*>(tensor));
+}
@@ -24,7 +24,9 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/util.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
 #include <algorithm>
+#include <atomic>
 #include "stackvm.h"
 
 namespace tvm {
@@ -36,6 +38,13 @@ StackVM::State* StackVM::ThreadLocalState() {
   return StackVMStateStore::Get();
 }
 
+// whether Run executes the fused program.
+static std::atomic<bool> stackvm_use_fused{true};
+
+void StackVM::SetFusedDispatch(bool enable) {
+  stackvm_use_fused = enable;
+}
+
 #define STACK_VM_BINOP(OP, FIELD)                                 \
   {                                                               \
     stack[sp - 1].FIELD = stack[sp - 1].FIELD OP stack[sp].FIELD; \
@@ -64,6 +73,157 @@ StackVM::State* StackVM::ThreadLocalState() {
     sp -= 2; pc += 2;                                                   \
   }
 
+// load element index of the array at addr, as the ARRAY_LOAD_* op codes.
+inline void ArrayLoad(int op, void* addr, int index, TVMValue* dst) {
+  switch (op) {
+    case StackVM::ARRAY_LOAD_UINT32: {
+      dst->v_int64 = static_cast<int64_t>(static_cast<uint32_t*>(addr)[index]); break;
+    }
+    case StackVM::ARRAY_LOAD_INT32: {
+      dst->v_int64 = static_cast<int64_t>(static_cast<int32_t*>(addr)[index]); break;
+    }
+    case StackVM::ARRAY_LOAD_INT64: {
+      dst->v_int64 = static_cast<int64_t*>(addr)[index]; break;
+    }
+    case StackVM::ARRAY_LOAD_FP64: {
+      dst->v_float64 = static_cast<double*>(addr)[index]; break;
+    }
+    case StackVM::ARRAY_LOAD_HANDLE: {
+      dst->v_handle = static_cast<void**>(addr)[index]; break;
+    }
+    case StackVM::ARRAY_LOAD_TVMVALUE: {
+      *dst = static_cast<TVMValue*>(addr)[index]; break;
+    }
+    default: LOG(FATAL) << "unknown load op code " << op;
+  }
+}
+
+// store value to element index of the array at addr, as the ARRAY_STORE_* op codes.
+inline void ArrayStore(int op, void* addr, int index, const TVMValue& value) {
+  switch (op) {
+    case StackVM::ARRAY_STORE_UINT32: {
+      static_cast<uint32_t*>(addr)[index] = static_cast<uint32_t>(value.v_int64); break;
+    }
+    case StackVM::ARRAY_STORE_INT32: {
+      static_cast<int32_t*>(addr)[index] = static_cast<int32_t>(value.v_int64); break;
+    }
+    case StackVM::ARRAY_STORE_INT64: {
+      static_cast<int64_t*>(addr)[index] = value.v_int64; break;
+    }
+    case StackVM::ARRAY_STORE_FP64: {
+      static_cast<double*>(addr)[index] = value.v_float64; break;
+    }
+    case StackVM::ARRAY_STORE_HANDLE: {
+      static_cast<void**>(addr)[index] = value.v_handle; break;
+    }
+    case StackVM::ARRAY_STORE_TVMVALUE: {
+      static_cast<TVMValue*>(addr)[index] = value; break;
+    }
+    default: LOG(FATAL) << "unknown store op code " << op;
+  }
+}
+
+// get field kind of the structure at handle, as TVM_STRUCT_GET.
+inline void StructGet(void* handle, int index, int kind, TVMValue* dst) {
+  using namespace ir;
+  TVMArray* arr = static_cast<TVMArray*>(handle);
+  switch (kind) {
+    case intrinsic::kArrData: {
+      dst->v_handle = arr[index].data; break;
+    }
+    case intrinsic::kArrShape: {
+      dst->v_handle = arr[index].shape; break;
+    }
+    case intrinsic::kArrStrides: {
+      dst->v_handle = arr[index].strides; break;
+    }
+    case intrinsic::kArrNDim: {
+      dst->v_int64 = arr[index].ndim; break;
+    }
+    case intrinsic::kArrTypeCode: {
+      dst->v_int64 = static_cast<int64_t>(
+          arr[index].dtype.code); break;
+    }
+    case intrinsic::kArrTypeBits: {
+      dst->v_int64 = static_cast<int64_t>(
+          arr[index].dtype.bits); break;
+    }
+    case intrinsic::kArrTypeLanes: {
+      dst->v_int64 = static_cast<int64_t>(
+          arr[index].dtype.lanes); break;
+    }
+    case intrinsic::kArrByteOffset: {
+      dst->v_int64 = static_cast<int64_t>(
+          arr[index].byte_offset); break;
+    }
+    case intrinsic::kArrDeviceId: {
+      dst->v_int64 = arr[index].ctx.device_id; break;
+    }
+    case intrinsic::kArrDeviceType: {
+      dst->v_int64 = static_cast<int64_t>(
+          arr[index].ctx.device_type); break;
+    }
+    case intrinsic::kArrAddr: {
+      dst->v_handle = arr + index; break;
+    }
+    case intrinsic::kTVMValueContent: {
+      *dst = static_cast<TVMValue*>(handle)[index]; break;
+    }
+    default: LOG(FATAL) << "unhandled get " << kind;
+  }
+}
+
+// set field kind of the structure at handle, as TVM_STRUCT_SET.
+inline void StructSet(void* handle, int index, int kind, const TVMValue& value) {
+  using namespace ir;
+  TVMArray* arr = static_cast<TVMArray*>(handle);
+  switch (kind) {
+    case intrinsic::kArrData: {
+      arr[index].data = value.v_handle; break;
+    }
+    case intrinsic::kArrShape: {
+      arr[index].shape = static_cast<int64_t*>(value.v_handle);
+      break;
+    }
+    case intrinsic::kArrStrides: {
+      arr[index].strides = static_cast<int64_t*>(value.v_handle);
+      break;
+    }
+    case intrinsic::kArrNDim: {
+      arr[index].ndim = static_cast<int>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrTypeCode: {
+      arr[index].dtype.code = static_cast<uint8_t>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrTypeBits: {
+      arr[index].dtype.bits = static_cast<uint8_t>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrTypeLanes: {
+      arr[index].dtype.lanes = static_cast<uint16_t>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrByteOffset: {
+      arr[index].byte_offset = static_cast<uint64_t>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrDeviceId: {
+      arr[index].ctx.device_id = static_cast<int>(value.v_int64);
+      break;
+    }
+    case intrinsic::kArrDeviceType: {
+      arr[index].ctx.device_type = static_cast<DLDeviceType>(value.v_int64);
+      break;
+    }
+    case intrinsic::kTVMValueContent: {
+      static_cast<TVMValue*>(handle)[index] = value; break;
+    }
+    default: LOG(FATAL) << "unhandled tvm_struct_set " << kind;
+  }
+}
+
 #define STACK_VM_PRINT_CODE0(CODE)                            \
   case CODE:  {                                                     \
     os << "[" << pc << "]\t" << #CODE << std::endl; return pc + 1;  \
@@ -203,13 +363,18 @@ void StackVM::Run(const runtime::TVMArgs& args,
   s->heap[0].v_handle = (void*)args.values;  // NOLINT(*)
   s->heap[1].v_handle = (void*)args.type_codes;  // NOLINT(*)
   s->heap[2].v_int64 = args.num_args;
-  this->Run(s);
+  if (stackvm_use_fused && !fused_code_.empty()) {
+    this->RunFused(s);
+  } else {
+    this->Run(s);
+  }
 }
 
 void StackVM::InitCache() {
   extern_func_cache_.clear();
   extern_func_cache_.resize(
       extern_func_name.size(), PackedFunc(nullptr));
+  this->BuildFusedCode();
 }
 
 void StackVM::Save(dmlc::Stream* strm) const {
@@ -392,107 +557,12 @@ void StackVM::Run(State* s) const {
       }
       // intrinsics
       case TVM_STRUCT_GET: {
-        using namespace ir;
-        int index = code[pc + 1].v_int;
-        int kind = code[pc + 2].v_int;
-        TVMArray* arr = static_cast<TVMArray*>(stack[sp].v_handle);
-        switch (kind) {
-          case intrinsic::kArrData: {
-            stack[sp].v_handle = arr[index].data; break;
-          }
-          case intrinsic::kArrShape: {
-            stack[sp].v_handle = arr[index].shape; break;
-          }
-          case intrinsic::kArrStrides: {
-            stack[sp].v_handle = arr[index].strides; break;
-          }
-          case intrinsic::kArrNDim: {
-            stack[sp].v_int64 = arr[index].ndim; break;
-          }
-          case intrinsic::kArrTypeCode: {
-            stack[sp].v_int64 = static_cast<int64_t>(
-                arr[index].dtype.code); break;
-          }
-          case intrinsic::kArrTypeBits: {
-            stack[sp].v_int64 = static_cast<int64_t>(
-                arr[index].dtype.bits); break;
-          }
-          case intrinsic::kArrTypeLanes: {
-            stack[sp].v_int64 = static_cast<int64_t>(
-                arr[index].dtype.lanes); break;
-          }
-          case intrinsic::kArrByteOffset: {
-            stack[sp].v_int64 = static_cast<int64_t>(
-                arr[index].byte_offset); break;
-          }
-          case intrinsic::kArrDeviceId: {
-            stack[sp].v_int64 = arr[index].ctx.device_id; break;
-          }
-          case intrinsic::kArrDeviceType: {
-            stack[sp].v_int64 = static_cast<int64_t>(
-                arr[index].ctx.device_type); break;
-          }
-          case intrinsic::kArrAddr: {
-            stack[sp].v_handle = arr + index; break;
-          }
-          case intrinsic::kTVMValueContent: {
-            stack[sp] = static_cast<TVMValue*>(stack[sp].v_handle)[index]; break;
-          }
-          default: LOG(FATAL) << "unhandled get " << kind;
-        }
+        StructGet(stack[sp].v_handle, code[pc + 1].v_int, code[pc + 2].v_int, &stack[sp]);
         pc = pc + 3;
         break;
       }
       case TVM_STRUCT_SET: {
-        using namespace ir;
-        int index = code[pc + 1].v_int;
-        int kind = code[pc + 2].v_int;
-        TVMArray* arr = static_cast<TVMArray*>(stack[sp - 1].v_handle);
-        switch (kind) {
-          case intrinsic::kArrData: {
-            arr[index].data = stack[sp].v_handle; break;
-          }
-          case intrinsic::kArrShape: {
-            arr[index].shape = static_cast<int64_t*>(stack[sp].v_handle);
-            break;
-          }
-          case intrinsic::kArrStrides: {
-            arr[index].strides = static_cast<int64_t*>(stack[sp].v_handle);
-            break;
-          }
-          case intrinsic::kArrNDim: {
-            arr[index].ndim = static_cast<int>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrTypeCode: {
-            arr[index].dtype.code = static_cast<uint8_t>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrTypeBits: {
-            arr[index].dtype.bits = static_cast<uint8_t>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrTypeLanes: {
-            arr[index].dtype.lanes = static_cast<uint16_t>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrByteOffset: {
-            arr[index].byte_offset = static_cast<uint64_t>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrDeviceId: {
-            arr[index].ctx.device_id = static_cast<int>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kArrDeviceType: {
-            arr[index].ctx.device_type = static_cast<DLDeviceType>(stack[sp].v_int64);
-            break;
-          }
-          case intrinsic::kTVMValueContent: {
-            static_cast<TVMValue*>(stack[sp - 1].v_handle)[index] = stack[sp]; break;
-          }
-          default: LOG(FATAL) << "unhandled tvm_struct_set " << kind;
-        }
+        StructSet(stack[sp - 1].v_handle, code[pc + 1].v_int, code[pc + 2].v_int, stack[sp]);
         sp -= 2;
         pc += 3;
         break;
@@ -541,6 +611,636 @@ void StackVM::Run(State* s) const {
   }
 }
 
+// Integer binary ops that are fused with their operands.
+#define STACK_VM_FUSED_BINOPS(X)                                        \
+  X(ADD, +) X(SUB, -) X(MUL, *) X(EQ, ==) X(LT, <) X(LE, <=)
+
+// Comparisons that are fused with the branch consuming them.
+#define STACK_VM_FUSED_CMPOPS(X)                \
+  X(EQ, ==) X(LT, <) X(LE, <=)
+
+#define STACK_VM_FUSED_BINOP_CODES(NAME, OP)                            \
+  PUSH_HEAP_##NAME##_IMM, PUSH_HEAP_##NAME##_HEAP, NAME##_IMM, NAME##_HEAP,
+
+#define STACK_VM_FUSED_CMPOP_CODES(NAME, OP)                    \
+  BR_IF_NOT_HEAP_##NAME##_IMM, BR_IF_NOT_HEAP_##NAME##_HEAP,
+
+/*!
+ * \brief Superinstructions of the fused program, numbered after StackVM::OpCode.
+ * \note Notation of the operands: a, b, c, d of StackVM::Instr.
+ *  Jump targets are always in d, as index into the fused program.
+ */
+enum FusedOpCode {
+  kFusedOpBegin = StackVM::TVM_STRUCT_SET,
+  /*!
+   * \brief Integer binary op on heap slots and immediates.
+   * \code
+   *  PUSH_HEAP_ADD_IMM:  stack[sp + 1].v_int64 = heap[a].v_int64 + b; sp = sp + 1;
+   *  PUSH_HEAP_ADD_HEAP: stack[sp + 1].v_int64 = heap[a].v_int64 + heap[b].v_int64; sp = sp + 1;
+   *  ADD_IMM:            stack[sp].v_int64 = stack[sp].v_int64 + a;
+   *  ADD_HEAP:           stack[sp].v_int64 = stack[sp].v_int64 + heap[a].v_int64;
+   * \endcode
+   */
+  STACK_VM_FUSED_BINOPS(STACK_VM_FUSED_BINOP_CODES)
+  /*!
+   * \brief Compare heap slots and immediates, and branch without touching the stack.
+   * \code
+   *  BR_IF_NOT_HEAP_LT_IMM: if (!(heap[a].v_int64 < b)) pc = d;
+   * \endcode
+   */
+  STACK_VM_FUSED_CMPOPS(STACK_VM_FUSED_CMPOP_CODES)
+  /*!
+   * \brief Pop the condition and branch if it is false.
+   *  Fuses RJUMP_IF_FALSE, POP when the jump lands on a POP as well.
+   * \code
+   *  cond = stack[sp].v_int64; sp = sp - 1;
+   *  if (!cond) pc = d;
+   * \endcode
+   */
+  BR_POP_IF_FALSE,
+  /*!
+   * \brief Assert equality.
+   * \code
+   *  ASSERT_HEAP_EQ_IMM:  CHECK(heap[a].v_int64 == b) << str_data[c];
+   *  ASSERT_HEAP_EQ_HEAP: CHECK(heap[a].v_int64 == heap[b].v_int64) << str_data[c];
+   *  ASSERT_EQ_IMM:       CHECK(stack[sp].v_int64 == a) << str_data[c]; sp = sp - 1;
+   *  ASSERT_EQ_HEAP:      CHECK(stack[sp].v_int64 == heap[a].v_int64) << str_data[c]; sp = sp - 1;
+   * \endcode
+   */
+  ASSERT_HEAP_EQ_IMM,
+  ASSERT_HEAP_EQ_HEAP,
+  ASSERT_EQ_IMM,
+  ASSERT_EQ_HEAP,
+  /*! \brief heap[b] = heap[a] */
+  MOVE_HEAP,
+  /*! \brief heap[b].v_int64 = a */
+  STORE_HEAP_IMM,
+  /*!
+   * \brief Structure access through a heap slot.
+   * \code
+   *  HEAP_STRUCT_GET:         stack[sp + 1] = struct_get(heap[a].v_handle, b, c); sp = sp + 1;
+   *  HEAP_STRUCT_GET_TO_HEAP: heap[d] = struct_get(heap[a].v_handle, b, c);
+   * \endcode
+   */
+  HEAP_STRUCT_GET,
+  HEAP_STRUCT_GET_TO_HEAP,
+  /*!
+   * \brief Array load through a heap slot, c is the ARRAY_LOAD_* op code.
+   * \code
+   *  HEAP_ARRAY_LOAD:         stack[sp + 1] = ((DType*)heap[a].v_handle)[b]; sp = sp + 1;
+   *  HEAP_ARRAY_LOAD_TO_HEAP: heap[d] = ((DType*)heap[a].v_handle)[b];
+   * \endcode
+   */
+  HEAP_ARRAY_LOAD,
+  HEAP_ARRAY_LOAD_TO_HEAP,
+  /*!
+   * \brief Address of an element, from PUSH_I64 a, MUL_I64, ADDR_ADD.
+   * \code
+   *  stack[sp - 1].v_handle = (char*)stack[sp - 1].v_handle + stack[sp].v_int64 * a;
+   *  sp = sp - 1;
+   * \endcode
+   */
+  INDEX_ADDR,
+  /*!
+   * \brief INDEX_ADDR followed by the ARRAY_LOAD_* op code c with offset b.
+   */
+  INDEX_LOAD
+};
+
+// The fused op codes of an integer binary op.
+struct FusedBinOp {
+  int push_heap_imm, push_heap_heap, imm, heap;
+  // branches, -1 if the op is not a comparison
+  int br_if_not_heap_imm{-1}, br_if_not_heap_heap{-1};
+};
+
+inline bool GetFusedBinOp(int op, FusedBinOp* f) {
+  switch (op) {
+#define STACK_VM_FUSED_BINOP_CASE(NAME, OP)                             \
+    case StackVM::NAME##_I64: {                                         \
+      f->push_heap_imm = PUSH_HEAP_##NAME##_IMM;                        \
+      f->push_heap_heap = PUSH_HEAP_##NAME##_HEAP;                      \
+      f->imm = NAME##_IMM;                                              \
+      f->heap = NAME##_HEAP;                                            \
+      break;                                                            \
+    }
+    STACK_VM_FUSED_BINOPS(STACK_VM_FUSED_BINOP_CASE)
+    default: return false;
+  }
+  switch (op) {
+#define STACK_VM_FUSED_CMPOP_CASE(NAME, OP)                             \
+    case StackVM::NAME##_I64: {                                         \
+      f->br_if_not_heap_imm = BR_IF_NOT_HEAP_##NAME##_IMM;              \
+      f->br_if_not_heap_heap = BR_IF_NOT_HEAP_##NAME##_HEAP;            \
+      break;                                                            \
+    }
+    STACK_VM_FUSED_CMPOPS(STACK_VM_FUSED_CMPOP_CASE)
+    default: break;
+  }
+  return true;
+}
+
+// number of code entries taken by an instruction.
+inline int64_t CodeLength(int op) {
+  switch (op) {
+    case StackVM::ARRAY_LOAD_UINT32:
+    case StackVM::ARRAY_LOAD_INT32:
+    case StackVM::ARRAY_LOAD_INT64:
+    case StackVM::ARRAY_LOAD_FP64:
+    case StackVM::ARRAY_LOAD_HANDLE:
+    case StackVM::ARRAY_LOAD_TVMVALUE:
+    case StackVM::ARRAY_STORE_UINT32:
+    case StackVM::ARRAY_STORE_INT32:
+    case StackVM::ARRAY_STORE_INT64:
+    case StackVM::ARRAY_STORE_FP64:
+    case StackVM::ARRAY_STORE_HANDLE:
+    case StackVM::ARRAY_STORE_TVMVALUE:
+    case StackVM::PUSH_I64:
+    case StackVM::PUSH_VALUE:
+    case StackVM::LOAD_HEAP:
+    case StackVM::STORE_HEAP:
+    case StackVM::ASSERT:
+    case StackVM::RJUMP_IF_TRUE:
+    case StackVM::RJUMP_IF_FALSE:
+    case StackVM::RJUMP:
+    case StackVM::ASSERT_SP:
+    case StackVM::TVM_STACK_ALLOCA_BY_8BYTE: return 2;
+    case StackVM::TVM_STRUCT_GET:
+    case StackVM::TVM_STRUCT_SET: return 3;
+    case StackVM::CALL_PACKED_LOWERED: return 4;
+    default: return 1;
+  }
+}
+
+inline bool IsArrayLoad(int op) {
+  return op >= StackVM::ARRAY_LOAD_UINT32 && op <= StackVM::ARRAY_LOAD_TVMVALUE;
+}
+
+inline bool IsArrayStore(int op) {
+  return op >= StackVM::ARRAY_STORE_UINT32 && op <= StackVM::ARRAY_STORE_TVMVALUE;
+}
+
+inline bool IsJump(int op) {
+  switch (op) {
+    case StackVM::RJUMP:
+    case StackVM::RJUMP_IF_TRUE:
+    case StackVM::RJUMP_IF_FALSE:
+    case BR_POP_IF_FALSE:
+#define STACK_VM_FUSED_CMPOP_JUMP(NAME, OP)                     \
+    case BR_IF_NOT_HEAP_##NAME##_IMM:                           \
+    case BR_IF_NOT_HEAP_##NAME##_HEAP:
+    STACK_VM_FUSED_CMPOPS(STACK_VM_FUSED_CMPOP_JUMP)
+      return true;
+    default: return false;
+  }
+}
+
+void StackVM::BuildFusedCode() {
+  fused_code_.clear();
+  const int64_t code_size = static_cast<int64_t>(code.size());
+  // Instructions that are jumped to must start a fused instruction.
+  std::vector<bool> is_target(code_size + 1, false);
+  for (int64_t pc = 0; pc < code_size; pc += CodeLength(code[pc].op_code)) {
+    OpCode op = code[pc].op_code;
+    if (op != RJUMP && op != RJUMP_IF_TRUE && op != RJUMP_IF_FALSE) continue;
+    CHECK_LT(pc + 1, code_size);
+    int64_t target = pc + code[pc + 1].v_int;
+    CHECK(target >= 0 && target <= code_size)
+        << "jump out of the program at pc=" << pc;
+    is_target[target] = true;
+    // a fused branch skips the POP at its target.
+    if (op == RJUMP_IF_FALSE && target < code_size && code[target].op_code == POP) {
+      is_target[target + 1] = true;
+    }
+  }
+  // index of the fused instruction starting at each pc.
+  std::vector<int> index(code_size + 1, -1);
+  int64_t pc = 0;
+  while (pc < code_size) {
+    // the instructions that can be fused with the one at pc.
+    const int kMaxFused = 5;
+    int64_t seq[kMaxFused];
+    int num = 0;
+    for (int64_t p = pc;
+         num < kMaxFused && p < code_size && (num == 0 || !is_target[p]);
+         p += CodeLength(code[p].op_code)) {
+      seq[num++] = p;
+    }
+    auto op = [&](int k) -> int {
+      return k < num ? static_cast<int>(code[seq[k]].op_code) : -1;
+    };
+    auto arg = [&](int k, int i) {
+      CHECK_LT(seq[k] + i, code_size);
+      return code[seq[k] + i].v_int;
+    };
+    // target of RJUMP_IF_FALSE, POP at k when it lands on a POP, else -1.
+    auto branch_pop_target = [&](int k) -> int64_t {
+      if (op(k) != RJUMP_IF_FALSE || op(k + 1) != POP) return -1;
+      int64_t target = seq[k] + arg(k, 1);
+      if (target >= code_size || code[target].op_code != POP) return -1;
+      return target + 1;
+    };
+    Instr ins{op(0), 0, 0, 0, 0};
+    int len = 1;
+    int64_t target = -1;
+    FusedBinOp f;
+    if (op(0) == LOAD_HEAP && (op(1) == LOAD_HEAP || op(1) == PUSH_I64) &&
+        GetFusedBinOp(op(2), &f)) {
+      bool imm = op(1) == PUSH_I64;
+      ins.a = arg(0, 1);
+      ins.b = arg(1, 1);
+      if (f.br_if_not_heap_imm >= 0 && (target = branch_pop_target(3)) >= 0) {
+        ins.op = imm ? f.br_if_not_heap_imm : f.br_if_not_heap_heap;
+        ins.d = static_cast<int>(target);
+        len = 5;
+      } else if (op(2) == EQ_I64 && op(3) == ASSERT) {
+        ins.op = imm ? ASSERT_HEAP_EQ_IMM : ASSERT_HEAP_EQ_HEAP;
+        ins.c = arg(3, 1);
+        len = 4;
+      } else {
+        ins.op = imm ? f.push_heap_imm : f.push_heap_heap;
+        len = 3;
+      }
+    } else if (op(0) == LOAD_HEAP && op(1) == TVM_STRUCT_GET) {
+      ins.a = arg(0, 1);
+      ins.b = arg(1, 1);
+      ins.c = arg(1, 2);
+      if (op(2) == STORE_HEAP) {
+        ins.op = HEAP_STRUCT_GET_TO_HEAP;
+        ins.d = arg(2, 1);
+        len = 3;
+      } else {
+        ins.op = HEAP_STRUCT_GET;
+        len = 2;
+      }
+    } else if (op(0) == LOAD_HEAP && IsArrayLoad(op(1))) {
+      ins.a = arg(0, 1);
+      ins.b = arg(1, 1);
+      ins.c = op(1);
+      if (op(2) == STORE_HEAP) {
+        ins.op = HEAP_ARRAY_LOAD_TO_HEAP;
+        ins.d = arg(2, 1);
+        len = 3;
+      } else {
+        ins.op = HEAP_ARRAY_LOAD;
+        len = 2;
+      }
+    } else if (op(0) == LOAD_HEAP && op(1) == STORE_HEAP) {
+      ins.op = MOVE_HEAP;
+      ins.a = arg(0, 1);
+      ins.b = arg(1, 1);
+      len = 2;
+    } else if (op(0) == PUSH_I64 && op(1) == MUL_I64 && op(2) == ADDR_ADD) {
+      ins.a = arg(0, 1);
+      if (IsArrayLoad(op(3))) {
+        ins.op = INDEX_LOAD;
+        ins.b = arg(3, 1);
+        ins.c = op(3);
+        len = 4;
+      } else {
+        ins.op = INDEX_ADDR;
+        len = 3;
+      }
+    } else if ((op(0) == LOAD_HEAP || op(0) == PUSH_I64) &&
+               op(1) == EQ_I64 && op(2) == ASSERT) {
+      ins.op = op(0) == PUSH_I64 ? ASSERT_EQ_IMM : ASSERT_EQ_HEAP;
+      ins.a = arg(0, 1);
+      ins.c = arg(2, 1);
+      len = 3;
+    } else if ((op(0) == LOAD_HEAP || op(0) == PUSH_I64) && GetFusedBinOp(op(1), &f)) {
+      ins.op = op(0) == PUSH_I64 ? f.imm : f.heap;
+      ins.a = arg(0, 1);
+      len = 2;
+    } else if (op(0) == PUSH_I64 && op(1) == STORE_HEAP) {
+      ins.op = STORE_HEAP_IMM;
+      ins.a = arg(0, 1);
+      ins.b = arg(1, 1);
+      len = 2;
+    } else if ((target = branch_pop_target(0)) >= 0) {
+      ins.op = BR_POP_IF_FALSE;
+      ins.d = static_cast<int>(target);
+      len = 2;
+    } else {
+      // plain instruction with decoded operands.
+      int64_t length = CodeLength(op(0));
+      if (length > 1) ins.a = arg(0, 1);
+      if (length > 2) ins.b = arg(0, 2);
+      if (length > 3) ins.c = arg(0, 3);
+      if (IsJump(op(0))) ins.d = static_cast<int>(pc + ins.a);
+    }
+    index[pc] = static_cast<int>(fused_code_.size());
+    fused_code_.push_back(ins);
+    pc = seq[len - 1] + CodeLength(op(len - 1));
+  }
+  index[code_size] = static_cast<int>(fused_code_.size());
+  for (Instr& ins : fused_code_) {
+    if (!IsJump(ins.op)) continue;
+    ins.d = index[ins.d];
+    CHECK_GE(ins.d, 0) << "jump into a fused instruction";
+  }
+}
+
+#define STACK_VM_FUSED_BINOP_RUN(NAME, OP)                              \
+  case PUSH_HEAP_##NAME##_IMM: {                                        \
+    stack[sp + 1].v_int64 = heap[ins.a].v_int64 OP ins.b;               \
+    sp += 1; pc += 1;                                                   \
+    break;                                                              \
+  }                                                                     \
+  case PUSH_HEAP_##NAME##_HEAP: {                                       \
+    stack[sp + 1].v_int64 = heap[ins.a].v_int64 OP heap[ins.b].v_int64; \
+    sp += 1; pc += 1;                                                   \
+    break;                                                              \
+  }                                                                     \
+  case NAME##_IMM: {                                                    \
+    stack[sp].v_int64 = stack[sp].v_int64 OP ins.a;                     \
+    pc += 1;                                                            \
+    break;                                                              \
+  }                                                                     \
+  case NAME##_HEAP: {                                                   \
+    stack[sp].v_int64 = stack[sp].v_int64 OP heap[ins.a].v_int64;       \
+    pc += 1;                                                            \
+    break;                                                              \
+  }
+
+#define STACK_VM_FUSED_CMPOP_RUN(NAME, OP)                              \
+  case BR_IF_NOT_HEAP_##NAME##_IMM: {                                   \
+    pc = (heap[ins.a].v_int64 OP ins.b) ? pc + 1 : ins.d;               \
+    break;                                                              \
+  }                                                                     \
+  case BR_IF_NOT_HEAP_##NAME##_HEAP: {                                  \
+    pc = (heap[ins.a].v_int64 OP heap[ins.b].v_int64) ? pc + 1 : ins.d; \
+    break;                                                              \
+  }
+
+void StackVM::RunFused(State* s) const {
+  int64_t sp = s->sp;
+  int64_t pc = 0;
+  int64_t alloca_sp = s->sp;
+  if (s->stack.size() < stack_size) {
+    s->stack.resize(stack_size);
+  }
+  int64_t stack_cap = static_cast<int64_t>(stack_size - 4);
+  if (s->heap.size() < heap_size) {
+    s->heap.resize(heap_size);
+  }
+  TVMValue* stack = s->stack.data();
+  TVMValue* heap = s->heap.data();
+  const Instr* prog = fused_code_.data();
+  const int64_t prog_size = static_cast<int64_t>(fused_code_.size());
+  while (pc < prog_size) {
+    const Instr& ins = prog[pc];
+    switch (ins.op) {
+      STACK_VM_FUSED_BINOPS(STACK_VM_FUSED_BINOP_RUN)
+      STACK_VM_FUSED_CMPOPS(STACK_VM_FUSED_CMPOP_RUN)
+      case BR_POP_IF_FALSE: {
+        pc = stack[sp].v_int64 ? pc + 1 : ins.d;
+        sp -= 1;
+        break;
+      }
+      case ASSERT_HEAP_EQ_IMM: {
+        CHECK(heap[ins.a].v_int64 == ins.b) << str_data[ins.c];
+        pc += 1;
+        break;
+      }
+      case ASSERT_HEAP_EQ_HEAP: {
+        CHECK(heap[ins.a].v_int64 == heap[ins.b].v_int64) << str_data[ins.c];
+        pc += 1;
+        break;
+      }
+      case ASSERT_EQ_IMM: {
+        CHECK(stack[sp].v_int64 == ins.a) << str_data[ins.c];
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case ASSERT_EQ_HEAP: {
+        CHECK(stack[sp].v_int64 == heap[ins.a].v_int64) << str_data[ins.c];
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case MOVE_HEAP: {
+        heap[ins.b] = heap[ins.a];
+        pc += 1;
+        break;
+      }
+      case STORE_HEAP_IMM: {
+        heap[ins.b].v_int64 = ins.a;
+        pc += 1;
+        break;
+      }
+      case HEAP_STRUCT_GET: {
+        StructGet(heap[ins.a].v_handle, ins.b, ins.c, &stack[sp + 1]);
+        sp += 1;
+        pc += 1;
+        break;
+      }
+      case HEAP_STRUCT_GET_TO_HEAP: {
+        StructGet(heap[ins.a].v_handle, ins.b, ins.c, &heap[ins.d]);
+        pc += 1;
+        break;
+      }
+      case HEAP_ARRAY_LOAD: {
+        ArrayLoad(ins.c, heap[ins.a].v_handle, ins.b, &stack[sp + 1]);
+        sp += 1;
+        pc += 1;
+        break;
+      }
+      case HEAP_ARRAY_LOAD_TO_HEAP: {
+        ArrayLoad(ins.c, heap[ins.a].v_handle, ins.b, &heap[ins.d]);
+        pc += 1;
+        break;
+      }
+      case INDEX_ADDR: {
+        stack[sp - 1].v_handle =
+            (char*)(stack[sp - 1].v_handle) + stack[sp].v_int64 * ins.a;  // NOLINT(*)
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case INDEX_LOAD: {
+        void* addr = (char*)(stack[sp - 1].v_handle) + stack[sp].v_int64 * ins.a;  // NOLINT(*)
+        sp -= 1;
+        ArrayLoad(ins.c, addr, ins.b, &stack[sp]);
+        pc += 1;
+        break;
+      }
+      // plain instructions
+      case ADD_I64: STACK_VM_BINOP(+, v_int64); break;
+      case SUB_I64: STACK_VM_BINOP(-, v_int64); break;
+      case MUL_I64: STACK_VM_BINOP(*, v_int64); break;
+      case DIV_I64: STACK_VM_BINOP(/, v_int64); break;
+      case MOD_I64: STACK_VM_BINOP(%, v_int64); break;
+      case EQ_I64: STACK_VM_CMPOP(==, v_int64); break;
+      case LT_I64: STACK_VM_CMPOP(<, v_int64); break;
+      case LE_I64: STACK_VM_CMPOP(<=, v_int64); break;
+      case ADD_F64: STACK_VM_BINOP(+, v_float64); break;
+      case SUB_F64: STACK_VM_BINOP(-, v_float64); break;
+      case MUL_F64: STACK_VM_BINOP(*, v_float64); break;
+      case DIV_F64: STACK_VM_BINOP(/, v_float64); break;
+      case EQ_F64: STACK_VM_CMPOP(==, v_float64); break;
+      case LT_F64: STACK_VM_CMPOP(<, v_float64); break;
+      case LE_F64: STACK_VM_CMPOP(<=, v_float64); break;
+      case EQ_HANDLE: STACK_VM_CMPOP(==, v_handle); break;
+      case ARRAY_LOAD_UINT32:
+      case ARRAY_LOAD_INT32:
+      case ARRAY_LOAD_INT64:
+      case ARRAY_LOAD_FP64:
+      case ARRAY_LOAD_HANDLE:
+      case ARRAY_LOAD_TVMVALUE: {
+        ArrayLoad(ins.op, stack[sp].v_handle, ins.a, &stack[sp]);
+        pc += 1;
+        break;
+      }
+      case ARRAY_STORE_UINT32:
+      case ARRAY_STORE_INT32:
+      case ARRAY_STORE_INT64:
+      case ARRAY_STORE_FP64:
+      case ARRAY_STORE_HANDLE:
+      case ARRAY_STORE_TVMVALUE: {
+        ArrayStore(ins.op, stack[sp - 1].v_handle, ins.a, stack[sp]);
+        sp -= 2;
+        pc += 1;
+        break;
+      }
+      case ADDR_ADD: {
+        stack[sp - 1].v_handle = (char*)(stack[sp - 1].v_handle) + stack[sp].v_int64;  // NOLINT(*)
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case NOT: {
+        stack[sp].v_int64 = !stack[sp].v_int64;
+        pc += 1;
+        break;
+      }
+      case PUSH_I64: {
+        stack[sp + 1].v_int64 = ins.a;
+        sp += 1;
+        pc += 1;
+        break;
+      }
+      case PUSH_VALUE: {
+        CHECK_LE(ins.a, 0);
+        stack[sp + 1] = stack[sp + ins.a];
+        sp += 1;
+        pc += 1;
+        break;
+      }
+      case POP: {
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case SELECT: {
+        stack[sp - 2] = (stack[sp].v_int64 ? stack[sp - 2] : stack[sp - 1]);
+        sp -= 2;
+        pc += 1;
+        break;
+      }
+      case LOAD_HEAP: {
+        stack[sp + 1] = heap[ins.a];
+        sp += 1;
+        pc += 1;
+        break;
+      }
+      case STORE_HEAP: {
+        heap[ins.a] = stack[sp];
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case ASSERT: {
+        CHECK(stack[sp].v_int64) << str_data[ins.a];
+        sp -= 1;
+        pc += 1;
+        break;
+      }
+      case RJUMP_IF_TRUE: {
+        pc = stack[sp].v_int64 ? ins.d : pc + 1;
+        break;
+      }
+      case RJUMP_IF_FALSE: {
+        pc = stack[sp].v_int64 ? pc + 1 : ins.d;
+        break;
+      }
+      case RJUMP: {
+        pc = ins.d;
+        break;
+      }
+      case ASSERT_SP: {
+        CHECK_EQ(sp, ins.a)
+            << "sp assertion failed, expected="
+            << ins.a << " now=" << sp << ", pc=" << pc;
+        pc += 1;
+        break;
+      }
+      case CALL_PACKED_LOWERED: {
+        TVMValue* value_stack = static_cast<TVMValue*>(stack[sp - 1].v_handle);
+        int* type_stack = static_cast<int*>(stack[sp].v_handle);
+        runtime::TVMRetValue rv;
+        GetExtern(s, ins.a).CallPacked(
+            runtime::TVMArgs(value_stack + ins.b, type_stack + ins.b, ins.c - ins.b), &rv);
+        sp = sp - 1;
+        stack[sp] = rv.value();
+        pc += 1;
+        break;
+      }
+      case TVM_STRUCT_GET: {
+        StructGet(stack[sp].v_handle, ins.a, ins.b, &stack[sp]);
+        pc += 1;
+        break;
+      }
+      case TVM_STRUCT_SET: {
+        StructSet(stack[sp - 1].v_handle, ins.a, ins.b, stack[sp]);
+        sp -= 2;
+        pc += 1;
+        break;
+      }
+      case TVM_STACK_ALLOCA_BY_8BYTE: {
+        void* addr = &stack[sp] + 1;
+        sp = sp + ins.a + 1;
+        alloca_sp = sp - 1;
+        stack[sp].v_handle = addr;
+        pc += 1;
+        break;
+      }
+      case TVM_DEVICE_ALLOCA: {
+        int device_type = static_cast<int>(stack[sp - 4].v_int64);
+        int device_id = static_cast<int>(stack[sp - 3].v_int64);
+        size_t nbytes = static_cast<size_t>(stack[sp - 2].v_int64);
+        int dtype_code_hint = static_cast<int>(stack[sp - 1].v_int64);
+        int dtype_bits_hint = static_cast<int>(stack[sp].v_int64);
+        void* ptr = TVMBackendAllocWorkspace(device_type, device_id, nbytes,
+                                             dtype_code_hint, dtype_bits_hint);
+        stack[sp - 4].v_handle = ptr;
+        sp = sp - 4;
+        pc += 1;
+        break;
+      }
+      case TVM_DEVICE_FREE: {
+        int device_type = static_cast<int>(stack[sp - 2].v_int64);
+        int device_id = static_cast<int>(stack[sp - 1].v_int64);
+        void* ptr = stack[sp].v_handle;
+        int ret = TVMBackendFreeWorkspace(device_type, device_id, ptr);
+        stack[sp - 2].v_int64 = ret;
+        sp = sp - 2;
+        pc += 1;
+        break;
+      }
+      case TVM_THROW_LAST_ERROR: {
+        LOG(FATAL) << TVMGetLastError();
+        break;
+      }
+      default: LOG(FATAL) << "unknown fused op code " << ins.op;
+    }
+    if (sp < alloca_sp || sp >= stack_cap) {
+      CHECK_GE(sp, alloca_sp) << "touch allocated space";
+      CHECK_LT(sp, stack_cap) << "Stack overflow";
+    }
+  }
+}
+
 const PackedFunc& StackVM::GetExtern(State* s, int fid) const {
   CHECK_LT(static_cast<size_t>(fid), extern_func_cache_.size());
   // allow race write in this, since write is idempotent
@@ -555,5 +1255,8 @@ const PackedFunc& StackVM::GetExtern(State* s, int fid) const {
   return f;
 }
 
+TVM_REGISTER_GLOBAL("module._StackVMSetFusedDispatch")
+.set_body_typed(StackVM::SetFusedDispatch);
+
 }  // namespace runtime
 }  // namespace tvm
@@ -301,7 +301,10 @@ class StackVM {
     /*! \brief The current module context of stackvm */
     runtime::ModuleNode* mod_ctx{nullptr};
   };
-  /*! \brief Initialize local cache*/
+  /*!
+   * \brief Initialize local cache,
+   *  including the fused program used by Run.
+   */
   void InitCache();
   /*!
    * \brief Save stackvm program to an output stream
@@ -322,6 +325,12 @@ class StackVM {
   int64_t PrintCode(std::ostream&os, int64_t pc) const;  // NOLINT(*)
   /*! \brief Get thread local state of the stack VM */
   static State* ThreadLocalState();
+  /*!
+   * \brief Whether Run executes the fused program, on by default.
+   *  The plain stack interpreter is kept for debugging and benchmarks.
+   * \param enable Whether to use the fused program.
+   */
+  static void SetFusedDispatch(bool enable);
   // The code below are programs
   /*! \brief The instructions */
   std::vector<Code> code;
@@ -406,12 +415,32 @@ class StackVM {
   friend std::ostream& operator<<(std::ostream& os, const StackVM& vm);  // NOLINT(*)
 
  private:
+  /*!
+   * \brief Pre-decoded instruction of the fused program.
+   *
+   *  The fused program is translated from code once, in InitCache.
+   *  Common instruction sequences become superinstructions that read
+   *  and write heap slots directly as registers instead of going
+   *  through the stack, and jumps are resolved to instruction indices.
+   */
+  struct Instr {
+    /*! \brief OpCode, or one of the fused op codes in stackvm.cc */
+    int op;
+    /*! \brief decoded operands */
+    int a, b, c, d;
+  };
   //  execute the stack vm with given state
   void Run(State* state) const;
+  //  execute the fused program with given state
+  void RunFused(State* state) const;
+  // translate code into the fused program.
+  void BuildFusedCode();
   // get extern function.
   const PackedFunc& GetExtern(State* s, int fid) const;
   // cached extern function
   mutable std::vector<PackedFunc> extern_func_cache_;
+  // the fused program
+  std::vector<Instr> fused_code_;
 };
 
 }  // namespace runtime
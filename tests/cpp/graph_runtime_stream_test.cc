@@ -0,0 +1,421 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace tvm::runtime;
+
+namespace {
+
+// A stream of the simulated device: a worker thread running its tasks in order.
+class SimStream {
+ public:
+  SimStream() : worker_([this]() { this->Loop(); }) {}
+
+  ~SimStream() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  void Push(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(task);
+      ++pending_;
+    }
+    cv_.notify_all();
+  }
+
+  void Drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return pending_ == 0; });
+  }
+
+  int pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+  }
+
+ private:
+  void Loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty()) return;
+        task = tasks_.front();
+        tasks_.pop_front();
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --pending_;
+      }
+      cv_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()> > tasks_;
+  int pending_{0};
+  bool stop_{false};
+  std::thread worker_;
+};
+
+// A one-shot event, recorded on a stream and waited on by another.
+struct SimEvent {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool set{false};
+
+  void Set() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      set = true;
+    }
+    cv.notify_all();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return set; });
+  }
+};
+
+// An asynchronous device in host memory. Copies and kernels queued on a
+// stream run later on its worker, after a random delay, so that a missing
+// dependency between streams shows up as a wrong result. The null stream
+// waits for all the streams, like the legacy default stream of CUDA.
+class SimDeviceAPI final : public DeviceAPI {
+ public:
+  void SetDevice(TVMContext ctx) final {}
+
+  void GetAttr(TVMContext ctx, DeviceAttrKind kind, TVMRetValue* rv) final {
+    if (kind == kExist) {
+      *rv = 1;
+    }
+  }
+
+  void* AllocDataSpace(TVMContext ctx, size_t nbytes, size_t alignment,
+                       TVMType type_hint) final {
+    void* ptr;
+    CHECK_EQ(posix_memalign(&ptr, alignment, nbytes), 0);
+    return ptr;
+  }
+
+  void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    free(ptr);
+  }
+
+  void CopyDataFromTo(const void* from, size_t from_offset, void* to, size_t to_offset,
+                      size_t size, TVMContext ctx_from, TVMContext ctx_to,
+                      TVMType type_hint, TVMStreamHandle stream) final {
+    const char* src = static_cast<const char*>(from) + from_offset;
+    char* dst = static_cast<char*>(to) + to_offset;
+    this->Launch(static_cast<SimStream*>(stream), [src, dst, size]() {
+        memcpy(dst, src, size);
+      });
+  }
+
+  TVMStreamHandle CreateStream(TVMContext ctx) final {
+    SimStream* stream = new SimStream();
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.insert(stream);
+    return stream;
+  }
+
+  void FreeStream(TVMContext ctx, TVMStreamHandle stream) final {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      streams_.erase(static_cast<SimStream*>(stream));
+    }
+    delete static_cast<SimStream*>(stream);
+  }
+
+  void StreamSync(TVMContext ctx, TVMStreamHandle stream) final {
+    if (stream == nullptr) {
+      this->DrainAll();
+    } else {
+      static_cast<SimStream*>(stream)->Drain();
+    }
+  }
+
+  void SetStream(TVMContext ctx, TVMStreamHandle stream) final {
+    CurrentStream() = static_cast<SimStream*>(stream);
+  }
+
+  void SyncStreamFromTo(TVMContext ctx, TVMStreamHandle event_src,
+                        TVMStreamHandle event_dst) final {
+    CHECK(event_src != nullptr && event_dst != nullptr);
+    auto event = std::make_shared<SimEvent>();
+    static_cast<SimStream*>(event_src)->Push([event]() { event->Set(); });
+    static_cast<SimStream*>(event_dst)->Push([event]() { event->Wait(); });
+  }
+
+  // Run a kernel on the stream set for the calling thread.
+  void Launch(std::function<void()> task) {
+    this->Launch(CurrentStream(), task);
+  }
+
+  // Number of tasks queued and not done yet.
+  int Pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int pending = 0;
+    for (SimStream* stream : streams_) {
+      pending += stream->pending();
+    }
+    return pending;
+  }
+
+  // Hold the tasks of all the streams until Release.
+  void Hold() {
+    std::lock_guard<std::mutex> lock(gate_mutex_);
+    held_ = true;
+  }
+
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(gate_mutex_);
+      held_ = false;
+    }
+    gate_cv_.notify_all();
+  }
+
+  static SimDeviceAPI* Global() {
+    static SimDeviceAPI* inst = new SimDeviceAPI();
+    return inst;
+  }
+
+ private:
+  static SimStream*& CurrentStream() {
+    static thread_local SimStream* stream = nullptr;
+    return stream;
+  }
+
+  void Launch(SimStream* stream, std::function<void()> task) {
+    if (stream == nullptr) {
+      this->DrainAll();
+      task();
+      return;
+    }
+    int delay = delay_(rng_);
+    stream->Push([this, task, delay]() {
+        {
+          std::unique_lock<std::mutex> lock(gate_mutex_);
+          gate_cv_.wait(lock, [this]() { return !held_; });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(delay));
+        task();
+      });
+  }
+
+  void DrainAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (SimStream* stream : streams_) {
+      stream->Drain();
+    }
+  }
+
+  std::mutex mutex_;
+  std::unordered_set<SimStream*> streams_;
+  std::mt19937 rng_{42};
+  std::uniform_int_distribution<int> delay_{0, 500};
+  std::mutex gate_mutex_;
+  std::condition_variable gate_cv_;
+  bool held_{false};
+};
+
+TVM_REGISTER_GLOBAL("device_api.ext_dev")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    *rv = static_cast<void*>(SimDeviceAPI::Global());
+  });
+
+// out = a + b on the simulated device, or a - b on the host.
+void ElemwiseOp(TVMArgs args, bool add) {
+  DLTensor* a = args[0];
+  DLTensor* b = args[1];
+  DLTensor* out = args[2];
+  const float* pa = static_cast<const float*>(a->data);
+  const float* pb = static_cast<const float*>(b->data);
+  float* pout = static_cast<float*>(out->data);
+  int64_t n = out->shape[0];
+  auto task = [pa, pb, pout, n, add]() {
+    for (int64_t i = 0; i < n; ++i) {
+      pout[i] = add ? pa[i] + pb[i] : pa[i] - pb[i];
+    }
+  };
+  if (out->ctx.device_type == kDLExtDev) {
+    SimDeviceAPI::Global()->Launch(task);
+  } else {
+    task();
+  }
+}
+
+class SimModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final {
+    return "sim";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "sim_add") {
+      return PackedFunc([](TVMArgs args, TVMRetValue* rv) { ElemwiseOp(args, true); });
+    } else if (name == "host_sub") {
+      return PackedFunc([](TVMArgs args, TVMRetValue* rv) { ElemwiseOp(args, false); });
+    }
+    return PackedFunc();
+  }
+};
+
+// out = (A + B) - C + D: the adds run on the device and the sub on the host,
+// with a copy each way. The output of the first add and of the second share
+// a storage, so the second add must wait for the copy reading the first.
+const char* kDuplexGraph = R"({
+  "nodes": [
+    {"op": "null", "name": "A", "inputs": []},
+    {"op": "null", "name": "B", "inputs": []},
+    {"op": "tvm_op", "name": "add0", "inputs": [[0, 0, 0], [1, 0, 0]],
+     "attrs": {"func_name": "sim_add", "num_inputs": "2", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "tvm_op", "name": "copy0", "inputs": [[2, 0, 0]],
+     "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "null", "name": "C", "inputs": []},
+    {"op": "tvm_op", "name": "sub", "inputs": [[3, 0, 0], [4, 0, 0]],
+     "attrs": {"func_name": "host_sub", "num_inputs": "2", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "tvm_op", "name": "copy1", "inputs": [[5, 0, 0]],
+     "attrs": {"func_name": "__copy", "num_inputs": "1", "num_outputs": "1",
+               "flatten_data": "0"}},
+    {"op": "null", "name": "D", "inputs": []},
+    {"op": "tvm_op", "name": "add1", "inputs": [[6, 0, 0], [7, 0, 0]],
+     "attrs": {"func_name": "sim_add", "num_inputs": "2", "num_outputs": "1",
+               "flatten_data": "0"}}
+  ],
+  "arg_nodes": [0, 1, 4, 7],
+  "node_row_ptr": [0, 1, 2, 3, 4, 5, 6, 7, 8, 9],
+  "heads": [[8, 0, 0]],
+  "attrs": {
+    "storage_id": ["list_int", [0, 1, 2, 3, 4, 5, 6, 7, 2]],
+    "shape": ["list_shape", [[64], [64], [64], [64], [64], [64], [64], [64], [64]]],
+    "device_index": ["list_int", [12, 12, 12, 1, 1, 1, 12, 12, 12]],
+    "dltype": ["list_str", ["float32", "float32", "float32", "float32", "float32",
+                            "float32", "float32", "float32", "float32"]]
+  }
+})";
+
+Module CreateDuplexRuntime() {
+  const PackedFunc* create = Registry::Get("tvm.graph_runtime.create");
+  CHECK(create != nullptr);
+  Module lib(make_object<SimModuleNode>());
+  Module mod = (*create)(std::string(kDuplexGraph), lib,
+                         static_cast<int>(kDLCPU), 0, static_cast<int>(kDLExtDev), 0);
+  mod.GetFunction("enable_streams")();
+  return mod;
+}
+
+NDArray CPUArray(float start) {
+  NDArray arr = NDArray::Empty({64}, DLDataType{kDLFloat, 32, 1}, DLContext{kDLCPU, 0});
+  float* data = static_cast<float*>(arr->data);
+  for (int i = 0; i < 64; ++i) {
+    data[i] = start + i;
+  }
+  return arr;
+}
+
+}  // namespace
+
+TEST(GraphRuntimeStreams, SimulatedDevice) {
+  Module mod = CreateDuplexRuntime();
+  PackedFunc set_input = mod.GetFunction("set_input_async");
+  PackedFunc run = mod.GetFunction("run");
+  PackedFunc get_output = mod.GetFunction("get_output_async");
+  PackedFunc sync = mod.GetFunction("sync");
+  NDArray out = CPUArray(0);
+  for (int iter = 0; iter < 20; ++iter) {
+    NDArray a = CPUArray(iter), b = CPUArray(2 * iter), c = CPUArray(3), d = CPUArray(-iter);
+    set_input("A", a);
+    set_input("B", b);
+    set_input("C", c);
+    set_input("D", d);
+    run();
+    get_output(0, out);
+    sync();
+    const float* data = static_cast<const float*>(out->data);
+    for (int i = 0; i < 64; ++i) {
+      float expected = (iter + i) + (2 * iter + i) - (3 + i) + (-iter + i);
+      ASSERT_EQ(data[i], expected) << "iteration " << iter << " index " << i;
+    }
+  }
+}
+
+TEST(GraphRuntimeStreams, AsyncInputs) {
+  Module mod = CreateDuplexRuntime();
+  SimDeviceAPI* device = SimDeviceAPI::Global();
+  NDArray a = CPUArray(1), b = CPUArray(2), c = CPUArray(3), d = CPUArray(4);
+  // The copies to the device are only queued.
+  device->Hold();
+  mod.GetFunction("set_input_async")("A", a);
+  mod.GetFunction("set_input_async")("B", b);
+  mod.GetFunction("set_input_async")("D", d);
+  EXPECT_GT(device->Pending(), 0);
+  device->Release();
+  mod.GetFunction("set_input")("C", c);
+  EXPECT_EQ(device->Pending(), 0);
+  mod.GetFunction("run")();
+  NDArray out = CPUArray(0);
+  mod.GetFunction("get_output")(0, out);
+  const float* data = static_cast<const float*>(out->data);
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(data[i], (1 + i) + (2 + i) - (3 + i) + (4 + i));
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
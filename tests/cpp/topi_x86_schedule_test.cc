@@ -0,0 +1,252 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <topi/nn/batch_matmul.h>
+#include <topi/x86/batch_matmul.h>
+#include <topi/x86/conv2d.h>
+#include <topi/x86/conv2d_winograd.h>
+#include <topi/x86/dense.h>
+#include <tvm/build_module.h>
+#include <tvm/operation.h>
+#include <tvm/runtime/registry.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using namespace tvm;
+
+runtime::NDArray RandomArray(const Tensor& t, std::mt19937* rng) {
+  std::vector<int64_t> shape;
+  for (auto dim : t->shape) {
+    shape.push_back(topi::detail::GetConstInt(dim));
+  }
+  auto arr = runtime::NDArray::Empty(shape, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  float* data = static_cast<float*>(arr->data);
+  size_t size = runtime::GetDataSize(*arr.operator->()) / sizeof(float);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = dist(*rng);
+  }
+  return arr;
+}
+
+/*
+ * Build the schedule of the last tensor of args, run it on random inputs and
+ * compare the output with the reference computed from the inputs.
+ */
+void CheckSchedule(Schedule s, const Array<Tensor>& args,
+                   std::function<std::vector<float>(const std::vector<const float*>&)> ref,
+                   float tol = 1e-4f) {
+  auto config = BuildConfig::Create();
+  auto target = Target::Create("llvm");
+  std::unordered_map<Tensor, Buffer> binds;
+  auto lowered = lower(s, args, "func", binds, config);
+  auto module = build(lowered, target, Target(), config);
+  auto func = module.GetFunction("func");
+
+  std::mt19937 rng(0);
+  std::vector<runtime::NDArray> arrays;
+  std::vector<const float*> inputs;
+  std::vector<TVMValue> values(args.size());
+  std::vector<int> codes(args.size());
+  for (size_t i = 0; i < args.size(); ++i) {
+    arrays.push_back(RandomArray(args[i], &rng));
+    inputs.push_back(static_cast<const float*>(arrays[i]->data));
+    values[i].v_handle = const_cast<DLTensor*>(arrays[i].operator->());
+    codes[i] = kArrayHandle;
+  }
+  inputs.pop_back();
+  runtime::TVMRetValue rv;
+  int num_args = static_cast<int>(args.size());
+  func.CallPacked(runtime::TVMArgs(values.data(), codes.data(), num_args), &rv);
+
+  auto expected = ref(inputs);
+  const float* out = static_cast<const float*>(arrays.back()->data);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(out[i], expected[i], tol * std::max(1.0f, std::fabs(expected[i])))
+      << "at " << i;
+  }
+}
+
+std::vector<float> RefDense(const float* data, const float* weight, const float* bias,
+                            int M, int N, int K) {
+  std::vector<float> out(M * N);
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      float sum = bias ? bias[j] : 0.0f;
+      for (int k = 0; k < K; ++k) {
+        sum += data[i * K + k] * weight[j * K + k];
+      }
+      out[i * N + j] = sum;
+    }
+  }
+  return out;
+}
+
+/* NCHW conv2d with a 1x1 stride */
+std::vector<float> RefConv2d(const float* data, const float* kernel,
+                             int C, int H, int W, int K, int KH, int KW, int pad) {
+  int OH = H + 2 * pad - KH + 1;
+  int OW = W + 2 * pad - KW + 1;
+  std::vector<float> out(K * OH * OW);
+  for (int k = 0; k < K; ++k) {
+    for (int y = 0; y < OH; ++y) {
+      for (int x = 0; x < OW; ++x) {
+        float sum = 0.0f;
+        for (int c = 0; c < C; ++c) {
+          for (int i = 0; i < KH; ++i) {
+            for (int j = 0; j < KW; ++j) {
+              int h = y + i - pad;
+              int w = x + j - pad;
+              if (h >= 0 && h < H && w >= 0 && w < W) {
+                sum += data[(c * H + h) * W + w] * kernel[((k * C + c) * KH + i) * KW + j];
+              }
+            }
+          }
+        }
+        out[(k * OH + y) * OW + x] = sum;
+      }
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(TopiX86, Dense) {
+  auto target = Target::Create("llvm");
+  for (int M : { 4, 64 }) {
+    const int N = 48, K = 96;
+    auto data = placeholder({ M, K }, DataType::Float(32), "data");
+    auto weight = placeholder({ N, K }, DataType::Float(32), "weight");
+    auto bias = placeholder({ N }, DataType::Float(32), "bias");
+    auto out = topi::x86::dense_x86(target, data, weight, bias, DataType::Float(32));
+    CHECK_EQ(out->op->InputTensors()[0]->op->tag, M <= 16 ? "dense_nopack" : "dense_pack");
+    auto s = topi::x86::schedule_dense(target, { out });
+    CheckSchedule(s, { data, weight, bias, out }, [&](const std::vector<const float*>& in) {
+      return RefDense(in[0], in[1], in[2], M, N, K);
+    });
+  }
+}
+
+TEST(TopiX86, DenseTunedConfig) {
+  auto target = Target::Create("llvm");
+  const int M = 32, N = 64, K = 64;
+  topi::detail::ScheduleConfig cfg;
+  cfg.Set("tile_y", { 2, 2, 8 });
+  cfg.Set("tile_x", { 2, 2, 16 });
+  cfg.Set("tile_k", { 16, 4 });
+  auto data = placeholder({ M, K }, DataType::Float(32), "data");
+  auto weight = placeholder({ N, K }, DataType::Float(32), "weight");
+  auto out = topi::x86::dense_x86(target, data, weight, Tensor(), DataType::Float(32), cfg);
+  auto s = topi::x86::schedule_dense(target, { out }, cfg);
+  CheckSchedule(s, { data, weight, out }, [&](const std::vector<const float*>& in) {
+    return RefDense(in[0], in[1], nullptr, M, N, K);
+  });
+}
+
+TEST(TopiX86, BatchMatmul) {
+  auto target = Target::Create("llvm");
+  const int B = 3, M = 16, N = 24, K = 32;
+  auto x = placeholder({ B, M, K }, DataType::Float(32), "x");
+  auto y = placeholder({ B, N, K }, DataType::Float(32), "y");
+  auto out = topi::nn::batch_matmul(x, y);
+  auto s = topi::x86::schedule_batch_matmul(target, { out });
+  CheckSchedule(s, { x, y, out }, [&](const std::vector<const float*>& in) {
+    std::vector<float> res;
+    for (int b = 0; b < B; ++b) {
+      auto r = RefDense(in[0] + b * M * K, in[1] + b * N * K, nullptr, M, N, K);
+      res.insert(res.end(), r.begin(), r.end());
+    }
+    return res;
+  });
+}
+
+TEST(TopiX86, Conv2dNCHWc) {
+  auto target = Target::Create("llvm");
+  const int C = 16, H = 14, W = 14, K = 32;
+  for (int ksize : { 1, 3 }) {
+    int pad = ksize / 2;
+    auto cfg = topi::x86::default_conv2d_NCHWc_config(target, C, K, H, W, ksize, ksize);
+    int ic_bn = topi::detail::InnerFactor(cfg["tile_ic"]);
+    int oc_bn = topi::detail::InnerFactor(cfg["tile_oc"]);
+    auto data = placeholder({ 1, C / ic_bn, H, W, ic_bn }, DataType::Float(32), "data");
+    auto kernel = placeholder({ K / oc_bn, C / ic_bn, ksize, ksize, ic_bn, oc_bn },
+                              DataType::Float(32), "kernel");
+    auto conv = topi::x86::conv2d_NCHWc(data, kernel, pad, pad, 1, 1, 1, 1,
+                                        DataType::Float(32));
+    auto out = topi::relu<float>(conv);
+    auto s = topi::x86::schedule_conv2d_NCHWc(target, { out }, cfg);
+    CheckSchedule(s, { data, kernel, out }, [&](const std::vector<const float*>& in) {
+      // unpack to NCHW / OIHW, compute and pack the result again
+      std::vector<float> d(C * H * W), k(K * C * ksize * ksize);
+      for (int c = 0; c < C; ++c) {
+        for (int i = 0; i < H * W; ++i) {
+          d[c * H * W + i] = in[0][((c / ic_bn) * H * W + i) * ic_bn + c % ic_bn];
+        }
+      }
+      for (int o = 0; o < K; ++o) {
+        for (int c = 0; c < C; ++c) {
+          for (int i = 0; i < ksize * ksize; ++i) {
+            k[(o * C + c) * ksize * ksize + i] =
+              in[1][((((o / oc_bn) * (C / ic_bn) + c / ic_bn) * ksize * ksize + i) * ic_bn +
+                     c % ic_bn) * oc_bn + o % oc_bn];
+          }
+        }
+      }
+      auto ref = RefConv2d(d.data(), k.data(), C, H, W, K, ksize, ksize, pad);
+      std::vector<float> res(ref.size());
+      for (int o = 0; o < K; ++o) {
+        for (int i = 0; i < H * W; ++i) {
+          res[((o / oc_bn) * H * W + i) * oc_bn + o % oc_bn] =
+            std::max(ref[o * H * W + i], 0.0f);
+        }
+      }
+      return res;
+    });
+  }
+}
+
+TEST(TopiX86, Conv2dWinograd) {
+  auto target = Target::Create("llvm");
+  const int C = 8, H = 15, W = 17, K = 16;
+  // without padding, the output of 13 x 15 is not a multiple of the tile size either
+  for (int pad : { 1, 0 }) {
+    auto data = placeholder({ 1, C, H, W }, DataType::Float(32), "data");
+    auto kernel = placeholder({ K, C, 3, 3 }, DataType::Float(32), "kernel");
+    auto out = topi::x86::conv2d_winograd_nchw(target, data, kernel, pad, pad,
+                                               DataType::Float(32));
+    auto s = topi::x86::schedule_conv2d_winograd(target, { out });
+    CheckSchedule(s, { data, kernel, out }, [&](const std::vector<const float*>& in) {
+      return RefConv2d(in[0], in[1], C, H, W, K, 3, 3, pad);
+    }, 1e-3f);
+  }
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
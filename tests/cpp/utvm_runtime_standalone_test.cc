@@ -44,13 +44,18 @@
 #include <tvm/runtime/registry.h>
 
 #include <spawn.h>
+#include <chrono>
 #include <sys/wait.h>
 
 TVM_REGISTER_GLOBAL("test.sch").set_body([](tvm::TVMArgs args, tvm::TVMRetValue* rv) {
   *rv = topi::generic::schedule_injective(args[0], args[1]);
 });
 
-TEST(MicroStandaloneRuntime, BuildModule) {
+// Build `a + b + c` for the host and save it as a shared library. When `c_value` is
+// given, `c` is bound as a parameter and the saved parameter blob is returned in `params`.
+static std::string BuildAddModule(std::string* so_fname,
+                                  const tvm::runtime::NDArray* c_value = nullptr,
+                                  std::string* params = nullptr) {
   using namespace tvm;
   auto tensor_type = relay::TensorTypeNode::make({2, 3}, ::tvm::Float(32));
   auto a = relay::VarNode::make("a", tensor_type);
@@ -60,19 +65,6 @@ TEST(MicroStandaloneRuntime, BuildModule) {
   auto c = relay::VarNode::make("c", tensor_type);
   auto y = relay::CallNode::make(add_op, {x, c}, tvm::Attrs(), {});
   auto func = relay::FunctionNode::make(relay::FreeVars(y), y, relay::Type(), {});
-  auto A = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
-  auto B = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
-  auto C = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
-
-  auto pA = (float*)A.ToDLPack()->dl_tensor.data;
-  auto pB = (float*)B.ToDLPack()->dl_tensor.data;
-  auto pC = (float*)C.ToDLPack()->dl_tensor.data;
-
-  for (int i = 0; i < 6; ++i) {
-    pA[i] = i;
-    pB[i] = i + 1;
-    pC[i] = i + 2;
-  }
   // get schedule
   auto reg = tvm::runtime::Registry::Get("relay.op._Register");
   auto s_i = tvm::runtime::Registry::Get("test.sch");
@@ -90,23 +82,67 @@ TEST(MicroStandaloneRuntime, BuildModule) {
   auto json_f = build_mod.GetFunction("get_graph_json", false);
   auto mod_f = build_mod.GetFunction("get_module", false);
   Map<tvm::Integer, tvm::Target> targets;
+  if (c_value != nullptr) {
+    Map<std::string, relay::Constant> bind;
+    bind.Set("c", relay::ConstantNode::make(*c_value));
+    build_mod.GetFunction("set_params", false)(bind);
+  }
 
   Target llvm_tgt = Target::Create("llvm");
   targets.Set(0, llvm_tgt);
   build_f(func, targets, llvm_tgt);
   std::string json = json_f();
   tvm::runtime::Module mod = mod_f();
+  if (params != nullptr) {
+    Map<std::string, relay::Constant> built_params = build_mod.GetFunction("get_params", false)();
+    std::vector<std::string> names;
+    for (const auto& kv : built_params) {
+      names.push_back(kv.first);
+    }
+    std::vector<TVMValue> values(names.size() * 2);
+    std::vector<int> type_codes(names.size() * 2);
+    tvm::runtime::TVMArgsSetter setter(values.data(), type_codes.data());
+    for (size_t i = 0; i < names.size(); ++i) {
+      setter(2 * i, names[i]);
+      setter(2 * i + 1, built_params[names[i]]->data);
+    }
+    auto save_f = tvm::runtime::Registry::Get("tvm.relay._save_param_dict");
+    CHECK(save_f != nullptr);
+    tvm::runtime::TVMRetValue rv;
+    save_f->CallPacked(tvm::runtime::TVMArgs(values.data(), type_codes.data(),
+                                             static_cast<int>(values.size())), &rv);
+    *params = rv.operator std::string();
+  }
   std::string o_fname = std::tmpnam(nullptr);
-  std::string so_fname = std::tmpnam(nullptr);
+  *so_fname = std::tmpnam(nullptr);
   mod->SaveToFile(o_fname, "o");
-  const std::vector<std::string> args = {"gcc", "-shared", "-fPIC", "-o", so_fname, o_fname};
+  const std::vector<std::string> args = {"gcc", "-shared", "-fPIC", "-o", *so_fname, o_fname};
   std::stringstream s;
   for (auto& c : args) {
     s << c << " ";
   }
   const auto ss = s.str();
   const auto ret = system(ss.c_str());
-  ASSERT_EQ(ret, 0);
+  CHECK_EQ(ret, 0);
+  return json;
+}
+
+TEST(MicroStandaloneRuntime, BuildModule) {
+  auto A = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto B = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto C = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+
+  auto pA = (float*)A.ToDLPack()->dl_tensor.data;
+  auto pB = (float*)B.ToDLPack()->dl_tensor.data;
+  auto pC = (float*)C.ToDLPack()->dl_tensor.data;
+
+  for (int i = 0; i < 6; ++i) {
+    pA[i] = i;
+    pB[i] = i + 1;
+    pC[i] = i + 2;
+  }
+  std::string so_fname;
+  std::string json = BuildAddModule(&so_fname);
   // Now, execute the minimal runtime.
   auto* dsoModule = UTVMRuntimeDSOModuleCreate(so_fname.c_str(), so_fname.size());
   ASSERT_NE(dsoModule, nullptr);
@@ -127,6 +163,110 @@ TEST(MicroStandaloneRuntime, BuildModule) {
   UTVMRuntimeDSOModuleDestroy(dsoModule);
 }
 
+TEST(MicroStandaloneRuntime, AOTModule) {
+  auto A = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto B = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto C = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+
+  auto pA = (float*)A.ToDLPack()->dl_tensor.data;
+  auto pB = (float*)B.ToDLPack()->dl_tensor.data;
+  auto pC = (float*)C.ToDLPack()->dl_tensor.data;
+
+  for (int i = 0; i < 6; ++i) {
+    pA[i] = i;
+    pB[i] = i + 1;
+    pC[i] = i + 2;
+  }
+  std::string so_fname;
+  std::string json = BuildAddModule(&so_fname);
+  auto* dsoModule = UTVMRuntimeDSOModuleCreate(so_fname.c_str(), so_fname.size());
+  ASSERT_NE(dsoModule, nullptr);
+
+  // Compile the graph ahead of time into an aligned descriptor.
+  size_t descriptor_size = UTVMRuntimeAOTCompile(json.c_str(), json.size(), nullptr, 0,
+                                                 nullptr, 0);
+  std::vector<uint64_t> descriptor((descriptor_size + 63) / 8);
+  void* aligned_descriptor = reinterpret_cast<void*>(
+      (reinterpret_cast<uintptr_t>(descriptor.data()) + 63) / 64 * 64);
+  ASSERT_EQ(UTVMRuntimeAOTCompile(json.c_str(), json.size(), nullptr, 0, aligned_descriptor,
+                                  descriptor_size),
+            descriptor_size);
+  size_t arena_size = UTVMRuntimeAOTArenaSize(aligned_descriptor);
+  std::vector<uint8_t> arena(arena_size);
+
+  // Startup of both runtimes.
+  auto t0 = std::chrono::high_resolution_clock::now();
+  auto* graph_handle = UTVMRuntimeCreate(json.c_str(), json.size(), dsoModule);
+  auto t1 = std::chrono::high_resolution_clock::now();
+  auto* handle = UTVMRuntimeAOTCreate(aligned_descriptor, arena.data(), arena_size, dsoModule);
+  auto t2 = std::chrono::high_resolution_clock::now();
+  ASSERT_NE(handle, nullptr);
+  LOG(INFO) << "startup: json " << std::chrono::duration<double, std::micro>(t1 - t0).count()
+            << "us, aot " << std::chrono::duration<double, std::micro>(t2 - t1).count()
+            << "us; footprint: json " << json.size() << "B, descriptor " << descriptor_size
+            << "B + arena " << arena_size << "B";
+
+  UTVMRuntimeAOTSetInput(handle, 0, &A.ToDLPack()->dl_tensor);
+  UTVMRuntimeAOTSetInput(handle, 1, &B.ToDLPack()->dl_tensor);
+  UTVMRuntimeAOTSetInput(handle, 2, &C.ToDLPack()->dl_tensor);
+  ASSERT_EQ(UTVMRuntimeAOTRun(handle), 0);
+  auto Y = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  UTVMRuntimeAOTGetOutput(handle, 0, &Y.ToDLPack()->dl_tensor);
+  auto* pY = (float*)Y.ToDLPack()->dl_tensor.data;
+  for (int i = 0; i < 6; ++i) {
+    CHECK_LT(fabs(pY[i] - (i + (i + 1) + (i + 2))), 1e-4);
+  }
+  UTVMRuntimeDestroy(graph_handle);
+  UTVMRuntimeDSOModuleDestroy(dsoModule);
+}
+
+TEST(MicroStandaloneRuntime, AOTModuleWithParams) {
+  auto A = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto B = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  auto C = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+
+  auto pA = (float*)A.ToDLPack()->dl_tensor.data;
+  auto pB = (float*)B.ToDLPack()->dl_tensor.data;
+  auto pC = (float*)C.ToDLPack()->dl_tensor.data;
+
+  for (int i = 0; i < 6; ++i) {
+    pA[i] = i;
+    pB[i] = i + 1;
+    pC[i] = i + 2;
+  }
+  std::string so_fname;
+  std::string params;
+  std::string json = BuildAddModule(&so_fname, &C, &params);
+  ASSERT_FALSE(params.empty());
+  auto* dsoModule = UTVMRuntimeDSOModuleCreate(so_fname.c_str(), so_fname.size());
+  ASSERT_NE(dsoModule, nullptr);
+
+  // `c` is baked into the descriptor, only `a` and `b` are left as inputs.
+  size_t descriptor_size = UTVMRuntimeAOTCompile(json.c_str(), json.size(), params.data(),
+                                                 params.size(), nullptr, 0);
+  std::vector<uint64_t> descriptor((descriptor_size + 63) / 8);
+  void* aligned_descriptor = reinterpret_cast<void*>(
+      (reinterpret_cast<uintptr_t>(descriptor.data()) + 63) / 64 * 64);
+  ASSERT_EQ(UTVMRuntimeAOTCompile(json.c_str(), json.size(), params.data(), params.size(),
+                                  aligned_descriptor, descriptor_size),
+            descriptor_size);
+  size_t arena_size = UTVMRuntimeAOTArenaSize(aligned_descriptor);
+  std::vector<uint8_t> arena(arena_size);
+  auto* handle = UTVMRuntimeAOTCreate(aligned_descriptor, arena.data(), arena_size, dsoModule);
+  ASSERT_NE(handle, nullptr);
+
+  UTVMRuntimeAOTSetInput(handle, 0, &A.ToDLPack()->dl_tensor);
+  UTVMRuntimeAOTSetInput(handle, 1, &B.ToDLPack()->dl_tensor);
+  ASSERT_EQ(UTVMRuntimeAOTRun(handle), 0);
+  auto Y = tvm::runtime::NDArray::Empty({2, 3}, {kDLFloat, 32, 1}, {kDLCPU, 0});
+  UTVMRuntimeAOTGetOutput(handle, 0, &Y.ToDLPack()->dl_tensor);
+  auto* pY = (float*)Y.ToDLPack()->dl_tensor.data;
+  for (int i = 0; i < 6; ++i) {
+    CHECK_LT(fabs(pY[i] - (i + (i + 1) + (i + 2))), 1e-4);
+  }
+  UTVMRuntimeDSOModuleDestroy(dsoModule);
+}
+
 #endif
 #endif
 
@@ -102,8 +102,32 @@ def skipped_test_tflite_runtime():
             np.testing.assert_equal(out.asnumpy(), tflite_output)
 
 
+    def check_pipeline():
+        tflite_model = create_tflite_model()
+        num_interpreters = 2
+        runtime = tflite_runtime.create(tflite_model, tvm.cpu(0), num_interpreters)
+        assert runtime.num_interpreters == num_interpreters
+        runtime.allocate_tensors()
+
+        inputs = [tvm.nd.array(np.random.random_sample((2, )).astype("float32"))
+                  for _ in range(num_interpreters)]
+        for slot, data in enumerate(inputs):
+            runtime.set_input_zero_copy(0, data, slot)
+            runtime.invoke_async(slot)
+        runtime.wait()
+        for slot, data in enumerate(inputs):
+            out = runtime.get_output_view(0, slot)
+            np.testing.assert_allclose(out.asnumpy(), data.asnumpy() * [1., 2.])
+
+        # the bound array is read again by the next invocation
+        inputs[0].copyfrom(np.ones((2, ), dtype="float32"))
+        runtime.invoke_async(0)
+        np.testing.assert_allclose(runtime.get_output(0, 0).asnumpy(), [1., 2.])
+
+
     check_verify()
     check_remote()
+    check_pipeline()
 
 if __name__ == "__main__":
     # skipped_test_tflite_runtime()
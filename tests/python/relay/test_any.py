@@ -598,6 +598,41 @@ def test_recursive_concat_with_wrong_annotation():
     except Exception as e:
         assert "in particular dimension 0 conflicts 2 does not match 1" in str(e)
 
+def test_any_shape_buckets():
+    dtype = 'float32'
+    x = relay.var('x', shape=(relay.Any(), 16), dtype=dtype)
+    y = relay.var('y', shape=(relay.Any(), 16), dtype=dtype)
+    mod = relay.module.Module()
+    mod["main"] = relay.Function([x, y], relay.nn.relu(relay.add(x, y)))
+    relay.backend.compile_engine.get().clear()
+    lowered = []
+
+    def count_lower(stmt):
+        lowered.append(stmt)
+        return stmt
+
+    with tvm.build_config(dynamic_shape_buckets=[4, 8], add_lower_pass=[(1, count_lower)]):
+        ex = relay.create_executor("vm", mod=mod, ctx=tvm.cpu(), target="llvm")
+        # hit the factor 8 variant, the factor 4 variant and the fallback.
+        for n in [16, 12, 7]:
+            x_np = np.random.uniform(-1, 1, size=(n, 16)).astype(dtype)
+            y_np = np.random.uniform(-1, 1, size=(n, 16)).astype(dtype)
+            result = ex.evaluate()(x_np, y_np)
+            tvm.testing.assert_allclose(result.asnumpy(), np.maximum(x_np + y_np, 0))
+    # the custom passes run on the generic body and on both buckets
+    assert len(lowered) >= 3
+    relay.backend.compile_engine.get().clear()
+
+    # the buckets are part of the cache key
+    func = infer_type(relay.Function([x, y], relay.add(x, y)))
+    target = tvm.target.create("llvm")
+    key = relay.backend.compile_engine.CCacheKey(func, target)
+    with tvm.build_config(dynamic_shape_buckets=[4]):
+        key4 = relay.backend.compile_engine.CCacheKey(func, target)
+    assert [x.value for x in key4.dynamic_shape_buckets] == [4]
+    assert not key.dynamic_shape_buckets
+
+
 if __name__ == "__main__":
     test_any_full()
     test_any_broadcast()
@@ -624,3 +659,4 @@ if __name__ == "__main__":
     test_arange_with_dynamic_shape()
     test_recursive_concat()
     test_recursive_concat_with_wrong_annotation()
+    test_any_shape_buckets()
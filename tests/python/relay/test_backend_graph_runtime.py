@@ -14,9 +14,11 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import json
 import numpy as np
 
 import tvm
+import topi.testing
 from tvm import relay
 from tvm.contrib import graph_runtime
 from tvm.relay.scope_builder import ScopeBuilder
@@ -136,13 +138,73 @@ def test_plan_memory():
         for x in v[1]:
             device_types.add(x.value)
 
-    # Current rule requires vars have unique storage id
-    # because we don't do inplace, we will need another
-    # two alternating temporary space.
+    # Current rule requires vars have unique storage id,
+    # the chain of exp is computed in place in the storage of add.
     assert len(storage_ids) == 4
     assert len(device_types) == 1
 
 
+def plan_storage_ids(func):
+    mod = relay.Module.from_expr(func)
+    mod = relay.transform.FuseOps(0)(mod)
+    smap = relay.backend._backend.GraphPlanMemory(mod["main"])
+    return set(sid.value for v in smap.values() for sid in v[0])
+
+
+def test_plan_memory_inplace():
+    x = relay.var("x", shape=(10,))
+    z = relay.exp(x)
+    for _ in range(4):
+        z = relay.exp(z)
+    # x and a single buffer for the chain
+    assert len(plan_storage_ids(relay.Function([x], z))) == 2
+
+    # a cast to a narrower type cannot overwrite its input
+    z = relay.cast(relay.exp(x), "float16")
+    assert len(plan_storage_ids(relay.Function([x], z))) == 3
+
+    # an input used later is not overwritten
+    a = relay.exp(x)
+    b = relay.exp(a)
+    c = relay.add(a, b)
+    func = relay.Function([x], relay.exp(c))
+    assert len(plan_storage_ids(func)) == 3
+    x_data = np.random.rand(10).astype("float32")
+    check_rts(func, [x_data], np.exp(np.exp(x_data) + np.exp(np.exp(x_data))))
+
+    # an output of the function is not overwritten
+    a = relay.exp(x)
+    func = relay.Function([x], relay.Tuple([a, relay.exp(a)]))
+    assert len(plan_storage_ids(func)) == 3
+    graph, lib, _ = relay.build(relay.Module.from_expr(func), "llvm")
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    m.run(x=x_data)
+    tvm.testing.assert_allclose(m.get_output(0).asnumpy(), np.exp(x_data), rtol=1e-5)
+    tvm.testing.assert_allclose(m.get_output(1).asnumpy(), np.exp(np.exp(x_data)), rtol=1e-5)
+
+    # a fused broadcast function written in place over its input, whose kernel
+    # is lowered without noalias arguments.
+    x = relay.var("x", shape=(4, 64))
+    bias = relay.var("bias", shape=(64,))
+    # softmax is not fused with the broadcast ops after it.
+    a = relay.nn.softmax(x)
+    func = relay.Function([x, bias], relay.multiply(relay.add(a, bias), a))
+    x_data = np.random.rand(4, 64).astype("float32")
+    bias_data = np.random.rand(64).astype("float32")
+    a_data = topi.testing.softmax_python(x_data)
+    for target, ctx in ctx_list():
+        graph, lib, _ = relay.build(relay.Module.from_expr(func), target)
+        graph_json = json.loads(graph)
+        storage_ids = graph_json["attrs"]["storage_id"][1]
+        # x, bias and the output of softmax, reused by the fused add and multiply
+        assert len(set(storage_ids)) == 3
+        m = graph_runtime.create(graph, lib, ctx)
+        m.run(x=x_data, bias=bias_data)
+        tvm.testing.assert_allclose(
+            m.get_output(0).asnumpy(),
+            (a_data + bias_data) * a_data, rtol=1e-5)
+
+
 def test_gru_like():
     def unit(rnn_dim):
         X = relay.var("X", shape=(1, rnn_dim))
@@ -182,6 +244,7 @@ def test_gru_like():
 
 if __name__ == "__main__":
     test_plan_memory()
+    test_plan_memory_inplace()
     test_with_params()
     test_add_op_scalar()
     test_add_op_tensor()
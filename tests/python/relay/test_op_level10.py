@@ -316,6 +316,20 @@ def test_batch_matmul():
     zz = run_infer_type(z)
     assert zz.checked_type == relay.TensorType((b, m, n), "float32")
 
+    x = relay.var("x", relay.TensorType((b, m, k), "uint8"))
+    y = relay.var("y", relay.TensorType((b, n, k), "int8"))
+    z = relay.nn.batch_matmul(x, y, out_dtype="int32")
+    zz = run_infer_type(z)
+    assert zz.checked_type == relay.TensorType((b, m, n), "int32")
+    # the inputs are widened to the output type.
+    x_np = np.random.randint(0, 256, size=(2, 3, 8)).astype("uint8")
+    y_np = np.random.randint(-128, 128, size=(2, 5, 8)).astype("int8")
+    func = relay.Function([x, y], z)
+    intrp = relay.create_executor("graph", ctx=tvm.cpu(0), target="llvm")
+    res = intrp.evaluate(func)(x_np, y_np)
+    np.testing.assert_equal(
+        res.asnumpy(), topi.testing.batch_matmul(x_np.astype("int32"), y_np.astype("int32")))
+
     verify_batch_matmul((1, 16, 32), (1, 16, 32), (1, 16, 16))
     verify_batch_matmul((5, 16, 32), (5, 16, 32), (5, 16, 16))
     verify_batch_matmul((5, 16, 32), (5, 20, 32), (5, 16, 20))
@@ -290,7 +290,8 @@ def test_conv_network():
             for did in storage_dev_type[1]:
                 device_types.append(did.value)
         assert len(storage_ids) == 10
-        assert len(set(storage_ids)) == 8
+        # the add is computed in place in the storage of a device copy
+        assert len(set(storage_ids)) == 7
         assert len(set(device_types)) == 2
         assert set(device_types) == {1, 2}
 
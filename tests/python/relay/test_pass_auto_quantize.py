@@ -67,7 +67,35 @@ def test_calibrate_target(create_target=False):
             relay.quantize.quantize(mod, params, dataset)
 
 
+def test_calibration_stats():
+    from tvm.relay.quantize import _quantize
+    from tvm.relay.quantize.kl_divergence import _find_scale_by_kl, stats
+    np.random.seed(0)
+    batch = np.random.normal(size=(4, 1000)).astype("float32")
+    batches = [batch, batch[::-1].copy()]
+    calib = _quantize.CreateCalibrationStats(2, 8001)
+    for i, arr in enumerate(batches):
+        # the range of the second output grows with the batches
+        calib["update"](tvm.nd.array(arr), tvm.nd.array(arr * (i + 1)))
+    data = np.concatenate(batches).reshape(-1)
+
+    min_max = calib["min_max"]().asnumpy()
+    np.testing.assert_allclose(min_max[0], [data.min(), data.max()], rtol=1e-6)
+    np.testing.assert_allclose(min_max[1], [2 * data.min(), 2 * data.max()], rtol=1e-6)
+
+    scales = calib["find_scales"]("percentile", 1.0).asnumpy()
+    np.testing.assert_allclose(scales[0], np.abs(data).max(), rtol=1e-3)
+    scales = calib["find_scales"]("percentile", 0.99).asnumpy()
+    np.testing.assert_allclose(scales[0], np.percentile(np.abs(data), 99), rtol=1e-2)
+
+    scales = calib["find_scales"]("kl_divergence", 255).asnumpy()
+    if stats is not None:
+        np.testing.assert_allclose(scales[0], _find_scale_by_kl(data), rtol=1e-2)
+    assert 0 < scales[1] <= 2 * np.abs(data).max()
+
+
 if __name__ == "__main__":
     test_mul_rewrite()
     test_calibrate_target(False)
     test_calibrate_target(True)
+    test_calibration_stats()
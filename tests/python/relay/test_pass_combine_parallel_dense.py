@@ -188,7 +188,80 @@ def test_combine_parallel_dense_biasadd_scale_reshape():
     check(100, 200, 300, 0.5, 0.25, (1, 1, 200))
 
 
+def test_combine_parallel_dense_flat():
+    """Testcase of combining dense ops with different units into one dense"""
+    def before(x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3):
+        args = [x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3]
+        ys = []
+        for w, b, scale in [(w1, b1, scale1), (w2, b2, scale2), (w3, b3, scale3)]:
+            y = relay.nn.bias_add(relay.nn.dense(x, w), b)
+            y = relay.multiply(relay.nn.relu(y), scale)
+            ys.append(y)
+        return relay.Function(args, relay.Tuple(ys))
+
+    def expected(x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3, j1, j2, j3):
+        args = [x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3]
+        w = relay.concatenate((w1, w2, w3), axis=0)
+        y = relay.nn.dense(x, w)
+        b = relay.concatenate((b1, b2, b3), axis=0)
+        y = relay.nn.relu(relay.nn.bias_add(y, b))
+        scale = relay.concatenate((relay.repeat(scale1, j1, 0),
+                                   relay.repeat(scale2, j2, 0),
+                                   relay.repeat(scale3, j3, 0)), axis=0)
+        y = relay.multiply(y, scale)
+        y1 = relay.strided_slice(y, [0, 0], [None, j1])
+        y2 = relay.strided_slice(y, [0, j1], [None, j1 + j2])
+        y3 = relay.strided_slice(y, [0, j1 + j2], [None, j1 + j2 + j3])
+        return relay.Function(args, relay.Tuple((y1, y2, y3)))
+
+    def check(i, j1, j2, j3, k):
+        x = relay.var("x", shape=(i, k))
+        w1 = relay.var("w1", shape=(j1, k))
+        w2 = relay.var("w2", shape=(j2, k))
+        w3 = relay.var("w3", shape=(j3, k))
+        b1 = relay.var("b1", shape=(j1,))
+        b2 = relay.var("b2", shape=(j2,))
+        b3 = relay.var("b3", shape=(j3,))
+        scale1 = relay.var("scale1", shape=(1,))
+        scale2 = relay.var("scale2", shape=(1,))
+        scale3 = relay.var("scale3", shape=(1,))
+
+        y_before = before(x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3)
+        y = run_opt_pass(y_before,
+                         transform.CombineParallelDense(min_num_branches=3, to_batch=False))
+        y_expected = expected(x, w1, w2, w3, b1, b2, b3, scale1, scale2, scale3, j1, j2, j3)
+        y_expected = run_opt_pass(y_expected, transform.InferType())
+        assert relay.analysis.alpha_equal(y, y_expected)
+
+    check(3, 5, 5, 5, 4)
+    check(100, 200, 300, 100, 64)
+
+
+def test_combine_parallel_dense_flat_incompatible():
+    """Dense ops with different reduction dims, or different scalar scales, stay apart"""
+    x = relay.var("x", shape=(4, 16))
+    w1 = relay.var("w1", shape=(8, 16))
+    w2 = relay.var("w2", shape=(12, 16))
+    w3 = relay.var("w3", shape=(8, 32))
+    y1 = relay.multiply(relay.nn.dense(x, w1), relay.const(0.5))
+    y2 = relay.multiply(relay.nn.dense(x, w2), relay.const(0.25))
+    y3 = relay.nn.dense(relay.concatenate((x, x), axis=1), w3)
+    before = relay.Function([x, w1, w2, w3], relay.Tuple((y1, y2, y3)))
+    after = run_opt_pass(before, transform.CombineParallelDense(min_num_branches=2,
+                                                                to_batch=False))
+    # the dense ops of y1 and y2 are combined, but not the multiplies
+    y = relay.nn.dense(x, relay.concatenate((w1, w2), axis=0))
+    y1 = relay.multiply(relay.strided_slice(y, [0, 0], [None, 8]), relay.const(0.5))
+    y2 = relay.multiply(relay.strided_slice(y, [0, 8], [None, 20]), relay.const(0.25))
+    y3 = relay.nn.dense(relay.concatenate((x, x), axis=1), w3)
+    expected = relay.Function([x, w1, w2, w3], relay.Tuple((y1, y2, y3)))
+    expected = run_opt_pass(expected, transform.InferType())
+    assert relay.analysis.alpha_equal(after, expected)
+
+
 if __name__ == "__main__":
     test_combine_parallel_dense()
     test_combine_parallel_dense_biasadd()
     test_combine_parallel_dense_biasadd_scale_reshape()
+    test_combine_parallel_dense_flat()
+    test_combine_parallel_dense_flat_incompatible()
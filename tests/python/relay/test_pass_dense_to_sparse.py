@@ -0,0 +1,80 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import transform
+from tvm.contrib import graph_runtime
+
+
+def random_block_sparse(shape, block_size, sparsity):
+    """A random matrix in which `sparsity` of the blocks are zero"""
+    rows, cols = shape
+    bs_r, bs_c = block_size
+    mask = np.random.uniform(size=(rows // bs_r, cols // bs_c)) >= sparsity
+    mask[0, 0] = True
+    mask = np.kron(mask, np.ones(block_size))
+    return (np.random.uniform(-1, 1, size=shape) * mask).astype("float32")
+
+
+def run_dense_to_sparse(func, block_size, sparsity_threshold):
+    mod = relay.Module.from_expr(func)
+    mod = transform.DenseToSparse(block_size, sparsity_threshold)(mod)
+    mod = transform.InferType()(mod)
+    return mod["main"]
+
+
+def count_calls(func, op_name):
+    calls = []
+    def fvisit(e):
+        if isinstance(e, relay.Call) and e.op == relay.op.get(op_name):
+            calls.append(e)
+    relay.analysis.post_order_visit(func, fvisit)
+    return len(calls)
+
+
+def test_dense_to_sparse():
+    x = relay.var("x", shape=(16, 64))
+    w_sparse = random_block_sparse((32, 64), (1, 16), 0.9)
+    w_dense = np.random.uniform(size=(32, 32)).astype("float32")
+    y = relay.nn.relu(relay.nn.dense(x, relay.const(w_sparse)))
+    y = relay.nn.dense(y, relay.const(w_dense))
+    func = relay.Function([x], y)
+
+    after = run_dense_to_sparse(func, (1, 16), 0.8)
+    assert count_calls(after, "nn.sparse_dense") == 1
+    assert count_calls(after, "nn.dense") == 1
+    # the threshold is on zero blocks, not zero elements
+    after_large_blocks = run_dense_to_sparse(func, (32, 64), 0.8)
+    assert count_calls(after_large_blocks, "nn.sparse_dense") == 0
+    # a weight not divisible by the block size stays dense
+    after_uneven = run_dense_to_sparse(func, (3, 16), 0.0)
+    assert count_calls(after_uneven, "nn.sparse_dense") == 0
+
+    x_np = np.random.uniform(size=(16, 64)).astype("float32")
+    expected = np.maximum(x_np.dot(w_sparse.T), 0).dot(w_dense.T)
+    with relay.build_config(opt_level=3):
+        graph, lib, params = relay.build(relay.Module.from_expr(after), "llvm")
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    m.set_input(**params)
+    m.run(x=x_np)
+    tvm.testing.assert_allclose(m.get_output(0).asnumpy(), expected, rtol=1e-4, atol=1e-4)
+
+
+if __name__ == "__main__":
+    test_dense_to_sparse()
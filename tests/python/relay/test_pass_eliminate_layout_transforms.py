@@ -0,0 +1,157 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import transform
+from tvm.relay.testing import run_infer_type
+from tvm.contrib import graph_runtime
+
+
+def run_opt_pass(expr, opt_pass):
+    mod = relay.Module.from_expr(expr)
+    mod = opt_pass(mod)
+    mod = transform.InferType()(mod)
+    return mod["main"]
+
+
+def count_layout_transforms(func):
+    calls = []
+    def fvisit(e):
+        if isinstance(e, relay.Call) and e.op == relay.op.get("layout_transform"):
+            calls.append(e)
+    relay.analysis.post_order_visit(func, fvisit)
+    return len(calls)
+
+
+def conv_nchw16c(x, name):
+    w = relay.var(name, shape=(1, 1, 3, 3, 16, 16))
+    return relay.nn.contrib_conv2d_nchwc(x, w, channels=16, kernel_size=(3, 3),
+                                         padding=(1, 1), data_layout="NCHW16c",
+                                         kernel_layout="OIHW16i16o", out_layout="NCHW16c")
+
+
+def test_elemwise_region():
+    """The relu and the add between two blocked convolutions run blocked"""
+    def before():
+        x = relay.var("x", shape=(1, 1, 8, 8, 16))
+        b = relay.var("b", shape=(1, 16, 8, 8))
+        y = conv_nchw16c(x, "w1")
+        y = relay.layout_transform(y, "NCHW16c", "NCHW")
+        y = relay.add(relay.nn.relu(y), b)
+        y = relay.multiply(y, relay.const(2.0))
+        y = relay.layout_transform(y, "NCHW", "NCHW16c")
+        y = conv_nchw16c(y, "w2")
+        return relay.Function(relay.analysis.free_vars(y), y)
+
+    def expected():
+        x = relay.var("x", shape=(1, 1, 8, 8, 16))
+        b = relay.var("b", shape=(1, 16, 8, 8))
+        y = conv_nchw16c(x, "w1")
+        y = relay.add(relay.nn.relu(y), relay.layout_transform(b, "NCHW", "NCHW16c"))
+        y = relay.multiply(y, relay.const(2.0))
+        y = conv_nchw16c(y, "w2")
+        return relay.Function(relay.analysis.free_vars(y), y)
+
+    after = run_opt_pass(before(), transform.EliminateLayoutTransforms())
+    assert relay.analysis.alpha_equal(after, run_infer_type(expected()))
+    assert count_layout_transforms(after) == 1
+
+
+def test_transform_chain():
+    """A transform to a layout and back folds away"""
+    x = relay.var("x", shape=(1, 1, 8, 8, 16))
+    y = relay.layout_transform(x, "NCHW16c", "NCHW")
+    y = relay.layout_transform(y, "NCHW", "NCHW4c")
+    y = relay.layout_transform(y, "NCHW4c", "NCHW16c")
+    y = conv_nchw16c(y, "w")
+    after = run_opt_pass(relay.Function(relay.analysis.free_vars(y), y),
+                         transform.EliminateLayoutTransforms())
+    assert count_layout_transforms(after) == 0
+
+
+def test_region_output():
+    """A region which is also the function output keeps a transform back"""
+    x = relay.var("x", shape=(1, 1, 8, 8, 16))
+    y = conv_nchw16c(x, "w1")
+    y = relay.nn.relu(relay.layout_transform(y, "NCHW16c", "NCHW"))
+    z = conv_nchw16c(relay.layout_transform(y, "NCHW", "NCHW16c"), "w2")
+    z = relay.layout_transform(z, "NCHW16c", "NCHW")
+    before = relay.Function(relay.analysis.free_vars(z), relay.Tuple([y, z]))
+    after = run_opt_pass(before, transform.EliminateLayoutTransforms())
+    # the relu runs blocked, with a transform back for the output
+    assert count_layout_transforms(after) == 2
+    relu = after.body.fields[0].args[0]
+    assert relu.op == relay.op.get("nn.relu")
+    assert relu.checked_type.shape[-1] == 16
+
+    inputs = {"x": np.random.uniform(size=(1, 1, 8, 8, 16)).astype("float32"),
+              "w1": np.random.uniform(size=(1, 1, 3, 3, 16, 16)).astype("float32"),
+              "w2": np.random.uniform(size=(1, 1, 3, 3, 16, 16)).astype("float32")}
+    outputs = []
+    for func in [before, after]:
+        with relay.build_config(opt_level=0):
+            graph, lib, params = relay.build(relay.Module.from_expr(func), "llvm")
+        m = graph_runtime.create(graph, lib, tvm.cpu(0))
+        m.run(**inputs)
+        outputs.append([m.get_output(i).asnumpy() for i in range(2)])
+    for ref, res in zip(*outputs):
+        tvm.testing.assert_allclose(res, ref, rtol=1e-5)
+
+
+def test_keep_cheaper_layout():
+    """A region between a large NCHW input and one blocked user stays NCHW"""
+    x = relay.var("x", shape=(1, 16, 8, 8))
+    b = relay.var("b", shape=(1, 16, 8, 8))
+    c = relay.var("c", shape=(1, 16, 8, 8))
+    y = relay.add(relay.add(x, b), c)
+    y = relay.layout_transform(y, "NCHW", "NCHW16c")
+    y = conv_nchw16c(y, "w")
+    before = relay.Function(relay.analysis.free_vars(y), y)
+    after = run_opt_pass(before, transform.EliminateLayoutTransforms())
+    assert count_layout_transforms(after) == 1
+
+
+def test_build_required():
+    """The pass only runs in relay.build when required, with the same results"""
+    x = relay.var("x", shape=(1, 16, 8, 8))
+    y = x
+    for i in range(2):
+        w = relay.var("w%d" % i, shape=(16, 16, 3, 3))
+        y = relay.nn.conv2d(y, w, channels=16, kernel_size=(3, 3), padding=(1, 1))
+        y = relay.nn.relu(relay.add(y, relay.const(1.0)))
+    func = relay.Function(relay.analysis.free_vars(y), y)
+    inputs = {"x": np.random.uniform(size=(1, 16, 8, 8)).astype("float32"),
+              "w0": np.random.uniform(size=(16, 16, 3, 3)).astype("float32"),
+              "w1": np.random.uniform(size=(16, 16, 3, 3)).astype("float32")}
+    outputs = []
+    for required_pass in [None, ["EliminateLayoutTransforms"]]:
+        with relay.build_config(opt_level=3, required_pass=required_pass):
+            graph, lib, params = relay.build(relay.Module.from_expr(func), "llvm")
+        m = graph_runtime.create(graph, lib, tvm.cpu(0))
+        m.run(**inputs)
+        outputs.append(m.get_output(0).asnumpy())
+    tvm.testing.assert_allclose(outputs[1], outputs[0], rtol=1e-5)
+
+
+if __name__ == "__main__":
+    test_elemwise_region()
+    test_transform_chain()
+    test_region_output()
+    test_keep_cheaper_layout()
+    test_build_required()
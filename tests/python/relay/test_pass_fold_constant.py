@@ -161,6 +161,76 @@ def test_fold_full():
     assert relay.analysis.graph_equal(zz, zexpected)
 
 
+def test_fold_native_ops():
+    c_data = np.arange(24).reshape(2, 3, 4).astype("float32")
+    t = relay.TensorType([4, 6], "int32")
+    def before():
+        c = relay.const(c_data)
+        x = relay.var("x", t)
+        y = relay.transpose(c, axes=(0, 2, 1))
+        y = relay.reshape(y, (4, 6))
+        y = relay.maximum(y, relay.const(3, "float32"))
+        y = relay.subtract(y, relay.const(np.arange(6).astype("float32")))
+        y = relay.divide(y, relay.const(2, "float32"))
+        y = relay.cast(y, "int32")
+        z = relay.add(x, y)
+        return relay.Function([x], z)
+
+    def expected():
+        x = relay.var("x", t)
+        y = np.transpose(c_data, (0, 2, 1)).reshape(4, 6)
+        y = (np.maximum(y, 3) - np.arange(6)) / 2
+        z = relay.add(x, relay.const(y.astype("int32")))
+        return relay.Function([x], z)
+
+    zz = run_opt_pass(before(), transform.FoldConstant())
+    zexpected = run_opt_pass(expected(), transform.InferType())
+    assert relay.analysis.alpha_equal(zz, zexpected)
+
+    # integer overflow wraps around like the compiled kernels.
+    for dtype in ["int32", "int64"]:
+        info = np.iinfo(dtype)
+        a = np.array([info.max, info.min, info.max]).astype(dtype)
+        b = np.array([1, 1, 2]).astype(dtype)
+        for op, ref in [(relay.add, [info.min, info.min + 1, info.min + 1]),
+                        (relay.subtract, [info.max - 1, info.max, info.max - 2]),
+                        (relay.multiply, [info.max, info.min, -2])]:
+            zz = run_opt_pass(op(relay.const(a), relay.const(b)), transform.FoldConstant())
+            assert isinstance(zz, relay.Constant)
+            np.testing.assert_equal(zz.data.asnumpy(), np.array(ref).astype(dtype))
+
+
+def test_fold_batched():
+    c_data = np.array([1, 2, 3]).astype("float32")
+    t = relay.TensorType([3], "float32")
+    def before():
+        c = relay.const(c_data)
+        x = relay.var("x", t)
+        # exp and sqrt are compiled, the shared exp is evaluated once.
+        e = relay.exp(c)
+        a = relay.reshape(relay.add(e, e), (3,))
+        b = relay.sqrt(relay.multiply(e, c))
+        z = relay.add(relay.multiply(x, a), b)
+        return relay.Function([x], z)
+
+    zz = run_opt_pass(before(), transform.FoldConstant())
+    x = np.array([4, 5, 6]).astype("float32")
+    e = np.exp(c_data)
+    ref = x * (e + e) + np.sqrt(e * c_data)
+    # no operator is left on constants.
+    consts = []
+    def check(node):
+        if isinstance(node, relay.Call):
+            assert any(not isinstance(arg, relay.Constant) for arg in node.args)
+        if isinstance(node, relay.Constant):
+            consts.append(node)
+    relay.analysis.post_order_visit(zz, check)
+    assert len(consts) == 2
+    intrp = relay.create_executor("debug", ctx=tvm.cpu(0), target="llvm")
+    res = intrp.evaluate(zz)(x)
+    tvm.testing.assert_allclose(res.asnumpy(), ref, rtol=1e-5)
+
+
 if __name__ == "__main__":
     test_fold_const()
     test_fold_let()
@@ -168,3 +238,5 @@ if __name__ == "__main__":
     test_fold_concat()
     test_fold_shape_of()
     test_fold_full()
+    test_fold_native_ops()
+    test_fold_batched()
@@ -586,6 +586,66 @@ def test_fuse_max():
     after = run_opt_pass(expected(), transform.InferType())
     assert relay.analysis.alpha_equal(zz, after)
 
+def test_fuse_conv2d_chain():
+    """Test chain fusion of depthwise and pointwise conv2d on CPU."""
+    def before(dshape):
+        x = relay.var("x", shape=dshape)
+        w1 = relay.var("w1")
+        w2 = relay.var("w2")
+        y = relay.nn.conv2d(x, w1, kernel_size=(3, 3), padding=(1, 1),
+                            channels=dshape[1], groups=dshape[1])
+        y = relay.nn.relu(y)
+        y = relay.nn.conv2d(y, w2, kernel_size=(1, 1), channels=32)
+        y = relay.nn.relu(y)
+        return relay.Function(relay.analysis.free_vars(y), y)
+
+    def expected(dshape):
+        x = relay.var("p0", shape=dshape)
+        w1 = relay.var("p1")
+        w2 = relay.var("p2")
+        y = relay.nn.conv2d(x, w1, kernel_size=(3, 3), padding=(1, 1),
+                            channels=dshape[1], groups=dshape[1])
+        y = relay.nn.relu(y)
+        y = relay.nn.conv2d(y, w2, kernel_size=(1, 1), channels=32)
+        y = relay.nn.relu(y)
+        f = relay.Function([x, w1, w2], y)
+        x = relay.var("x", shape=dshape)
+        y = relay.Call(f, [x, relay.var("w1"), relay.var("w2")])
+        return relay.Function(relay.analysis.free_vars(y), y)
+
+    dshape = (1, 16, 56, 56)
+    z = before(dshape)
+    # without a CPU target the two convolutions stay apart
+    zz = run_opt_pass(z, transform.FuseOps(fuse_opt_level=4))
+    assert not relay.analysis.alpha_equal(
+        zz, run_opt_pass(expected(dshape), transform.InferType()))
+    with tvm.target.create("llvm"):
+        zz = run_opt_pass(z, transform.FuseOps(fuse_opt_level=2))
+        assert not relay.analysis.alpha_equal(
+            zz, run_opt_pass(expected(dshape), transform.InferType()))
+        zz = run_opt_pass(z, transform.FuseOps(fuse_opt_level=4))
+    after = run_opt_pass(expected(dshape), transform.InferType())
+    assert relay.analysis.alpha_equal(zz, after)
+
+    # a 1x1 -> 3x3 -> 1x1 bottleneck only chains one producer per group
+    x = relay.var("x", shape=dshape)
+    y = x
+    for i, (ksize, pad) in enumerate([(1, 0), (3, 1), (1, 0)]):
+        y = relay.nn.conv2d(y, relay.var("w%d" % i), kernel_size=(ksize, ksize),
+                            padding=(pad, pad), channels=16)
+        y = relay.nn.relu(y)
+    z = relay.Function(relay.analysis.free_vars(y), y)
+    with tvm.target.create("llvm"):
+        zz = run_opt_pass(z, transform.FuseOps(fuse_opt_level=4))
+    funcs = []
+    def count_funcs(node):
+        if isinstance(node, relay.Function):
+            funcs.append(node)
+    relay.analysis.post_order_visit(zz, count_funcs)
+    # the main function and two fused groups
+    assert len(funcs) == 3
+
+
 if __name__ == "__main__":
     test_fuse_simple()
     test_conv2d_fuse()
@@ -602,3 +662,4 @@ if __name__ == "__main__":
     test_immutable()
     test_split()
     test_fuse_max()
+    test_fuse_conv2d_chain()
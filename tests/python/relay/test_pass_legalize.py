@@ -171,9 +171,155 @@ def test_legalize_multi_input():
 
     assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
 
+def test_legalize_dense_int8():
+    """Test the x86 legalization of int8 dense for the uint8 x int8 instructions"""
+    if not tvm.module.enabled("llvm") or tvm.codegen.llvm_version_major() < 8:
+        print("Skip because llvm >= 8 is not enabled")
+        return
+    target = "llvm -mcpu=skylake-avx512"
+
+    def before(batch, units, data_dtype, kernel_dtype):
+        x = relay.var("x", shape=(batch, 8), dtype=data_dtype)
+        w = relay.var("w", shape=(units, 8), dtype=kernel_dtype)
+        y = relay.nn.dense(x, w, units=units, out_dtype="int32")
+        return relay.Function([x, w], y)
+
+    def legalize(func):
+        with tvm.target.create(target):
+            return run_opt_pass(func, transform.Legalize())
+
+    def expected():
+        x = relay.var("x", shape=(2, 8), dtype="int8")
+        w = relay.var("w", shape=(10, 8), dtype="int8")
+        shift = relay.sum(relay.cast(w, "int32"), axis=1)
+        shift = relay.multiply(shift, relay.const(128, "int32"))
+        data = relay.cast(relay.add(relay.cast(x, "int32"), relay.const(128, "int32")), "uint8")
+        kernel = relay.nn.pad(w, pad_width=((0, 6), (0, 0)))
+        y = relay.nn.dense(data, kernel, units=16, out_dtype="int32")
+        y = relay.strided_slice(y, begin=(0, 0), end=[2, 10])
+        y = relay.subtract(y, shift)
+        return relay.Function([x, w], y)
+
+    a = legalize(before(2, 10, "int8", "int8"))
+    b = run_opt_pass(expected(), transform.InferType())
+    assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
+
+    # Already legal: uint8 x int8 with units divisible by 16.
+    a = legalize(before(2, 32, "uint8", "int8"))
+    b = run_opt_pass(before(2, 32, "uint8", "int8"), transform.InferType())
+    assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
+
+    # The legalized graph computes the same result, run on the host target.
+    ranges = {"int8": (-128, 128), "uint8": (0, 256)}
+    for units in [10, 16, 33]:
+        for data_dtype, kernel_dtype in [("int8", "int8"), ("uint8", "int8"),
+                                         ("uint8", "uint8")]:
+            x_np = np.random.randint(*ranges[data_dtype], size=(3, 8)).astype(data_dtype)
+            w_np = np.random.randint(*ranges[kernel_dtype], size=(units, 8)).astype(kernel_dtype)
+            ref = np.dot(x_np.astype("int32"), w_np.astype("int32").T)
+            func = legalize(before(3, units, data_dtype, kernel_dtype))
+            intrp = relay.create_executor("graph", ctx=tvm.cpu(0), target="llvm")
+            res = intrp.evaluate(func)(x_np, w_np)
+            np.testing.assert_equal(res.asnumpy(), ref)
+
+
+def test_legalize_group_conv2d_int8():
+    """Test the x86 legalization of int8 grouped conv2d into a conv2d per group"""
+    if not tvm.module.enabled("llvm") or tvm.codegen.llvm_version_major() < 8:
+        print("Skip because llvm >= 8 is not enabled")
+        return
+    target = "llvm -mcpu=skylake-avx512"
+
+    def before(in_channels, channels, groups, data_dtype):
+        x = relay.var("x", shape=(1, in_channels, 6, 6), dtype=data_dtype)
+        w = relay.var("w", shape=(channels, in_channels // groups, 3, 3), dtype="int8")
+        y = relay.nn.conv2d(x, w, padding=(1, 1), channels=channels, kernel_size=(3, 3),
+                            groups=groups, out_dtype="int32")
+        return relay.Function([x, w], y)
+
+    def legalize(func):
+        with tvm.target.create(target):
+            return run_opt_pass(func, transform.Legalize())
+
+    # Every group is a conv2d of its own, depthwise convs are left alone.
+    func = legalize(before(64, 64, 2, "uint8"))
+    convs = []
+    analysis.post_order_visit(func, lambda e: convs.append(e) if isinstance(
+        e, relay.Call) and e.op.name == "nn.conv2d" else None)
+    assert len(convs) == 2
+    assert all(conv.attrs.groups == 1 and conv.attrs.channels == 32 for conv in convs)
+    a = legalize(before(16, 16, 16, "uint8"))
+    b = run_opt_pass(before(16, 16, 16, "uint8"), transform.InferType())
+    assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
+
+    # The legalized graph computes the same result, run on the host target.
+    ranges = {"int8": (-128, 128), "uint8": (0, 256)}
+    for in_channels, channels, groups in [(8, 8, 2), (12, 24, 3), (64, 32, 4)]:
+        for data_dtype in ["int8", "uint8"]:
+            x_np = np.random.randint(*ranges[data_dtype],
+                                     size=(1, in_channels, 6, 6)).astype(data_dtype)
+            w_np = np.random.randint(-128, 128, size=(channels, in_channels // groups, 3, 3))
+            w_np = w_np.astype("int8")
+            intrp = relay.create_executor("graph", ctx=tvm.cpu(0), target="llvm")
+            ref = intrp.evaluate(before(in_channels, channels, groups, data_dtype))(x_np, w_np)
+            func = legalize(before(in_channels, channels, groups, data_dtype))
+            res = intrp.evaluate(func)(x_np, w_np)
+            np.testing.assert_equal(res.asnumpy(), ref.asnumpy())
+
+
+def test_legalize_batch_matmul_int8():
+    """Test the x86 legalization of int8 batch_matmul into a dense per batch"""
+    if not tvm.module.enabled("llvm") or tvm.codegen.llvm_version_major() < 8:
+        print("Skip because llvm >= 8 is not enabled")
+        return
+    target = "llvm -mcpu=skylake-avx512"
+
+    def before(batch, n, x_dtype, y_dtype, out_dtype="int32"):
+        x = relay.var("x", shape=(batch, 3, 8), dtype=x_dtype)
+        y = relay.var("y", shape=(batch, n, 8), dtype=y_dtype)
+        z = relay.nn.batch_matmul(x, y, out_dtype=out_dtype)
+        return relay.Function([x, y], z)
+
+    def legalize(func):
+        with tvm.target.create(target):
+            return run_opt_pass(func, transform.Legalize())
+
+    def expected():
+        x = relay.var("x", shape=(2, 3, 8), dtype="uint8")
+        y = relay.var("y", shape=(2, 16, 8), dtype="int8")
+        xs = relay.split(x, 2, axis=0)
+        ys = relay.split(y, 2, axis=0)
+        outs = [relay.nn.dense(relay.reshape(xs[b], (3, 8)), relay.reshape(ys[b], (16, 8)),
+                               out_dtype="int32") for b in range(2)]
+        return relay.Function([x, y], relay.stack(outs, axis=0))
+
+    a = legalize(before(2, 16, "uint8", "int8"))
+    b = run_opt_pass(expected(), transform.InferType())
+    assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
+
+    # Only int8 batch_matmul with int32 output is rewritten.
+    a = legalize(before(2, 16, "float32", "float32", ""))
+    b = run_opt_pass(before(2, 16, "float32", "float32", ""), transform.InferType())
+    assert analysis.alpha_equal(a, b), "Actual = \n" + str(a)
+
+    # The legalized graph computes the same result, run on the host target.
+    ranges = {"int8": (-128, 128), "uint8": (0, 256)}
+    for batch, n in [(1, 16), (3, 10)]:
+        for x_dtype, y_dtype in [("int8", "int8"), ("uint8", "int8"), ("uint8", "uint8")]:
+            x_np = np.random.randint(*ranges[x_dtype], size=(batch, 3, 8)).astype(x_dtype)
+            y_np = np.random.randint(*ranges[y_dtype], size=(batch, n, 8)).astype(y_dtype)
+            ref = np.matmul(x_np.astype("int32"), y_np.astype("int32").transpose(0, 2, 1))
+            func = legalize(before(batch, n, x_dtype, y_dtype))
+            intrp = relay.create_executor("graph", ctx=tvm.cpu(0), target="llvm")
+            res = intrp.evaluate(func)(x_np, y_np)
+            np.testing.assert_equal(res.asnumpy(), ref)
+
 
 if __name__ == "__main__":
     test_legalize()
     test_legalize_none()
     test_legalize_multiple_ops()
     test_legalize_multi_input()
+    test_legalize_dense_int8()
+    test_legalize_group_conv2d_int8()
+    test_legalize_batch_matmul_int8()
@@ -505,6 +505,92 @@ def test_sequential_with_scoping():
     assert analysis.alpha_equal(zz, zexpected)
 
 
+def test_parallel_function_pass():
+    shape = (1, 2, 3)
+    c_data = np.array(shape).astype("float32")
+    tp = relay.TensorType(shape, "float32")
+    def make_func(i):
+        c = relay.const(c_data * i)
+        x = relay.var("x", tp)
+        y = relay.add(c, c)
+        y = relay.add(x, y)
+        z = relay.add(y, c)
+        z1 = relay.add(y, c)
+        return relay.Function([x], relay.add(z, z1))
+
+    def make_mod():
+        mod = relay.Module()
+        for i in range(16):
+            mod[relay.GlobalVar("f%d" % i)] = make_func(i)
+        return mod
+
+    seq = _transform.Sequential([
+        relay.transform.InferType(),
+        relay.transform.FoldConstant(),
+        relay.transform.EliminateCommonSubexpr(),
+    ])
+    with relay.build_config(opt_level=3):
+        serial = seq(make_mod())
+    with relay.build_config(opt_level=3, num_threads=4):
+        parallel = seq(make_mod())
+    for i in range(16):
+        name = "f%d" % i
+        assert analysis.alpha_equal(serial[serial.get_global_var(name)],
+                                    parallel[parallel.get_global_var(name)])
+
+    # type inference of an already checked module leaves the functions as is.
+    with relay.build_config(num_threads=4):
+        mod = _transform.InferType()(serial)
+    for i in range(16):
+        gv = serial.get_global_var("f%d" % i)
+        assert mod[gv].same_as(serial[gv])
+
+    # the workers see the build config of the caller.
+    buckets = []
+    @_transform.function_pass(opt_level=1)
+    def record_config(func, mod, ctx):
+        config = tvm.build_module.current_build_config()
+        buckets.append([x.value for x in config.dynamic_shape_buckets])
+        return func
+    with tvm.build_config(dynamic_shape_buckets=[4, 8]):
+        with relay.build_config(num_threads=4):
+            record_config(make_mod())
+    assert len(buckets) == 16
+    assert all(x == [4, 8] for x in buckets)
+
+
+def test_function_pass_retype_callers():
+    tp = relay.TensorType((2, 2), "float32")
+    x = relay.var("x", tp)
+    callee = relay.GlobalVar("callee")
+    mod = relay.Module()
+    mod[callee] = relay.Function([x], relay.add(x, x))
+    y = relay.var("y", tp)
+    mod["main"] = relay.Function([y], callee(y))
+    old_main = mod["main"]
+    assert old_main.checked_type.ret_type.dtype == "float32"
+
+    @_transform.function_pass(opt_level=0)
+    def to_float64(func, _mod, _ctx):
+        # change the signature of the callee only, main is returned as is.
+        if func.params[0].name_hint != "x":
+            return func
+        z = relay.var("x", tp)
+        return relay.Function([z], relay.cast(relay.add(z, z), "float64"))
+
+    for num_threads in [1, 2]:
+        with relay.build_config(num_threads=num_threads):
+            new_mod = _transform.Sequential([to_float64, _transform.InferType()])(mod)
+        main = new_mod["main"]
+        assert main.checked_type.ret_type.dtype == "float64"
+        assert main.body.checked_type.dtype == "float64"
+
+    # a module whose callers are consistent keeps its functions.
+    with relay.build_config(num_threads=1):
+        same = _transform.InferType()(mod)
+    assert same["main"].same_as(old_main)
+
+
 def test_print_ir(capfd):
     shape = (1, 2, 3)
     tp = relay.TensorType(shape, "float32")
@@ -0,0 +1,78 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay import transform
+from tvm.relay.testing import run_infer_type
+from tvm.contrib import graph_runtime
+
+
+def count_calls(func, op_name):
+    calls = []
+    def fvisit(e):
+        if isinstance(e, relay.Call) and e.op == relay.op.get(op_name):
+            calls.append(e)
+    relay.analysis.post_order_visit(func, fvisit)
+    return len(calls)
+
+
+def skip_connection():
+    """The relu output stays alive across two convolutions for the add"""
+    x = relay.var("x", shape=(1, 4, 16, 16))
+    w1 = relay.var("w1", shape=(16, 4, 3, 3))
+    w2 = relay.var("w2", shape=(4, 16, 3, 3))
+    a = relay.nn.relu(x)
+    y = relay.nn.conv2d(a, w1, channels=16, kernel_size=(3, 3), padding=(1, 1))
+    y = relay.nn.conv2d(y, w2, channels=4, kernel_size=(3, 3), padding=(1, 1))
+    return relay.Function([x, w1, w2], relay.add(y, a))
+
+
+def test_rematerialize():
+    before = run_infer_type(skip_connection())
+    # 4096 bytes for the relu, 16384 for the first convolution, 4096 for the second
+    flops, peak_before, peak_after = relay.analysis.rematerialization_tradeoff(before, 22000)
+    assert peak_before == 24576
+    assert peak_after == 20480
+    assert flops == 1024
+
+    mod = transform.Rematerialize(22000)(relay.Module.from_expr(before))
+    assert count_calls(mod["main"], "nn.relu") == 2
+    # nothing to do within the budget
+    mod = transform.Rematerialize(24576)(relay.Module.from_expr(before))
+    assert count_calls(mod["main"], "nn.relu") == 1
+
+
+def test_rematerialize_build():
+    func = skip_connection()
+    inputs = {"x": np.random.uniform(-1, 1, size=(1, 4, 16, 16)).astype("float32"),
+              "w1": np.random.uniform(size=(16, 4, 3, 3)).astype("float32"),
+              "w2": np.random.uniform(size=(4, 16, 3, 3)).astype("float32")}
+    outputs = []
+    for memory_budget in [0, 22000]:
+        with relay.build_config(opt_level=3, memory_budget=memory_budget):
+            graph, lib, params = relay.build(relay.Module.from_expr(func), "llvm")
+        m = graph_runtime.create(graph, lib, tvm.cpu(0))
+        m.run(**inputs)
+        outputs.append(m.get_output(0).asnumpy())
+    tvm.testing.assert_allclose(outputs[1], outputs[0], rtol=1e-5)
+
+
+if __name__ == "__main__":
+    test_rematerialize()
+    test_rematerialize_build()
@@ -0,0 +1,182 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Test the template-free auto scheduler"""
+import numpy as np
+
+import tvm
+import topi
+from tvm import autotvm, relay
+from tvm.autotvm.task import auto_schedule, create_auto_task
+from tvm.contrib import graph_runtime
+
+
+def dense_bias_relu(N, L, M, dtype):
+    A = tvm.placeholder((N, L), name='A', dtype=dtype)
+    B = tvm.placeholder((M, L), name='B', dtype=dtype)
+    bias = tvm.placeholder((M,), name='bias', dtype=dtype)
+    k = tvm.reduce_axis((0, L), name='k')
+    C = tvm.compute((N, M), lambda i, j: tvm.sum(A[i, k] * B[j, k], axis=k), name='C')
+    D = tvm.compute((N, M), lambda i, j: C[i, j] + bias[j], name='D')
+    E = tvm.compute((N, M), lambda i, j: tvm.max(D[i, j], tvm.const(0, dtype)), name='E')
+    return [A, B, bias, E]
+
+
+def check_config(task, config):
+    with tvm.target.create("llvm"):
+        s, arg_bufs = task.instantiate(config)
+        func = tvm.build(s, arg_bufs, "llvm")
+    ctx = tvm.cpu(0)
+    a_np = np.random.uniform(size=(32, 64)).astype("float32")
+    b_np = np.random.uniform(size=(48, 64)).astype("float32")
+    bias_np = np.random.uniform(-1, 1, size=(48,)).astype("float32")
+    e_np = np.maximum(np.dot(a_np, b_np.T) + bias_np, 0)
+    e = tvm.nd.empty(e_np.shape, ctx=ctx)
+    func(tvm.nd.array(a_np, ctx), tvm.nd.array(b_np, ctx), tvm.nd.array(bias_np, ctx), e)
+    tvm.testing.assert_allclose(e.asnumpy(), e_np, rtol=1e-5)
+
+
+def test_config_space():
+    task = create_auto_task(dense_bias_relu, (32, 64, 48, "float32"), "llvm")
+    space = task.config_space
+    assert task.workload[0] == "auto_schedule"
+    # the bias add is inlined and the reduction is computed in the tiles of the relu,
+    # so only the reduction defines knobs
+    assert set(space.space_map.keys()) == \
+        {"tile_0_s0", "tile_0_s1", "tile_0_r0", "auto_unroll_0"}
+    assert len(space) > 100
+    assert task.flop >= 2 * 32 * 64 * 48
+
+    # the same DAG gets the same workload
+    other = create_auto_task(dense_bias_relu, (32, 64, 48, "float32"), "llvm")
+    assert other.workload == task.workload
+
+
+def test_random_configs():
+    task = create_auto_task(dense_bias_relu, (32, 64, 48, "float32"), "llvm")
+    for index in np.random.choice(len(task.config_space), 5, replace=False):
+        check_config(task, task.config_space.get(int(index)))
+
+    # the fallback config without any tuning
+    with tvm.target.create("llvm"):
+        s, arg_bufs = task.func(*task.args)
+        assert s is not None
+
+
+def test_full_reduction():
+    def sum_scale(N, M, dtype):
+        A = tvm.placeholder((N, M), name='A', dtype=dtype)
+        B = topi.sum(A)
+        C = tvm.compute((), lambda: B() * tvm.const(2, dtype), name='C')
+        return [A, B, C]
+
+    # a reduction to a 0-d tensor only tiles its reduce axes
+    task = create_auto_task(sum_scale, (16, 24, "float32"), "llvm")
+    assert set(task.config_space.space_map.keys()) == \
+        {"tile_0_r0", "tile_0_r1", "auto_unroll_0"}
+    ctx = tvm.cpu(0)
+    a_np = np.random.uniform(size=(16, 24)).astype("float32")
+    for config in [task.config_space.get(0), None]:
+        with tvm.target.create("llvm"):
+            if config is None:
+                s, arg_bufs = task.func(*task.args)
+            else:
+                s, arg_bufs = task.instantiate(config)
+            func = tvm.build(s, arg_bufs, "llvm")
+        b = tvm.nd.empty((), ctx=ctx)
+        c = tvm.nd.empty((), ctx=ctx)
+        func(tvm.nd.array(a_np, ctx), b, c)
+        tvm.testing.assert_allclose(c.asnumpy(), 2 * a_np.sum(), rtol=1e-5)
+
+
+def test_tune_and_apply():
+    task = create_auto_task(dense_bias_relu, (32, 64, 48, "float32"), "llvm")
+    measure_option = autotvm.measure_option(
+        builder=autotvm.LocalBuilder(),
+        runner=autotvm.LocalRunner(number=2, check_correctness=True))
+    records = []
+
+    def _callback(tuner, inputs, results):
+        for inp, res in zip(inputs, results):
+            assert res.error_no == 0
+            records.append((inp, res))
+
+    tuner = autotvm.tuner.XGBTuner(task, feature_type='itervar')
+    tuner.tune(n_trial=8, measure_option=measure_option, callbacks=[_callback])
+    assert len(records) == 8
+
+    # the tuned config is found by the workload of the compute DAG
+    with autotvm.apply_history_best(records):
+        with tvm.target.create("llvm"):
+            A, B, bias, E = dense_bias_relu(32, 64, 48, "float32")
+            s = auto_schedule(E)
+            func = tvm.build(s, [A, B, bias, E], "llvm")
+    assert func
+
+
+def test_tune_relay_fused_op():
+    x = relay.var("x", shape=(16, 64))
+    b = relay.var("b", shape=(64,))
+    y = relay.sum(relay.nn.relu(x + b), axis=1)
+    mod = relay.Module.from_expr(relay.Function([x, b], y))
+    target = tvm.target.create("llvm")
+
+    # the add and the relu are fused into the sum, whose schedule opts in
+    tasks = autotvm.task.extract_auto_tasks(mod["main"], None, target)
+    assert len(tasks) == 1
+    task = tasks[0]
+    assert task.workload[0] == "auto_schedule"
+
+    measure_option = autotvm.measure_option(
+        builder=autotvm.LocalBuilder(),
+        runner=autotvm.LocalRunner(number=2, check_correctness=True))
+    records = []
+
+    def _callback(tuner, inputs, results):
+        for inp, res in zip(inputs, results):
+            assert res.error_no == 0
+            records.append((inp, res))
+
+    tuner = autotvm.tuner.RandomTuner(task)
+    tuner.tune(n_trial=4, measure_option=measure_option, callbacks=[_callback])
+    assert len(records) == 4
+
+    with autotvm.apply_history_best(records):
+        # the x86 reduction schedule of the fused op is the tuned one
+        with target:
+            s, arg_bufs = task.func(*task.args)
+            outs = [t for t in arg_bufs if not isinstance(t.op, tvm.tensor.PlaceholderOp)]
+            tuned = tvm.lower(s, arg_bufs, simple_mode=True)
+            hooked = tvm.lower(topi.generic.schedule_reduce(outs), arg_bufs, simple_mode=True)
+        assert str(tuned) == str(hooked)
+        graph, lib, params = relay.build(mod, target)
+
+    x_np = np.random.uniform(-1, 1, size=(16, 64)).astype("float32")
+    b_np = np.random.uniform(-1, 1, size=(64,)).astype("float32")
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    m.set_input(x=x_np, b=b_np)
+    m.set_input(**params)
+    m.run()
+    tvm.testing.assert_allclose(m.get_output(0).asnumpy(),
+                                np.maximum(x_np + b_np, 0).sum(axis=1), rtol=1e-5)
+
+
+if __name__ == "__main__":
+    test_config_space()
+    test_random_configs()
+    test_full_reduction()
+    test_tune_and_apply()
+    test_tune_relay_fused_op()
@@ -16,12 +16,21 @@
 # under the License.
 """Test database"""
 import copy
+import json
 import logging
-
+import os
+import struct
+import time
+
+import tvm
+import topi
+from tvm import autotvm
+from tvm.contrib import util
 from tvm.autotvm import database
-from tvm.autotvm.record import encode, MeasureResult
+from tvm.autotvm.measure import MeasureInput
+from tvm.autotvm.record import encode, MeasureResult, AUTOTVM_LOG_VERSION
 
-from test_autotvm_common import get_sample_records
+from test_autotvm_common import get_sample_records, get_sample_task, matmul
 
 def test_save_load():
     logging.info("test basic db load/save ...")
@@ -110,9 +119,115 @@ def test_db_filter():
     records = _db.filter(lambda inp, ress: any(r.costs[0] <= 2 for r in ress))
     assert len(records) == 2
 
+def test_indexed_db():
+    logging.info("test indexed db ...")
+    records = get_sample_records(5)
+    inp, _ = records[0]
+    tmp = util.tempdir()
+    path = tmp.relpath("tune.db")
+
+    with database.IndexedDatabase(path) as _db:
+        _db.import_log(reversed(records))
+        best_inp, best_res = _db.query_best(inp.target, inp.task.workload)
+        assert str(best_inp.config) == str(records[0][0].config)
+        assert best_res.costs == (1,)
+        assert _db.load(records[3][0]).costs == (4,)
+
+    # the records are rows of the json log format
+    with open(path, "rb") as fin:
+        fin.seek(len(database.IndexedDatabase.MAGIC))
+        length = struct.unpack("<I", fin.read(4))[0]
+        assert json.loads(fin.read(length).decode("utf-8"))["v"] == AUTOTVM_LOG_VERSION
+
+    # reopen with the index, then rebuild it from the records
+    for remove_index in [False, True]:
+        if remove_index:
+            os.remove(path + ".idx")
+        with database.IndexedDatabase(path) as _db:
+            _, best_res = _db.query_best(inp.target, inp.task.workload)
+            assert best_res.costs == (1,)
+            assert _db.query_best(inp.target, ("matmul", 1, 1, 1, "float32")) is None
+            # the records of the configs are only scanned by load
+            assert _db._records is None
+            assert _db.load(records[3][0]).costs == (4,)
+
+def test_indexed_db_nearest():
+    logging.info("test indexed db nearest workload ...")
+    records = get_sample_records(5)
+    inp, _ = records[0]
+    target = inp.target
+    tmp = util.tempdir()
+    path = tmp.relpath("tune.db")
+
+    with database.IndexedDatabase(path) as _db:
+        for i, (inp, res) in enumerate(records):
+            # the best config of n=128 has a non-trivial tiling
+            cost = 0.5 if i == 4 else res.costs[0]
+            _db.save(inp, MeasureResult((cost,), 0, res.all_cost, res.timestamp))
+
+        task, _ = get_sample_task(n=64)
+        recs = _db.nearest(target, task.workload)
+        assert len(recs) == 1
+        assert recs[0][0].task.workload == records[0][0].task.workload
+        assert _db.nearest(target, ("conv2d", 64)) == []
+        # negative integer fields are compared too
+        negative = tuple(-x if isinstance(x, int) else x for x in task.workload)
+        assert len(_db.nearest(target, negative)) == 1
+
+        ref = records[4][0].config
+        with database.ApplyDatabaseBest(_db):
+            with target:
+                cfg = autotvm.DispatchContext.current.query(target, task.workload)
+                assert isinstance(cfg, autotvm.task.space.ReferenceConfigEntity)
+                matmul(64, 64, 64, "float32")
+        for name in ["tile_y", "tile_x"]:
+            assert cfg[name].size[1:] == ref[name].size[1:]
+
+
+def test_indexed_db_nearest_topi():
+    logging.info("test indexed db nearest workload of a topi dispatcher ...")
+    autotvm.task.TaskExtractEnv.get()
+    target = tvm.target.create("llvm")
+
+    def conv2d_args(size):
+        return (('TENSOR', (1, 16, size, size), 'float32'),
+                ('TENSOR', (32, 16, 3, 3), 'float32'),
+                (1, 1), (1, 1), (1, 1), 'NCHW', 'float32')
+
+    task = autotvm.task.create("topi_nn_conv2d", conv2d_args(28), target,
+                               template_key="direct")
+    other = autotvm.task.create("topi_nn_conv2d", conv2d_args(24), target,
+                                template_key="direct")
+    tmp = util.tempdir()
+    # x86 conv2d only registers the direct template, a reference tuned with
+    # another one falls back to the default config of the direct template
+    for key, is_reference in [("direct", True), ("winograd", False)]:
+        config = copy.deepcopy(task.config_space.get(len(task.config_space) - 1))
+        config.template_key = key
+        with database.IndexedDatabase(tmp.relpath("%s.db" % key)) as _db:
+            _db.save(MeasureInput(target, task, config),
+                     MeasureResult((1.0,), 0, 1.0, time.time()))
+            with database.ApplyDatabaseBest(_db):
+                with target:
+                    data = tvm.placeholder((1, 16, 24, 24), name='data')
+                    kernel = tvm.placeholder((32, 16, 3, 3), name='kernel')
+                    out = topi.nn.conv2d(data, kernel, (1, 1), (1, 1), (1, 1), 'NCHW', 'float32')
+                    s = topi.generic.schedule_conv2d_nchw([out])
+                    tvm.build(s, [data, kernel, out], target)
+                    cfg = autotvm.DispatchContext.current.query(target, other.workload)
+        assert isinstance(cfg, autotvm.task.space.ReferenceConfigEntity) == is_reference
+        if is_reference:
+            assert cfg.template_key == "direct"
+            assert cfg.code_hash == config.code_hash
+        else:
+            assert cfg.is_fallback
+
 if __name__ == '__main__':
     logging.basicConfig(level=logging.INFO)
     test_save_load()
     test_db_hash()
     test_db_latest_all()
     test_db_filter()
+    test_indexed_db()
+    test_indexed_db_nearest()
+    test_indexed_db_nearest_topi()
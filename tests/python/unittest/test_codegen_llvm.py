@@ -20,6 +20,7 @@ from tvm.contrib import util, clang
 import numpy as np
 import ctypes
 import math
+import re
 
 def test_llvm_intrin():
     ib = tvm.ir_builder.create()
@@ -644,6 +645,66 @@ def test_llvm_shuffle():
         module(a_, b_, c_)
         tvm.testing.assert_allclose(c_.asnumpy(), (a_.asnumpy() * 2).astype('int32'))
 
+def test_llvm_multiversion():
+    if not tvm.module.enabled("llvm"):
+        return
+    target = "llvm -mcpu=x86-64 -mattr-variants=+avx2,+fma;+avx512f,+avx512bw"
+    if not tvm.codegen.llvm_target_enabled(target):
+        return
+    n = 1024
+    A = tvm.placeholder((n,), name='A')
+    B = tvm.compute(A.shape, lambda i: A[i] * 2 + 1, name='B')
+    s = tvm.create_schedule(B.op)
+    xo, xi = s[B].split(B.op.axis[0], factor=16)
+    s[B].vectorize(xi)
+    f = tvm.build(s, [A, B], target, name="vscale")
+    asm = f.get_source("asm")
+    assert "vscale__tvm_variant0" in asm
+    assert "vscale__tvm_variant1" in asm
+    assert "zmm" in asm
+
+    def check(m):
+        ctx = tvm.cpu(0)
+        a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), ctx)
+        b = tvm.nd.array(np.zeros(n, dtype=B.dtype), ctx)
+        m(a, b)
+        tvm.testing.assert_allclose(b.asnumpy(), a.asnumpy() * 2 + 1, rtol=1e-5)
+
+    check(f)
+    temp = util.tempdir()
+    path = temp.relpath("vscale.so")
+    f.export_library(path)
+    check(tvm.module.load(path))
+
+    # the parallel lambdas hold the loops, they are compiled for the variant as well
+    s = tvm.create_schedule(B.op)
+    xo, xi = s[B].split(B.op.axis[0], factor=16)
+    s[B].parallel(xo)
+    s[B].vectorize(xi)
+    f = tvm.build(s, [A, B], target, name="pscale")
+    ll = f.get_source("ll")
+    groups = dict(re.findall(r"^attributes #(\d+) = \{(.*)\}$", ll, re.M))
+    lambdas = re.findall(r"^define .*@__tvm_parallel_lambda[.\d]*\(.*\) .*#(\d+)", ll, re.M)
+    features = [groups[x] for x in lambdas]
+    assert sum("+avx2" in x and "+avx512f" not in x for x in features) == 1
+    assert sum("+avx512f" in x for x in features) == 1
+    check(f)
+
+    # the exported library probes every feature the variants can be built with
+    s = tvm.create_schedule(B.op)
+    f = tvm.build(s, [A, B], "llvm -mcpu=x86-64 -mattr-variants=+avx512f,+avx512vnni",
+                  name="vnni")
+    path = temp.relpath("vnni.so")
+    f.export_library(path)
+    check(tvm.module.load(path))
+    # and refuses the features the runtime cannot detect
+    try:
+        tvm.build(s, [A, B], "llvm -mcpu=x86-64 -mattr-variants=+retpoline", name="unknown")
+        assert False
+    except tvm.TVMError:
+        pass
+
+
 if __name__ == "__main__":
     test_llvm_import()
     test_alignment()
@@ -664,3 +725,4 @@ if __name__ == "__main__":
     test_llvm_fp_math()
     test_dwarf_debug_information()
     test_llvm_shuffle()
+    test_llvm_multiversion()
@@ -109,8 +109,52 @@ def test_vm_parallel():
         np.testing.assert_equal(a.asnumpy(), np.ones(a.shape[0]))
     run_jit(fapi, check)
 
+def test_stack_vm_fused():
+    if not tvm.module.enabled("stackvm"):
+        return
+    set_fused = tvm.get_global_func("module._StackVMSetFusedDispatch")
+    dtype = 'int64'
+    n = tvm.var('n')
+    Ab = tvm.decl_buffer((n, ), dtype)
+    Bb = tvm.decl_buffer((n, ), dtype)
+    ib = tvm.ir_builder.create()
+    A = ib.buffer_ptr(Ab)
+    B = ib.buffer_ptr(Bb)
+    with ib.for_range(0, n - 1, "i") as i:
+        with ib.if_scope(tvm.make.LT(i, 4)):
+            A[i + 1] = A[i] + B[i] * 2
+        with ib.else_scope():
+            A[i + 1] = tvm.max(A[i] - B[i + 1], 3)
+    stmt = ib.get()
+    fapi = tvm.ir_pass.MakeAPI(stmt, "test", [Ab, Bb], 0, True)
+    fapi = tvm.ir_pass.LowerTVMBuiltin(fapi)
+    f = tvm.codegen.build_module(fapi, "stackvm")
+    b = tvm.nd.array(np.arange(10, dtype=dtype))
+    results = []
+    try:
+        for fused in [False, True]:
+            set_fused(fused)
+            a = tvm.nd.array(np.zeros(10, dtype=dtype))
+            f(a, b)
+            results.append(a.asnumpy())
+            # argument checks of MakeAPI raise the same errors
+            try:
+                f(a)
+                assert False
+            except tvm.TVMError as err:
+                assert "num_args" in str(err)
+            try:
+                f(a, tvm.nd.array(np.zeros(10, dtype='float32')))
+                assert False
+            except tvm.TVMError as err:
+                assert "dtype" in str(err)
+    finally:
+        set_fused(True)
+    np.testing.assert_equal(results[0], results[1])
+
 
 if __name__ == "__main__":
+    test_stack_vm_fused()
     test_vm_parallel()
     test_stack_vm_loop()
     test_stack_vm_basic()
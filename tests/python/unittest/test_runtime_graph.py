@@ -14,11 +14,13 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import ctypes
 import tvm
 import numpy as np
 import json
 from tvm import rpc
-from tvm.contrib import util, graph_runtime
+from tvm.contrib import util, graph_runtime, cc, graph_aot
+from tvm._ffi.libinfo import find_include_path
 
 def test_graph_simple():
     n = 4
@@ -122,5 +124,103 @@ def test_graph_simple():
     check_remote()
     check_sharing()
 
+def test_graph_aot():
+    if not tvm.module.enabled("llvm"):
+        print("Skip because llvm is not enabled")
+        return
+    n = 4
+    A = tvm.placeholder((n,), name='A')
+    W = tvm.placeholder((n,), name='W')
+    B = tvm.compute(A.shape, lambda *i: A(*i) + W(*i), name='B')
+    s = tvm.create_schedule(B.op)
+
+    nodes = [{"op": "null", "name": "x", "inputs": []},
+             {"op": "null", "name": "w", "inputs": []}]
+    for i in range(2):
+        nodes.append({"op": "tvm_op", "name": "add%d" % i,
+                      "inputs": [[i * 2, 0, 0], [1, 0, 0]],
+                      "attrs": {"func_name": "myadd",
+                                "flatten_data": "0",
+                                "num_inputs" : "2",
+                                "num_outputs" : "1"}})
+    shape = (n,)
+    graph = json.dumps({
+        "nodes": nodes,
+        "arg_nodes": [0, 1],
+        "node_row_ptr": [0, 1, 2, 3, 4],
+        "heads": [[3, 0, 0]],
+        "attrs": {"shape" : ["list_shape", [shape] * 4],
+                  "dltype" : ["list_str", ["float32"] * 4],
+                  "storage_id" : ["list_int", [0, 1, 2, 3]]}})
+    mlib = tvm.build(s, [A, W, B], "llvm", name="myadd")
+    w = tvm.nd.array(np.random.uniform(size=shape).astype(A.dtype))
+
+    temp = util.tempdir()
+    def build_aot(graph, mlib, params, name):
+        mlib.save(temp.relpath("%s.o" % name))
+        with open(temp.relpath("%s_aot.cc" % name), "w") as f:
+            f.write(graph_aot.codegen(graph, params))
+        path_dso = temp.relpath("%s_aot.so" % name)
+        cc.create_shared(path_dso, [temp.relpath("%s.o" % name),
+                                    temp.relpath("%s_aot.cc" % name)],
+                         options=["-std=c++11"] + ["-I" + p for p in find_include_path()])
+        dll = ctypes.CDLL(path_dso)
+        dll.tvm_aot_input.restype = ctypes.c_void_p
+        dll.tvm_aot_output.restype = ctypes.c_void_p
+        assert dll.tvm_aot_init() == 0
+        return dll
+
+    def tensor_data(handle):
+        # DLTensor starts with its data pointer.
+        return ctypes.cast(handle, ctypes.POINTER(ctypes.c_void_p))[0]
+
+    dll = build_aot(graph, mlib, {"w": w}, "model")
+    a = np.random.uniform(size=shape).astype(A.dtype)
+    # parameters live in read-only data and cannot be set
+    assert dll.tvm_aot_get_input_index(ctypes.c_char_p(b"w")) == -1
+    assert dll.tvm_aot_get_input_index(ctypes.c_char_p(b"y")) == -1
+    index = dll.tvm_aot_get_input_index(ctypes.c_char_p(b"x"))
+    ctypes.memmove(tensor_data(dll.tvm_aot_input(index)), a.ctypes.data, a.nbytes)
+    assert dll.tvm_aot_run() == 0
+    out = np.empty(shape, dtype=A.dtype)
+    ctypes.memmove(out.ctypes.data, tensor_data(dll.tvm_aot_output(0)), out.nbytes)
+
+    mod = graph_runtime.create(graph, mlib, tvm.cpu(0))
+    mod.set_input(w=w)
+    mod.run(x=a)
+    tvm.testing.assert_allclose(out, mod.get_output(0).asnumpy())
+    tvm.testing.assert_allclose(out, a + 2 * w.asnumpy())
+
+    # kernels reach the functions they call with tvm_call_packed through the
+    # module context bound by init.
+    @tvm.register_func("tvm.test.aot_double")
+    def aot_double(x, y):
+        y.copyfrom(x.asnumpy() * 2)
+    X = tvm.placeholder((n,), name='X')
+    Y = tvm.extern(X.shape, [X], lambda ins, outs: tvm.call_packed(
+        "tvm.test.aot_double", ins[0], outs[0]), name='Y')
+    s = tvm.create_schedule(Y.op)
+    mlib = tvm.build(s, [X, Y], "llvm", name="mydouble")
+    graph = json.dumps({
+        "nodes": [{"op": "null", "name": "x", "inputs": []},
+                  {"op": "tvm_op", "name": "double", "inputs": [[0, 0, 0]],
+                   "attrs": {"func_name": "mydouble",
+                             "flatten_data": "0",
+                             "num_inputs" : "1",
+                             "num_outputs" : "1"}}],
+        "arg_nodes": [0],
+        "node_row_ptr": [0, 1, 2],
+        "heads": [[1, 0, 0]],
+        "attrs": {"shape" : ["list_shape", [shape] * 2],
+                  "dltype" : ["list_str", ["float32"] * 2],
+                  "storage_id" : ["list_int", [0, 1]]}})
+    dll = build_aot(graph, mlib, None, "packed")
+    ctypes.memmove(tensor_data(dll.tvm_aot_input(0)), a.ctypes.data, a.nbytes)
+    assert dll.tvm_aot_run() == 0
+    ctypes.memmove(out.ctypes.data, tensor_data(dll.tvm_aot_output(0)), out.nbytes)
+    tvm.testing.assert_allclose(out, 2 * a)
+
+
 if __name__ == "__main__":
     test_graph_simple()
+    test_graph_aot()
@@ -390,14 +390,85 @@ def test_duplex_data_transferring():
             np.testing.assert_equal(
                 out.asnumpy(), tensor_a + tensor_b - tensor_c + tensor_d)
 
+        def check_streams():
+            # OpenCL has no streams.
+            if device != "cuda":
+                return
+            mod = graph_runtime.create(graph, mhost, ctx)
+            mod.enable_streams()
+            out = tvm.nd.empty(shape)
+            for _ in range(3):
+                for name, value in params.items():
+                    mod.set_input_async(name, tvm.nd.array(value))
+                mod.run()
+                mod.get_output_async(0, out)
+                mod.sync()
+                np.testing.assert_equal(
+                    out.asnumpy(), tensor_a + tensor_b - tensor_c + tensor_d)
+
         check_verify()
         check_load_module()
+        check_streams()
 
     dev_tar = {"cuda": "cuda", "opencl": "opencl"}
     for device, target in dev_tar.items():
         with tvm.target.create(device):
             check_device(device, target)
 
+
+def test_streams_on_cpu():
+    """Run the duplex graph on streams with only cpu contexts, where the
+    streams are trivial."""
+    target = "llvm"
+    if not tvm.module.enabled(target):
+        print("Skip test because llvm is not enabled.")
+        return
+    ctx = tvm.cpu(0)
+    graph = get_duplex_graph(ctx.device_type, ctx.device_type)
+    shape = (4,)
+    copy_add_sub = tvm.placeholder(shape, name="__copy0")
+    copy_sub_add = tvm.placeholder(shape, name="__copy1")
+    tensor_a = tvm.placeholder(shape, name="A")
+    tensor_b = tvm.placeholder(shape, name="B")
+    tensor_c = tvm.placeholder(shape, name="C")
+    tensor_d = tvm.placeholder(shape, name="D")
+    elemwise_add0 = tvm.compute(shape, lambda *i: tensor_a(*i) + tensor_b(*i),
+                                name="elemwise_add0")
+    elemwise_add1 = tvm.compute(shape, lambda *i: copy_sub_add(*i) + tensor_d(*i),
+                                name="elemwise_add1")
+    elemwise_sub = tvm.compute(shape, lambda *i: copy_add_sub(*i) - tensor_c(*i),
+                               name="elemwise_sub")
+    funcs = []
+    for args, name in [([tensor_a, tensor_b, elemwise_add0], "elemwise_add0"),
+                       ([tensor_d, copy_sub_add, elemwise_add1], "elemwise_add1"),
+                       ([copy_add_sub, tensor_c, elemwise_sub], "elemwise_sub")]:
+        sch = tvm.create_schedule(args[-1].op)
+        funcs.append(tvm.lower(sch, args, name=name))
+    mhost = tvm.build(funcs, target=target)
+
+    mod = graph_runtime.create(graph, mhost, [ctx, ctx])
+    mod.enable_streams()
+    out = tvm.nd.empty(shape)
+    for _ in range(3):
+        params = {name: np.random.uniform(size=shape).astype("float32")
+                  for name in ["A", "B", "C", "D"]}
+        for name, value in params.items():
+            mod.set_input_async(name, tvm.nd.array(value))
+        mod.run()
+        mod.get_output_async(0, out)
+        mod.sync()
+        np.testing.assert_allclose(
+            out.asnumpy(), params["A"] + params["B"] - params["C"] + params["D"],
+            rtol=1e-5)
+    # the synchronous interface keeps working.
+    mod.set_input(**params)
+    mod.run()
+    np.testing.assert_allclose(
+        mod.get_output(0).asnumpy(),
+        params["A"] + params["B"] - params["C"] + params["D"], rtol=1e-5)
+
+
 if __name__ == "__main__":
     test_simplex_data_transferring()
     test_duplex_data_transferring()
+    test_streams_on_cpu()
@@ -151,6 +151,64 @@ def test_graph_runtime():
                 result, x_in * x_in + 1.0)
 
 
+def test_batched_tasks():
+    """Test running several function calls in a single device execution."""
+    if not tvm.module.enabled("micro_dev"):
+        return
+    shape = (1024,)
+    dtype = "float32"
+
+    # Construct TVM expression.
+    tvm_shape = tvm.convert(shape)
+    A = tvm.placeholder(tvm_shape, name="A", dtype=dtype)
+    B = tvm.placeholder(tvm_shape, name="B", dtype=dtype)
+    C = tvm.compute(A.shape, lambda *i: A(*i) + B(*i), name="C")
+    s = tvm.create_schedule(C.op)
+
+    func_name = "fadd"
+    c_mod = tvm.build(s, [A, B, C], target="c", name=func_name)
+
+    with micro.Session(DEV_CONFIG) as sess:
+        micro_mod = create_micro_mod(c_mod, DEV_CONFIG)
+        micro_func = micro_mod[func_name]
+        ctx = tvm.micro_dev(0)
+        a = tvm.nd.array(np.random.uniform(size=shape).astype(dtype), ctx)
+        b = tvm.nd.array(np.random.uniform(size=shape).astype(dtype), ctx)
+        c = tvm.nd.array(np.zeros(shape, dtype=dtype), ctx)
+        d = tvm.nd.array(np.zeros(shape, dtype=dtype), ctx)
+        sess.begin_batch()
+        micro_func(a, b, c)
+        micro_func(c, b, d)
+        micro_func(d, a, c)
+        times = sess.end_batch()
+        assert len(times) == 3
+        tvm.testing.assert_allclose(
+                c.asnumpy(), 2 * a.asnumpy() + 2 * b.asnumpy(), rtol=1e-5)
+
+        # More tasks than the args section holds are flushed in several runs.
+        num_tasks = 32
+        e = tvm.nd.array(np.zeros(shape, dtype=dtype), ctx)
+        sess.begin_batch()
+        for _ in range(num_tasks):
+            micro_func(e, b, e)
+        times = sess.end_batch()
+        assert len(times) == num_tasks
+        tvm.testing.assert_allclose(
+                e.asnumpy(), num_tasks * b.asnumpy(), rtol=1e-5)
+
+        # Reading an output flushes the calls queued by the graph runtime.
+        x = relay.var("x", relay.TensorType(shape=shape, dtype=dtype))
+        z = relay.add(relay.multiply(x, x), relay.const(1.0))
+        mod = relay_micro_build(relay.Function([x], z), DEV_CONFIG)
+        x_in = np.random.uniform(size=shape[0]).astype(dtype)
+        sess.begin_batch()
+        mod.run(x=x_in)
+        result = mod.get_output(0).asnumpy()
+        assert sess.end_batch()
+        tvm.testing.assert_allclose(
+                result, x_in * x_in + 1.0)
+
+
 def test_multiple_modules():
     """Test loading multiple modules on the device simultaneously."""
     if not tvm.module.enabled("micro_dev"):
@@ -276,6 +334,7 @@ if __name__ == "__main__":
     test_add()
     test_workspace_add()
     test_graph_runtime()
+    test_batched_tasks()
     test_multiple_modules()
     test_interleave_sessions()
     test_nested_sessions()
@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file schedule_config.h
+ * \brief Knobs of tunable schedules
+ */
+#ifndef TOPI_DETAIL_SCHEDULE_CONFIG_H_
+#define TOPI_DETAIL_SCHEDULE_CONFIG_H_
+
+#include <string>
+
+#include "tvm/operation.h"
+
+namespace topi {
+namespace detail {
+using namespace tvm;
+
+/*!
+ * \brief The knobs of a tunable schedule, keyed by their AutoTVM names.
+ * A split knob holds the factors of its SplitEntity, e.g. [-1, 4, 8], and
+ * an option knob holds the value of its OtherOptionEntity as a single
+ * element. Knobs which are not set take the fallback value of the schedule.
+ */
+using ScheduleConfig = tvm::Map<std::string, Array<Integer> >;
+
+/*!
+ * \brief Get a knob from a schedule config
+ *
+ * \param cfg The schedule config
+ * \param fallback The fallback config, used for the knobs cfg does not set
+ * \param name The name of the knob
+ *
+ * \return The value of the knob
+ */
+inline Array<Integer> GetKnob(const ScheduleConfig& cfg,
+                              const ScheduleConfig& fallback,
+                              const std::string& name) {
+  if (cfg.count(name)) {
+    return cfg[name];
+  }
+  CHECK(fallback.count(name)) << "No value for knob " << name;
+  return fallback[name];
+}
+
+/*!
+ * \brief Get the innermost factor of a split knob, the size[-1] of AutoTVM
+ *
+ * \param knob The split knob
+ *
+ * \return The innermost factor
+ */
+inline int InnerFactor(const Array<Integer>& knob) {
+  CHECK_GT(knob.size(), 0);
+  return static_cast<int>(knob[knob.size() - 1]->value);
+}
+
+/*!
+ * \brief Split an axis the way an AutoTVM SplitEntity does: the innermost
+ * factors are split off first and the outermost factor is inferred.
+ *
+ * \param stage The stage in which to apply the split
+ * \param axis The axis to split
+ * \param knob The split knob
+ *
+ * \return The axes from the outermost to the innermost
+ */
+inline Array<IterVar> ApplySplit(Stage stage, IterVar axis, const Array<Integer>& knob) {
+  Array<IterVar> inner;
+  for (size_t i = knob.size() - 1; i > 0; --i) {
+    IterVar outer, split;
+    stage.split(axis, knob[i], &outer, &split);
+    inner.push_back(split);
+    axis = outer;
+  }
+  Array<IterVar> res{ axis };
+  for (size_t i = inner.size(); i > 0; --i) {
+    res.push_back(inner[i - 1]);
+  }
+  return res;
+}
+
+/*!
+ * \brief Get the largest factor of n which is not larger than max_value
+ *
+ * \param n The number to factor
+ * \param max_value The upper bound of the factor
+ *
+ * \return The factor
+ */
+inline int GetMaxFactor(int n, int max_value) {
+  for (int bn = max_value; bn > 1; --bn) {
+    if (n % bn == 0) {
+      return bn;
+    }
+  }
+  return 1;
+}
+
+}  // namespace detail
+}  // namespace topi
+#endif  // TOPI_DETAIL_SCHEDULE_CONFIG_H_
@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file x86/batch_matmul.h
+ * \brief x86 schedule for batch_matmul
+ */
+#ifndef TOPI_X86_BATCH_MATMUL_H_
+#define TOPI_X86_BATCH_MATMUL_H_
+
+#include "topi/tags.h"
+#include "topi/detail/array_utils.h"
+#include "topi/detail/constant_utils.h"
+#include "topi/detail/fuse.h"
+#include "topi/detail/schedule_config.h"
+#include "tvm/operation.h"
+#include "tvm/build_module.h"
+
+namespace topi {
+using namespace tvm;
+
+namespace x86 {
+/*!
+* \brief Get the largest power of two factor of n not larger than max_value
+*/
+inline int GetMaxPower2Factor(int n, int max_value) {
+  int x = 1;
+  while (n % 2 == 0 && x * 2 <= max_value) {
+    x *= 2;
+    n /= 2;
+  }
+  return x;
+}
+
+/*!
+* \brief Get the fallback knobs of batch_matmul, tile_y, tile_x and tile_k
+*
+* \param M The number of rows of the output
+* \param N The number of columns of the output
+* \param K The reduction length
+*
+* \return The fallback config
+*/
+inline detail::ScheduleConfig default_batch_matmul_config(int M, int N, int K) {
+  int x_bn = GetMaxPower2Factor(N, 8);
+  int y_bn = GetMaxPower2Factor(M, 8);
+  detail::ScheduleConfig cfg;
+  cfg.Set("tile_k", { K / 16, 16 });
+  cfg.Set("tile_x", { N / x_bn, x_bn });
+  cfg.Set("tile_y", { M / y_bn, y_bn });
+  return cfg;
+}
+
+/*!
+* \brief Create an x86 schedule for batch_matmul. The output is tiled and
+* the reduction is vectorized through an rfactor of tile_k[-1] lanes.
+*
+* \param target The target to generate a schedule for.
+* \param outs The output tensors.
+* \param cfg The knobs of the schedule, see default_batch_matmul_config
+*
+* \return A schedule for the given ops.
+*/
+inline Schedule schedule_batch_matmul(const Target &target, const Array<Tensor>& outs,
+                                      const detail::ScheduleConfig& cfg =
+                                        detail::ScheduleConfig()) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule = [&](const Tensor& C) {
+    auto A = C->op->InputTensors()[0];
+    int M = static_cast<int>(detail::GetConstInt(A->shape[1]));
+    int K = static_cast<int>(detail::GetConstInt(A->shape[2]));
+    int N = static_cast<int>(detail::GetConstInt(C->shape[2]));
+    auto fallback = default_batch_matmul_config(M, N, K);
+
+    // The epilogue, if any, is the root of the loop nest and the product is
+    // accumulated in a local tile of it.
+    Tensor O, CC;
+    if (detail::contains(s->outputs, C->op)) {
+      O = C;
+      CC = s.cache_write(C, "global");
+    } else {
+      O = outs[0];
+      CC = C;
+    }
+
+    auto b = O->op.as<ComputeOpNode>()->axis[0];
+    auto y = O->op.as<ComputeOpNode>()->axis[1];
+    auto x = O->op.as<ComputeOpNode>()->axis[2];
+    auto ys = detail::ApplySplit(s[O], y, detail::GetKnob(cfg, fallback, "tile_y"));
+    auto xs = detail::ApplySplit(s[O], x, detail::GetKnob(cfg, fallback, "tile_x"));
+    CHECK(ys.size() == 2 && xs.size() == 2) << "tile_y and tile_x must have two factors";
+    s[O].reorder({ b, ys[0], xs[0], ys[1], xs[1] });
+    auto bxyo = detail::Fuse(s[O], { b, ys[0], xs[0] });
+    s[O].parallel(bxyo);
+
+    s[CC].compute_at(s[O], bxyo);
+    auto k = CC->op.as<ComputeOpNode>()->reduce_axis[0];
+    auto ks = detail::ApplySplit(s[CC], k, detail::GetKnob(cfg, fallback, "tile_k"));
+    CHECK_EQ(ks.size(), 2) << "tile_k must have two factors";
+
+    auto Crf = s.rfactor(CC, ks[1])[0];
+    s[Crf].compute_at(s[CC], s[CC]->op.as<ComputeOpNode>()->axis[0]);
+    auto rf_axis = s[Crf]->op.as<ComputeOpNode>()->axis;
+    IterVar fused;
+    s[Crf].fuse(rf_axis[2], rf_axis[3], &fused);
+    s[Crf].vectorize(rf_axis[0]);
+    s[O].pragma(bxyo, "auto_unroll_max_step", 16);
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    // Inline all one-to-one-mapping operators except the last stage (output)
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "batch_matmul") {
+      _schedule(op.output(0));
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace x86
+}  // namespace topi
+#endif  // TOPI_X86_BATCH_MATMUL_H_
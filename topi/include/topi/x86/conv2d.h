@@ -0,0 +1,307 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file x86/conv2d.h
+ * \brief x86 declaration and schedule for conv2d in NCHW[x]c layout
+ */
+#ifndef TOPI_X86_CONV2D_H_
+#define TOPI_X86_CONV2D_H_
+
+#include <string>
+
+#include "topi/tags.h"
+#include "topi/nn.h"
+#include "topi/detail/array_utils.h"
+#include "topi/detail/constant_utils.h"
+#include "topi/detail/fuse.h"
+#include "topi/detail/schedule_config.h"
+#include "topi/x86/util.h"
+#include "tvm/operation.h"
+#include "tvm/build_module.h"
+
+namespace topi {
+using namespace tvm;
+
+namespace x86 {
+/*!
+* \brief Get the fallback knobs of conv2d_NCHWc. tile_ic[-1] and tile_oc[-1]
+* are the channel blocks the data and the kernel have to be packed with,
+* tile_ow[-1] is the number of output pixels kept in registers. 1x1 kernels
+* tile the output height by tile_oh, the others choose with unroll_kw whether
+* to unroll the kernel width.
+*
+* \param target The x86 target
+* \param in_channel The number of input channels
+* \param num_filter The number of output channels
+* \param out_height The height of the output
+* \param out_width The width of the output
+* \param kernel_h The height of the kernel
+* \param kernel_w The width of the kernel
+*
+* \return The fallback config
+*/
+inline detail::ScheduleConfig default_conv2d_NCHWc_config(const Target& target,
+                                                          int in_channel,
+                                                          int num_filter,
+                                                          int out_height,
+                                                          int out_width,
+                                                          int kernel_h,
+                                                          int kernel_w) {
+  int oc_bn = detail::GetMaxFactor(num_filter, GetFp32Len(target));
+  int ic_bn = detail::GetMaxFactor(in_channel, oc_bn);
+  detail::ScheduleConfig cfg;
+  cfg.Set("tile_ic", { in_channel / ic_bn, ic_bn });
+  cfg.Set("tile_oc", { num_filter / oc_bn, oc_bn });
+
+  if (kernel_h == 1 && kernel_w == 1) {
+    for (int ow_factor = out_width; ow_factor > 0; --ow_factor) {
+      if (out_width % ow_factor != 0) continue;
+      for (int oh_factor = out_height; oh_factor > 0; --oh_factor) {
+        if (out_height % oh_factor == 0 && ow_factor * oh_factor < 32) {
+          cfg.Set("tile_oh", { oh_factor });
+          cfg.Set("tile_ow", { out_width / ow_factor, ow_factor });
+          return cfg;
+        }
+      }
+    }
+    LOG(FATAL) << "Cannot decide the default schedule for a " << out_height << "x"
+               << out_width << " output";
+  }
+
+  int reg_n = detail::GetMaxFactor(out_width, 31);
+  cfg.Set("tile_ow", { out_width / reg_n, reg_n });
+  cfg.Set("unroll_kw", { 0 });
+  return cfg;
+}
+
+/*!
+* \brief Conv2D in NCHW[x]c layout. The data and the kernel are expected to
+* be packed already, with the channel blocks of default_conv2d_NCHWc_config
+* or of a tuned config.
+*
+* \param data Tensor with shape [batch, in_channel_chunk, in_height, in_width,
+* in_channel_block]
+* \param kernel Tensor with shape [num_filter_chunk, in_channel_chunk,
+* filter_height, filter_width, in_channel_block, num_filter_block]
+* \param pad_h The padding of the height, before and after
+* \param pad_w The padding of the width, before and after
+* \param stride_h The stride of the height
+* \param stride_w The stride of the width
+* \param dilation_h The dilation of the height
+* \param dilation_w The dilation of the width
+* \param out_dtype Output data type. Used for mixed precision.
+* \param name The name of the operation
+*
+* \return Tensor with shape [batch, out_channel_chunk, out_height, out_width,
+* out_channel_block]
+*/
+inline Tensor conv2d_NCHWc(const Tensor& data,
+                           const Tensor& kernel,
+                           int pad_h,
+                           int pad_w,
+                           int stride_h,
+                           int stride_w,
+                           int dilation_h,
+                           int dilation_w,
+                           const DataType& out_dtype,
+                           std::string name = "conv2d_NCHWc") {
+  CHECK_EQ(data->shape.size(), 5) << "conv2d_NCHWc requires 5-D data";
+  CHECK_EQ(kernel->shape.size(), 6) << "conv2d_NCHWc requires 6-D kernel";
+  auto batch = data->shape[0];
+  int ic_chunk = static_cast<int>(detail::GetConstInt(data->shape[1]));
+  int in_height = static_cast<int>(detail::GetConstInt(data->shape[2]));
+  int in_width = static_cast<int>(detail::GetConstInt(data->shape[3]));
+  int ic_bn = static_cast<int>(detail::GetConstInt(data->shape[4]));
+  auto oc_chunk = kernel->shape[0];
+  int kernel_h = static_cast<int>(detail::GetConstInt(kernel->shape[2]));
+  int kernel_w = static_cast<int>(detail::GetConstInt(kernel->shape[3]));
+  auto oc_bn = kernel->shape[5];
+  CHECK_EQ(detail::GetConstInt(kernel->shape[1]), ic_chunk)
+    << "conv2d_NCHWc does not support groups";
+  CHECK_EQ(detail::GetConstInt(kernel->shape[4]), ic_bn)
+    << "the data and the kernel are packed with different channel blocks";
+
+  int dilated_kernel_h = (kernel_h - 1) * dilation_h + 1;
+  int dilated_kernel_w = (kernel_w - 1) * dilation_w + 1;
+  int out_height = (in_height + 2 * pad_h - dilated_kernel_h) / stride_h + 1;
+  int out_width = (in_width + 2 * pad_w - dilated_kernel_w) / stride_w + 1;
+
+  auto data_pad = data;
+  if (pad_h != 0 || pad_w != 0) {
+    data_pad = pad(data, { 0, 0, pad_h, pad_w, 0 }, { 0, 0, pad_h, pad_w, 0 },
+                   Expr(), "data_pad", "injective,pad");
+  }
+
+  auto ic = tvm::reduce_axis(Range(0, ic_chunk * ic_bn), "ic");
+  auto kh = tvm::reduce_axis(Range(0, kernel_h), "kh");
+  auto kw = tvm::reduce_axis(Range(0, kernel_w), "kw");
+  return tvm::compute(
+    { batch, oc_chunk, out_height, out_width, oc_bn },
+    [&](const Array<Var>& idx) {
+      auto n = idx[0], occ = idx[1], oh = idx[2], ow = idx[3], ocb = idx[4];
+      return tvm::sum(
+        tvm::cast(out_dtype, data_pad(n, indexdiv(ic, ic_bn),
+                                      oh * stride_h + kh * dilation_h,
+                                      ow * stride_w + kw * dilation_w,
+                                      indexmod(ic, ic_bn))) *
+        tvm::cast(out_dtype, kernel(occ, indexdiv(ic, ic_bn), kh, kw,
+                                    indexmod(ic, ic_bn), ocb)),
+        { ic, kh, kw });
+    }, name, "conv2d_NCHWc");
+}
+
+/*!
+* \brief Create an x86 schedule for conv2d_NCHWc
+*
+* \param target The target to generate a schedule for.
+* \param outs The output tensors.
+* \param cfg The knobs of the schedule, see default_conv2d_NCHWc_config
+*
+* \return A schedule for the given ops.
+*/
+inline Schedule schedule_conv2d_NCHWc(const Target &target, const Array<Tensor>& outs,
+                                      const detail::ScheduleConfig& cfg =
+                                        detail::ScheduleConfig()) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule = [&](const Tensor& C) {
+    auto A = C->op->InputTensors()[0];
+    auto W = C->op->InputTensors()[1];
+    auto O = outs[0];
+    int ic_bn = static_cast<int>(detail::GetConstInt(A->shape[4]));
+    int in_channel = static_cast<int>(detail::GetConstInt(A->shape[1])) * ic_bn;
+    int num_filter = static_cast<int>(detail::GetConstInt(C->shape[1]) *
+                                      detail::GetConstInt(C->shape[4]));
+    int out_height = static_cast<int>(detail::GetConstInt(C->shape[2]));
+    int out_width = static_cast<int>(detail::GetConstInt(C->shape[3]));
+    int kernel_h = static_cast<int>(detail::GetConstInt(W->shape[2]));
+    int kernel_w = static_cast<int>(detail::GetConstInt(W->shape[3]));
+    bool is_1x1 = kernel_h == 1 && kernel_w == 1;
+    auto fallback = default_conv2d_NCHWc_config(target, in_channel, num_filter,
+                                                out_height, out_width, kernel_h, kernel_w);
+    int ow_factor = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_ow"));
+    int oh_factor = 1;
+    bool unroll_kw = false;
+    if (is_1x1) {
+      oh_factor = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_oh"));
+    } else {
+      unroll_kw = detail::InnerFactor(detail::GetKnob(cfg, fallback, "unroll_kw")) != 0;
+    }
+
+    // schedule data
+    if (A->op.as<ComputeOpNode>()) {
+      auto axis = A->op.as<ComputeOpNode>()->axis;
+      auto fused = detail::Fuse(s[A], { axis[0], axis[1], axis[2] });
+      s[A].parallel(fused);
+    }
+
+    // schedule 5-D NCHW[x]c conv
+    auto CC = s.cache_write(C, "global");
+    auto c_axis = C->op.as<ComputeOpNode>()->axis;
+    IterVar oh_outer, oh_inner, ow_outer, ow_inner, parallel_axis;
+    if (is_1x1) {
+      s[C].split(c_axis[2], oh_factor, &oh_outer, &oh_inner);
+      s[C].split(c_axis[3], ow_factor, &ow_outer, &ow_inner);
+      s[C].reorder({ c_axis[1], oh_outer, ow_outer, oh_inner, ow_inner, c_axis[4] });
+      s[C].vectorize(c_axis[4]);
+      parallel_axis = detail::Fuse(s[C], { c_axis[0], c_axis[1], oh_outer });
+      s[CC].compute_at(s[C], parallel_axis);
+    } else {
+      s[C].split(c_axis[3], ow_factor, &ow_outer, &ow_inner);
+      s[C].reorder({ c_axis[1], c_axis[2], ow_outer, ow_inner, c_axis[4] });
+      parallel_axis = detail::Fuse(s[C], { c_axis[0], c_axis[1], c_axis[2] });
+      s[C].vectorize(c_axis[4]);
+      s[CC].compute_at(s[C], ow_outer);
+    }
+    if (C == O) {
+      s[C].parallel(parallel_axis);
+    }
+
+    auto cc_axis = CC->op.as<ComputeOpNode>()->axis;
+    auto cc_reduce = CC->op.as<ComputeOpNode>()->reduce_axis;
+    IterVar ic_chunk, ic_block;
+    s[CC].split(cc_reduce[0], ic_bn, &ic_chunk, &ic_block);
+    if (is_1x1) {
+      s[CC].split(cc_axis[2], oh_factor, &oh_outer, &oh_inner);
+      s[CC].split(cc_axis[3], ow_factor, &ow_outer, &ow_inner);
+      s[CC].reorder({ cc_axis[1], oh_outer, ow_outer, ic_chunk, ic_block,
+                      oh_inner, ow_inner, cc_axis[4] });
+      detail::Fuse(s[CC], { cc_axis[1], oh_outer });
+      s[CC].unroll(oh_inner);
+    } else {
+      auto kh = cc_reduce[1];
+      auto kw = cc_reduce[2];
+      s[CC].split(cc_axis[3], ow_factor, &ow_outer, &ow_inner);
+      if (unroll_kw) {
+        s[CC].reorder({ cc_axis[1], cc_axis[2], ow_outer, ic_chunk, kh, ic_block, kw,
+                        ow_inner, cc_axis[4] });
+        s[CC].unroll(kw);
+      } else {
+        s[CC].reorder({ cc_axis[1], cc_axis[2], ow_outer, ic_chunk, kh, kw, ic_block,
+                        ow_inner, cc_axis[4] });
+      }
+    }
+    s[CC].vectorize(cc_axis[4]);
+    s[CC].unroll(ow_inner);
+
+    if (C != O) {
+      auto o_axis = O->op.as<ComputeOpNode>()->axis;
+      CHECK_EQ(o_axis.size(), 5) << "conv2d_NCHWc must be followed by 5-D operators";
+      IterVar o_oh_outer, o_oh_inner, o_ow_outer, o_ow_inner;
+      s[O].split(o_axis[2], oh_factor, &o_oh_outer, &o_oh_inner);
+      s[O].split(o_axis[3], ow_factor, &o_ow_outer, &o_ow_inner);
+      s[O].reorder({ o_axis[1], o_oh_outer, o_ow_outer, o_oh_inner, o_ow_inner, o_axis[4] });
+      auto o_parallel = detail::Fuse(s[O], { o_axis[0], o_axis[1], o_oh_outer });
+      s[C].compute_at(s[O], o_parallel);
+      s[O].vectorize(o_axis[4]);
+      s[O].parallel(o_parallel);
+    }
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    // Inline all one-to-one-mapping operators except the last stage (output)
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "conv2d_NCHWc") {
+      _schedule(op.output(0));
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace x86
+}  // namespace topi
+#endif  // TOPI_X86_CONV2D_H_
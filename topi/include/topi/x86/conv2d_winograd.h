@@ -0,0 +1,415 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file x86/conv2d_winograd.h
+ * \brief x86 declaration and schedule for the Winograd F(4x4, 3x3) conv2d
+ */
+#ifndef TOPI_X86_CONV2D_WINOGRAD_H_
+#define TOPI_X86_CONV2D_WINOGRAD_H_
+
+#include <string>
+#include <vector>
+
+#include "topi/tags.h"
+#include "topi/nn.h"
+#include "topi/detail/array_utils.h"
+#include "topi/detail/constant_utils.h"
+#include "topi/detail/fuse.h"
+#include "topi/detail/schedule_config.h"
+#include "topi/x86/util.h"
+#include "tvm/operation.h"
+#include "tvm/build_module.h"
+#include "tvm/ir.h"
+
+namespace topi {
+using namespace tvm;
+
+namespace x86 {
+/*! \brief The output tile size of the Winograd transforms */
+constexpr int kWinogradTileSize = 4;
+
+/*!
+* \brief Create a constant matrix as a tensor
+*
+* \param data The rows of the matrix
+* \param dtype The data type of the elements
+* \param name The name of the operation
+*
+* \return A 2-D tensor holding the matrix
+*/
+inline Tensor WinogradConstMatrix(const std::vector<std::vector<double> >& data,
+                                  const DataType& dtype,
+                                  std::string name) {
+  int row = static_cast<int>(data.size());
+  int col = static_cast<int>(data[0].size());
+  return tvm::compute(
+    { row, col },
+    [&](Var i, Var j) {
+      Expr now = make_const(dtype, 0);
+      for (int ii = 0; ii < row; ++ii) {
+        for (int jj = 0; jj < col; ++jj) {
+          now = ir::Select::make(indexmod(i, row) == ii && indexmod(j, col) == jj,
+                                 make_const(dtype, data[ii][jj]), now);
+        }
+      }
+      return now;
+    }, name);
+}
+
+/*!
+* \brief The A, B and G matrices of F(4x4, 3x3) with the interpolation points
+* 0, -1, 1, 1/2 and -2, the same as topi.nn.winograd_transform_matrices(4, 3).
+*/
+inline Tensor WinogradMatrixA(const DataType& dtype) {
+  return WinogradConstMatrix({ { 1, 0, 0, 0 },
+                               { 1, -1, 1, -1 },
+                               { 1, 1, 1, 1 },
+                               { 1, 0.5, 0.25, 0.125 },
+                               { 1, -2, 4, -8 },
+                               { 0, 0, 0, 1 } }, dtype, "A");
+}
+
+inline Tensor WinogradMatrixB(const DataType& dtype) {
+  return WinogradConstMatrix({ { 1, 0, 0, 0, 0, 0 },
+                               { -1.5, 1, -1, -2, 0.5, 1 },
+                               { -2, -2.5, 0.5, -1, -1, -1.5 },
+                               { 1.5, 0.5, 2.5, 2, -0.5, -2 },
+                               { 1, 1, 1, 1, 1, 1.5 },
+                               { 0, 0, 0, 0, 0, 1 } }, dtype, "B");
+}
+
+inline Tensor WinogradMatrixG(const DataType& dtype) {
+  return WinogradConstMatrix({ { 1, 0, 0 },
+                               { -1.0 / 3, 1.0 / 3, -1.0 / 3 },
+                               { 1.0 / 3, 1.0 / 3, 1.0 / 3 },
+                               { -16.0 / 15, -8.0 / 15, -4.0 / 15 },
+                               { 1.0 / 15, -2.0 / 15, 4.0 / 15 },
+                               { 0, 0, 1 } }, dtype, "G");
+}
+
+/*!
+* \brief Get the fallback knobs of the Winograd conv2d. tile_p[-1] tiles are
+* transformed and multiplied as one vector, tile_k[-1] is the output channel
+* block of the transformed kernel and tile_c[-1] the unrolled input channels
+* of the batched GEMM.
+*
+* \param target The x86 target
+* \param num_tiles The number of output tiles of the batch
+* \param num_filter The number of output channels
+* \param in_channel The number of input channels
+*
+* \return The fallback config
+*/
+inline detail::ScheduleConfig default_conv2d_winograd_config(const Target& target,
+                                                             int num_tiles,
+                                                             int num_filter,
+                                                             int in_channel) {
+  int vp = detail::GetMaxFactor(num_tiles, GetFp32Len(target));
+  int vk = detail::GetMaxFactor(num_filter, 8);
+  int vc = detail::GetMaxFactor(in_channel, 8);
+  detail::ScheduleConfig cfg;
+  cfg.Set("tile_p", { num_tiles / vp, vp });
+  cfg.Set("tile_k", { num_filter / vk, vk });
+  cfg.Set("tile_c", { in_channel / vc, vc });
+  return cfg;
+}
+
+/*!
+* \brief Transform a conv2d kernel for conv2d_winograd_nchw ahead of time
+*
+* \param kernel Tensor with shape [num_filter, in_channel, 3, 3]
+* \param tile_k The output channel block, tile_k[-1] of the config
+* \param out_dtype Output data type
+*
+* \return Tensor with shape [6, 6, num_filter / tile_k, in_channel, tile_k]
+*/
+inline Tensor conv2d_winograd_weight_transform(const Tensor& kernel,
+                                               int tile_k,
+                                               const DataType& out_dtype) {
+  CHECK_EQ(kernel->shape.size(), 4) << "Winograd requires a 4-D kernel";
+  int K = static_cast<int>(detail::GetConstInt(kernel->shape[0]));
+  CHECK_EQ(K % tile_k, 0) << "tile_k[-1] must divide the number of filters";
+  CHECK(detail::GetConstInt(kernel->shape[2]) == 3 && detail::GetConstInt(kernel->shape[3]) == 3)
+    << "Winograd F(4x4, 3x3) requires a 3x3 kernel";
+  int alpha = kWinogradTileSize + 2;
+  auto G = WinogradMatrixG(out_dtype);
+  auto r_kh = tvm::reduce_axis(Range(0, 3), "r_kh");
+  auto r_kw = tvm::reduce_axis(Range(0, 3), "r_kw");
+  return tvm::compute(
+    { alpha, alpha, K / tile_k, kernel->shape[1], tile_k },
+    [&](const Array<Var>& idx) {
+      auto eps = idx[0], nu = idx[1], k = idx[2], c = idx[3], kk = idx[4];
+      return tvm::sum(tvm::cast(out_dtype, kernel(k * tile_k + kk, c, r_kh, r_kw)) *
+                      G(eps, r_kh) * G(nu, r_kw), { r_kh, r_kw });
+    }, "U");
+}
+
+/*!
+* \brief Conv2D in NCHW layout with the Winograd F(4x4, 3x3) algorithm,
+* for 3x3 kernels with unit strides.
+*
+* \param target The x86 target
+* \param data Tensor with shape [batch, in_channel, in_height, in_width]
+* \param kernel Tensor with shape [num_filter, in_channel, 3, 3], or the
+* output of conv2d_winograd_weight_transform
+* \param pad_h The padding of the height, before and after
+* \param pad_w The padding of the width, before and after
+* \param out_dtype Output data type. Used for mixed precision.
+* \param cfg The knobs of the schedule, see default_conv2d_winograd_config
+*
+* \return Tensor with shape [batch, num_filter, out_height, out_width]
+*/
+inline Tensor conv2d_winograd_nchw(const Target& target,
+                                   const Tensor& data,
+                                   const Tensor& kernel,
+                                   int pad_h,
+                                   int pad_w,
+                                   const DataType& out_dtype,
+                                   const detail::ScheduleConfig& cfg =
+                                     detail::ScheduleConfig()) {
+  CHECK_EQ(data->shape.size(), 4) << "Winograd requires 4-D data";
+  int N = static_cast<int>(detail::GetConstInt(data->shape[0]));
+  int C = static_cast<int>(detail::GetConstInt(data->shape[1]));
+  int IH = static_cast<int>(detail::GetConstInt(data->shape[2]));
+  int IW = static_cast<int>(detail::GetConstInt(data->shape[3]));
+  bool pre_computed = kernel->shape.size() == 5;
+  int K;
+  if (pre_computed) {
+    K = static_cast<int>(detail::GetConstInt(kernel->shape[2]) *
+                         detail::GetConstInt(kernel->shape[4]));
+  } else {
+    CHECK_EQ(kernel->shape.size(), 4) << "Winograd requires a 4-D kernel";
+    K = static_cast<int>(detail::GetConstInt(kernel->shape[0]));
+  }
+
+  const int m = kWinogradTileSize;
+  const int alpha = m + 2;
+  int H = IH + 2 * pad_h - 2;
+  int W = IW + 2 * pad_w - 2;
+  int nH = (H + m - 1) / m;
+  int nW = (W + m - 1) / m;
+  int P = N * nH * nW;
+
+  auto fallback = default_conv2d_winograd_config(target, P, K, C);
+  int VP = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_p"));
+  int VK = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_k"));
+  CHECK_EQ(P % VP, 0) << "tile_p[-1] must divide the number of tiles";
+  CHECK_EQ(K % VK, 0) << "tile_k[-1] must divide the number of filters";
+
+  // The input tiles cover nH * m + 2 rows and nW * m + 2 columns, pad the
+  // bottom and right past the border even without padding.
+  auto data_pad = pad(data, { 0, 0, pad_h, pad_w },
+                      { 0, 0, nH * m + 2 - IH - pad_h, nW * m + 2 - IW - pad_w },
+                      Expr(), "data_pad", "injective,pad");
+
+  // pack input tile
+  auto input_tile = tvm::compute(
+    { C, P / VP, alpha, alpha, VP },
+    [&](const Array<Var>& idx) {
+      auto c = idx[0], b = idx[1], eps = idx[2], nu = idx[3], bb = idx[4];
+      return data_pad(indexdiv(b * VP + bb, nH * nW), c,
+                      indexmod(indexdiv(b * VP + bb, nW), nH) * m + eps,
+                      indexmod(b * VP + bb, nW) * m + nu);
+    }, "d");
+
+  // transform kernel
+  Tensor U;
+  if (pre_computed) {
+    CHECK_EQ(detail::GetConstInt(kernel->shape[4]), VK)
+      << "The kernel is transformed with another tile_k[-1]";
+    U = kernel;
+  } else {
+    U = conv2d_winograd_weight_transform(kernel, VK, out_dtype);
+  }
+
+  // transform image
+  auto B = WinogradMatrixB(out_dtype);
+  auto r_eps = tvm::reduce_axis(Range(0, alpha), "r_eps");
+  auto r_nu = tvm::reduce_axis(Range(0, alpha), "r_nu");
+  auto V = tvm::compute(
+    { alpha, alpha, P / VP, C, VP },
+    [&](const Array<Var>& idx) {
+      auto eps = idx[0], nu = idx[1], b = idx[2], c = idx[3], bb = idx[4];
+      return tvm::sum(tvm::cast(out_dtype, input_tile(c, b, r_eps, r_nu, bb)) *
+                      B(r_eps, eps) * B(r_nu, nu), { r_eps, r_nu });
+    }, "V");
+
+  // batch gemm
+  auto rc = tvm::reduce_axis(Range(0, C), "c");
+  auto M = tvm::compute(
+    { alpha, alpha, K, P },
+    [&](Var eps, Var nu, Var k, Var b) {
+      return tvm::sum(U(eps, nu, indexdiv(k, VK), rc, indexmod(k, VK)) *
+                      V(eps, nu, indexdiv(b, VP), rc, indexmod(b, VP)), { rc });
+    }, "M");
+
+  // inverse transform
+  auto A = WinogradMatrixA(out_dtype);
+  auto r_a = tvm::reduce_axis(Range(0, alpha), "r_eps");
+  auto r_b = tvm::reduce_axis(Range(0, alpha), "r_nu");
+  auto Y = tvm::compute(
+    { K, P, m, m },
+    [&](Var k, Var b, Var vh, Var vw) {
+      return tvm::sum(M(r_a, r_b, k, b) * A(r_a, vh) * A(r_b, vw), { r_a, r_b });
+    }, "Y");
+
+  // unpack output
+  return tvm::compute(
+    { N, K, H, W },
+    [&](Var n, Var k, Var h, Var w) {
+      return Y(k, n * nH * nW + indexdiv(h, m) * nW + indexdiv(w, m),
+               indexmod(h, m), indexmod(w, m));
+    }, "output", "winograd_conv2d_output");
+}
+
+/*!
+* \brief Create an x86 schedule for conv2d_winograd_nchw
+*
+* \param target The target to generate a schedule for.
+* \param outs The output tensors.
+* \param cfg The knobs of the schedule, see default_conv2d_winograd_config
+*
+* \return A schedule for the given ops.
+*/
+inline Schedule schedule_conv2d_winograd(const Target &target, const Array<Tensor>& outs,
+                                         const detail::ScheduleConfig& cfg =
+                                           detail::ScheduleConfig()) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule = [&](const Tensor& output) {
+    auto last = outs[0];
+    auto Y = output->op->InputTensors()[0];
+    auto M = Y->op->InputTensors()[0];
+    auto A = Y->op->InputTensors()[1];
+    auto U = M->op->InputTensors()[0];
+    auto V = M->op->InputTensors()[1];
+    auto d = V->op->InputTensors()[0];
+    auto B = V->op->InputTensors()[1];
+    auto data_pad = d->op->InputTensors()[0];
+
+    int K = static_cast<int>(detail::GetConstInt(M->shape[2]));
+    int P = static_cast<int>(detail::GetConstInt(M->shape[3]));
+    int C = static_cast<int>(detail::GetConstInt(V->shape[3]));
+    auto fallback = default_conv2d_winograd_config(target, P, K, C);
+
+    // padding and input tiles
+    if (data_pad->op.as<ComputeOpNode>()) {
+      s[data_pad].compute_inline();
+    }
+    s[d].compute_inline();
+
+    // transform kernel
+    if (auto u_op = U->op.as<ComputeOpNode>()) {
+      auto G = U->op->InputTensors()[1];
+      s[G].compute_inline();
+      auto axis = u_op->axis;
+      auto r_kh = u_op->reduce_axis[0];
+      auto r_kw = u_op->reduce_axis[1];
+      s[U].reorder({ axis[2], axis[3], axis[0], axis[1], r_kh, r_kw, axis[4] });
+      for (auto iv : { axis[0], axis[1], r_kh, r_kw }) {
+        s[U].unroll(iv);
+      }
+      s[U].vectorize(axis[4]);
+      s[U].parallel(axis[2]);
+    }
+
+    // transform image
+    auto DD = s.cache_read(d, "global", { V->op });
+    s[B].compute_inline();
+    auto v_axis = V->op.as<ComputeOpNode>()->axis;
+    auto v_reduce = V->op.as<ComputeOpNode>()->reduce_axis;
+    s[V].reorder({ v_axis[2], v_axis[3], v_axis[0], v_axis[1],
+                   v_reduce[0], v_reduce[1], v_axis[4] });
+    for (auto iv : { v_axis[0], v_axis[1], v_reduce[0], v_reduce[1] }) {
+      s[V].unroll(iv);
+    }
+    s[DD].compute_at(s[V], v_axis[3]);
+    s[V].vectorize(v_axis[4]);
+    s[V].parallel(v_axis[2]);
+
+    // batch gemm
+    auto m_axis = M->op.as<ComputeOpNode>()->axis;
+    auto c = M->op.as<ComputeOpNode>()->reduce_axis[0];
+    auto cs = detail::ApplySplit(s[M], c, detail::GetKnob(cfg, fallback, "tile_c"));
+    auto ps = detail::ApplySplit(s[M], m_axis[3], detail::GetKnob(cfg, fallback, "tile_p"));
+    CHECK(cs.size() == 2 && ps.size() == 2) << "tile_c and tile_p must have two factors";
+    s[M].reorder({ m_axis[0], m_axis[1], ps[0], cs[0], m_axis[2], cs[1], ps[1] });
+    s[M].unroll(cs[1]);
+    s[M].unroll(m_axis[2]);
+    s[M].vectorize(ps[1]);
+
+    // inverse transform
+    s[A].compute_inline();
+    auto y_axis = Y->op.as<ComputeOpNode>()->axis;
+    auto y_reduce = Y->op.as<ComputeOpNode>()->reduce_axis;
+    for (auto iv : { y_axis[2], y_axis[3], y_reduce[0], y_reduce[1] }) {
+      s[Y].unroll(iv);
+    }
+
+    // output
+    auto o_axis = last->op.as<ComputeOpNode>()->axis;
+    CHECK_EQ(o_axis.size(), 4) << "The Winograd conv2d must be followed by 4-D operators";
+    auto ks = detail::ApplySplit(s[last], o_axis[1], detail::GetKnob(cfg, fallback, "tile_k"));
+    auto p = detail::Fuse(s[last], { o_axis[0], ks[0] });
+    s[M].compute_at(s[last], p);
+    s[last].parallel(p);
+
+    auto MM = s.cache_read(M, "global", { Y->op });
+    IterVar ho, wo, hi, wi;
+    s[last].tile(o_axis[2], o_axis[3], kWinogradTileSize, kWinogradTileSize,
+                 &ho, &wo, &hi, &wi);
+    s[Y].compute_at(s[last], wo);
+    s[MM].compute_at(s[last], wo);
+
+    if (output != last) {
+      s[output].compute_inline();
+    }
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    // Inline all one-to-one-mapping operators except the last stage (output)
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "winograd_conv2d_output") {
+      _schedule(op.output(0));
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace x86
+}  // namespace topi
+#endif  // TOPI_X86_CONV2D_WINOGRAD_H_
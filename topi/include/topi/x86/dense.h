@@ -0,0 +1,364 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file x86/dense.h
+ * \brief x86 declaration and schedules for dense
+ */
+#ifndef TOPI_X86_DENSE_H_
+#define TOPI_X86_DENSE_H_
+
+#include <string>
+
+#include "topi/tags.h"
+#include "topi/detail/array_utils.h"
+#include "topi/detail/constant_utils.h"
+#include "topi/detail/fuse.h"
+#include "topi/detail/schedule_config.h"
+#include "topi/nn/dense.h"
+#include "topi/x86/util.h"
+#include "tvm/operation.h"
+#include "tvm/build_module.h"
+
+namespace topi {
+using namespace tvm;
+
+namespace x86 {
+/*!
+* \brief Get the fallback knobs of dense_pack, tile_y, tile_x and tile_k.
+* The innermost tile_x factor is the block size of the packed weight.
+*
+* \param target The x86 target
+* \param M The batch size, or -1 when it is not a constant
+* \param N The output dimension
+* \param K The input dimension
+*
+* \return The fallback config
+*/
+inline detail::ScheduleConfig default_dense_pack_config(const Target& target,
+                                                        int M, int N, int K) {
+  if (M < 0) {
+    M = 16;
+  }
+  int vec_width = GetFp32Len(target);
+  int tilex_ii = detail::GetMaxFactor(N, vec_width * 2);
+  int NN = N / tilex_ii;
+  int tilex_oi = 1;
+  while (NN / tilex_oi > 4 && (NN / tilex_oi) % 2 == 0) {
+    tilex_oi *= 2;
+  }
+
+  int tiley_ii = 8;
+  while (M % tiley_ii != 0) {
+    tiley_ii /= 2;
+  }
+  int MM = M / tiley_ii;
+  int tiley_oi = 1;
+  while (MM / tiley_oi > 4 && (MM / tiley_oi) % 2 == 0) {
+    tiley_oi *= 2;
+  }
+
+  detail::ScheduleConfig cfg;
+  cfg.Set("tile_y", { MM / tiley_oi, tiley_oi, tiley_ii });
+  cfg.Set("tile_x", { NN / tilex_oi, tilex_oi, tilex_ii });
+  cfg.Set("tile_k", { K, 1 });
+  return cfg;
+}
+
+/*!
+* \brief Get the fallback knobs of dense_nopack, tile_y, tile_x and tile_k.
+* The innermost tile_k factor is the vector length of the reduction.
+*
+* \param target The x86 target
+* \param M The batch size, or -1 when it is not a constant
+* \param N The output dimension
+* \param K The input dimension
+*
+* \return The fallback config
+*/
+inline detail::ScheduleConfig default_dense_nopack_config(const Target& target,
+                                                          int M, int N, int K) {
+  if (M < 0) {
+    M = 16;
+  }
+  int tilek_bn = detail::GetMaxFactor(K, GetFp32Len(target) * 2);
+  detail::ScheduleConfig cfg;
+  cfg.Set("tile_y", { 1, M });
+  cfg.Set("tile_x", { N, 1 });
+  cfg.Set("tile_k", { K / tilek_bn, tilek_bn });
+  return cfg;
+}
+
+/*!
+* \brief Dense with the weight packed into blocks of tile_x[-1] output
+* channels, so that the inner loop streams through a contiguous block.
+*
+* \param target The x86 target
+* \param data Tensor with shape [batch, in_dim]
+* \param weight Tensor with shape [out_dim, in_dim]
+* \param bias Tensor with shape [out_dim]. Optional; to omit bias, pass Tensor()
+* \param out_dtype Output data type. Used for mixed precision.
+* \param cfg The knobs of the schedule, see default_dense_pack_config
+*
+* \return Tensor with shape [batch, out_dim]
+*/
+inline Tensor dense_pack(const Target& target,
+                         const Tensor& data,
+                         const Tensor& weight,
+                         const Tensor& bias,
+                         const DataType& out_dtype,
+                         const detail::ScheduleConfig& cfg = detail::ScheduleConfig()) {
+  auto batch = data->shape[0];
+  int M = detail::IsConstInt(batch) ? static_cast<int>(detail::GetConstInt(batch)) : -1;
+  int N = static_cast<int>(detail::GetConstInt(weight->shape[0]));
+  int K = static_cast<int>(detail::GetConstInt(weight->shape[1]));
+  auto fallback = default_dense_pack_config(target, M, N, K);
+  int bn = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_x"));
+  CHECK_EQ(N % bn, 0) << "tile_x[-1] must divide the output dimension";
+
+  auto packed_weight = tvm::compute(
+    { N / bn, K, bn },
+    [&](Var z, Var y, Var x) {
+      return weight(z * bn + x, y);
+    }, "packed_weight");
+
+  auto k = tvm::reduce_axis(Range(0, K), "k");
+  auto matmul = tvm::compute(
+    { batch, N },
+    [&](Var y, Var x) {
+      return tvm::sum(tvm::cast(out_dtype, data(y, k)) *
+                      tvm::cast(out_dtype, packed_weight(indexdiv(x, bn), k, indexmod(x, bn))),
+                      { k });
+    }, "tensor", "dense_pack");
+
+  if (bias.defined()) {
+    matmul = tvm::compute(
+      { batch, N },
+      [&](Var i, Var j) {
+        return matmul(i, j) + tvm::cast(out_dtype, bias(j));
+      }, "tensor", kBroadcast);
+  }
+  return matmul;
+}
+
+/*!
+* \brief Dense which keeps the weight layout and vectorizes the reduction
+* in chunks of tile_k[-1], for small batches where packing does not pay off.
+*
+* \param target The x86 target
+* \param data Tensor with shape [batch, in_dim]
+* \param weight Tensor with shape [out_dim, in_dim]
+* \param bias Tensor with shape [out_dim]. Optional; to omit bias, pass Tensor()
+* \param out_dtype Output data type. Used for mixed precision.
+* \param cfg The knobs of the schedule, see default_dense_nopack_config
+*
+* \return Tensor with shape [batch, out_dim]
+*/
+inline Tensor dense_nopack(const Target& target,
+                           const Tensor& data,
+                           const Tensor& weight,
+                           const Tensor& bias,
+                           const DataType& out_dtype,
+                           const detail::ScheduleConfig& cfg = detail::ScheduleConfig()) {
+  auto batch = data->shape[0];
+  int M = detail::IsConstInt(batch) ? static_cast<int>(detail::GetConstInt(batch)) : -1;
+  int N = static_cast<int>(detail::GetConstInt(weight->shape[0]));
+  int K = static_cast<int>(detail::GetConstInt(weight->shape[1]));
+  auto fallback = default_dense_nopack_config(target, M, N, K);
+  int vec = detail::InnerFactor(detail::GetKnob(cfg, fallback, "tile_k"));
+  CHECK_EQ(K % vec, 0) << "tile_k[-1] must divide the input dimension";
+
+  auto k = tvm::reduce_axis(Range(0, K / vec), "k");
+  auto partial = tvm::compute(
+    { batch, N, vec },
+    [&](Var z, Var y, Var x) {
+      return tvm::sum(tvm::cast(out_dtype, data(z, k * vec + x)) *
+                      tvm::cast(out_dtype, weight(y, k * vec + x)), { k });
+    }, "tensor_partial");
+
+  auto kk = tvm::reduce_axis(Range(0, vec), "kk");
+  auto matmul = tvm::compute(
+    { batch, N },
+    [&](Var y, Var x) {
+      return tvm::sum(partial(y, x, kk), { kk });
+    }, "tensor", "dense_nopack");
+
+  if (bias.defined()) {
+    matmul = tvm::compute(
+      { batch, N },
+      [&](Var i, Var j) {
+        return matmul(i, j) + tvm::cast(out_dtype, bias(j));
+      }, "tensor", kBroadcast);
+  }
+  return matmul;
+}
+
+/*!
+* \brief Implementation of dense for x86 backend. Batches of up to 16 rows
+* and dynamic batches use dense_nopack, larger batches use dense_pack.
+*
+* \param target The target device
+* \param data Tensor with shape [batch, in_dim]
+* \param weight Tensor with shape [out_dim, in_dim]
+* \param bias Tensor with shape [out_dim]. Optional; to omit bias, pass Tensor()
+* \param out_dtype Output data type. Used for mixed precision.
+* \param cfg The knobs of the schedule
+*
+* \return Tensor with shape [batch, out_dim]
+*/
+inline Tensor dense_x86(const Target& target,
+                        const Tensor& data,
+                        const Tensor& weight,
+                        const Tensor& bias,
+                        const DataType& out_dtype,
+                        const detail::ScheduleConfig& cfg = detail::ScheduleConfig()) {
+  CHECK_EQ(data->shape.size(), 2) << "dense requires 2-D data";
+  CHECK_EQ(weight->shape.size(), 2) << "dense requires 2-D weight";
+  if (bias.defined()) {
+    CHECK_EQ(bias->shape.size(), 1) << "dense requires 1-D bias";
+  }
+  auto batch = data->shape[0];
+  if (!detail::IsConstInt(batch) || detail::GetConstInt(batch) <= 16) {
+    return dense_nopack(target, data, weight, bias, out_dtype, cfg);
+  }
+  return dense_pack(target, data, weight, bias, out_dtype, cfg);
+}
+
+/*!
+* \brief Create an x86 schedule for dense
+*
+* \param target The target to generate a schedule for.
+* \param outs The output tensors.
+* \param cfg The knobs of the schedule. Must be the config dense_x86 was
+* called with.
+*
+* \return A schedule for the given ops.
+*/
+inline Schedule schedule_dense(const Target &target, const Array<Tensor>& outs,
+                               const detail::ScheduleConfig& cfg = detail::ScheduleConfig()) {
+  Array<Operation> out_ops;
+  for (auto t : outs) {
+    out_ops.push_back(t->op);
+  }
+  auto s = create_schedule(out_ops);
+
+  auto _schedule_pack = [&](const Tensor& C) {
+    auto A = C->op->InputTensors()[0];
+    auto packed = C->op->InputTensors()[1];
+    int M = detail::IsConstInt(A->shape[0]) ? static_cast<int>(detail::GetConstInt(A->shape[0]))
+                                            : -1;
+    int N = static_cast<int>(detail::GetConstInt(C->shape[1]));
+    int K = static_cast<int>(detail::GetConstInt(A->shape[1]));
+    auto fallback = default_dense_pack_config(target, M, N, K);
+
+    auto CC = s.cache_write(C, "global");
+    auto y = C->op.as<ComputeOpNode>()->axis[0];
+    auto x = C->op.as<ComputeOpNode>()->axis[1];
+    auto ys = detail::ApplySplit(s[C], y, detail::GetKnob(cfg, fallback, "tile_y"));
+    auto xs = detail::ApplySplit(s[C], x, detail::GetKnob(cfg, fallback, "tile_x"));
+    CHECK(ys.size() == 3 && xs.size() == 3) << "tile_y and tile_x must have three factors";
+    s[C].reorder({ ys[0], xs[0], ys[1], xs[1], ys[2], xs[2] });
+    auto xyt = detail::Fuse(s[C], { ys[0], xs[0] });
+    s[C].parallel(xyt);
+    auto xyo = detail::Fuse(s[C], { ys[1], xs[1] });
+    s[C].unroll(ys[2]);
+    s[C].vectorize(xs[2]);
+
+    s[CC].compute_at(s[C], xyo);
+    auto cy = CC->op.as<ComputeOpNode>()->axis[0];
+    auto cx = CC->op.as<ComputeOpNode>()->axis[1];
+    auto k = CC->op.as<ComputeOpNode>()->reduce_axis[0];
+    auto ks = detail::ApplySplit(s[CC], k, detail::GetKnob(cfg, fallback, "tile_k"));
+    CHECK_EQ(ks.size(), 2) << "tile_k must have two factors";
+    s[CC].reorder({ ks[0], ks[1], cy, cx });
+    s[CC].vectorize(cx);
+    s[CC].unroll(cy);
+    s[CC].unroll(ks[1]);
+
+    auto pz = packed->op.as<ComputeOpNode>()->axis[0];
+    auto py = packed->op.as<ComputeOpNode>()->axis[1];
+    auto px = packed->op.as<ComputeOpNode>()->axis[2];
+    s[packed].reorder({ pz, px, py });
+    s[packed].parallel(pz);
+    s[packed].vectorize(py);
+  };
+
+  auto _schedule_nopack = [&](const Tensor& C) {
+    auto CC = C->op->InputTensors()[0];
+    int M = detail::IsConstInt(C->shape[0]) ? static_cast<int>(detail::GetConstInt(C->shape[0]))
+                                            : -1;
+    int N = static_cast<int>(detail::GetConstInt(C->shape[1]));
+    int vec = static_cast<int>(detail::GetConstInt(CC->shape[2]));
+    auto K = static_cast<int>(detail::GetConstInt(
+      CC->op.as<ComputeOpNode>()->reduce_axis[0]->dom->extent)) * vec;
+    auto fallback = default_dense_nopack_config(target, M, N, K);
+
+    auto y = C->op.as<ComputeOpNode>()->axis[0];
+    auto x = C->op.as<ComputeOpNode>()->axis[1];
+    auto kk = C->op.as<ComputeOpNode>()->reduce_axis[0];
+    auto ys = detail::ApplySplit(s[C], y, detail::GetKnob(cfg, fallback, "tile_y"));
+    auto xs = detail::ApplySplit(s[C], x, detail::GetKnob(cfg, fallback, "tile_x"));
+    CHECK(ys.size() == 2 && xs.size() == 2) << "tile_y and tile_x must have two factors";
+    s[C].reorder({ ys[0], xs[0], ys[1], xs[1] });
+    auto xyo = detail::Fuse(s[C], { ys[0], xs[0] });
+    s[C].parallel(xyo);
+    s[C].unroll(kk);
+
+    s[CC].compute_at(s[C], xyo);
+    auto cz = CC->op.as<ComputeOpNode>()->axis[0];
+    auto cy = CC->op.as<ComputeOpNode>()->axis[1];
+    auto cx = CC->op.as<ComputeOpNode>()->axis[2];
+    auto k = CC->op.as<ComputeOpNode>()->reduce_axis[0];
+    auto yz = detail::Fuse(s[CC], { cz, cy });
+    s[CC].reorder({ k, yz, cx });
+    s[CC].unroll(yz);
+    s[CC].vectorize(cx);
+  };
+
+  std::function<void(Operation)> traverse;
+  traverse = [&](const Operation& op) {
+    // Inline all one-to-one-mapping operators except the last stage (output)
+    if (is_broadcast(op->tag)) {
+      if (!detail::contains(s->outputs, op)) {
+        s[op].compute_inline();
+      }
+      for (auto tensor : op->InputTensors()) {
+        if (tensor->op->InputTensors().size() > 0) {
+          traverse(tensor->op);
+        }
+      }
+    } else if (op->tag == "dense_pack") {
+      _schedule_pack(op.output(0));
+    } else if (op->tag == "dense_nopack") {
+      _schedule_nopack(op.output(0));
+    } else if (op->tag == "dense") {
+      auto C = op.output(0);
+      s[C].parallel(C->op.as<ComputeOpNode>()->axis[0]);
+    } else {
+      LOG(ERROR) << "Unsupported operator " << op->tag;
+    }
+  };
+
+  traverse(outs[0]->op);
+  return s;
+}
+
+}  // namespace x86
+}  // namespace topi
+#endif  // TOPI_X86_DENSE_H_
@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file x86/util.h
+ * \brief Common x86 related utilities
+ */
+#ifndef TOPI_X86_UTIL_H_
+#define TOPI_X86_UTIL_H_
+
+#include <string>
+
+#include "tvm/build_module.h"
+
+namespace topi {
+using namespace tvm;
+
+namespace x86 {
+/*!
+* \brief Get the number of fp32 lanes of the vector registers of a target
+*
+* \param target The x86 target
+*
+* \return 16 for the AVX512 targets, 8 otherwise
+*/
+inline int GetFp32Len(const Target& target) {
+  if (target.defined()) {
+    for (const auto& opt : target->options()) {
+      if (opt == "-mcpu=skylake-avx512" || opt == "-mcpu=cascadelake") {
+        return 16;
+      }
+    }
+  }
+  return 8;
+}
+
+}  // namespace x86
+}  // namespace topi
+#endif  // TOPI_X86_UTIL_H_
@@ -33,6 +33,7 @@ from .depthwise_conv2d import schedule_depthwise_conv2d_NCHWc
 from .dense import _schedule_dense, _schedule_dense_pack, _schedule_dense_nopack
 from .batch_matmul import schedule_batch_matmul
 from .roi_align import roi_align_nchw
+from .nms import get_valid_counts_cpu, non_max_suppression_cpu
 from .conv2d_transpose import _schedule_conv2d_transpose_nchw
 from .sparse import *
 from .conv2d_alter_op import *
@@ -18,9 +18,12 @@
 """x86 batch_matmul operators"""
 from __future__ import absolute_import as _abs
 import tvm
+from tvm import relay
 from tvm import autotvm
 from tvm.autotvm.task.space import SplitEntity
 from tvm.contrib import cblas
+from .conv2d_int8 import _is_int8_hw_support
+from .dense import _dense_legalize
 from .. import generic, nn
 from ..util import traverse_inline, get_const_tuple, get_max_power2_factor
 
@@ -137,3 +140,49 @@ def _default_batch_matmul_nopack_config(cfg, M, N, K):
     cfg["tile_x"] = SplitEntity([N // x_bn, x_bn])
     y_bn = get_max_power2_factor(M, 8)
     cfg["tile_y"] = SplitEntity([M // y_bn, y_bn])
+
+
+@nn.batch_matmul_legalize.register("cpu")
+def _batch_matmul_legalize(attrs, inputs, arg_types):
+    """Legalizes int8 batch_matmul into an int8 dense per batch, which runs on
+    the uint8 x int8 dot-product instructions.
+
+    Parameters
+    ----------
+    attrs : tvm.attrs.Attrs
+        Attributes of current batch_matmul
+    inputs : list of tvm.relay.Expr
+        The args of the Relay expr to be legalized
+    types : list of types
+        List of input and output types
+
+    Returns
+    -------
+    result : tvm.relay.Expr
+        The legalized expr
+    """
+    x_tensor, y_tensor, output_tensor = arg_types
+    if output_tensor.dtype != "int32" or \
+            not _is_int8_hw_support("uint8", "int8") or \
+            (x_tensor.dtype, y_tensor.dtype) not in \
+            (("uint8", "int8"), ("int8", "int8"), ("uint8", "uint8")):
+        return None
+    shape = list(x_tensor.shape) + [y_tensor.shape[1]]
+    if not all(isinstance(dim, tvm.expr.IntImm) for dim in shape):
+        return None
+    batch, M, K, N = [dim.value for dim in shape]
+    x, y = inputs
+    xs = relay.split(x, batch, axis=0)
+    ys = relay.split(y, batch, axis=0)
+    outs = []
+    for b in range(batch):
+        x_b = relay.reshape(xs[b], (M, K))
+        y_b = relay.reshape(ys[b], (N, K))
+        out = relay.nn.dense(x_b, y_b, out_dtype="int32")
+        # the dense legalization shifts the dtypes and pads the units.
+        types = [relay.TensorType((M, K), x_tensor.dtype),
+                 relay.TensorType((N, K), y_tensor.dtype),
+                 relay.TensorType((M, N), "int32")]
+        legalized = _dense_legalize(out.attrs, [x_b, y_b], types)
+        outs.append(out if legalized is None else legalized)
+    return relay.stack(outs, axis=0)
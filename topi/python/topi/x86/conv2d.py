@@ -32,7 +32,7 @@ from ..nn.depthwise_conv2d import _get_workload as _get_depthwise_conv2d_workloa
 from ..nn.pad import pad
 from ..util import get_const_tuple
 
-from . import conv2d_avx_1x1, conv2d_avx_common
+from . import conv2d_avx_1x1, conv2d_avx_common, conv2d_chain
 
 logger = logging.getLogger('topi')
 
@@ -221,7 +221,7 @@ def schedule_conv2d(cfg, outs):
                 if isinstance(tensor.op, tvm.tensor.ComputeOp) and tensor.op not in scheduled_ops:
                     traverse(tensor.op)
 
-        if 'conv2d_nchw' in op.tag:
+        if 'conv2d_nchw' in op.tag and 'depthwise' not in op.tag:
             output = op.output(0)
             conv_out = op.input_tensors[0]
             kernel_vec = conv_out.op.input_tensors[1]
@@ -238,7 +238,11 @@ def schedule_conv2d(cfg, outs):
             _, _, kh, kw = get_const_tuple(kernel.shape)
             is_kernel_1x1 = kh == 1 and kw == 1
             args = [s, cfg, data, data_pad, data_vec, kernel_vec, conv_out, output, outs[0]]
-            if is_kernel_1x1:
+            # conv2d chain fused by relay, see conv2d_chain.py
+            chain = conv2d_chain.find_fused_producer(data)
+            if chain is not None:
+                conv2d_chain.schedule_conv_chain(*(args + list(chain)))
+            elif is_kernel_1x1:
                 conv2d_avx_1x1._schedule_conv(*args)
             else:
                 conv2d_avx_common._schedule_conv(*args)
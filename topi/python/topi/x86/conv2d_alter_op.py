@@ -87,7 +87,9 @@ def _alter_conv2d_layout(attrs, inputs, tinfo, F):
 
     cfg = dispatch_ctx.query(target, workload)
     if cfg.is_fallback:
-        if _is_int8_hw_support(data_dtype, kernel_dtype):
+        # depthwise convs have no reduction over channels for the int8 dot product,
+        # they use the widening NCHWc schedule.
+        if _is_int8_hw_support(data_dtype, kernel_dtype) and not is_depthwise:
             _get_default_config_int8(cfg, data_tensor, kernel_tensor, strides, padding, out_dtype,
                                      is_depthwise, data_layout)
         else:
@@ -196,10 +198,10 @@ def _conv2d_legalize(attrs, inputs, arg_types):
     if not (dilation[0] == 1 and dilation[1] == 1):
         return None
 
-    # No legalization for depthwise convolutions yet.
+    # Grouped convolutions are legalized one group at a time.
     groups = attrs.get_int("groups")
     if groups != 1:
-        return None
+        return _group_conv2d_legalize(attrs, inputs, arg_types)
 
     # Collect the input tensors.
     data_tensor, kernel_tensor = arg_types[0], arg_types[1]
@@ -315,3 +317,45 @@ def _conv2d_legalize(attrs, inputs, arg_types):
 
         return out
     return None
+
+
+def _group_conv2d_legalize(attrs, inputs, arg_types):
+    """Splits an int8 grouped convolution into a convolution per group, so that each
+    group is legalized as above and runs on the uint8 x int8 dot-product instructions.
+    Depthwise convolutions have no reduction over channels and are left alone.
+    """
+    if attrs['data_layout'] != 'NCHW' or attrs['kernel_layout'] != 'OIHW':
+        return None
+    data_tensor, kernel_tensor, output_tensor = arg_types
+    if data_tensor.dtype not in ('int8', 'uint8') or \
+            not _is_int8_hw_support('uint8', kernel_tensor.dtype):
+        return None
+    shapes = [data_tensor.shape, kernel_tensor.shape, output_tensor.shape]
+    if not all(isinstance(dim, tvm.expr.IntImm) for shape in shapes for dim in shape):
+        return None
+    groups = attrs.get_int("groups")
+    batch_size, _, height, width = get_const_tuple(data_tensor.shape)
+    out_channel, group_in_channel, kh, kw = get_const_tuple(kernel_tensor.shape)
+    _, _, out_height, out_width = get_const_tuple(output_tensor.shape)
+    if group_in_channel == 1:
+        return None
+    group_out_channel = out_channel // groups
+
+    data, kernel = inputs
+    datas = relay.split(data, groups, axis=1)
+    kernels = relay.split(kernel, groups, axis=0)
+    new_attrs = {k: attrs[k] for k in attrs.keys()}
+    new_attrs['groups'] = 1
+    new_attrs['channels'] = group_out_channel
+    outs = []
+    for g in range(groups):
+        out = relay.nn.conv2d(datas[g], kernels[g], **new_attrs)
+        types = [relay.TensorType((batch_size, group_in_channel, height, width),
+                                  data_tensor.dtype),
+                 relay.TensorType((group_out_channel, group_in_channel, kh, kw),
+                                  kernel_tensor.dtype),
+                 relay.TensorType((batch_size, group_out_channel, out_height, out_width),
+                                  output_tensor.dtype)]
+        legalized = _conv2d_legalize(out.attrs, [datas[g], kernels[g]], types)
+        outs.append(out if legalized is None else legalized)
+    return relay.concatenate(outs, axis=1)
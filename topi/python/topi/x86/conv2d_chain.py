@@ -0,0 +1,199 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=invalid-name,unused-variable,unused-argument
+"""Schedule of fused conv2d chains on x86.
+
+Relay fuses a conv2d into the conv2d consuming its output when building with
+opt_level=4. The consumer is computed in bands of output rows, and for each band
+the producer computes the rows it needs (plus the halo of the consumer kernel)
+into a scratch buffer sized to stay in L2, instead of writing the whole
+intermediate feature map to memory.
+"""
+from __future__ import absolute_import as _abs
+import tvm
+
+from .. import tag
+from ..nn.util import infer_pad, infer_stride
+from ..util import get_const_tuple
+from .util import get_fp32_len
+
+# Budget of the per-band intermediate buffer, in bytes.
+L2_SCRATCH_BYTES = 256 * 1024
+
+
+def find_fused_producer(data):
+    """Find the conv2d producing the input of a conv2d in the same fused function.
+
+    Parameters
+    ----------
+    data : tvm.Tensor
+        The (unpadded) input of the consumer conv2d.
+
+    Returns
+    -------
+    result : tuple of (tvm.Tensor, list of tvm.Operation) or None
+        The producer conv2d output and the elementwise ops in between,
+        None if the input is not produced by a conv2d.
+    """
+    epilogue = []
+    t = data
+    while isinstance(t.op, tvm.tensor.ComputeOp):
+        if 'conv2d_nchw' in t.op.tag:
+            return t, epilogue
+        if not tag.is_broadcast(t.op.tag):
+            return None
+        # follow the only elementwise path back to the producer, e.g. conv + bias + relu;
+        # injective operands such as the expanded bias are left to the caller.
+        computed = [x for x in t.op.input_tensors
+                    if isinstance(x.op, tvm.tensor.ComputeOp) and
+                    ('conv2d_nchw' in x.op.tag or tag.is_broadcast(x.op.tag))]
+        if len(computed) != 1:
+            return None
+        epilogue.append(t.op)
+        t = computed[0]
+    return None
+
+
+def _band_height(out_height, in_row_bytes, stride, kernel_height):
+    """Largest band of output rows whose input rows fit the scratch budget"""
+    for oh_factor in range(out_height, 0, -1):
+        if out_height % oh_factor != 0:
+            continue
+        rows = (oh_factor - 1) * stride + kernel_height
+        if rows * in_row_bytes <= L2_SCRATCH_BYTES:
+            return oh_factor
+    return 1
+
+
+def _schedule_producer(s, producer, stage, axis):
+    """Compute the producer conv2d per band of the consumer"""
+    simd_width = get_fp32_len()
+    if 'depthwise_conv2d_nchw' in producer.op.tag:
+        data_pad, kernel = producer.op.input_tensors
+        if isinstance(data_pad.op, tvm.tensor.ComputeOp) and 'pad' in data_pad.op.tag:
+            s[data_pad].compute_inline()
+        if isinstance(kernel.op, tvm.tensor.ComputeOp) and 'dilate' in kernel.op.tag:
+            s[kernel].compute_inline()
+        s[producer].compute_at(stage, axis)
+        _, c, h, w = s[producer].op.axis
+        di, dj = s[producer].op.reduce_axis
+        w_outer, w_inner = s[producer].split(w, factor=simd_width)
+        s[producer].reorder(c, h, w_outer, di, dj, w_inner)
+        s[producer].vectorize(w_inner)
+        return
+    # the x86 NCHW conv2d: pack data, pack kernel, conv in blocked layout and unpack.
+    conv_out = producer.op.input_tensors[0]
+    data_vec, kernel_vec = conv_out.op.input_tensors
+    data_pad = data_vec.op.input_tensors[0]
+    if isinstance(data_pad.op, tvm.tensor.ComputeOp) and 'pad' in data_pad.op.tag:
+        s[data_pad].compute_inline()
+    kernel = kernel_vec.op.input_tensors[0]
+    if isinstance(kernel.op, tvm.tensor.ComputeOp) and 'dilate' in kernel.op.tag:
+        s[kernel].compute_inline()
+    # unpacking is folded into the packing of the consumer input.
+    s[producer].compute_inline()
+    s[data_vec].compute_at(stage, axis)
+    s[conv_out].compute_at(stage, axis)
+    _, oc_chunk, oh, ow, oc_block = s[conv_out].op.axis
+    ic, kh, kw = s[conv_out].op.reduce_axis
+    s[conv_out].reorder(oc_chunk, oh, ic, kh, kw, ow, oc_block)
+    s[conv_out].vectorize(oc_block)
+    # weights are packed once, outside of the bands.
+    oc_chunk, ic_chunk, oh, ow, ic_block, oc_block = s[kernel_vec].op.axis
+    s[kernel_vec].reorder(oc_chunk, oh, ic_chunk, ow, ic_block, oc_block)
+    if get_const_tuple(kernel_vec.shape)[-1] > 1:
+        s[kernel_vec].vectorize(oc_block)
+    s[kernel_vec].parallel(s[kernel_vec].fuse(oc_chunk, oh))
+
+
+def schedule_conv_chain(s, cfg, data, data_pad, data_vec, kernel_vec,
+                        conv_out, output, last, producer, epilogue):
+    """Schedule a NCHW conv2d whose input is produced by a fused conv2d
+
+    Parameters
+    ----------
+    s : tvm.schedule.Schedule
+        The schedule to update.
+    cfg : ConfigEntity
+        The config of the consumer conv2d.
+    data, data_pad, data_vec, kernel_vec, conv_out, output : tvm.Tensor
+        The stages of the consumer conv2d.
+    last : tvm.Tensor
+        The output of the fused function.
+    producer : tvm.Tensor
+        The output of the producer conv2d.
+    epilogue : list of tvm.Operation
+        The elementwise ops between the producer and the consumer.
+    """
+    ic_bn, oc_bn, reg_n = (cfg["tile_ic"].size[-1], cfg["tile_oc"].size[-1],
+                           cfg["tile_ow"].size[-1])
+    HPAD, WPAD = infer_pad(data, data_pad)
+    if HPAD != 0 or WPAD != 0:
+        s[data_pad].compute_inline()
+    for op in epilogue:
+        s[op].compute_inline()
+
+    kernel = kernel_vec.op.input_tensors[0]
+    stride, _ = infer_stride(data_pad if data_pad is not None else data, kernel, output)
+    _, in_channel, _, in_width = get_const_tuple(data.shape)
+    _, _, kernel_height, _ = get_const_tuple(kernel.shape)
+    _, _, out_height, _ = get_const_tuple(output.shape)
+    in_row_bytes = in_channel * (in_width + 2 * WPAD) * 4
+    oh_factor = _band_height(out_height, in_row_bytes, stride, kernel_height)
+
+    # schedule kernel pack
+    W = kernel_vec
+    oc_chunk, ic_chunk, oh, ow, ic_block, oc_block = s[W].op.axis
+    s[W].reorder(oc_chunk, oh, ic_chunk, ow, ic_block, oc_block)
+    if oc_bn > 1:
+        s[W].vectorize(oc_block)
+    s[W].parallel(s[W].fuse(oc_chunk, oh))
+
+    C, O0, O = conv_out, output, last
+    if O0 != O:
+        s[O0].compute_inline()
+    # bands of output rows are the unit of parallelism and of fusion.
+    batch, oc, oh, ow = s[O].op.axis
+    oh_outer, oh_inner = s[O].split(oh, factor=oh_factor)
+    oc_chunk, oc_block = s[O].split(oc, factor=oc_bn)
+    ow_chunk, ow_block = s[O].split(ow, factor=reg_n)
+    s[O].reorder(batch, oh_outer, oc_chunk, oh_inner, ow_chunk, ow_block, oc_block)
+    band = s[O].fuse(batch, oh_outer)
+    s[O].parallel(band)
+    s[O].vectorize(oc_block)
+
+    # the packed consumer input holds the band of the intermediate with its halo.
+    s[data_vec].compute_at(s[O], band)
+    _schedule_producer(s, producer, s[O], band)
+
+    CC = s.cache_write(C, 'global')
+    s[C].compute_at(s[O], oc_chunk)
+    _, c_oc_chunk, c_oh, c_ow, c_oc_block = s[C].op.axis
+    c_ow_chunk, c_ow_block = s[C].split(c_ow, factor=reg_n)
+    s[C].reorder(c_oc_chunk, c_oh, c_ow_chunk, c_ow_block, c_oc_block)
+    s[C].vectorize(c_oc_block)
+
+    s[CC].compute_at(s[C], c_ow_chunk)
+    _, cc_oc_chunk, cc_oh, cc_ow, cc_oc_block = s[CC].op.axis
+    ic, kh, kw = s[CC].op.reduce_axis
+    cc_ow_chunk, cc_ow_block = s[CC].split(cc_ow, factor=reg_n)
+    ic_chunk, ic_block = s[CC].split(ic, factor=ic_bn)
+    s[CC].reorder(cc_oc_chunk, cc_oh, cc_ow_chunk, ic_chunk, kh, kw,
+                  ic_block, cc_ow_block, cc_oc_block)
+    s[CC].vectorize(cc_oc_block)
+    s[CC].unroll(cc_ow_block)
+    return s
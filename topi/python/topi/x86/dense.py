@@ -18,11 +18,14 @@
 """x86 dense operators"""
 from __future__ import absolute_import as _abs
 import tvm
+from tvm import relay
 from tvm import autotvm
 from tvm.autotvm.task.space import SplitEntity
 from tvm.contrib import cblas
 
 from .util import get_fp32_len
+from .conv2d_int8 import _is_int8_hw_support
+from .tensor_intrin import dot_16x1x16_uint8_int8_int32
 from .. import generic, tag, nn
 from ..util import traverse_inline, get_const_tuple
 
@@ -43,6 +46,11 @@ def _declaration_dense(cfg, data, weight, bias=None, out_dtype=None):
     if isinstance(M, tvm.expr.Var):
         return _declaration_dense_nopack(cfg, data, weight, bias, out_dtype)
 
+    N, _ = get_const_tuple(weight.shape)
+    if out_dtype == "int32" and N % 16 == 0 and \
+            _is_int8_hw_support(data.dtype, weight.dtype):
+        return _declaration_dense_int8(cfg, data, weight, bias, out_dtype)
+
     # For small batch sizes, don't pack weight into cache-friendly layout
     # because of overhead in packing and limited reuse from batch dimension
     # TODO(icemelon9): use a more systematic way to determine which schedule to use
@@ -117,6 +125,54 @@ def _declaration_dense_nopack(cfg, data, weight, bias=None, out_dtype=None):
     return C
 
 
+# Declare uint8 x int8 dense accumulating in int32 for the AVX512 dot-product intrinsics
+@autotvm.register_topi_compute(nn.dense, "cpu", "direct_int8")
+def _declaration_dense_int8(cfg, data, weight, bias=None, out_dtype=None):
+    if out_dtype is None:
+        out_dtype = "int32"
+    assert out_dtype == "int32", "int8 dense only accumulates in int32"
+    M, K = get_const_tuple(data.shape)
+    N, _ = get_const_tuple(weight.shape)
+    # 16 int32 lanes per output vector, 4 int8 elements reduced per lane.
+    int32_lanes, num_int8_elements = 16, 4
+    assert N % int32_lanes == 0, "int8 dense needs a multiple of 16 output units"
+    KP = (K + num_int8_elements - 1) // num_int8_elements * num_int8_elements
+    # create tuning space
+    cfg.define_split("tile_y", M, num_outputs=2)
+    cfg.define_split("tile_x", N, num_outputs=2,
+                     filter=lambda x: x.size[-1] % int32_lanes == 0)
+    if cfg.is_fallback:
+        _default_dense_int8_config(cfg, M, N)
+
+    if KP != K:
+        data = tvm.compute((M, KP), lambda y, k: tvm.if_then_else(
+            k < K, data[y, k], tvm.const(0, data.dtype)), name="data_pad")
+    # (N, K) -> (N/16, K/4, 16, 4), the reduction axis is zero padded
+    packw = tvm.compute(
+        (N // int32_lanes, KP // num_int8_elements, int32_lanes, num_int8_elements),
+        lambda z, y, x, w: tvm.if_then_else(
+            y * num_int8_elements + w < K,
+            weight[z * int32_lanes + x, tvm.min(y * num_int8_elements + w, K - 1)],
+            tvm.const(0, weight.dtype)),
+        name="packed_weight")
+
+    idxdiv = tvm.indexdiv
+    idxmod = tvm.indexmod
+    ko = tvm.reduce_axis((0, KP // num_int8_elements), name="ko")
+    ki = tvm.reduce_axis((0, num_int8_elements), name="ki")
+    C = tvm.compute((M, N),
+                    lambda y, x: tvm.sum(
+                        data[y, ko * num_int8_elements + ki].astype(out_dtype) *
+                        packw[idxdiv(x, int32_lanes), ko, idxmod(x, int32_lanes),
+                              ki].astype(out_dtype),
+                        axis=[ko, ki]),
+                    tag="dense_int8")
+    if bias is not None:
+        C = tvm.compute((M, N), lambda i, j: C[i, j] + bias[j].astype(out_dtype),
+                        tag=tag.BROADCAST)
+    return C
+
+
 @autotvm.register_topi_schedule(generic.schedule_dense, "cpu", "direct")
 def _schedule_dense(cfg, outs):
     target = tvm.target.current_target()
@@ -130,6 +186,8 @@ def _schedule_dense(cfg, outs):
             _schedule_dense_pack_template(cfg, s, op.output(0))
         elif 'dense_nopack' in op.tag:
             _schedule_dense_nopack_template(cfg, s, op.output(0))
+        elif "dense_int8" in op.tag:
+            _schedule_dense_int8_template(cfg, s, op.output(0), outs[0])
     traverse_inline(s, outs[0].op, _callback)
     return s
 
@@ -164,6 +222,17 @@ def _schedule_dense_nopack(cfg, outs):
     return s
 
 
+@autotvm.register_topi_schedule(generic.schedule_dense, "cpu", "direct_int8")
+def _schedule_dense_int8(cfg, outs):
+    s = tvm.create_schedule([x.op for x in outs])
+
+    def _callback(op):
+        if "dense_int8" in op.tag:
+            _schedule_dense_int8_template(cfg, s, op.output(0), outs[0])
+    traverse_inline(s, outs[0].op, _callback)
+    return s
+
+
 def _schedule_dense_pack_template(cfg, s, C):
     A, packedB = s[C].op.input_tensors
 
@@ -216,6 +285,57 @@ def _schedule_dense_nopack_template(cfg, s, C):
     return s
 
 
+def _schedule_dense_int8_template(cfg, s, C, O):
+    A, packedB = s[C].op.input_tensors
+    int32_lanes = 16
+
+    # the epilogue (bias, requantize, ...) is computed on the accumulator tile.
+    CC = s.cache_write(C, "global")
+    if C != O:
+        s[C].compute_inline()
+    y, x = s[O].op.axis
+    yo, yi = cfg["tile_y"].apply(s, O, y)
+    xo, xi = cfg["tile_x"].apply(s, O, x)
+    s[O].reorder(yo, xo, yi, xi)
+    xyo = s[O].fuse(yo, xo)
+    s[O].parallel(xyo)
+    xi_o, xi_i = s[O].split(xi, factor=int32_lanes)
+    s[O].vectorize(xi_i)
+
+    s[CC].compute_at(s[O], xyo)
+    y, x = s[CC].op.axis
+    ko, ki = s[CC].op.reduce_axis
+    x_o, x_i = s[CC].split(x, factor=int32_lanes)
+    s[CC].reorder(ko, y, x_o, x_i, ki)
+    s[CC].tensorize(x_i, dot_16x1x16_uint8_int8_int32())
+    s[CC].unroll(y)
+    s[CC].unroll(x_o)
+
+    if isinstance(A.op, tvm.tensor.ComputeOp) and A.op.name == "data_pad":
+        y, k = s[A].op.axis
+        s[A].parallel(y)
+    z, y, x, w = s[packedB].op.axis
+    s[packedB].parallel(z)
+    s[packedB].vectorize(s[packedB].fuse(x, w))
+    return s
+
+
+def _default_dense_int8_config(cfg, M, N):
+    # Keep the accumulator tile in the 32 AVX512 registers.
+    tilex_i = 16
+    for bn in (64, 48, 32):
+        if N % bn == 0:
+            tilex_i = bn
+            break
+    tiley_i = 1
+    for bn in (8, 6, 4, 2):
+        if M % bn == 0 and bn * tilex_i // 16 <= 24:
+            tiley_i = bn
+            break
+    cfg["tile_y"] = SplitEntity([M // tiley_i, tiley_i])
+    cfg["tile_x"] = SplitEntity([N // tilex_i, tilex_i])
+
+
 def _default_dense_pack_config(cfg, M, N, K):
     # Generate default schedule for dynamic shape.
     if isinstance(M, tvm.expr.Var):
@@ -271,3 +391,61 @@ def _default_dense_nopack_config(cfg, M, N, K):
     cfg["tile_k"] = SplitEntity([K // tilek_bn, tilek_bn])
     cfg["tile_x"] = SplitEntity([N, 1])
     cfg["tile_y"] = SplitEntity([1, M])
+
+
+@nn.dense_legalize.register("cpu")
+def _dense_legalize(attrs, inputs, arg_types):
+    """Legalizes int8 dense for the uint8 x int8 dot-product instructions.
+
+    Parameters
+    ----------
+    attrs : tvm.attrs.Attrs
+        Attributes of current dense
+    inputs : list of tvm.relay.Expr
+        The args of the Relay expr to be legalized
+    types : list of types
+        List of input and output types
+
+    Returns
+    -------
+    result : tvm.relay.Expr
+        The legalized expr
+    """
+    data_tensor, kernel_tensor, output_tensor = arg_types
+    if output_tensor.dtype != "int32" or \
+            not _is_int8_hw_support("uint8", "int8") or \
+            (data_tensor.dtype, kernel_tensor.dtype) not in \
+            (("uint8", "int8"), ("int8", "int8"), ("uint8", "uint8")):
+        return None
+    data, kernel = inputs
+    new_attrs = {k: attrs[k] for k in attrs.keys()}
+    adjust_shift = None
+    # C = A (dense) B with int8 A is computed as (A + 128) (dense) B - 128 * sum(B)
+    if data_tensor.dtype == "int8":
+        adjust_shift = relay.sum(relay.cast(kernel, "int32"), axis=1)
+        adjust_shift = relay.multiply(adjust_shift, relay.const(128, "int32"))
+        data = relay.cast(relay.add(relay.cast(data, "int32"), relay.const(128, "int32")),
+                          "uint8")
+    # C = A (dense) B with uint8 B is computed as A (dense) (B - 128) + 128 * sum(A)
+    if kernel_tensor.dtype == "uint8":
+        adjust_shift = relay.sum(relay.cast(data, "int32"), axis=1, keepdims=True)
+        adjust_shift = relay.multiply(adjust_shift, relay.const(-128, "int32"))
+        kernel = relay.cast(relay.subtract(relay.cast(kernel, "int32"),
+                                           relay.const(128, "int32")), "int8")
+
+    # The output vectors are 16 int32 lanes wide, pad the units to a multiple of 16.
+    out_dim = kernel_tensor.shape[0].value
+    new_out_dim = (out_dim + 15) // 16 * 16
+    if new_out_dim == out_dim and adjust_shift is None:
+        return None
+    if new_out_dim != out_dim:
+        kernel = relay.nn.pad(kernel, pad_width=((0, new_out_dim - out_dim), (0, 0)))
+        new_attrs["units"] = new_out_dim
+
+    out = relay.nn.dense(data, kernel, **new_attrs)
+    if new_out_dim != out_dim:
+        original_out_shape = [x.value for x in output_tensor.shape]
+        out = relay.strided_slice(out, begin=(0, 0), end=original_out_shape)
+    if adjust_shift is not None:
+        out = relay.subtract(out, adjust_shift)
+    return out
@@ -18,6 +18,7 @@
 """x86 declaration and schedules."""
 from __future__ import absolute_import as _abs
 import tvm
+from tvm import autotvm
 from .. import generic
 
 @generic.schedule_injective_from_existing.register(["cpu"])
@@ -62,6 +63,9 @@ def schedule_injective(outs):
         The computation schedule for the op.
     """
     outs = [outs] if isinstance(outs, tvm.tensor.Tensor) else outs
+    s = autotvm.task.tuned_auto_schedule(outs)
+    if s is not None:
+        return s
     x = outs[0]
     s = tvm.create_schedule([x.op for x in outs])
     tvm.schedule.AutoInlineInjective(s)
@@ -100,6 +104,9 @@ def schedule_concatenate(outs):
                 sch[tensor].vectorize(inner_i)
 
     outs = [outs] if isinstance(outs, tvm.tensor.Tensor) else outs
+    s = autotvm.task.tuned_auto_schedule(outs)
+    if s is not None:
+        return s
     x = outs[0]
     s = tvm.create_schedule([x.op for x in outs])
     tvm.schedule.AutoInlineInjective(s)
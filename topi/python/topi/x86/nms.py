@@ -0,0 +1,97 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=invalid-name, too-many-arguments
+"""Non-maximum suppression operators for intel cpu.
+
+The boxes are processed by the runtime kernels of contrib.sort, which
+only sort the top_k boxes and run the suppression in parallel over the
+batch and the classes. The generic hybrid script versions are used when
+the runtime is built without USE_SORT or for other dtypes than float32.
+"""
+import tvm
+from tvm import api
+
+from ..vision.nms import get_valid_counts, non_max_suppression
+
+
+def _use_runtime_kernel(data, func_name):
+    return data.dtype == "float32" and \
+        tvm.get_global_func(func_name, allow_missing=True) is not None
+
+
+@get_valid_counts.register(["cpu"])
+def get_valid_counts_cpu(data, score_threshold=0, id_index=0, score_index=1):
+    """Get valid count of bounding boxes given a score threshold on cpu.
+    Also moves valid boxes to the top of input data.
+
+    See topi.vision.get_valid_counts for the parameters.
+    """
+    if not _use_runtime_kernel(data, "tvm.contrib.sort.get_valid_counts"):
+        return get_valid_counts.fdefault(data, score_threshold, id_index, score_index)
+    batch_size = data.shape[0]
+    data_buf = api.decl_buffer(data.shape, data.dtype, "data_buf", data_alignment=8)
+    valid_count_buf = api.decl_buffer((batch_size,), "int32", "valid_count_buf",
+                                      data_alignment=4)
+    out_buf = api.decl_buffer(data.shape, data.dtype, "out_buf", data_alignment=8)
+    valid_count, out_tensor = \
+        tvm.extern([(batch_size,), data.shape], [data],
+                   lambda ins, outs: tvm.call_packed(
+                       "tvm.contrib.sort.get_valid_counts", ins[0], outs[0], outs[1],
+                       float(score_threshold), id_index, score_index),
+                   dtype=["int32", data.dtype],
+                   in_buffers=[data_buf],
+                   out_buffers=[valid_count_buf, out_buf],
+                   name="get_valid_counts_cpu",
+                   tag="get_valid_counts_cpu")
+    return [valid_count, out_tensor]
+
+
+@non_max_suppression.register(["cpu"])
+def non_max_suppression_cpu(data, valid_count, max_output_size=-1,
+                            iou_threshold=0.5, force_suppress=False, top_k=-1,
+                            coord_start=2, score_index=1, id_index=0,
+                            return_indices=True, invalid_to_bottom=False):
+    """Non-maximum suppression operator for object detection on cpu.
+
+    See topi.vision.non_max_suppression for the parameters.
+    """
+    if not _use_runtime_kernel(data, "tvm.contrib.sort.nms"):
+        return non_max_suppression.fdefault(data, valid_count, max_output_size,
+                                            iou_threshold, force_suppress, top_k,
+                                            coord_start, score_index, id_index,
+                                            return_indices, invalid_to_bottom)
+    batch_size, num_anchors, _ = data.shape
+    data_buf = api.decl_buffer(data.shape, data.dtype, "data_buf", data_alignment=8)
+    valid_count_buf = api.decl_buffer(valid_count.shape, valid_count.dtype,
+                                      "valid_count_buf", data_alignment=4)
+    out_buf = api.decl_buffer(data.shape, data.dtype, "out_buf", data_alignment=8)
+    indices_buf = api.decl_buffer((batch_size, num_anchors), "int32", "indices_buf",
+                                  data_alignment=8)
+    # the indices refer to the unsorted boxes, so only the boxes are moved to the top.
+    move_to_bottom = not return_indices and invalid_to_bottom
+    out, box_indices = \
+        tvm.extern([data.shape, (batch_size, num_anchors)], [data, valid_count],
+                   lambda ins, outs: tvm.call_packed(
+                       "tvm.contrib.sort.nms", ins[0], ins[1], outs[0], outs[1],
+                       max_output_size, float(iou_threshold), int(force_suppress),
+                       top_k, coord_start, score_index, id_index, int(move_to_bottom)),
+                   dtype=[data.dtype, "int32"],
+                   in_buffers=[data_buf, valid_count_buf],
+                   out_buffers=[out_buf, indices_buf],
+                   name="nms_cpu",
+                   tag="nms_cpu")
+    return box_indices if return_indices else out
@@ -18,6 +18,7 @@
 """x86 declaration and schedules."""
 from __future__ import absolute_import as _abs
 import tvm
+from tvm import autotvm
 from .. import tag
 from .. import generic
 from ..util import get_const_tuple
@@ -74,6 +75,9 @@ def schedule_reduce(outs):
         The computation schedule for the op.
     """
     outs = [outs] if isinstance(outs, tvm.tensor.Tensor) else outs
+    sch = autotvm.task.tuned_auto_schedule(outs)
+    if sch is not None:
+        return sch
     sch = tvm.create_schedule([x.op for x in outs])
     scheduled_ops = []
 
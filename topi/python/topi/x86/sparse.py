@@ -18,16 +18,118 @@
 """sparse_dense schedule on x86"""
 import tvm
 
-from .. import generic
-from ..util import traverse_inline, get_const_int
+from .. import generic, nn
+from ..nn.sparse import _sparse_dense_csrmm
+from ..util import traverse_inline, get_const_int, get_const_tuple
 from .util import get_fp32_len
 
+# Number of vector registers used as accumulators by the BSR micro-kernel.
+BSR_ACCUMULATORS = 12
+
+
+@nn.sparse_dense.register(["cpu"])
+def sparse_dense_x86(data, weight_data, weight_indices, weight_indptr):
+    """sparse_dense on x86. CSR weights use the generic compute.
+
+    For BSR weights, the products of each block are accumulated over the
+    blocks of its row with both block dimensions kept spatial, so that the
+    schedule can keep a tile of them in registers, vectorized along the
+    contiguous dimension of the block, and reduce them once at the end.
+    """
+    if len(weight_data.shape) != 3:
+        return _sparse_dense_csrmm(data, weight_data, weight_indices, weight_indptr)
+    (m, _) = get_const_tuple(data.shape)
+    (_, bs_r, bs_c) = get_const_tuple(weight_data.shape)
+    (num_blocks_plus_1, ) = get_const_tuple(weight_indptr.shape)
+    num_blocks = num_blocks_plus_1 - 1
+
+    def _compute_block(i, nb_j, j, c):
+        row_start = weight_indptr[nb_j]
+        row_end = weight_indptr[nb_j + 1]
+        elem_idx = tvm.reduce_axis((0, row_end - row_start), name="elem_idx")
+        block_offset = row_start + elem_idx
+        block_j = weight_indices[block_offset]
+        return tvm.sum(weight_data[block_offset, j, c] * data[i, bs_c * block_j + c],
+                       axis=elem_idx)
+
+    idxd = tvm.indexdiv
+    idxm = tvm.indexmod
+
+    bsrmm_block = tvm.compute(
+        (m, num_blocks, bs_r, bs_c), _compute_block,
+        tag="sparse_dense_bsrmm_x86_block")
+    c = tvm.reduce_axis((0, bs_c), name="c")
+    return tvm.compute(
+        (m, num_blocks * bs_r),
+        lambda i, n: tvm.sum(bsrmm_block[i, idxd(n, bs_r), idxm(n, bs_r), c], axis=c),
+        tag="sparse_dense_bsrmm_x86")
+
+
+def _bsr_tile(m, bs_r, bs_c, simd_width):
+    """Rows of data computed per block, and whether the block is vectorized
+    along its columns (else along its rows)."""
+    vec_c = bs_c > 1 and bs_c >= bs_r
+    lanes, other = (bs_c, bs_r) if vec_c else (bs_r, bs_c)
+    regs_per_row = other * ((lanes + simd_width - 1) // simd_width)
+    max_tile = max(1, BSR_ACCUMULATORS // regs_per_row)
+    tile_m = max(x for x in range(1, min(m, max_tile) + 1) if m % x == 0)
+    return tile_m, vec_c
+
+
+def _schedule_bsrmm_x86(s, block, out, last):
+    """Parallel over the block rows of the weight and tiles of data rows,
+    with the products of a tile accumulated in registers."""
+    (i, _, j, c) = s[block].op.axis
+    (elem_idx, ) = s[block].op.reduce_axis
+    bs_r = get_const_int(j.dom.extent)
+    bs_c = get_const_int(c.dom.extent)
+    tile_m, vec_c = _bsr_tile(get_const_int(i.dom.extent), bs_r, bs_c, get_fp32_len())
+
+    (m_o, n_o) = s[last].op.axis
+    (nb_o, j_o) = s[last].split(n_o, bs_r)
+    (mo_o, mi_o) = s[last].split(m_o, tile_m)
+    if last == out:
+        (c_o, ) = s[out].op.reduce_axis
+        if vec_c:
+            s[last].reorder(mo_o, nb_o, mi_o, j_o, c_o)
+        else:
+            s[last].reorder(mo_o, nb_o, mi_o, c_o, j_o)
+            s[last].vectorize(j_o)
+    else:
+        s[last].reorder(mo_o, nb_o, mi_o, j_o)
+        s[last].vectorize(j_o)
+    tile = s[last].fuse(mo_o, nb_o)
+    s[last].parallel(tile)
+    if last != out:
+        s[out].compute_at(s[last], tile)
+        if not vec_c:
+            (m_y, n_y) = s[out].op.axis
+            (c_y, ) = s[out].op.reduce_axis
+            s[out].reorder(m_y, c_y, n_y)
+            s[out].vectorize(n_y)
+
+    # the micro-kernel: one accumulator per row of the tile and block element.
+    s[block].compute_at(s[last], tile)
+    (i, nb_j, j, c) = s[block].op.axis
+    if vec_c:
+        s[block].reorder(nb_j, elem_idx, i, j, c)
+        s[block].unroll(j)
+        s[block].vectorize(c)
+    else:
+        s[block].reorder(nb_j, elem_idx, i, c, j)
+        s[block].unroll(c)
+        s[block].vectorize(j)
+    s[block].unroll(i)
+
 
 @generic.schedule_sparse_dense.register(["cpu"])
 def _schedule_sparse_dense(outs):
     s = tvm.create_schedule([x.op for x in outs])
 
     def _callback(op):
+        if op.tag == "sparse_dense_bsrmm_x86":
+            _schedule_bsrmm_x86(s, op.input_tensors[0], op.output(0), outs[0])
+            return
         simd_width = get_fp32_len()
         if op.tag == "sparse_dense_csrmm" and op != outs[0].op:
             (_, v_i) = s[op].op.axis
@@ -61,8 +61,12 @@
 #include <topi/cuda/softmax.h>
 #include <topi/cuda/normalization.h>
 
+#include <topi/x86/batch_matmul.h>
 #include <topi/x86/bnn.h>
+#include <topi/x86/conv2d.h>
+#include <topi/x86/conv2d_winograd.h>
 #include <topi/x86/default.h>
+#include <topi/x86/dense.h>
 #include <topi/x86/injective.h>
 
 #include <topi/rocm/dense.h>
@@ -88,6 +92,14 @@ Array<Integer> ArrayOrInt(TVMArgValue arg) {
   }
 }
 
+/*! \brief Get the schedule config passed at args[index], empty when it is omitted */
+inline detail::ScheduleConfig ScheduleConfigArg(TVMArgs args, int index) {
+  if (args.size() > index && args[index].type_code() != kNull) {
+    return args[index];
+  }
+  return detail::ScheduleConfig();
+}
+
 inline bool IsTensorType(TVMArgValue arg) {
   return (arg.type_code() == kObjectHandle &&
           static_cast<Object*>(
@@ -619,6 +631,55 @@ TVM_REGISTER_GLOBAL("topi.x86.schedule_binary_dense")
   *rv = topi::x86::schedule_binary_dense(args[0], args[1]);
   });
 
+TVM_REGISTER_GLOBAL("topi.x86.dense_x86")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = x86::dense_x86(args[0], args[1], args[2], args[3], args[4],
+                       ScheduleConfigArg(args, 5));
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.schedule_dense")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = topi::x86::schedule_dense(args[0], args[1], ScheduleConfigArg(args, 2));
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.schedule_batch_matmul")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = topi::x86::schedule_batch_matmul(args[0], args[1], ScheduleConfigArg(args, 2));
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.default_conv2d_NCHWc_config")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = x86::default_conv2d_NCHWc_config(args[0], args[1], args[2], args[3],
+                                         args[4], args[5], args[6]);
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.conv2d_NCHWc")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = x86::conv2d_NCHWc(args[0], args[1], args[2], args[3], args[4],
+                          args[5], args[6], args[7], args[8]);
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.schedule_conv2d_NCHWc")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = topi::x86::schedule_conv2d_NCHWc(args[0], args[1], ScheduleConfigArg(args, 2));
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.conv2d_winograd_weight_transform")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = x86::conv2d_winograd_weight_transform(args[0], args[1], args[2]);
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.conv2d_winograd_nchw")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = x86::conv2d_winograd_nchw(args[0], args[1], args[2], args[3], args[4], args[5],
+                                  ScheduleConfigArg(args, 6));
+  });
+
+TVM_REGISTER_GLOBAL("topi.x86.schedule_conv2d_winograd")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+  *rv = topi::x86::schedule_conv2d_winograd(args[0], args[1], ScheduleConfigArg(args, 2));
+  });
+
 TVM_REGISTER_GLOBAL("topi.x86.default_schedule")
 .set_body([](TVMArgs args, TVMRetValue *rv) {
   if (args[2]) {
@@ -780,11 +841,17 @@ TVM_REGISTER_GENERIC_FUNC(schedule_softmax)
 
 TVM_REGISTER_GENERIC_FUNC(schedule_dense)
 .set_default(WrapSchedule(topi::generic::default_schedule))
+.register_func({ "cpu" }, WrapSchedule([](const Target& target, const Array<Tensor>& outs) {
+  return topi::x86::schedule_dense(target, outs);
+}))
 .register_func({ "cuda", "gpu" }, WrapSchedule(topi::cuda::schedule_dense))
 .register_func({ "rocm" }, WrapSchedule(topi::rocm::schedule_dense));
 
 TVM_REGISTER_GENERIC_FUNC(schedule_batch_matmul)
-.set_default(WrapSchedule(topi::generic::default_schedule));
+.set_default(WrapSchedule(topi::generic::default_schedule))
+.register_func({ "cpu" }, WrapSchedule([](const Target& target, const Array<Tensor>& outs) {
+  return topi::x86::schedule_batch_matmul(target, outs);
+}));
 
 TVM_REGISTER_GENERIC_FUNC(schedule_pool)
 .set_default(WrapSchedule(topi::generic::default_schedule))
@@ -870,6 +937,13 @@ TVM_REGISTER_GENERIC_FUNC(dense)
                             const DataType& out_dtype) {
   return topi::nn::dense(data, weight, bias, out_dtype);
 }))
+.register_func({ "cpu" }, WrapDenseOp([](const Target& target,
+                                          const tvm::Tensor& data,
+                                          const tvm::Tensor& weight,
+                                          const tvm::Tensor& bias,
+                                          const DataType& out_dtype) {
+  return topi::x86::dense_x86(target, data, weight, bias, out_dtype);
+}))
 .register_func({ "cuda", "gpu" }, WrapDenseOp(topi::cuda::dense_cuda))
 .register_func({ "rocm" }, WrapDenseOp(topi::rocm::dense_rocm));
 
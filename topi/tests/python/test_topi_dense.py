@@ -114,6 +114,41 @@ def verify_dense_int8(batch, in_dim, out_dim, use_bias=True):
         check_device(device)
 
 
+def verify_dense_int8_x86(batch, in_dim, out_dim, use_bias=True):
+    A = tvm.placeholder((batch, in_dim), name='A', dtype='uint8')
+    B = tvm.placeholder((out_dim, in_dim), name='B', dtype='int8')
+    C = tvm.placeholder((out_dim,), name='C', dtype='int32')
+
+    a_np = np.random.randint(low=0, high=255, size=(batch, in_dim)).astype('uint8')
+    b_np = np.random.randint(low=-128, high=127, size=(out_dim, in_dim)).astype('int8')
+    c_np = np.random.randint(low=-1024, high=1024, size=(out_dim,)).astype('int32')
+    d_np = np.dot(a_np.astype('int32'), b_np.T.astype('int32'))
+    if use_bias:
+        d_np += c_np
+    # requantize-like epilogue
+    d_np = np.clip(np.right_shift(d_np, 8) + 128, 0, 255).astype('uint8')
+
+    device = "llvm -mcpu=skylake-avx512"
+    ctx = tvm.context(device, 0)
+    if not ctx.exist or tvm.codegen.llvm_version_major() < 8:
+        print("Skip because %s is not enabled" % device)
+        return
+    print("Running on target: %s" % device)
+    with tvm.target.create(device):
+        D = topi.nn.dense(A, B, C if use_bias else None, out_dtype='int32')
+        assert "dense_int8" in D.op.tag or "dense_int8" in D.op.input_tensors[0].op.tag
+        D = topi.right_shift(D, 8) + 128
+        D = topi.cast(topi.clip(D, 0, 255), 'uint8')
+        s = topi.generic.schedule_dense([D])
+    a = tvm.nd.array(a_np, ctx)
+    b = tvm.nd.array(b_np, ctx)
+    c = tvm.nd.array(c_np, ctx)
+    d = tvm.nd.array(np.zeros(get_const_tuple(D.shape), dtype='uint8'), ctx)
+    f = tvm.build(s, [A, B, C, D], device, name="dense")
+    f(a, b, c, d)
+    tvm.testing.assert_allclose(d.asnumpy(), d_np)
+
+
 def test_dense():
     verify_dense(1, 1024, 1000, use_bias=True)
     verify_dense(1, 1024, 1000, use_bias=False)
@@ -128,6 +163,13 @@ def test_dense_int8():
         verify_dense_int8(2, 1024, 1000, use_bias=False)
 
 
+def test_dense_int8_x86():
+    verify_dense_int8_x86(1, 1024, 1008, use_bias=True)
+    verify_dense_int8_x86(128, 768, 3072, use_bias=False)
+    verify_dense_int8_x86(32, 1022, 256, use_bias=True)
+
+
 if __name__ == "__main__":
     test_dense()
     test_dense_int8()
+    test_dense_int8_x86()
@@ -333,10 +333,45 @@ def test_sparse_dense_bsr_randomized():
         tvm.testing.assert_allclose(Y_tvm.asnumpy(), Y_np, atol=1e-5, rtol=1e-5)
 
 
+def verify_sparse_dense_bsr_x86(M, N, K, BS_R, BS_C, density, epilogue=False):
+    X_np = np.random.randn(M, K).astype("float32")
+    W_sp_np = random_bsr_matrix(N, K, BS_R, BS_C, density=density, dtype="float32")
+    Y_np = np.array(X_np.dot(W_sp_np.todense().T))
+    if epilogue:
+        Y_np = np.maximum(Y_np, 0)
+
+    W_data = tvm.placeholder(shape=W_sp_np.data.shape, dtype=str(W_sp_np.data.dtype))
+    W_indices = tvm.placeholder(shape=W_sp_np.indices.shape, dtype=str(W_sp_np.indices.dtype))
+    W_indptr = tvm.placeholder(shape=W_sp_np.indptr.shape, dtype=str(W_sp_np.indptr.dtype))
+    X = tvm.placeholder(shape=X_np.shape, dtype=str(X_np.dtype))
+    with tvm.target.create("llvm"):
+        Y = topi.nn.sparse_dense(X, W_data, W_indices, W_indptr)
+        assert Y.op.tag == "sparse_dense_bsrmm_x86"
+        if epilogue:
+            Y = topi.nn.relu(Y)
+        s = topi.generic.schedule_sparse_dense([Y])
+    func = tvm.build(s, [X, W_data, W_indices, W_indptr, Y])
+    Y_tvm = tvm.ndarray.array(np.zeros(Y_np.shape, dtype=Y_np.dtype))
+    func(tvm.ndarray.array(X_np),
+         tvm.ndarray.array(W_sp_np.data),
+         tvm.ndarray.array(W_sp_np.indices),
+         tvm.ndarray.array(W_sp_np.indptr),
+         Y_tvm)
+    tvm.testing.assert_allclose(Y_tvm.asnumpy(), Y_np, atol=1e-4, rtol=1e-4)
+
+def test_sparse_dense_bsr_x86():
+    for BS_R, BS_C in [(1, 16), (16, 1), (8, 16), (4, 4), (1, 1)]:
+        for M in [1, 7, 32]:
+            verify_sparse_dense_bsr_x86(M, 64, 128, BS_R, BS_C, density=0.2)
+    verify_sparse_dense_bsr_x86(16, 64, 128, 1, 16, density=0.1, epilogue=True)
+    verify_sparse_dense_bsr_x86(16, 64, 128, 16, 1, density=0.1, epilogue=True)
+
+
 def test_sparse_dense():
     test_sparse_dense_csr()
     test_sparse_dense_bsr()
     test_sparse_dense_bsr_randomized()
+    test_sparse_dense_bsr_x86()
 
 if __name__ == "__main__":
     test_csrmv()
@@ -150,6 +150,54 @@ def test_non_max_suppression():
     verify_non_max_suppression(np_data, np_valid_count, np_result, np_indices_result, 0.7, False, 2, 1, 0, -1)
 
 
+def verify_nms_cpu(dshape, score_threshold, iou_threshold, force_suppress, top_k,
+                   max_output_size, id_index, return_indices, invalid_to_bottom):
+    """Compare the cpu kernels with the generic hybrid script versions"""
+    if not tvm.get_global_func("tvm.contrib.sort.nms", allow_missing=True):
+        print("Skip because sort function not enabled")
+        return
+    dtype = "float32"
+    batch_size, num_anchors, elem_length = dshape
+    score_index = 1 if id_index >= 0 else 0
+    coord_start = elem_length - 4
+    np_data = np.random.uniform(0, 100, size=dshape).astype(dtype)
+    np_data[:, :, score_index] = np.random.uniform(-0.5, 1, size=(batch_size, num_anchors))
+    if id_index >= 0:
+        np_data[:, :, id_index] = np.random.randint(-1, 4, size=(batch_size, num_anchors))
+    np_data[:, :, coord_start + 2:] = np_data[:, :, coord_start:coord_start + 2] + \
+        np.random.uniform(0, 30, size=(batch_size, num_anchors, 2))
+    data = tvm.placeholder(dshape, name="data", dtype=dtype)
+
+    def build(valid_counts_func, nms_func):
+        with tvm.target.create("llvm"):
+            counts = valid_counts_func(data, score_threshold, id_index, score_index)
+            out = nms_func(counts[1], counts[0], max_output_size, iou_threshold,
+                           force_suppress, top_k, coord_start=coord_start,
+                           score_index=score_index, id_index=id_index,
+                           return_indices=return_indices,
+                           invalid_to_bottom=invalid_to_bottom)
+            s = topi.generic.schedule_nms(out)
+        return tvm.build(s, [data, out], "llvm")
+
+    ctx = tvm.cpu(0)
+    out_shape = (batch_size, num_anchors) if return_indices else dshape
+    out_dtype = "int32" if return_indices else dtype
+    results = []
+    for funcs in [(get_valid_counts, non_max_suppression),
+                  (get_valid_counts.fdefault, non_max_suppression.fdefault)]:
+        tvm_out = tvm.nd.array(np.zeros(out_shape, dtype=out_dtype), ctx)
+        build(*funcs)(tvm.nd.array(np_data, ctx), tvm_out)
+        results.append(tvm_out.asnumpy())
+    tvm.testing.assert_allclose(results[0], results[1])
+
+
+def test_non_max_suppression_cpu():
+    verify_nms_cpu((1, 2500, 6), 0, 0.5, False, -1, -1, 0, True, False)
+    verify_nms_cpu((2, 1000, 6), 0.3, 0.45, True, 100, -1, 0, False, True)
+    verify_nms_cpu((4, 500, 6), 0.1, 0.6, False, 200, 50, 0, False, False)
+    verify_nms_cpu((3, 800, 5), 0.2, 0.5, False, -1, 20, -1, True, False)
+    verify_nms_cpu((2, 300, 6), 0, 0, False, -1, -1, 0, False, True)
+
 
 def verify_multibox_prior(dshape, sizes=(1,), ratios=(1,), steps=(-1, -1), offsets=(0.5, 0.5), clip=False):
     data = tvm.placeholder(dshape, name="data")
@@ -425,6 +473,7 @@ def test_proposal():
 if __name__ == "__main__":
     test_get_valid_counts()
     test_non_max_suppression()
+    test_non_max_suppression_cpu()
     test_multibox_prior()
     test_multibox_detection()
     test_roi_align()
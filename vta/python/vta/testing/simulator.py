@@ -84,6 +84,9 @@ def stats():
 
 # debug flag to skip execution.
 DEBUG_SKIP_EXEC = 1
+# debug flag to run GEMM/ALU with the bit-level reference implementation
+# instead of the fast path.
+DEBUG_REFERENCE_EXEC = 2
 
 def debug_mode(flag):
     """Set debug mode
@@ -26,11 +26,15 @@
 #include <tvm/runtime/registry.h>
 #include <vta/sim_tlpp.h>
 #include <type_traits>
+#include <algorithm>
 #include <mutex>
 #include <map>
+#include <thread>
 #include <unordered_map>
 #include <cstring>
+#include <limits>
 #include <sstream>
+#include <vector>
 
 #include "../vmem/virtual_memory.h"
 
@@ -39,7 +43,9 @@ namespace sim {
 
 /*! \brief debug flag for skipping computation */
 enum DebugFlagMask {
-  kSkipExec = 1
+  kSkipExec = 1,
+  /*! \brief run GEMM/ALU with the bit-level reference implementation */
+  kReferenceExec = 2
 };
 
 /*!
@@ -246,6 +252,10 @@ class Profiler {
   bool SkipExec() const {
     return (debug_flag & DebugFlagMask::kSkipExec) != 0;
   }
+  /*! \return Whether we should use the reference execution. */
+  bool ReferenceExec() const {
+    return (debug_flag & DebugFlagMask::kReferenceExec) != 0;
+  }
 
   std::string AsJSON() {
     std::ostringstream os;
@@ -354,6 +364,10 @@ class Device {
     if (!op->reset_reg) {
       prof_->gemm_counter += op->iter_out * op->iter_in * (op->uop_end - op->uop_bgn);
       if (prof_->SkipExec()) return;
+      if (UseFastPath()) {
+        RunGEMMFast(op);
+        return;
+      }
       for (uint32_t y = 0; y < op->iter_out; ++y) {
         for (uint32_t x = 0; x < op->iter_in; ++x) {
           for (uint32_t uindex = op->uop_bgn; uindex < op->uop_end; ++uindex) {
@@ -388,6 +402,10 @@ class Device {
       }
     } else {
       if (prof_->SkipExec()) return;
+      if (UseFastPath()) {
+        RunGEMMFast(op);
+        return;
+      }
       // reset
       for (uint32_t y = 0; y < op->iter_out; ++y) {
         for (uint32_t x = 0; x < op->iter_in; ++x) {
@@ -450,6 +468,10 @@ class Device {
   void RunALULoop(const VTAAluInsn* op, F func) {
     prof_->alu_counter += op->iter_out * op->iter_in * (op->uop_end - op->uop_bgn);
     if (prof_->SkipExec()) return;
+    if (UseFastPath()) {
+      RunALUFast<use_imm>(op, func);
+      return;
+    }
     for (int y = 0; y < op->iter_out; ++y) {
       for (int x = 0; x < op->iter_in; ++x) {
         for (int k = op->uop_bgn; k < op->uop_end; ++k) {
@@ -472,6 +494,154 @@ class Device {
       }
     }
   }
+  /*!
+   * \brief The fast path works directly on the SRAM content, which holds
+   *  native integers when the operand widths are 8/8/32 bits.
+   */
+  static constexpr bool kNativeLayout =
+      VTA_INP_WIDTH == 8 && VTA_WGT_WIDTH == 8 && VTA_ACC_WIDTH == 32;
+  /*! \brief Minimum number of element operations to split an instruction over threads. */
+  static constexpr uint64_t kParallelMinOps = 1 << 18;
+
+  bool UseFastPath() const {
+    return kNativeLayout && !prof_->ReferenceExec();
+  }
+
+  // Range of the SRAM indices [min, max] touched by the uops of one outer iteration.
+  template<typename FIndex>
+  std::pair<uint64_t, uint64_t> UopRange(uint32_t uop_bgn, uint32_t uop_end,
+                                         uint32_t iter_in, uint32_t factor_in,
+                                         FIndex findex) {
+    uint64_t lo = std::numeric_limits<uint64_t>::max(), hi = 0;
+    for (uint32_t k = uop_bgn; k < uop_end; ++k) {
+      uint64_t idx = findex(static_cast<VTAUop*>(uop_.BeginPtr(k)));
+      lo = std::min(lo, idx);
+      hi = std::max(hi, idx);
+    }
+    return {lo, hi + static_cast<uint64_t>(iter_in - 1) * factor_in};
+  }
+
+  /*!
+   * \brief Run f(y) for y in [0, iter_out), with multiple threads when the
+   *  iterations are independent and there is enough work.
+   */
+  template<typename F>
+  static void ParallelIterOut(uint32_t iter_out, bool independent, uint64_t num_ops, F f) {
+    uint32_t num_threads = std::min<uint32_t>(
+        iter_out, std::max(std::thread::hardware_concurrency(), 1U));
+    if (!independent || num_ops < kParallelMinOps || num_threads <= 1) {
+      for (uint32_t y = 0; y < iter_out; ++y) f(y);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([=, &f]() {
+        for (uint32_t y = t; y < iter_out; y += num_threads) f(y);
+      });
+    }
+    for (auto& t : threads) t.join();
+  }
+
+  void RunGEMMFast(const VTAGemInsn* op) {
+    constexpr uint32_t kInpLane = VTA_BATCH * VTA_BLOCK_IN;
+    constexpr uint32_t kWgtLane = VTA_BLOCK_OUT * VTA_BLOCK_IN;
+    constexpr uint32_t kAccLane = VTA_BATCH * VTA_BLOCK_OUT;
+    if (op->iter_out == 0 || op->iter_in == 0 || op->uop_bgn >= op->uop_end) return;
+    auto dst = UopRange(op->uop_bgn, op->uop_end, op->iter_in, op->dst_factor_in,
+                        [](const VTAUop* u) { return u->dst_idx; });
+    auto src = UopRange(op->uop_bgn, op->uop_end, op->iter_in, op->src_factor_in,
+                        [](const VTAUop* u) { return u->src_idx; });
+    auto wgt = UopRange(op->uop_bgn, op->uop_end, op->iter_in, op->wgt_factor_in,
+                        [](const VTAUop* u) { return u->wgt_idx; });
+    uint32_t last = op->iter_out - 1;
+    // same bound checks as the accesses through SRAM::BeginPtr.
+    acc_.BeginPtr(dst.second + static_cast<uint64_t>(last) * op->dst_factor_out);
+    inp_.BeginPtr(src.second + static_cast<uint64_t>(last) * op->src_factor_out);
+    wgt_.BeginPtr(wgt.second + static_cast<uint64_t>(last) * op->wgt_factor_out);
+    int32_t* acc_base = static_cast<int32_t*>(acc_.BeginPtr(0));
+    const int8_t* inp_base = static_cast<const int8_t*>(inp_.BeginPtr(0));
+    const int8_t* wgt_base = static_cast<const int8_t*>(wgt_.BeginPtr(0));
+    const VTAUop* uops = static_cast<const VTAUop*>(uop_.BeginPtr(0));
+    // The outer iterations only write to their own accumulators when the
+    // accumulator windows of two consecutive iterations do not overlap.
+    bool independent = op->iter_out == 1 || op->dst_factor_out > dst.second - dst.first;
+    uint64_t num_ops = static_cast<uint64_t>(op->iter_out) * op->iter_in *
+        (op->uop_end - op->uop_bgn) * kAccLane * (op->reset_reg ? 1 : VTA_BLOCK_IN);
+
+    ParallelIterOut(op->iter_out, independent, num_ops, [&](uint32_t y) {
+      for (uint32_t x = 0; x < op->iter_in; ++x) {
+        for (uint32_t uindex = op->uop_bgn; uindex < op->uop_end; ++uindex) {
+          const VTAUop& uop = uops[uindex];
+          uint32_t acc_idx = uop.dst_idx + y * op->dst_factor_out + x * op->dst_factor_in;
+          int32_t* acc = acc_base + static_cast<uint64_t>(acc_idx) * kAccLane;
+          if (op->reset_reg) {
+            std::fill(acc, acc + kAccLane, 0);
+            continue;
+          }
+          uint32_t inp_idx = uop.src_idx + y * op->src_factor_out + x * op->src_factor_in;
+          uint32_t wgt_idx = uop.wgt_idx + y * op->wgt_factor_out + x * op->wgt_factor_in;
+          GemmBlock(acc, inp_base + static_cast<uint64_t>(inp_idx) * kInpLane,
+                    wgt_base + static_cast<uint64_t>(wgt_idx) * kWgtLane);
+        }
+      }
+    });
+  }
+
+  // acc += inp * wgt^T on one tensor intrinsic, with wrap-around accumulation.
+  static inline void GemmBlock(int32_t* acc, const int8_t* inp, const int8_t* wgt) {
+    for (uint32_t i = 0; i < VTA_BATCH; ++i) {
+      for (uint32_t j = 0; j < VTA_BLOCK_OUT; ++j) {
+        const int8_t* a = inp + i * VTA_BLOCK_IN;
+        const int8_t* b = wgt + j * VTA_BLOCK_IN;
+        uint32_t sum = 0;
+        for (uint32_t k = 0; k < VTA_BLOCK_IN; ++k) {
+          sum += static_cast<uint32_t>(static_cast<int32_t>(a[k]) * static_cast<int32_t>(b[k]));
+        }
+        uint32_t& out = reinterpret_cast<uint32_t&>(acc[i * VTA_BLOCK_OUT + j]);
+        out += sum;
+      }
+    }
+  }
+
+  template<bool use_imm, typename F>
+  void RunALUFast(const VTAAluInsn* op, F func) {
+    constexpr uint32_t kAccLane = VTA_BATCH * VTA_BLOCK_OUT;
+    if (op->iter_out == 0 || op->iter_in == 0 || op->uop_bgn >= op->uop_end) return;
+    auto dst = UopRange(op->uop_bgn, op->uop_end, op->iter_in, op->dst_factor_in,
+                        [](const VTAUop* u) { return u->dst_idx; });
+    auto src = UopRange(op->uop_bgn, op->uop_end, op->iter_in, op->src_factor_in,
+                        [](const VTAUop* u) { return u->src_idx; });
+    uint32_t last = op->iter_out - 1;
+    uint64_t dst_end = dst.second + static_cast<uint64_t>(last) * op->dst_factor_out;
+    uint64_t src_end = src.second + static_cast<uint64_t>(last) * op->src_factor_out;
+    acc_.BeginPtr(dst_end);
+    acc_.BeginPtr(src_end);
+    int32_t* acc_base = static_cast<int32_t*>(acc_.BeginPtr(0));
+    const VTAUop* uops = static_cast<const VTAUop*>(uop_.BeginPtr(0));
+    // Independent when every iteration writes its own window and no iteration
+    // reads what another one writes.
+    bool independent = op->iter_out == 1 ||
+        (op->dst_factor_out > dst.second - dst.first &&
+         (use_imm || src_end < dst.first || dst_end < src.first));
+    uint64_t num_ops = static_cast<uint64_t>(op->iter_out) * op->iter_in *
+        (op->uop_end - op->uop_bgn) * kAccLane;
+
+    ParallelIterOut(op->iter_out, independent, num_ops, [&](uint32_t y) {
+      for (uint32_t x = 0; x < op->iter_in; ++x) {
+        for (uint32_t uindex = op->uop_bgn; uindex < op->uop_end; ++uindex) {
+          const VTAUop& uop = uops[uindex];
+          uint32_t dst_idx = uop.dst_idx + y * op->dst_factor_out + x * op->dst_factor_in;
+          uint32_t src_idx = uop.src_idx + y * op->src_factor_out + x * op->src_factor_in;
+          int32_t* dst_ptr = acc_base + static_cast<uint64_t>(dst_idx) * kAccLane;
+          const int32_t* src_ptr = acc_base + static_cast<uint64_t>(src_idx) * kAccLane;
+          for (uint32_t k = 0; k < kAccLane; ++k) {
+            dst_ptr[k] = func(dst_ptr[k], use_imm ? op->imm : src_ptr[k]);
+          }
+        }
+      }
+    });
+  }
+
   // the finish counter
   int finish_counter_{0};
   // Prof_
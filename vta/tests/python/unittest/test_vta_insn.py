@@ -238,6 +238,16 @@ def test_gemm():
                 for k, v in sim_stats.items():
                     print("\t{:<16}: {:>16}".format(k, v))
 
+            if env.TARGET == "sim":
+                # the fast path must match the reference simulation
+                y_ref = tvm.nd.array(np.zeros(y_np.shape).astype(y.dtype), ctx)
+                simulator.clear_stats()
+                simulator.debug_mode(simulator.DEBUG_REFERENCE_EXEC)
+                f(x_nd, w_nd, y_ref)
+                simulator.debug_mode(0)
+                np.testing.assert_equal(y_ref.asnumpy(), y_nd.asnumpy())
+                assert simulator.stats() == sim_stats
+
         def test_schedule1():
             # default schedule with no smt
             s = tvm.create_schedule(y.op)